@@ -22,9 +22,45 @@ cbuffer cb : register(b0) {
     uint4 const1;
 };
 
+// With CAS_SAMPLE_STEREO, both eyes are processed in one dispatch, the eye being the group's Z. Each eye is a region of
+// a slice of the input and output textures, and the accesses outside of the region behave like outside of a texture.
+static uint Slice = 0;
+
+#if CAS_SAMPLE_STEREO
+cbuffer stereo : register(b1) {
+    int4 InputView[2];  // per eye: x, y, slice
+    int4 OutputView[2]; // per eye: x, y, slice
+    int4 ViewExtent;    // input width, height, output width, height
+};
+
+Texture2DArray InputTexture : register(t0);
+RWTexture2DArray<float4> OutputTexture : register(u0);
+
+float4 LoadInput(int2 p) {
+    if (any(p < 0) || any(p >= ViewExtent.xy)) {
+        return 0;
+    }
+    return InputTexture.Load(int4(p + InputView[Slice].xy, InputView[Slice].z, 0));
+}
+
+void StoreOutput(int2 p, float4 c) {
+    if (all(p < ViewExtent.zw)) {
+        OutputTexture[uint3(p + OutputView[Slice].xy, OutputView[Slice].z)] = c;
+    }
+}
+#else
 Texture2D InputTexture : register(t0);
 RWTexture2D<float4> OutputTexture : register(u0);
 
+float4 LoadInput(int2 p) {
+    return InputTexture.Load(int3(p, 0));
+}
+
+void StoreOutput(int2 p, float4 c) {
+    OutputTexture[p] = c;
+}
+#endif
+
 #define A_GPU 1
 #define A_HLSL 1
 
@@ -40,7 +76,7 @@ RWTexture2D<float4> OutputTexture : register(u0);
 #if CAS_SAMPLE_FP16
 
 AH3 CasLoadH(ASW2 p) {
-    return InputTexture.Load(ASU3(p, 0)).rgb;
+    return LoadInput(p).rgb;
 }
 
 // Lets you transform input from the load into a linear color space between 0 and 1. See ffx_cas.h
@@ -51,7 +87,7 @@ void CasInputH(inout AH2 r, inout AH2 g, inout AH2 b) {
 #else
 
 AF3 CasLoad(ASU2 p) {
-    return InputTexture.Load(int3(p, 0)).rgb;
+    return LoadInput(p).rgb;
 }
 
 // Lets you transform input from the load into a linear color space between 0 and 1. See ffx_cas.h
@@ -67,6 +103,8 @@ void CasInput(inout AF1 r, inout AF1 g, inout AF1 b) {
 void mainCS(uint3 LocalThreadId
                                                : SV_GroupThreadID, uint3 WorkGroupId
                                                : SV_GroupID) {
+    Slice = WorkGroupId.z;
+
     // Do remapping of local xy in workgroup for a more PS-like swizzle pattern.
     AU2 gxy = ARmp8x8(LocalThreadId.x) + AU2(WorkGroupId.x << 4u, WorkGroupId.y << 4u);
 
@@ -85,14 +123,14 @@ void mainCS(uint3 LocalThreadId
 
     CasFilterH(cR, cG, cB, gxy, const0, const1, sharpenOnly);
     CasDepack(c0, c1, cR, cG, cB);
-    OutputTexture[ASU2(gxy)] = AF4(c0);
-    OutputTexture[ASU2(gxy) + ASU2(8, 0)] = AF4(c1);
+    StoreOutput(ASU2(gxy), AF4(c0));
+    StoreOutput(ASU2(gxy) + ASU2(8, 0), AF4(c1));
     gxy.y += 8u;
 
     CasFilterH(cR, cG, cB, gxy, const0, const1, sharpenOnly);
     CasDepack(c0, c1, cR, cG, cB);
-    OutputTexture[ASU2(gxy)] = AF4(c0);
-    OutputTexture[ASU2(gxy) + ASU2(8, 0)] = AF4(c1);
+    StoreOutput(ASU2(gxy), AF4(c0));
+    StoreOutput(ASU2(gxy) + ASU2(8, 0), AF4(c1));
 
 #else
 
@@ -100,19 +138,19 @@ void mainCS(uint3 LocalThreadId
     AF3 c;
 
     CasFilter(c.r, c.g, c.b, gxy, const0, const1, sharpenOnly);
-    OutputTexture[ASU2(gxy)] = AF4(c, 1);
+    StoreOutput(ASU2(gxy), AF4(c, 1));
     gxy.x += 8u;
 
     CasFilter(c.r, c.g, c.b, gxy, const0, const1, sharpenOnly);
-    OutputTexture[ASU2(gxy)] = AF4(c, 1);
+    StoreOutput(ASU2(gxy), AF4(c, 1));
     gxy.y += 8u;
 
     CasFilter(c.r, c.g, c.b, gxy, const0, const1, sharpenOnly);
-    OutputTexture[ASU2(gxy)] = AF4(c, 1);
+    StoreOutput(ASU2(gxy), AF4(c, 1));
     gxy.x -= 8u;
 
     CasFilter(c.r, c.g, c.b, gxy, const0, const1, sharpenOnly);
-    OutputTexture[ASU2(gxy)] = AF4(c, 1);
+    StoreOutput(ASU2(gxy), AF4(c, 1));
 
 #endif
 }
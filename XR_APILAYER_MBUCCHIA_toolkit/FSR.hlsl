@@ -27,6 +27,9 @@ cbuffer cb : register(b0)
   uint4 Const2;
   uint4 Const3;
   uint4 Const4;
+  uint4 Const5;        // RCAS outside of the foveated region
+  float4 Foveation[2]; // per slice: gaze ndc_x, ndc_y, 1/(a^2), 1/(b^2) (all 0 for full quality everywhere)
+  uint4 OutputFlags;   // x: 1 when the output is a UNORM view of a sRGB texture (fused path only)
 };
 
 #define A_GPU 1
@@ -34,26 +37,108 @@ cbuffer cb : register(b0)
 
 SamplerState		samLinearClamp : register(s0);
 
+// The fused path runs EASU for a 16x16 tile plus a 1 pixel border into groupshared memory, then RCAS (and optionally
+// the post-processing) from there, without the intermediate texture. It is only implemented for the FP32 path.
+#if SAMPLE_FUSED
+  #define FUSED_TILE_STRIDE (16 + 2)
+  groupshared float3 FusedTile[FUSED_TILE_STRIDE * FUSED_TILE_STRIDE];
+  static int2 FusedTileOrigin;
+
+  // SAMPLE_POST_PROCESS: 0 = none, 1 = color gains only, 2 = all the adjustments.
+  #if SAMPLE_POST_PROCESS
+    #define POST_PROCESS_FUNCTIONS_ONLY 1
+    #define POST_PROCESS_CONFIG_REGISTER b1
+    #include "postprocess.hlsl"
+  #endif
+#endif
+
+// With SAMPLE_STEREO, both eyes are processed in one dispatch, the eye being the group's Z. Each eye is a region of a
+// slice of the input and output textures, and the reads are clamped to the region like the sampler clamps them to the
+// texture otherwise. It is only implemented for the FP32 path.
+static uint Slice = 0;
+#if SAMPLE_STEREO
+  cbuffer stereo : register(b2) // b1 is the post-processing of the fused path.
+  {
+    int4 InputView[2];  // per eye: x, y, slice
+    int4 OutputView[2]; // per eye: x, y, slice
+    int4 ViewExtent;    // input width, height, output width, height
+  };
+#endif
+
 #if SAMPLE_SLOW_FALLBACK
   #include "ffx_a.h"
-  Texture2D InputTexture : register(t0);
-  RWTexture2D<float4> OutputTexture : register(u0);
-  #if SAMPLE_EASU
+  #if SAMPLE_STEREO
+    Texture2DArray InputTexture : register(t0);
+    RWTexture2DArray<float4> OutputTexture : register(u0);
+
+    AF4 LoadInputClamped(int2 p) {
+      p = clamp(p, 0, ViewExtent.xy - 1);
+      return InputTexture.Load(int4(p + InputView[Slice].xy, InputView[Slice].z, 0));
+    }
+    // Like Load() outside of a texture, the pixels outside of the region are 0.
+    AF4 LoadInput(int2 p) {
+      if (any(p < 0) || any(p >= ViewExtent.xy)) {
+        return 0;
+      }
+      return InputTexture.Load(int4(p + InputView[Slice].xy, InputView[Slice].z, 0));
+    }
+    // The 4 pixels of a Gather*() at a position normalized to the region, in the same order.
+    AF4 GatherInput(AF2 p, uint channel) {
+      const int2 i = int2(floor(p * AF2(ViewExtent.xy) - 0.5));
+      return AF4(LoadInputClamped(i + int2(0, 1))[channel], LoadInputClamped(i + int2(1, 1))[channel],
+                 LoadInputClamped(i + int2(1, 0))[channel], LoadInputClamped(i)[channel]);
+    }
+    AF4 SampleInput(AF2 p) {
+      const AF2 t = p * AF2(ViewExtent.xy) - 0.5;
+      const int2 i = int2(floor(t));
+      const AF2 f = t - floor(t);
+      return lerp(lerp(LoadInputClamped(i), LoadInputClamped(i + int2(1, 0)), f.x),
+                  lerp(LoadInputClamped(i + int2(0, 1)), LoadInputClamped(i + int2(1, 1)), f.x), f.y);
+    }
+    void StoreOutput(int2 p, AF4 c) {
+      if (all(p < ViewExtent.zw)) {
+        OutputTexture[uint3(p + OutputView[Slice].xy, OutputView[Slice].z)] = c;
+      }
+    }
+  #else
+    Texture2D InputTexture : register(t0);
+    RWTexture2D<float4> OutputTexture : register(u0);
+
+    AF4 LoadInput(int2 p) { return InputTexture.Load(int3(p, 0)); }
+    AF4 SampleInput(AF2 p) { return InputTexture.SampleLevel(samLinearClamp, p, 0.0); }
+    void StoreOutput(int2 p, AF4 c) { OutputTexture[p] = c; }
+  #endif
+  #if SAMPLE_EASU || SAMPLE_FUSED
     #define FSR_EASU_F 1
-    AF4 FsrEasuRF(AF2 p) { AF4 res = InputTexture.GatherRed(samLinearClamp, p, int2(0, 0)); return res; }
-    AF4 FsrEasuGF(AF2 p) { AF4 res = InputTexture.GatherGreen(samLinearClamp, p, int2(0, 0)); return res; }
-    AF4 FsrEasuBF(AF2 p) { AF4 res = InputTexture.GatherBlue(samLinearClamp, p, int2(0, 0)); return res; }
+    #if SAMPLE_STEREO
+      AF4 FsrEasuRF(AF2 p) { return GatherInput(p, 0); }
+      AF4 FsrEasuGF(AF2 p) { return GatherInput(p, 1); }
+      AF4 FsrEasuBF(AF2 p) { return GatherInput(p, 2); }
+    #else
+      AF4 FsrEasuRF(AF2 p) { AF4 res = InputTexture.GatherRed(samLinearClamp, p, int2(0, 0)); return res; }
+      AF4 FsrEasuGF(AF2 p) { AF4 res = InputTexture.GatherGreen(samLinearClamp, p, int2(0, 0)); return res; }
+      AF4 FsrEasuBF(AF2 p) { AF4 res = InputTexture.GatherBlue(samLinearClamp, p, int2(0, 0)); return res; }
+    #endif
   #endif
   #if SAMPLE_RCAS
     #define FSR_RCAS_F
     #if SAMPLE_HDR_OUTPUT
-      AF4 FsrRcasLoadF(ASU2 p) { return sqrt(InputTexture.Load(int3(ASU2(p), 0))); }
+      AF4 FsrRcasLoadF(ASU2 p) { return sqrt(LoadInput(ASU2(p))); }
     #else
-      AF4 FsrRcasLoadF(ASU2 p) { return InputTexture.Load(int3(ASU2(p), 0)); }
+      AF4 FsrRcasLoadF(ASU2 p) { return LoadInput(ASU2(p)); }
     #endif
     void FsrRcasInputF(inout AF1 r, inout AF1 g, inout AF1 b) {
     }
   #endif
+  #if SAMPLE_FUSED
+    #define FSR_RCAS_F
+    AF4 FsrRcasLoadF(ASU2 p) {
+      const int2 t = p - FusedTileOrigin;
+      return AF4(FusedTile[t.y * FUSED_TILE_STRIDE + t.x], 1);
+    }
+    void FsrRcasInputF(inout AF1 r, inout AF1 g, inout AF1 b) {
+    }
+  #endif
 #else
   #define A_HALF
   #include "ffx_a.h"
@@ -70,48 +155,91 @@ SamplerState		samLinearClamp : register(s0);
     AH4 FsrRcasLoadH(ASW2 p) { return InputTexture.Load(ASW3(ASW2(p), 0)); }
     void FsrRcasInputH(inout AH1 r,inout AH1 g,inout AH1 b){}
   #endif
+  AH4 SampleInput(AF2 p) { return InputTexture.SampleLevel(samLinearClamp, p, 0.0); }
+  void StoreOutput(int2 p, AH4 c) { OutputTexture[p] = c; }
 #endif
 
 #include "ffx_fsr1.h"
 
+// Whether the tile intersects the foveated region, using its closest point to the gaze (same ellipse as VRS.hlsl).
+// Outside of the foveated region, bilinear filtering replaces EASU and RCAS is lighter.
+static bool TileFoveated = true;
+bool IsTileFoveated(int2 tileMin, int2 tileMax, uint2 outputSize)
+{
+  const float2 ndcMin = float2(2.0f, -2.0f) * (float2(tileMin) / outputSize) + float2(-1.0f, +1.0f);
+  const float2 ndcMax = float2(2.0f, -2.0f) * (float2(tileMax) / outputSize) + float2(-1.0f, +1.0f);
+  const float4 foveation = Foveation[Slice];
+  float2 pos_xy = clamp(foveation.xy, min(ndcMin, ndcMax), max(ndcMin, ndcMax)) - foveation.xy;
+  pos_xy *= pos_xy;
+  return dot(pos_xy, foveation.zw) <= 1.0f;
+}
+
+uint2 GetOutputSize()
+{
+  uint2 outputSize;
+#if SAMPLE_STEREO
+  outputSize = ViewExtent.zw;
+#else
+  OutputTexture.GetDimensions(outputSize.x, outputSize.y);
+#endif
+  return outputSize;
+}
+
 void CurrFilter(int2 pos)
 {
 #if SAMPLE_BILINEAR
   AF2 pp = (AF2(pos) * AF2_AU2(Const0.xy) + AF2_AU2(Const0.zw)) * AF2_AU2(Const1.xy) + AF2(0.5, -0.5) * AF2_AU2(Const1.zw);
-  OutputTexture[pos] = InputTexture.SampleLevel(samLinearClamp, pp, 0.0);
+  StoreOutput(pos, SampleInput(pp));
 #endif
 #if SAMPLE_EASU
+  if (!TileFoveated) {
+    AF2 pp = (AF2(pos) * AF2_AU2(Const0.xy) + AF2_AU2(Const0.zw)) * AF2_AU2(Const1.xy) + AF2(0.5, -0.5) * AF2_AU2(Const1.zw);
+  #if SAMPLE_SLOW_FALLBACK
+    AF3 c = SampleInput(pp).rgb;
+    #if SAMPLE_HDR_OUTPUT
+      c *= c;
+    #endif
+    StoreOutput(pos, float4(c, 1));
+  #else
+    AH3 c = SampleInput(pp).rgb;
+    #if SAMPLE_HDR_OUTPUT
+      c *= c;
+    #endif
+    StoreOutput(pos, AH4(c, 1));
+  #endif
+    return;
+  }
   #if SAMPLE_SLOW_FALLBACK
     AF3 c;
     FsrEasuF(c, pos, Const0, Const1, Const2, Const3);
     #if SAMPLE_HDR_OUTPUT
       c *= c;
     #endif
-    OutputTexture[pos] = float4(c, 1);
+    StoreOutput(pos, float4(c, 1));
   #else
     AH3 c;
     FsrEasuH(c, pos, Const0, Const1, Const2, Const3);
     #if SAMPLE_HDR_OUTPUT
       c *= c;
     #endif
-    OutputTexture[pos] = AH4(c, 1);
+    StoreOutput(pos, AH4(c, 1));
   #endif
 #endif
 #if SAMPLE_RCAS
   #if SAMPLE_SLOW_FALLBACK
     AF3 c;
-    FsrRcasF(c.r, c.g, c.b, pos, Const4);
+    FsrRcasF(c.r, c.g, c.b, pos, TileFoveated ? Const4 : Const5);
     #if SAMPLE_HDR_OUTPUT
       c *= c;
     #endif
-    OutputTexture[pos] = float4(c, 1);
+    StoreOutput(pos, float4(c, 1));
   #else
     AH3 c;
-    FsrRcasH(c.r, c.g, c.b, pos, Const4);
+    FsrRcasH(c.r, c.g, c.b, pos, TileFoveated ? Const4 : Const5);
     #if SAMPLE_HDR_OUTPUT
       c *= c;
     #endif
-    OutputTexture[pos] = AH4(c, 1);
+    StoreOutput(pos, AH4(c, 1));
   #endif
 #endif
 }
@@ -119,6 +247,12 @@ void CurrFilter(int2 pos)
 [numthreads(FSR_THREAD_GROUP_SIZE, 1, 1)]
 void mainCS(uint3 LocalThreadId : SV_GroupThreadID, uint3 WorkGroupId : SV_GroupID, uint3 Dtid : SV_DispatchThreadID)
 {
+  Slice = WorkGroupId.z;
+
+  // The decision is uniform across the group, so the branches do not diverge. The RCAS pass makes the same decision as
+  // the EASU pass for each tile.
+  TileFoveated = IsTileFoveated(int2(WorkGroupId.xy << 4u), int2(WorkGroupId.xy << 4u) + 16, GetOutputSize());
+
   // Do remapping of local xy in workgroup for a more PS-like swizzle pattern.
   AU2 gxy = ARmp8x8(LocalThreadId.x) + AU2(WorkGroupId.x << 4u, WorkGroupId.y << 4u);
   CurrFilter(gxy);
@@ -130,4 +264,64 @@ void mainCS(uint3 LocalThreadId : SV_GroupThreadID, uint3 WorkGroupId : SV_Group
   CurrFilter(gxy);
 }
 
+#if SAMPLE_FUSED
+void FusedFilter(AU2 pos)
+{
+  AF3 c;
+  FsrRcasF(c.r, c.g, c.b, pos, TileFoveated ? Const4 : Const5);
+  c *= c;
+  #if SAMPLE_POST_PROCESS == 1
+    c = PassThrough(c);
+  #elif SAMPLE_POST_PROCESS == 2
+    c = PostProcess(c);
+  #endif
+  if (OutputFlags.x) {
+    // What the hardware does when writing to a sRGB render target.
+    c = saturate(c);
+    c = c <= 0.0031308 ? c * 12.92 : 1.055 * pow(c, 1.0 / 2.4) - 0.055;
+  }
+  StoreOutput(pos, float4(c, 1));
+}
+
+[numthreads(FSR_THREAD_GROUP_SIZE, 1, 1)]
+void mainFusedCS(uint3 LocalThreadId : SV_GroupThreadID, uint3 WorkGroupId : SV_GroupID)
+{
+  Slice = WorkGroupId.z;
+
+  const uint2 outputSize = GetOutputSize();
+  FusedTileOrigin = int2(WorkGroupId.xy << 4u) - 1;
+
+  // The decision is uniform across the group, so the branch below does not diverge.
+  TileFoveated = IsTileFoveated(FusedTileOrigin + 1, FusedTileOrigin + 1 + 16, outputSize);
+
+  // EASU, including the border needed by RCAS. The pixels outside of the image replicate the edges. Outside of the
+  // foveated region, bilinear filtering replaces EASU.
+  for (uint i = LocalThreadId.x; i < FUSED_TILE_STRIDE * FUSED_TILE_STRIDE; i += FSR_THREAD_GROUP_SIZE) {
+    const int2 pos = clamp(FusedTileOrigin + int2(i % FUSED_TILE_STRIDE, i / FUSED_TILE_STRIDE),
+                           0, int2(outputSize) - 1);
+    AF3 c;
+    if (TileFoveated) {
+      FsrEasuF(c, AU2(pos), Const0, Const1, Const2, Const3);
+    } else {
+      const AF2 pp = (AF2(pos) * AF2_AU2(Const0.xy) + AF2_AU2(Const0.zw)) * AF2_AU2(Const1.xy) +
+                     AF2(0.5, -0.5) * AF2_AU2(Const1.zw);
+      c = SampleInput(pp).rgb;
+    }
+
+    // Like the separate path, RCAS works on the square root of the (saturated) EASU output.
+    FusedTile[i] = sqrt(saturate(c));
+  }
+  GroupMemoryBarrierWithGroupSync();
+
+  AU2 gxy = ARmp8x8(LocalThreadId.x) + AU2(WorkGroupId.x << 4u, WorkGroupId.y << 4u);
+  FusedFilter(gxy);
+  gxy.x += 8u;
+  FusedFilter(gxy);
+  gxy.y += 8u;
+  FusedFilter(gxy);
+  gxy.x -= 8u;
+  FusedFilter(gxy);
+}
+#endif
+
 // clang-format on
@@ -39,11 +39,6 @@ namespace {
     using namespace toolkit::graphics;
     using namespace toolkit::log;
 
-    struct CASConstants {
-        uint32_t Const0[4];
-        uint32_t Const1[4];
-    };
-
     class CASUpscaler : public IImageProcessor {
       public:
         CASUpscaler(std::shared_ptr<IConfigManager> configManager,
@@ -56,10 +51,13 @@ namespace {
         }
 
         void reload() override {
-            initializeUpscaler();
+            // The current shader is used until the new one is compiled.
+            createShaders();
         }
 
         void update() override {
+            utilities::shader::ResolveAsync(m_pendingShaderCAS, m_shaderCAS);
+            utilities::shader::ResolveAsync(m_pendingShaderCASStereo, m_shaderCASStereo);
         }
 
         void process(std::shared_ptr<ITexture> input,
@@ -67,15 +65,58 @@ namespace {
                      std::vector<std::shared_ptr<ITexture>>& textures,
                      std::array<uint8_t, 1024>& blob,
                      std::optional<utilities::Eye> eye = std::nullopt) override {
+            processInternal(input, output, blob);
+        }
+
+        bool getFusedPostProcess(FusedPostProcess& postProcess,
+                                 std::optional<utilities::Eye> eye = std::nullopt) const override {
+            return false;
+        }
+
+        bool processFused(std::shared_ptr<ITexture> input,
+                          std::shared_ptr<ITexture> output,
+                          std::vector<std::shared_ptr<ITexture>>& textures,
+                          std::array<uint8_t, 1024>& blob,
+                          const FusedPostProcess& postProcess,
+                          std::optional<utilities::Eye> eye = std::nullopt) override {
+            return false;
+        }
+
+        void setFoveation(const std::optional<Foveation>& foveation, utilities::Eye eye) override {
+        }
+
+        bool isStereoSupported() const override {
+            // The stereo shader is not waited for, the per-eye path is used until it is ready.
+            return !!m_shaderCASStereo;
+        }
+
+        void processStereo(std::shared_ptr<ITexture> input,
+                           const StereoViews& inputViews,
+                           std::shared_ptr<ITexture> output,
+                           const StereoViews& outputViews,
+                           std::vector<std::shared_ptr<ITexture>>& textures,
+                           std::array<uint8_t, 1024>& blob) override {
+            processInternal(input, output, blob, &inputViews, &outputViews);
+        }
+
+      private:
+        // In stereo, the views locate both eyes in the input and the output.
+        void processInternal(std::shared_ptr<ITexture> input,
+                             std::shared_ptr<ITexture> output,
+                             std::array<uint8_t, 1024>& blob,
+                             const StereoViews* inputViews = nullptr,
+                             const StereoViews* outputViews = nullptr) {
             // We need to use a per-instance blob.
             static_assert(sizeof(CASConstants) <= 1024);
             CASConstants* const config = reinterpret_cast<CASConstants*>(blob.data());
 
-            // Update the scaler's configuration specifically for this image.
-            const auto inputWidth = input->getInfo().width;
-            const auto inputHeight = input->getInfo().height;
-            const auto outputWidth = output->getInfo().width;
-            const auto outputHeight = output->getInfo().height;
+            // Update the scaler's configuration specifically for this image. In stereo, the shader addresses the region
+            // of each eye like a whole texture.
+            const bool isStereo = inputViews && outputViews;
+            const auto inputWidth = isStereo ? (uint32_t)inputViews->extent.width : input->getInfo().width;
+            const auto inputHeight = isStereo ? (uint32_t)inputViews->extent.height : input->getInfo().height;
+            const auto outputWidth = isStereo ? (uint32_t)outputViews->extent.width : output->getInfo().width;
+            const auto outputHeight = isStereo ? (uint32_t)outputViews->extent.height : output->getInfo().height;
             const float sharpness = m_configManager->getValue(SettingSharpness) / 100.f;
 
             CasSetup(config->Const0,
@@ -94,18 +135,34 @@ namespace {
             const std::array<unsigned int, 3> threadGroups = {
                 (outputWidth + (threadGroupWorkRegionDim - 1)) / threadGroupWorkRegionDim,  // dispatchX
                 (outputHeight + (threadGroupWorkRegionDim - 1)) / threadGroupWorkRegionDim, // dispatchY
-                1};
+                isStereo ? utilities::ViewCount : 1};                                       // one slice per eye
 
-            m_shaderCAS->updateThreadGroups(threadGroups);
-            m_device->setShader(m_shaderCAS, SamplerType::LinearClamp);
+            const auto& shader = isStereo ? m_shaderCASStereo : m_shaderCAS;
+            shader->updateThreadGroups(threadGroups);
+            m_device->setShader(shader, SamplerType::LinearClamp);
             m_device->setShaderInput(0, m_configBuffer);
-            m_device->setShaderInput(0, input);
-            m_device->setShaderOutput(0, output);
+            if (isStereo) {
+                const auto stereo = MakeStereoConstants(*inputViews, *outputViews);
+                m_stereoBuffer->uploadData(&stereo, sizeof(stereo));
+                m_device->setShaderInput(1, m_stereoBuffer);
+                m_device->setShaderInput(0, input, AllSlices);
+                m_device->setShaderOutput(0, output, AllSlices);
+            } else {
+                m_device->setShaderInput(0, input);
+                m_device->setShaderOutput(0, output);
+            }
             m_device->dispatchShader();
         }
 
-      private:
         void initializeUpscaler() {
+            createShaders();
+            utilities::shader::ResolveAsync(m_pendingShaderCAS, m_shaderCAS, true /* wait */);
+
+            m_configBuffer = m_device->createBuffer(sizeof(CASConstants), "CAS Constants CB");
+            m_stereoBuffer = m_device->createBuffer(sizeof(StereoConstants), "CAS Stereo CB");
+        }
+
+        void createShaders() {
             const auto shadersDir = dllHome / "shaders";
             const auto shaderFile = shadersDir / "CAS.hlsl";
 
@@ -113,9 +170,11 @@ namespace {
             defines.add("CAS_THREAD_GROUP_SIZE", 64);
             defines.add("CAS_SAMPLE_FP16", 0);
             defines.add("CAS_SAMPLE_SHARPEN_ONLY", m_isSharpenOnly ? 1 : 0);
-            m_shaderCAS = m_device->createComputeShader(shaderFile, "mainCS", "CAS CS", {}, defines.get());
+            m_pendingShaderCAS = m_device->createComputeShaderAsync(shaderFile, "mainCS", "CAS CS", {}, defines.get());
 
-            m_configBuffer = m_device->createBuffer(sizeof(CASConstants), "CAS Constants CB");
+            defines.add("CAS_SAMPLE_STEREO", 1);
+            m_pendingShaderCASStereo =
+                m_device->createComputeShaderAsync(shaderFile, "mainCS", "CAS Stereo CS", {}, defines.get());
         }
 
         const std::shared_ptr<IConfigManager> m_configManager;
@@ -123,7 +182,11 @@ namespace {
         const bool m_isSharpenOnly;
 
         std::shared_ptr<IComputeShader> m_shaderCAS;
+        std::shared_future<std::shared_ptr<IComputeShader>> m_pendingShaderCAS;
+        std::shared_ptr<IComputeShader> m_shaderCASStereo;
+        std::shared_future<std::shared_ptr<IComputeShader>> m_pendingShaderCASStereo;
         std::shared_ptr<IShaderBuffer> m_configBuffer;
+        std::shared_ptr<IShaderBuffer> m_stereoBuffer;
     };
 
 } // namespace
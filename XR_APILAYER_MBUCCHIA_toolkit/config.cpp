@@ -36,75 +36,185 @@ namespace {
 
     constexpr unsigned int WriteDelay = 22; // 1s in bad VR.
 
+    constexpr std::string_view SettingNames[] = {
+#define DECLARE_SETTING_NAME(id, name) name,
+        TOOLKIT_CONFIG_SETTINGS(DECLARE_SETTING_NAME)
+#undef DECLARE_SETTING_NAME
+    };
+    static_assert(std::size(SettingNames) == to_integral(SettingId::MaxValue));
+
+    // The groups of settings that consumers can watch with a single check.
+    const std::pair<SettingGroup, std::vector<Setting>> SettingGroups[] = {
+        {SettingGroup::PostProcess,
+         {SettingPostProcess,
+          SettingPostSunGlasses,
+          SettingPostContrast,
+          SettingPostBrightness,
+          SettingPostExposure,
+          SettingPostSaturation,
+          SettingPostVibrance,
+          SettingPostColorGainR,
+          SettingPostColorGainG,
+          SettingPostColorGainB,
+          SettingPostHighlights,
+          SettingPostShadows,
+          SettingPostChromaticCorrectionR,
+          SettingPostChromaticCorrectionB}},
+        {SettingGroup::VRS,
+         {SettingVRS,
+          SettingVRSQuality,
+          SettingVRSPattern,
+          SettingVRSOuter,
+          SettingVRSOuterRadius,
+          SettingVRSMiddle,
+          SettingVRSInnerRadius,
+          SettingVRSInner,
+          SettingVRSXOffset,
+          SettingVRSXScale,
+          SettingVRSYOffset,
+          SettingVRSPreferHorizontal,
+          SettingVRSLeftRightBias,
+          SettingVRSScaleFilter,
+          SettingVRSCullHAM}},
+        {SettingGroup::FOV,
+         {SettingICD,
+          SettingFOVType,
+          SettingFOV,
+          SettingFOVUp,
+          SettingFOVDown,
+          SettingFOVLeftLeft,
+          SettingFOVLeftRight,
+          SettingFOVRightLeft,
+          SettingFOVRightRight,
+          SettingZoom}},
+        {SettingGroup::Hands,
+         {SettingHandTrackingEnabled, SettingHandVisibilityAndSkinTone, SettingHandOcclusion, SettingHandTimeout}},
+    };
+
     struct ConfigValue {
-        int value;
+        int value{0};
         int defaultValue{0};
 
+        // Whether the value was read from (or written to) the config database at least once.
+        bool isLoaded{false};
+
         bool changedSinceLastQuery{false};
         unsigned int writeCountdown{0};
+
+        SettingGroup group{SettingGroup::MaxValue};
     };
 
-    // A very simple registry/DWORD backed configuration manager.
-    // Handles deferred writes (to only commit values after a few game loops completed).
+    // A very simple DWORD-based configuration manager, on top of a backing storage (registry or file).
+    // Handles deferred writes (to only commit values after a few game loops completed). The writes are then committed
+    // to the backing storage from a background thread, to avoid blocking the game loop.
+    // Settings from the registry are stored in a flat table indexed by their handle. Other settings (dynamically named
+    // or legacy keys) use a slower name-based lookup.
+    // Only the values with a pending write are visited upon tick(), and changes are tracked with generation counters
+    // (globally and per group of settings).
+    // Threads other than the frame thread must use the published snapshots. Snapshots are rotated through a small
+    // ring, and each slot is protected by a sequence lock: readers copy the slot and retry if it was rewritten during
+    // the copy (which only happens if a reader is preempted for a couple of frames).
     class ConfigManager : public IConfigManager {
       public:
-        ConfigManager(const std::string& appName) : m_appName(appName) {
+        ConfigManager(const std::string& appName, std::shared_ptr<IConfigStore> store)
+            : m_appName(appName), m_store(store) {
             // Check for safe mode.
-            m_safeMode = RegGetDword(HKEY_LOCAL_MACHINE, xr::utf8_to_wide(RegPrefix), L"safe_mode").value_or(0);
-            m_developer = RegGetDword(HKEY_LOCAL_MACHINE, xr::utf8_to_wide(RegPrefix), L"developer").value_or(0);
-
-            std::string baseKey = RegPrefix + "\\" + appName;
-            m_baseKey = xr::utf8_to_wide(baseKey);
+            m_safeMode = m_store->readGlobal("safe_mode").value_or(0);
+            m_developer = m_store->readGlobal("developer").value_or(0);
 
-            try {
-                m_watcher = wil::make_registry_watcher(
-                    HKEY_CURRENT_USER, m_baseKey.c_str(), true, [&](wil::RegistryChangeKind changeType) {
-                        // TODO: Every call to writeValue() will also cause us to invoke this (unnecessarily).
-                        m_needRefresh = true;
-                    });
-            } catch (std::exception&) {
-                // Ignore errors that can happen with UWP applications not able to write to the registry.
+            for (const auto& [group, settings] : SettingGroups) {
+                for (const auto& setting : settings) {
+                    getEntry(setting).group = group;
+                }
             }
+
+            m_store->watch([&] { m_needRefresh = true; });
+
+            // Readers might query a snapshot before the first frame.
+            publishSnapshot();
+
+            m_writerThread = std::thread([&] { writerThread(); });
         }
 
         ~ConfigManager() override {
-            // Log all unwritten values.
-            for (auto& value : m_values) {
-                ConfigValue& entry = value.second;
+            // Commit all the pending writes before exiting.
+            {
+                std::unique_lock lock(m_writerMutex);
+                m_stopWriter = true;
+            }
+            m_writerWakeup.notify_one();
+            m_writerThread.join();
 
+            // Log all unwritten values.
+            const auto logDiscarded = [](std::string_view name, const ConfigValue& entry) {
                 if (entry.writeCountdown > 0) {
                     Log("Config value '%s' was discarded due to quickly exiting after changing its value\n",
-                        value.first.c_str());
+                        std::string(name).c_str());
                 }
+            };
+
+            for (size_t i = 0; i < m_settings.size(); i++) {
+                logDiscarded(SettingNames[i], m_settings[i]);
+            }
+            for (auto& value : m_values) {
+                logDiscarded(value.first, value.second);
             }
         }
 
         void tick() override {
             const bool m_wasNeedRefresh = m_needRefresh;
+            if (m_wasNeedRefresh && !m_safeMode) {
+                m_store->reload();
 
-            for (auto& value : m_values) {
-                const std::string& name = value.first;
-                ConfigValue& entry = value.second;
+                // Values that were not loaded yet might have changed too.
+                m_generation++;
 
-                if (m_wasNeedRefresh && !m_ignoreRefresh.count(name)) {
-                    refreshValue(name, entry);
+                // Don't refresh the values that are not committed yet, including the batch being written.
+                std::unique_lock lock(m_writerMutex);
+                for (const auto& write : m_pendingWrites) {
+                    m_ignoreRefresh.insert(write.first);
                 }
+                for (const auto& name : m_inflightWrites) {
+                    m_ignoreRefresh.insert(name);
+                }
+            }
 
-                if (entry.writeCountdown > 0) {
-                    entry.writeCountdown--;
-
-                    if (entry.writeCountdown == 0) {
-                        writeValue(name, entry);
-
-                        // Delete any backup created by the companion tool. This is to avoid bad statefulness.
-                        deleteValue(name + "_bak");
-
-                        // Don't refresh this value, since we just wrote it!
-                        m_ignoreRefresh.insert(name);
+            if (m_wasNeedRefresh) {
+                // Refreshing is the only operation that requires to look at all the values.
+                for (size_t i = 0; i < m_settings.size(); i++) {
+                    if (m_settings[i].isLoaded && !m_ignoreRefresh.count(SettingNames[i])) {
+                        refreshValue(SettingNames[i], m_settings[i]);
+                    }
+                }
+                for (auto& value : m_values) {
+                    if (value.second.isLoaded && !m_ignoreRefresh.count(value.first)) {
+                        refreshValue(value.first, value.second);
                     }
                 }
             }
 
+            // Count down the values with a pending write.
+            for (auto it = m_pendingCommits.begin(); it != m_pendingCommits.end();) {
+                const auto index = to_integral(*it);
+                if (!tickCommit(SettingNames[index], m_settings[index])) {
+                    m_isPendingCommit.reset(index);
+                    it = m_pendingCommits.erase(it);
+                } else {
+                    it++;
+                }
+            }
+            for (auto it = m_pendingValueCommits.begin(); it != m_pendingValueCommits.end();) {
+                const auto entry = m_values.find(*it);
+                if (entry == m_values.end() || !tickCommit(entry->first, entry->second)) {
+                    it = m_pendingValueCommits.erase(it);
+                } else {
+                    it++;
+                }
+            }
+
+            // Commit all the writes from this tick at once.
+            submitWrites();
+
             // Only clear the need for refresh if the whole tick update saw the changes.
             m_needRefresh = m_wasNeedRefresh != m_needRefresh;
             if (!m_needRefresh) {
@@ -113,81 +223,94 @@ namespace {
         }
 
         void setActiveSession(const std::string& appName) override {
-            RegSetString(HKEY_CURRENT_USER, xr::utf8_to_wide(RegPrefix), L"running", appName);
+            m_store->setActiveSession(appName);
         }
 
-        void setDefault(const std::string& name, int value) override {
-            auto it = m_values.find(name);
+        void setDefault(Setting setting, int value) override {
+            setDefault(setting.name, getEntry(setting), value);
+        }
 
-            if (it != m_values.end()) {
-                Log("Config value '%s' is assigned a default after being used\n", name.c_str());
-            }
+        int getValue(Setting setting) const override {
+            return getValue(setting.name, getEntry(setting));
+        }
 
-            ConfigValue newEntry;
-            ConfigValue& entry = it != m_values.end() ? it->second : newEntry;
-            entry.defaultValue = value;
-            if (it == m_values.end()) {
-                readValue(name, entry);
-                m_values.insert_or_assign(name, entry);
+        int peekValue(Setting setting) const override {
+            return peekValue(setting.name, getEntry(setting));
+        }
+
+        void setValue(Setting setting, int value, bool noCommitDelay) override {
+            setValue(getEntry(setting), value, noCommitDelay);
+
+            const auto index = to_integral(setting.id);
+            if (!m_isPendingCommit.test(index)) {
+                m_isPendingCommit.set(index);
+                m_pendingCommits.push_back(setting.id);
             }
         }
 
-        int getValue(const std::string& name) const override {
-            auto it = m_values.find(name);
+        bool hasChanged(Setting setting) const override {
+            const ConfigValue& entry = getEntry(setting);
+            return entry.isLoaded && entry.changedSinceLastQuery;
+        }
 
-            ConfigValue newEntry;
-            ConfigValue& entry = it != m_values.end() ? it->second : newEntry;
-            if (it != m_values.end()) {
-                entry.changedSinceLastQuery = false;
+        void setDefault(const std::string& name, int value) override {
+            if (const auto setting = FindSetting(name)) {
+                setDefault(*setting, value);
             } else {
-                readValue(name, entry);
-                m_values.insert_or_assign(name, entry);
+                setDefault(name, m_values[name], value);
             }
+        }
 
-            return entry.value;
+        int getValue(const std::string& name) const override {
+            if (const auto setting = FindSetting(name)) {
+                return getValue(*setting);
+            }
+            return getValue(name, m_values[name]);
         }
 
         int peekValue(const std::string& name) const override {
-            auto it = m_values.find(name);
-
-            ConfigValue newEntry;
-            ConfigValue& entry = it != m_values.end() ? it->second : newEntry;
-            if (it == m_values.end()) {
-                readValue(name, entry);
-                m_values.insert_or_assign(name, entry);
+            if (const auto setting = FindSetting(name)) {
+                return peekValue(*setting);
             }
-
-            return entry.value;
+            return peekValue(name, m_values[name]);
         }
 
         void setValue(const std::string& name, int value, bool noCommitDelay) override {
-            auto it = m_values.find(name);
-
-            ConfigValue newEntry;
-            ConfigValue& entry = it != m_values.end() ? it->second : newEntry;
-            entry.value = value;
-            entry.changedSinceLastQuery = true;
-            entry.writeCountdown = noCommitDelay ? 1 : WriteDelay;
-            if (it == m_values.end()) {
-                m_values.insert_or_assign(name, entry);
+            if (const auto setting = FindSetting(name)) {
+                setValue(*setting, value, noCommitDelay);
+            } else {
+                setValue(m_values[name], value, noCommitDelay);
+                m_pendingValueCommits.insert(name);
             }
         }
 
         bool hasChanged(const std::string& name) const override {
-            auto it = m_values.find(name);
+            if (const auto setting = FindSetting(name)) {
+                return hasChanged(*setting);
+            }
 
+            auto it = m_values.find(name);
             if (it != m_values.end()) {
-                ConfigValue& entry = it->second;
+                const ConfigValue& entry = it->second;
 
-                return entry.changedSinceLastQuery;
+                return entry.isLoaded && entry.changedSinceLastQuery;
             }
 
             return false;
         }
 
         void deleteValue(const std::string& name) override {
-            RegDeleteValue(HKEY_CURRENT_USER, m_baseKey, xr::utf8_to_wide(name));
-            m_values.erase(name);
+            m_queuedWrites.insert_or_assign(name, std::nullopt);
+            submitWrites();
+
+            if (const auto setting = FindSetting(name)) {
+                auto& entry = getEntry(*setting);
+                const auto group = entry.group;
+                entry = {};
+                entry.group = group;
+            } else {
+                m_values.erase(name);
+            }
         }
 
         void resetToDefaults() override {
@@ -202,80 +325,345 @@ namespace {
             return m_developer;
         }
 
+        uint64_t getGeneration() const override {
+            return m_generation;
+        }
+
+        uint64_t getGeneration(SettingGroup group) const override {
+            return m_groupGenerations[to_integral(group)];
+        }
+
+        void publishSnapshot() override {
+            if (m_publishedGeneration == m_generation) {
+                return;
+            }
+            m_publishedGeneration = m_generation;
+
+            const size_t index = m_nextSnapshot;
+            m_nextSnapshot = (m_nextSnapshot + 1) % m_snapshots.size();
+
+            // An odd sequence number marks the slot as being written.
+            SnapshotSlot& slot = m_snapshots[index];
+            const uint32_t sequence = slot.sequence.load(std::memory_order_relaxed);
+            slot.sequence.store(sequence + 1, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_release);
+
+            slot.generation.store(m_generation, std::memory_order_relaxed);
+            for (size_t i = 0; i < m_settings.size(); i++) {
+                slot.values[i].store(resolveValue(SettingNames[i], m_settings[i]), std::memory_order_relaxed);
+            }
+
+            slot.sequence.store(sequence + 2, std::memory_order_release);
+            m_publishedSnapshot.store(index, std::memory_order_release);
+        }
+
+        ConfigSnapshot getSnapshot() const override {
+            ConfigSnapshot snapshot;
+            while (true) {
+                const size_t index = m_publishedSnapshot.load(std::memory_order_acquire);
+                const SnapshotSlot& slot = m_snapshots[index];
+
+                const uint32_t sequence = slot.sequence.load(std::memory_order_acquire);
+                if (sequence & 1) {
+                    continue;
+                }
+
+                snapshot.generation = slot.generation.load(std::memory_order_relaxed);
+                for (size_t i = 0; i < snapshot.values.size(); i++) {
+                    snapshot.values[i] = slot.values[i].load(std::memory_order_relaxed);
+                }
+
+                // The slot may also have been fully rewritten with a snapshot that is not published yet. Returning
+                // it would let the next call go back to the (older) published snapshot.
+                std::atomic_thread_fence(std::memory_order_acquire);
+                if (slot.sequence.load(std::memory_order_relaxed) == sequence &&
+                    m_publishedSnapshot.load(std::memory_order_relaxed) == index) {
+                    return snapshot;
+                }
+            }
+        }
+
         void hardReset() override {
-            RegDeleteKey(HKEY_CURRENT_USER, m_baseKey);
-            for (auto& value : m_values) {
-                ConfigValue& entry = value.second;
+            // Drop all the pending writes, they must not be committed after the reset.
+            m_queuedWrites.clear();
+            {
+                std::unique_lock lock(m_writerMutex);
+                m_pendingWrites.clear();
+                m_pendingReset = true;
+            }
+            m_writerWakeup.notify_one();
 
-                entry.value = entry.defaultValue;
-                entry.changedSinceLastQuery = true;
-                entry.writeCountdown = 0;
+            const auto resetValue = [&](ConfigValue& entry) {
+                if (entry.isLoaded) {
+                    entry.value = entry.defaultValue;
+                    entry.writeCountdown = 0;
+                    markChanged(entry);
+                }
+            };
+
+            for (auto& entry : m_settings) {
+                resetValue(entry);
             }
+            for (auto& value : m_values) {
+                resetValue(value.second);
+            }
+
+            m_isPendingCommit.reset();
+            m_pendingCommits.clear();
+            m_pendingValueCommits.clear();
         }
 
       private:
-        std::optional<int> readRegistry(const std::string& name) const {
-            auto value = RegGetDword(HKEY_CURRENT_USER, m_baseKey, xr::utf8_to_wide(name));
-            if (!value) {
-                // Fallback to HKLM for global options.
-                value = RegGetDword(HKEY_LOCAL_MACHINE, xr::utf8_to_wide(RegPrefix), xr::utf8_to_wide(name));
+        ConfigValue& getEntry(Setting setting) const {
+            assert(setting.isValid());
+            return m_settings[to_integral(setting.id)];
+        }
+
+        void setDefault(std::string_view name, ConfigValue& entry, int value) {
+            if (entry.isLoaded) {
+                Log("Config value '%s' is assigned a default after being used\n", std::string(name).c_str());
+            }
+
+            entry.defaultValue = value;
+            if (!entry.isLoaded) {
+                readValue(name, entry);
+            }
+        }
+
+        int getValue(std::string_view name, ConfigValue& entry) const {
+            if (entry.isLoaded) {
+                entry.changedSinceLastQuery = false;
+            } else {
+                readValue(name, entry);
             }
-            return value;
+
+            return entry.value;
+        }
+
+        int peekValue(std::string_view name, ConfigValue& entry) const {
+            if (!entry.isLoaded) {
+                readValue(name, entry);
+            }
+
+            return entry.value;
+        }
+
+        void setValue(ConfigValue& entry, int value, bool noCommitDelay) {
+            entry.value = value;
+            entry.isLoaded = true;
+            entry.writeCountdown = noCommitDelay ? 1 : WriteDelay;
+            markChanged(entry);
         }
 
-        void readValue(const std::string& name, ConfigValue& entry) const {
+        // Same as peekValue(), but without loading the value.
+        int resolveValue(std::string_view name, const ConfigValue& entry) const {
+            if (entry.isLoaded) {
+                return entry.value;
+            }
+            if (m_safeMode) {
+                return entry.defaultValue;
+            }
+            return m_store->read(name).value_or(entry.defaultValue);
+        }
+
+        void markChanged(ConfigValue& entry) const {
+            entry.changedSinceLastQuery = true;
+
+            m_generation++;
+            if (entry.group != SettingGroup::MaxValue) {
+                m_groupGenerations[to_integral(entry.group)]++;
+            }
+        }
+
+        // Returns whether the write is still pending.
+        bool tickCommit(std::string_view name, ConfigValue& entry) {
+            // The write might have been cancelled.
+            if (entry.writeCountdown == 0) {
+                return false;
+            }
+
+            entry.writeCountdown--;
+            if (entry.writeCountdown > 0) {
+                return true;
+            }
+
+            writeValue(name, entry);
+
+            // Delete any backup created by the companion tool. This is to avoid bad statefulness.
+            m_queuedWrites.insert_or_assign(std::string(name) + "_bak", std::nullopt);
+
+            // Don't refresh this value, since we just wrote it!
+            m_ignoreRefresh.insert(std::string(name));
+
+            return false;
+        }
+
+        void readValue(std::string_view name, ConfigValue& entry) const {
+            entry.isLoaded = true;
+
             if (m_safeMode) {
                 entry.value = entry.defaultValue;
-                entry.changedSinceLastQuery = true;
+                markChanged(entry);
                 return;
             }
 
-            const auto value = readRegistry(name);
+            const auto value = m_store->read(name);
             entry.value = value.value_or(entry.defaultValue);
-            entry.changedSinceLastQuery = true;
+            markChanged(entry);
 
-            TraceLoggingWrite(
-                g_traceProvider, "Config_ReadValue", TLArg(name.c_str(), "Name"), TLArg(entry.value, "Value"));
+            TraceLoggingWrite(g_traceProvider,
+                              "Config_ReadValue",
+                              TLArg(std::string(name).c_str(), "Name"),
+                              TLArg(entry.value, "Value"));
         }
 
-        void refreshValue(const std::string& name, ConfigValue& entry) const {
+        void refreshValue(std::string_view name, ConfigValue& entry) const {
             if (m_safeMode) {
                 return;
             }
 
-            const auto value = readRegistry(name);
+            const auto value = m_store->read(name);
             if (value && entry.value != value.value_or(entry.defaultValue)) {
                 entry.value = value.value_or(entry.defaultValue);
-                entry.changedSinceLastQuery = true;
+                markChanged(entry);
 
                 // Cancel pending writes.
                 entry.writeCountdown = 0;
             }
         }
 
-        void writeValue(const std::string& name, ConfigValue& entry) const {
-            TraceLoggingWrite(
-                g_traceProvider, "Config_WriteValue", TLArg(name.c_str(), "Name"), TLArg(entry.value, "Value"));
-            RegSetDword(HKEY_CURRENT_USER, m_baseKey, xr::utf8_to_wide(name), entry.value);
+        void writeValue(std::string_view name, ConfigValue& entry) {
+            TraceLoggingWrite(g_traceProvider,
+                              "Config_WriteValue",
+                              TLArg(std::string(name).c_str(), "Name"),
+                              TLArg(entry.value, "Value"));
+            m_queuedWrites.insert_or_assign(std::string(name), entry.value);
+        }
+
+        // Hand over the writes queued by the game loop to the writer thread. Successive writes to the same value are
+        // coalesced.
+        void submitWrites() {
+            if (m_queuedWrites.empty()) {
+                return;
+            }
+
+            {
+                std::unique_lock lock(m_writerMutex);
+                for (auto& write : m_queuedWrites) {
+                    m_pendingWrites.insert_or_assign(write.first, write.second);
+                }
+            }
+            m_queuedWrites.clear();
+            m_writerWakeup.notify_one();
+        }
+
+        void writerThread() {
+            std::unique_lock lock(m_writerMutex);
+            while (true) {
+                m_writerWakeup.wait(lock, [&] { return m_stopWriter || m_pendingReset || !m_pendingWrites.empty(); });
+                if (!m_pendingReset && m_pendingWrites.empty()) {
+                    break;
+                }
+
+                const bool reset = std::exchange(m_pendingReset, false);
+                const auto writes = std::exchange(m_pendingWrites, {});
+                for (const auto& write : writes) {
+                    m_inflightWrites.insert(write.first);
+                }
+                lock.unlock();
+
+                TraceLoggingWrite(g_traceProvider,
+                                  "Config_Commit",
+                                  TLArg(reset, "Reset"),
+                                  TLArg((uint32_t)writes.size(), "Count"));
+
+                // All the writes are committed as one batch.
+                if (reset) {
+                    m_store->removeAll();
+                }
+                for (const auto& [name, value] : writes) {
+                    if (value) {
+                        m_store->write(name, value.value());
+                    } else {
+                        m_store->remove(name);
+                    }
+                }
+                m_store->flush();
+
+                // The values can be refreshed from the backing storage again.
+                lock.lock();
+                m_inflightWrites.clear();
+            }
         }
 
         const std::string m_appName;
-        std::wstring m_baseKey;
+        const std::shared_ptr<IConfigStore> m_store;
         bool m_safeMode;
         bool m_developer;
-        wil::unique_registry_watcher m_watcher;
-        bool m_needRefresh{false};
-        std::set<std::string> m_ignoreRefresh;
+        std::atomic<bool> m_needRefresh{false};
+        std::set<std::string, std::less<>> m_ignoreRefresh;
 
+        mutable std::array<ConfigValue, to_integral(SettingId::MaxValue)> m_settings;
         mutable std::map<std::string, ConfigValue> m_values;
+
+        mutable uint64_t m_generation{1};
+        mutable std::array<uint64_t, to_integral(SettingGroup::MaxValue)> m_groupGenerations{};
+
+        // Snapshots for the other threads.
+        struct SnapshotSlot {
+            std::atomic<uint32_t> sequence{0};
+            std::atomic<uint64_t> generation{0};
+            std::array<std::atomic<int>, to_integral(SettingId::MaxValue)> values{};
+        };
+        std::array<SnapshotSlot, 3> m_snapshots;
+        size_t m_nextSnapshot{0};
+        uint64_t m_publishedGeneration{0};
+        std::atomic<size_t> m_publishedSnapshot{0};
+
+        // The values with a pending write.
+        std::bitset<to_integral(SettingId::MaxValue)> m_isPendingCommit;
+        std::vector<SettingId> m_pendingCommits;
+        std::set<std::string, std::less<>> m_pendingValueCommits;
+
+        // Writes from the game loop, not yet handed over to the writer thread. An empty value means deletion.
+        std::map<std::string, std::optional<int>> m_queuedWrites;
+
+        std::thread m_writerThread;
+        std::mutex m_writerMutex;
+        std::condition_variable m_writerWakeup;
+        std::map<std::string, std::optional<int>> m_pendingWrites;
+        std::set<std::string, std::less<>> m_inflightWrites;
+        bool m_pendingReset{false};
+        bool m_stopWriter{false};
     };
 
 } // namespace
 
 namespace toolkit::config {
 
+    std::optional<Setting> FindSetting(std::string_view name) {
+        static const std::map<std::string_view, Setting> settingsByName = [] {
+            std::map<std::string_view, Setting> settings;
+            for (uint32_t i = 0; i < to_integral(SettingId::MaxValue); i++) {
+                settings.insert_or_assign(SettingNames[i], Setting{static_cast<SettingId>(i), SettingNames[i]});
+            }
+            return settings;
+        }();
+
+        const auto it = settingsByName.find(name);
+        if (it != settingsByName.end()) {
+            return it->second;
+        }
+        return {};
+    }
+
     std::shared_ptr<IConfigManager> CreateConfigManager(const std::string& appName) {
-        return std::make_shared<ConfigManager>(appName);
+        return CreateConfigManager(appName, CreateConfigStore(appName));
+    }
+
+    std::shared_ptr<IConfigManager> CreateConfigManager(const std::string& appName,
+                                                        std::shared_ptr<IConfigStore> store) {
+        return std::make_shared<ConfigManager>(appName, store);
     }
 
 } // namespace toolkit::config
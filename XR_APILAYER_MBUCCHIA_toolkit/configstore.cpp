@@ -0,0 +1,457 @@
+// MIT License
+//
+// Copyright(c) 2021-2022 Matthieu Bucchianeri
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this softwareand associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright noticeand this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "pch.h"
+
+#include "factories.h"
+#include "interfaces.h"
+#include "layer.h"
+#include "log.h"
+
+namespace {
+
+    using namespace toolkit;
+    using namespace toolkit::config;
+    using namespace toolkit::log;
+    using namespace toolkit::utilities;
+
+    using ValueMap = std::map<std::string, int, std::less<>>;
+
+    std::optional<int> FindValue(const ValueMap& values, std::string_view name) {
+        const auto it = values.find(name);
+        if (it != values.end()) {
+            return it->second;
+        }
+        return {};
+    }
+
+    // A registry backed store. All the values for the application are read at once, with a fallback to the global
+    // key for the values not set for the application.
+    // The snapshot is protected by a lock, since the store is written to from the config writer thread.
+    class RegistryConfigStore : public IConfigStore {
+      public:
+        RegistryConfigStore(const std::string& appName)
+            : m_baseKey(xr::utf8_to_wide(RegPrefix + "\\" + appName)), m_globalKey(xr::utf8_to_wide(RegPrefix)) {
+            reload();
+        }
+
+        void reload() override {
+            auto values = RegGetDwords(HKEY_CURRENT_USER, m_baseKey);
+            auto globalValues = RegGetDwords(HKEY_LOCAL_MACHINE, m_globalKey);
+
+            std::unique_lock lock(m_mutex);
+            m_values = std::move(values);
+            m_globalValues = std::move(globalValues);
+        }
+
+        std::optional<int> read(std::string_view name) const override {
+            std::unique_lock lock(m_mutex);
+
+            auto value = FindValue(m_values, name);
+            if (!value) {
+                // Fallback to HKLM for global options.
+                value = FindValue(m_globalValues, name);
+            }
+            return value;
+        }
+
+        std::optional<int> readGlobal(std::string_view name) const override {
+            std::unique_lock lock(m_mutex);
+
+            return FindValue(m_globalValues, name);
+        }
+
+        std::map<std::string, int, std::less<>> readAll() const override {
+            std::unique_lock lock(m_mutex);
+
+            return m_values;
+        }
+
+        // The snapshot is updated before the registry, so that the watcher can tell our own modifications apart.
+        void write(std::string_view name, int value) override {
+            {
+                std::unique_lock lock(m_mutex);
+                m_values.insert_or_assign(std::string(name), value);
+            }
+            RegSetDword(HKEY_CURRENT_USER, m_baseKey, xr::utf8_to_wide(std::string(name)), value);
+        }
+
+        void remove(std::string_view name) override {
+            {
+                std::unique_lock lock(m_mutex);
+                const auto it = m_values.find(name);
+                if (it != m_values.end()) {
+                    m_values.erase(it);
+                }
+            }
+            RegDeleteValue(HKEY_CURRENT_USER, m_baseKey, xr::utf8_to_wide(std::string(name)));
+        }
+
+        void removeAll() override {
+            {
+                std::unique_lock lock(m_mutex);
+                m_values.clear();
+            }
+            RegDeleteKey(HKEY_CURRENT_USER, m_baseKey);
+        }
+
+        void flush() override {
+            // All writes are immediate.
+        }
+
+        void watch(std::function<void()> onChanged) override {
+            try {
+                m_watcher = wil::make_registry_watcher(
+                    HKEY_CURRENT_USER,
+                    m_baseKey.c_str(),
+                    true,
+                    [this, onChanged = std::move(onChanged)](wil::RegistryChangeKind changeType) {
+                        // Every write from this store also triggers the watcher. Only report modifications that
+                        // are not already reflected in the snapshot.
+                        const auto values = RegGetDwords(HKEY_CURRENT_USER, m_baseKey);
+                        {
+                            std::unique_lock lock(m_mutex);
+                            if (values == m_values) {
+                                return;
+                            }
+                        }
+                        onChanged();
+                    });
+            } catch (std::exception&) {
+                // Ignore errors that can happen with UWP applications not able to write to the registry.
+            }
+        }
+
+        void setActiveSession(const std::string& appName) override {
+            RegSetString(HKEY_CURRENT_USER, m_globalKey, L"running", appName);
+        }
+
+      private:
+        const std::wstring m_baseKey;
+        const std::wstring m_globalKey;
+
+        mutable std::mutex m_mutex;
+        ValueMap m_values;
+        ValueMap m_globalValues;
+
+        // Must be destroyed first, since the callback uses the snapshot.
+        wil::unique_registry_watcher m_watcher;
+    };
+
+    // A file backed store. The file is memory-mapped to load all the values at once, and it is rewritten entirely
+    // upon flush().
+    // The format is a header followed by a packed list of entries, each with a 32-bit value, a 16-bit name length
+    // and the (non null-terminated) name.
+    // The global options and the active session are still kept in the registry, through the fallback store. When there is
+    // no file yet, the values of the application are migrated from the fallback store.
+    // The snapshot is protected by a lock, since the store is written to from the config writer thread.
+    class FileConfigStore : public IConfigStore {
+        static constexpr uint32_t Magic = 0x4b545258; // 'XRTK'
+        static constexpr uint32_t Version = 1;
+
+        struct FileHeader {
+            uint32_t magic;
+            uint32_t version;
+            uint32_t count;
+        };
+
+      public:
+        FileConfigStore(const std::filesystem::path& path, std::shared_ptr<IConfigStore> fallback)
+            : m_path(path), m_fallback(fallback) {
+            reload();
+
+            // Write the migrated values right away, so that they are only migrated once.
+            flush();
+        }
+
+        void reload() override {
+            if (m_fallback) {
+                m_fallback->reload();
+            }
+
+            ValueMap values;
+            const bool exists = load(values);
+            bool migrated = false;
+            if (!exists && m_fallback) {
+                values = m_fallback->readAll();
+                migrated = !values.empty();
+                if (migrated) {
+                    Log("Migrating %u config values to '%s'\n", (uint32_t)values.size(), m_path.string().c_str());
+                }
+            }
+
+            std::unique_lock lock(m_mutex);
+            m_values = std::move(values);
+            m_dirty = migrated;
+        }
+
+        std::optional<int> read(std::string_view name) const override {
+            std::optional<int> value;
+            {
+                std::unique_lock lock(m_mutex);
+                value = FindValue(m_values, name);
+            }
+            if (!value) {
+                value = readGlobal(name);
+            }
+            return value;
+        }
+
+        std::optional<int> readGlobal(std::string_view name) const override {
+            return m_fallback ? m_fallback->readGlobal(name) : std::nullopt;
+        }
+
+        std::map<std::string, int, std::less<>> readAll() const override {
+            std::unique_lock lock(m_mutex);
+
+            return m_values;
+        }
+
+        void write(std::string_view name, int value) override {
+            std::unique_lock lock(m_mutex);
+
+            m_values.insert_or_assign(std::string(name), value);
+            m_dirty = true;
+        }
+
+        void remove(std::string_view name) override {
+            std::unique_lock lock(m_mutex);
+
+            const auto it = m_values.find(name);
+            if (it != m_values.end()) {
+                m_values.erase(it);
+                m_dirty = true;
+            }
+        }
+
+        void removeAll() override {
+            std::unique_lock lock(m_mutex);
+
+            m_values.clear();
+            m_dirty = true;
+        }
+
+        void flush() override {
+            // Serialize the flushes, so that an older snapshot never replaces a newer one.
+            std::unique_lock flushLock(m_flushMutex);
+
+            // Only the serialization is done under the lock. The file I/O must not block the readers.
+            std::vector<uint8_t> buffer;
+            {
+                std::unique_lock lock(m_mutex);
+
+                if (!m_dirty) {
+                    return;
+                }
+                m_dirty = false;
+
+                const auto append = [&buffer](const void* data, size_t size) {
+                    const auto bytes = reinterpret_cast<const uint8_t*>(data);
+                    buffer.insert(buffer.end(), bytes, bytes + size);
+                };
+
+                const FileHeader header{Magic, Version, static_cast<uint32_t>(m_values.size())};
+                append(&header, sizeof(header));
+                for (const auto& [name, value] : m_values) {
+                    const int32_t value32 = value;
+                    const uint16_t nameLength = static_cast<uint16_t>(std::min(name.size(), size_t(UINT16_MAX)));
+                    append(&value32, sizeof(value32));
+                    append(&nameLength, sizeof(nameLength));
+                    append(name.data(), nameLength);
+                }
+            }
+
+            if (!writeFile(buffer)) {
+                // Try again upon the next flush.
+                std::unique_lock lock(m_mutex);
+                m_dirty = true;
+            }
+        }
+
+        void watch(std::function<void()> onChanged) override {
+            try {
+                m_watcher = wil::make_folder_change_reader(
+                    m_path.parent_path().c_str(),
+                    false,
+                    wil::FolderChangeEvents::FileName | wil::FolderChangeEvents::LastWriteTime,
+                    [this, onChanged = std::move(onChanged)](wil::FolderChangeEvent, PCWSTR fileName) {
+                        if (_wcsicmp(fileName, m_path.filename().c_str())) {
+                            return;
+                        }
+
+                        // Every flush from this store also triggers the watcher. Only report modifications that
+                        // are not already reflected in the snapshot.
+                        ValueMap values;
+                        load(values);
+                        {
+                            std::unique_lock lock(m_mutex);
+                            if (values == m_values) {
+                                return;
+                            }
+                        }
+                        onChanged();
+                    });
+            } catch (std::exception& exc) {
+                Log("Failed to watch config file: %s\n", exc.what());
+            }
+        }
+
+        void setActiveSession(const std::string& appName) override {
+            if (m_fallback) {
+                m_fallback->setActiveSession(appName);
+            }
+        }
+
+      private:
+        // Returns false when there is no file. An invalid file loads no values.
+        bool load(ValueMap& values) const {
+            wil::unique_hfile file(CreateFileW(m_path.c_str(),
+                                               GENERIC_READ,
+                                               FILE_SHARE_READ | FILE_SHARE_DELETE,
+                                               nullptr,
+                                               OPEN_EXISTING,
+                                               FILE_ATTRIBUTE_NORMAL,
+                                               nullptr));
+            if (!file) {
+                // No settings were saved yet.
+                return false;
+            }
+
+            LARGE_INTEGER fileSize{};
+            if (!GetFileSizeEx(file.get(), &fileSize) || fileSize.QuadPart < (LONGLONG)sizeof(FileHeader)) {
+                Log("Config file '%s' is invalid\n", m_path.string().c_str());
+                return true;
+            }
+
+            wil::unique_handle mapping(CreateFileMappingW(file.get(), nullptr, PAGE_READONLY, 0, 0, nullptr));
+            if (!mapping) {
+                Log("Failed to map config file: %d\n", GetLastError());
+                return true;
+            }
+
+            wil::unique_mapview_ptr<uint8_t> view(
+                reinterpret_cast<uint8_t*>(MapViewOfFile(mapping.get(), FILE_MAP_READ, 0, 0, 0)));
+            if (!view) {
+                Log("Failed to map config file: %d\n", GetLastError());
+                return true;
+            }
+
+            if (!parse(view.get(), static_cast<size_t>(fileSize.QuadPart), values)) {
+                Log("Config file '%s' is corrupted\n", m_path.string().c_str());
+                values.clear();
+            }
+            return true;
+        }
+
+        bool writeFile(const std::vector<uint8_t>& buffer) const {
+            // Write to a temporary file first, so that the file is never left half-written.
+            auto tempPath = m_path;
+            tempPath += ".tmp";
+            {
+                wil::unique_hfile file(CreateFileW(
+                    tempPath.c_str(), GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr));
+                DWORD written = 0;
+                if (!file || !WriteFile(file.get(), buffer.data(), (DWORD)buffer.size(), &written, nullptr) ||
+                    written != buffer.size()) {
+                    Log("Failed to write config file: %d\n", GetLastError());
+                    return false;
+                }
+            }
+            if (!MoveFileExW(tempPath.c_str(), m_path.c_str(), MOVEFILE_REPLACE_EXISTING)) {
+                Log("Failed to replace config file: %d\n", GetLastError());
+                return false;
+            }
+            return true;
+        }
+
+        static bool parse(const uint8_t* data, size_t size, ValueMap& values) {
+            FileHeader header;
+            memcpy(&header, data, sizeof(header));
+            if (header.magic != Magic || header.version != Version) {
+                return false;
+            }
+
+            size_t offset = sizeof(header);
+            for (uint32_t i = 0; i < header.count; i++) {
+                int32_t value;
+                uint16_t nameLength;
+                if (offset + sizeof(value) + sizeof(nameLength) > size) {
+                    return false;
+                }
+                memcpy(&value, data + offset, sizeof(value));
+                offset += sizeof(value);
+                memcpy(&nameLength, data + offset, sizeof(nameLength));
+                offset += sizeof(nameLength);
+
+                if (offset + nameLength > size) {
+                    return false;
+                }
+                values.insert_or_assign(std::string(reinterpret_cast<const char*>(data + offset), nameLength),
+                                        value);
+                offset += nameLength;
+            }
+
+            return true;
+        }
+
+        const std::filesystem::path m_path;
+        const std::shared_ptr<IConfigStore> m_fallback;
+
+        std::mutex m_flushMutex;
+        mutable std::mutex m_mutex;
+        ValueMap m_values;
+        bool m_dirty{false};
+
+        // Must be destroyed first, since the callback uses the snapshot.
+        wil::unique_folder_change_reader m_watcher;
+    };
+
+} // namespace
+
+namespace toolkit::config {
+
+    std::shared_ptr<IConfigStore> CreateRegistryConfigStore(const std::string& appName) {
+        return std::make_shared<RegistryConfigStore>(appName);
+    }
+
+    std::shared_ptr<IConfigStore> CreateFileConfigStore(const std::filesystem::path& path,
+                                                        std::shared_ptr<IConfigStore> fallback) {
+        return std::make_shared<FileConfigStore>(path, fallback);
+    }
+
+    std::shared_ptr<IConfigStore> CreateConfigStore(const std::string& appName) {
+        auto registryStore = CreateRegistryConfigStore(appName);
+
+        // The file store is opt-in, until the companion app can edit it.
+        if (registryStore->readGlobal("config_file").value_or(0)) {
+            // Using std::filesystem automatically filters out unwanted app name chars.
+            std::string sanitizedName = appName;
+            std::replace(sanitizedName.begin(), sanitizedName.end(), '.', '_');
+            const auto path = localAppData / "configs" / (sanitizedName + ".settings");
+            Log("Using config file \"%s\"\n", path.string().c_str());
+            return CreateFileConfigStore(path, registryStore);
+        }
+
+        return registryStore;
+    }
+
+} // namespace toolkit::config
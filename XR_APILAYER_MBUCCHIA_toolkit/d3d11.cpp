@@ -462,14 +462,30 @@ void main(uint3 id : SV_DispatchThreadID)
         D3D11Texture(std::shared_ptr<IDevice> device,
                      const XrSwapchainCreateInfo& info,
                      const D3D11_TEXTURE2D_DESC& textureDesc,
-                     ID3D11Texture2D* texture)
-            : m_device(device), m_info(info), m_textureDesc(textureDesc), m_texture(texture) {
+                     ID3D11Texture2D* texture,
+                     bool ownsTexture = true)
+            : m_device(device), m_info(info), m_textureDesc(textureDesc), m_ownsTexture(ownsTexture) {
+            // A wrapper that does not own the texture must not outlive it (eg: the wrappers cached for the
+            // application's render targets). Its views are not cached either, since they reference the texture and
+            // would keep it alive (and its entry in the cache, see WrapperCacheTag).
+            if (m_ownsTexture) {
+                m_texture = texture;
+            } else {
+                m_texture.Attach(texture);
+            }
+
             m_shaderResourceSubView.resize(info.arraySize);
             m_unorderedAccessSubView.resize(info.arraySize);
             m_renderTargetSubView.resize(info.arraySize);
             m_depthStencilSubView.resize(info.arraySize);
         }
 
+        ~D3D11Texture() override {
+            if (!m_ownsTexture) {
+                m_texture.Detach();
+            }
+        }
+
         Api getApi() const override {
             return Api::D3D11;
         }
@@ -488,30 +504,48 @@ void main(uint3 id : SV_DispatchThreadID)
 
         std::shared_ptr<IShaderInputTextureView> getShaderResourceView(int32_t slice) const override {
             assert(slice < 0 || m_shaderResourceSubView.size() > size_t(slice));
-            auto& view = slice < 0 ? m_shaderResourceView : m_shaderResourceSubView[slice];
+            if (!m_ownsTexture) {
+                return makeShaderInputViewInternal(slice);
+            }
+            auto& view = slice == AllSlices ? m_shaderResourceArrayView
+                         : slice < 0        ? m_shaderResourceView
+                                            : m_shaderResourceSubView[slice];
             if (!view)
-                view = makeShaderInputViewInternal(std::max(slice, 0));
+                view = makeShaderInputViewInternal(slice);
             return view;
         }
 
         std::shared_ptr<IComputeShaderOutputView> getUnorderedAccessView(int32_t slice) const override {
             assert(slice < 0 || m_unorderedAccessSubView.size() > size_t(slice));
-            auto& view = slice < 0 ? m_unorderedAccessView : m_unorderedAccessSubView[slice];
+            if (!m_ownsTexture) {
+                return makeUnorderedAccessViewInternal(slice);
+            }
+            auto& view = slice == AllSlices ? m_unorderedAccessArrayView
+                         : slice < 0        ? m_unorderedAccessView
+                                            : m_unorderedAccessSubView[slice];
             if (!view)
-                view = makeUnorderedAccessViewInternal(std::max(slice, 0));
+                view = makeUnorderedAccessViewInternal(slice);
             return view;
         }
 
         std::shared_ptr<IRenderTargetView> getRenderTargetView(int32_t slice) const override {
             assert(slice < 0 || m_renderTargetSubView.size() > size_t(slice));
-            auto& view = slice < 0 ? m_renderTargetView : m_renderTargetSubView[slice];
+            if (!m_ownsTexture) {
+                return makeRenderTargetViewInternal(slice);
+            }
+            auto& view = slice == AllSlices ? m_renderTargetArrayView
+                         : slice < 0        ? m_renderTargetView
+                                            : m_renderTargetSubView[slice];
             if (!view)
-                view = makeRenderTargetViewInternal(std::max(slice, 0));
+                view = makeRenderTargetViewInternal(slice);
             return view;
         }
 
         std::shared_ptr<IDepthStencilView> getDepthStencilView(int32_t slice) const override {
             assert(slice < 0 || m_depthStencilSubView.size() > size_t(slice));
+            if (!m_ownsTexture) {
+                return makeDepthStencilViewInternal(std::max(slice, 0));
+            }
             auto& view = slice < 0 ? m_depthStencilView : m_depthStencilSubView[slice];
             if (!view)
                 view = makeDepthStencilViewInternal(std::max(slice, 0));
@@ -590,7 +624,9 @@ void main(uint3 id : SV_DispatchThreadID)
         }
 
       private:
-        std::shared_ptr<D3D11ShaderResourceView> makeShaderInputViewInternal(uint32_t slice) const {
+        // With AllSlices, the view covers the whole texture array. Otherwise, it covers one slice (the first one
+        // without a slice).
+        std::shared_ptr<D3D11ShaderResourceView> makeShaderInputViewInternal(int32_t slice) const {
             if (!(m_textureDesc.BindFlags & D3D11_BIND_SHADER_RESOURCE)) {
                 throw std::runtime_error("Texture was not created with D3D11_BIND_SHADER_RESOURCE");
             }
@@ -600,8 +636,8 @@ void main(uint3 id : SV_DispatchThreadID)
                 desc.Format = (DXGI_FORMAT)m_info.format;
                 desc.ViewDimension =
                     m_info.arraySize == 1 ? D3D11_SRV_DIMENSION_TEXTURE2D : D3D11_SRV_DIMENSION_TEXTURE2DARRAY;
-                desc.Texture2DArray.ArraySize = 1;
-                desc.Texture2DArray.FirstArraySlice = slice;
+                desc.Texture2DArray.ArraySize = slice == AllSlices ? m_info.arraySize : 1;
+                desc.Texture2DArray.FirstArraySlice = std::max(slice, 0);
                 desc.Texture2DArray.MipLevels = m_info.mipCount;
                 desc.Texture2DArray.MostDetailedMip = D3D11CalcSubresource(0, 0, m_info.mipCount);
 
@@ -612,18 +648,18 @@ void main(uint3 id : SV_DispatchThreadID)
             return nullptr;
         }
 
-        std::shared_ptr<D3D11UnorderedAccessView> makeUnorderedAccessViewInternal(uint32_t slice) const {
+        std::shared_ptr<D3D11UnorderedAccessView> makeUnorderedAccessViewInternal(int32_t slice) const {
             if (!(m_textureDesc.BindFlags & D3D11_BIND_UNORDERED_ACCESS)) {
                 throw std::runtime_error("Texture was not created with D3D11_BIND_UNORDERED_ACCESS");
             }
             if (auto device = m_device->getAs<D3D11>()) {
                 D3D11_UNORDERED_ACCESS_VIEW_DESC desc;
                 ZeroMemory(&desc, sizeof(desc));
-                desc.Format = (DXGI_FORMAT)m_info.format;
+                desc.Format = GetUnorderedAccessViewFormat((DXGI_FORMAT)m_info.format);
                 desc.ViewDimension =
                     m_info.arraySize == 1 ? D3D11_UAV_DIMENSION_TEXTURE2D : D3D11_UAV_DIMENSION_TEXTURE2DARRAY;
-                desc.Texture2DArray.ArraySize = 1;
-                desc.Texture2DArray.FirstArraySlice = slice;
+                desc.Texture2DArray.ArraySize = slice == AllSlices ? m_info.arraySize : 1;
+                desc.Texture2DArray.FirstArraySlice = std::max(slice, 0);
                 desc.Texture2DArray.MipSlice = D3D11CalcSubresource(0, 0, m_info.mipCount);
 
                 ComPtr<ID3D11UnorderedAccessView> uav;
@@ -633,7 +669,7 @@ void main(uint3 id : SV_DispatchThreadID)
             return nullptr;
         }
 
-        std::shared_ptr<D3D11RenderTargetView> makeRenderTargetViewInternal(uint32_t slice) const {
+        std::shared_ptr<D3D11RenderTargetView> makeRenderTargetViewInternal(int32_t slice) const {
             if (!(m_textureDesc.BindFlags & D3D11_BIND_RENDER_TARGET)) {
                 throw std::runtime_error("Texture was not created with D3D11_BIND_RENDER_TARGET");
             }
@@ -643,8 +679,8 @@ void main(uint3 id : SV_DispatchThreadID)
                 desc.Format = (DXGI_FORMAT)m_info.format;
                 desc.ViewDimension =
                     m_info.arraySize == 1 ? D3D11_RTV_DIMENSION_TEXTURE2D : D3D11_RTV_DIMENSION_TEXTURE2DARRAY;
-                desc.Texture2DArray.ArraySize = 1;
-                desc.Texture2DArray.FirstArraySlice = slice;
+                desc.Texture2DArray.ArraySize = slice == AllSlices ? m_info.arraySize : 1;
+                desc.Texture2DArray.FirstArraySlice = std::max(slice, 0);
                 desc.Texture2DArray.MipSlice = D3D11CalcSubresource(0, 0, m_info.mipCount);
 
                 ComPtr<ID3D11RenderTargetView> rtv;
@@ -678,18 +714,88 @@ void main(uint3 id : SV_DispatchThreadID)
         const std::shared_ptr<IDevice> m_device;
         const XrSwapchainCreateInfo m_info;
         const D3D11_TEXTURE2D_DESC m_textureDesc;
-        const ComPtr<ID3D11Texture2D> m_texture;
+        const bool m_ownsTexture;
+        ComPtr<ID3D11Texture2D> m_texture;
 
         mutable std::shared_ptr<D3D11ShaderResourceView> m_shaderResourceView;
+        mutable std::shared_ptr<D3D11ShaderResourceView> m_shaderResourceArrayView;
         mutable std::vector<std::shared_ptr<D3D11ShaderResourceView>> m_shaderResourceSubView;
         mutable std::shared_ptr<D3D11UnorderedAccessView> m_unorderedAccessView;
+        mutable std::shared_ptr<D3D11UnorderedAccessView> m_unorderedAccessArrayView;
         mutable std::vector<std::shared_ptr<D3D11UnorderedAccessView>> m_unorderedAccessSubView;
         mutable std::shared_ptr<D3D11RenderTargetView> m_renderTargetView;
+        mutable std::shared_ptr<D3D11RenderTargetView> m_renderTargetArrayView;
         mutable std::vector<std::shared_ptr<D3D11RenderTargetView>> m_renderTargetSubView;
         mutable std::shared_ptr<D3D11DepthStencilView> m_depthStencilView;
         mutable std::vector<std::shared_ptr<D3D11DepthStencilView>> m_depthStencilSubView;
     };
 
+    // A dynamic constant buffer suballocated with MAP_WRITE_NO_OVERWRITE, and renamed with MAP_WRITE_DISCARD once full.
+    // The constant buffers are bound at an offset within the ring (requires Direct3D 11.1).
+    struct D3D11ConstantRing {
+        struct Allocation {
+            UINT64 position;
+            UINT firstConstant;
+            UINT numConstants;
+        };
+
+        void initialize(ID3D11Device* device, UINT size) {
+            ringSize = size;
+
+            const auto desc =
+                CD3D11_BUFFER_DESC(ringSize, D3D11_BIND_CONSTANT_BUFFER, D3D11_USAGE_DYNAMIC, D3D11_CPU_ACCESS_WRITE);
+            CHECK_HRCMD(device->CreateBuffer(&desc, nullptr, set(buffer)));
+            SetDebugName(get(buffer), "Constant Ring");
+        }
+
+        Allocation allocate(ID3D11DeviceContext* context, const void* data, size_t size) {
+            // Offsets and sizes are expressed in constants (16 bytes), and must be multiples of 16 constants.
+            const UINT alignedSize = alignTo((UINT)size, 16 * 16);
+            if (alignedSize > ringSize) {
+                throw std::runtime_error("Constant buffer is larger than the ring");
+            }
+
+            // The allocations since the last rename are never overwritten.
+            UINT offset = (UINT)(head - discardPosition);
+            D3D11_MAP mapType = D3D11_MAP_WRITE_NO_OVERWRITE;
+            if (!isRenamed || offset + alignedSize > ringSize) {
+                mapType = D3D11_MAP_WRITE_DISCARD;
+                discardPosition = head;
+                offset = 0;
+                isRenamed = true;
+            }
+
+            D3D11_MAPPED_SUBRESOURCE mappedResources;
+            CHECK_HRCMD(context->Map(get(buffer), 0, mapType, 0, &mappedResources));
+            memcpy(reinterpret_cast<uint8_t*>(mappedResources.pData) + offset, data, size);
+            context->Unmap(get(buffer), 0);
+
+            const Allocation allocation{head, offset / 16, alignedSize / 16};
+            head += alignedSize;
+            peakUsage = std::max(peakUsage, (UINT)(head - discardPosition));
+            numUploads++;
+
+            return allocation;
+        }
+
+        // Whether the allocation is part of the current instance of the buffer.
+        bool isAlive(const Allocation& allocation) const {
+            return allocation.position >= discardPosition;
+        }
+
+        UINT ringSize{0};
+        ComPtr<ID3D11Buffer> buffer;
+
+        // Monotonic byte counters.
+        UINT64 head{0};
+        UINT64 discardPosition{0};
+        bool isRenamed{false};
+
+        UINT peakUsage{0};
+        uint32_t numUploads{0};
+        uint32_t numSkippedUploads{0};
+    };
+
     // Wrap a constant buffer. Obtained from D3D11Device.
     class D3D11Buffer : public IShaderBuffer {
       public:
@@ -697,6 +803,12 @@ void main(uint3 id : SV_DispatchThreadID)
             : m_device(device), m_bufferDesc(bufferDesc), m_buffer(buffer) {
         }
 
+        // A constant buffer suballocated from the constant ring upon each upload.
+        D3D11Buffer(std::shared_ptr<IDevice> device, D3D11_BUFFER_DESC bufferDesc, D3D11ConstantRing& constantRing)
+            : m_device(device), m_bufferDesc(bufferDesc), m_buffer(constantRing.buffer), m_constantRing(&constantRing),
+              m_shadowData(bufferDesc.ByteWidth, 0) {
+        }
+
         Api getApi() const override {
             return Api::D3D11;
         }
@@ -706,6 +818,21 @@ void main(uint3 id : SV_DispatchThreadID)
         }
 
         void uploadData(const void* buffer, size_t count) override {
+            if (m_constantRing) {
+                count = std::min(count, m_shadowData.size());
+
+                // Keep binding the previous allocation if the content did not change.
+                if (m_allocation && m_constantRing->isAlive(m_allocation.value()) &&
+                    !memcmp(m_shadowData.data(), buffer, count)) {
+                    m_constantRing->numSkippedUploads++;
+                    return;
+                }
+
+                memcpy(m_shadowData.data(), buffer, count);
+                allocate();
+                return;
+            }
+
             if (m_bufferDesc.CPUAccessFlags & D3D11_CPU_ACCESS_WRITE) {
                 if (auto context = m_device->getContextAs<D3D11>()) {
                     D3D11_MAPPED_SUBRESOURCE mappedResources;
@@ -718,6 +845,21 @@ void main(uint3 id : SV_DispatchThreadID)
             }
         }
 
+        // Returns false when the buffer is not suballocated and must be bound as a whole.
+        bool getConstantBufferRange(UINT& firstConstant, UINT& numConstants) const {
+            if (!m_constantRing) {
+                return false;
+            }
+
+            // Never uploaded, or renamed since.
+            if (!m_allocation || !m_constantRing->isAlive(m_allocation.value())) {
+                allocate();
+            }
+            firstConstant = m_allocation->firstConstant;
+            numConstants = m_allocation->numConstants;
+            return true;
+        }
+
         void pushState(D3D12_RESOURCE_STATES newState) override {
         }
         void popState() override {
@@ -728,9 +870,18 @@ void main(uint3 id : SV_DispatchThreadID)
         }
 
       private:
+        void allocate() const {
+            m_allocation =
+                m_constantRing->allocate(m_device->getContextAs<D3D11>(), m_shadowData.data(), m_shadowData.size());
+        }
+
         const std::shared_ptr<IDevice> m_device;
         const ComPtr<ID3D11Buffer> m_buffer;
         const D3D11_BUFFER_DESC m_bufferDesc;
+
+        D3D11ConstantRing* const m_constantRing{nullptr};
+        std::vector<uint8_t> m_shadowData;
+        mutable std::optional<D3D11ConstantRing::Allocation> m_allocation;
     };
 
     // Wrap a vertex+indices buffers. Obtained from D3D11Device.
@@ -768,17 +919,21 @@ void main(uint3 id : SV_DispatchThreadID)
         mutable struct D3D11::MeshData m_meshData;
     };
 
-    class D3D11GpuTimer : public IGpuTimer {
+    // Wrap a device context.
+    class D3D11Context : public graphics::IContext {
       public:
-        D3D11GpuTimer(std::shared_ptr<IDevice> device) : m_device(device) {
-            if (auto device = m_device->getAs<D3D11>()) {
-                D3D11_QUERY_DESC queryDesc;
-                ZeroMemory(&queryDesc, sizeof(D3D11_QUERY_DESC));
-                queryDesc.Query = D3D11_QUERY_TIMESTAMP_DISJOINT;
-                CHECK_HRCMD(device->CreateQuery(&queryDesc, set(m_timeStampDis)));
-                queryDesc.Query = D3D11_QUERY_TIMESTAMP;
-                CHECK_HRCMD(device->CreateQuery(&queryDesc, set(m_timeStampStart)));
-                CHECK_HRCMD(device->CreateQuery(&queryDesc, set(m_timeStampEnd)));
+        D3D11Context(std::shared_ptr<IDevice> device, ID3D11DeviceContext* context, bool ownsContext = true)
+            : m_device(device), m_ownsContext(ownsContext) {
+            if (m_ownsContext) {
+                m_context = context;
+            } else {
+                m_context.Attach(context);
+            }
+        }
+
+        ~D3D11Context() override {
+            if (!m_ownsContext) {
+                m_context.Detach();
             }
         }
 
@@ -790,74 +945,124 @@ void main(uint3 id : SV_DispatchThreadID)
             return m_device;
         }
 
-        void start() override {
-            assert(!m_valid);
-            if (auto context = m_device->getContextAs<D3D11>()) {
-                context->Begin(get(m_timeStampDis));
-                context->End(get(m_timeStampStart));
-            }
+        void* getNativePtr() const override {
+            return get(m_context);
         }
 
-        void stop() override {
-            assert(!m_valid);
-            if (auto context = m_device->getContextAs<D3D11>()) {
-                context->End(get(m_timeStampEnd));
-                context->End(get(m_timeStampDis));
-                m_valid = true;
+      private:
+        const std::shared_ptr<IDevice> m_device;
+        const bool m_ownsContext;
+        ComPtr<ID3D11DeviceContext> m_context;
+    };
+
+    // Wrappers for the application's objects seen by the interception hooks, so they are only created once per
+    // object. The wrappers do not hold a reference to the objects, and they are evicted when the object is destroyed.
+    // The generation tells apart the successive wrappers for a same object, in case a tag is replaced.
+    // The hooks run on all of the application's threads, so the entries are spread over shards with a reader-writer
+    // lock each, and lookups of different objects do not contend.
+    template <typename Wrapper>
+    class WrapperCache : public IWrapperCache, public std::enable_shared_from_this<WrapperCache<Wrapper>> {
+      public:
+        // Returns false if the object is unknown. A known object may have a null wrapper (eg: an object from another
+        // device).
+        bool find(ID3D11DeviceChild* object, std::shared_ptr<Wrapper>& wrapper) const {
+            const Shard& shard = getShard(object);
+            std::shared_lock lock(shard.lock);
+
+            auto it = shard.entries.find(object);
+            if (it == shard.entries.cend()) {
+                return false;
             }
+            wrapper = it->second.wrapper;
+            return true;
         }
 
-        uint64_t query(bool reset) const override {
-            uint64_t duration = 0;
-            auto context = m_device->getContextAs<D3D11>();
-            if (context && m_valid) {
-                UINT64 startime = 0, endtime = 0;
-                D3D11_QUERY_DATA_TIMESTAMP_DISJOINT disData = {0};
-
-                if (context->GetData(get(m_timeStampStart), &startime, sizeof(UINT64), 0) == S_OK &&
-                    context->GetData(get(m_timeStampEnd), &endtime, sizeof(UINT64), 0) == S_OK &&
-                    context->GetData(get(m_timeStampDis), &disData, sizeof(D3D11_QUERY_DATA_TIMESTAMP_DISJOINT), 0) ==
-                        S_OK &&
-                    !disData.Disjoint) {
-                    duration = static_cast<uint64_t>(((endtime - startime) * 1e6) / disData.Frequency);
-                }
-                m_valid = !reset;
+        void insert(ID3D11DeviceChild* object, std::shared_ptr<Wrapper> wrapper) {
+            const uint64_t generation = ++m_generation;
+            {
+                Shard& shard = getShard(object);
+                std::unique_lock lock(shard.lock);
+
+                shard.entries.insert_or_assign(object, Entry{generation, std::move(wrapper)});
             }
-            return duration;
-        }
 
-      private:
-        const std::shared_ptr<IDevice> m_device;
-        ComPtr<ID3D11Query> m_timeStampDis;
-        ComPtr<ID3D11Query> m_timeStampStart;
-        ComPtr<ID3D11Query> m_timeStampEnd;
+            // Replacing an existing tag releases it, which calls evict(): this must happen outside of the lock.
+            auto tag = Microsoft::WRL::Make<WrapperCacheTag>(this->weak_from_this(), object, generation);
+            object->SetPrivateDataInterface(__uuidof(IWrapperCacheTag), get(tag));
+        }
 
-        // Can the timer be queried (it might still only read 0).
-        mutable bool m_valid{false};
-    };
+        void evict(const void* object, uint64_t generation) override {
+            std::shared_ptr<Wrapper> wrapper;
+            Shard& shard = getShard(object);
+            std::unique_lock lock(shard.lock);
 
-    // Wrap a device context.
-    class D3D11Context : public graphics::IContext {
-      public:
-        D3D11Context(std::shared_ptr<IDevice> device, ID3D11DeviceContext* context)
-            : m_device(device), m_context(context) {
+            auto it = shard.entries.find(object);
+            if (it != shard.entries.end() && it->second.generation == generation) {
+                wrapper = std::move(it->second.wrapper);
+                shard.entries.erase(it);
+            }
         }
 
-        Api getApi() const override {
-            return Api::D3D11;
+        void clear() {
+            for (auto& shard : m_shards) {
+                std::unordered_map<const void*, Entry> entries;
+                std::unique_lock lock(shard.lock);
+
+                std::swap(entries, shard.entries);
+            }
         }
 
-        std::shared_ptr<IDevice> getDevice() const override {
-            return m_device;
+        size_t size() const {
+            size_t size = 0;
+            for (const auto& shard : m_shards) {
+                std::shared_lock lock(shard.lock);
+
+                size += shard.entries.size();
+            }
+            return size;
         }
 
-        void* getNativePtr() const override {
-            return get(m_context);
+        template <typename Predicate>
+        size_t count(Predicate&& predicate) const {
+            size_t count = 0;
+            for (const auto& shard : m_shards) {
+                std::shared_lock lock(shard.lock);
+
+                count += std::count_if(shard.entries.cbegin(), shard.entries.cend(), [&](const auto& entry) {
+                    return entry.second.wrapper && predicate(*entry.second.wrapper);
+                });
+            }
+            return count;
         }
 
       private:
-        const std::shared_ptr<IDevice> m_device;
-        const ComPtr<ID3D11DeviceContext> m_context;
+        static constexpr uint32_t ShardBits = 4;
+
+        struct Entry {
+            uint64_t generation;
+            std::shared_ptr<Wrapper> wrapper;
+        };
+
+        // Keep each shard on its own cache line.
+        struct alignas(64) Shard {
+            mutable std::shared_mutex lock;
+            std::unordered_map<const void*, Entry> entries;
+        };
+
+        Shard& getShard(const void* object) const {
+            // Fibonacci hashing spreads the COM pointers, which are multiples of a large alignment.
+            return m_shards[((uint64_t)object * 0x9E3779B97F4A7C15ull) >> (64 - ShardBits)];
+        }
+
+        mutable std::array<Shard, 1 << ShardBits> m_shards;
+        std::atomic<uint64_t> m_generation{0};
+    };
+
+    // The replacement for an application sampler, for one generation of the mip-map bias settings. The sampler is
+    // null when the application sampler does not need biasing.
+    struct BiasedSampler {
+        uint32_t biasGeneration;
+        ComPtr<ID3D11SamplerState> sampler;
     };
 
     class D3D11Device : public IDevice, public std::enable_shared_from_this<D3D11Device> {
@@ -902,8 +1107,10 @@ void main(uint3 id : SV_DispatchThreadID)
                     Log("Early initializeInterceptor() call\n");
                     initializeInterceptor();
                 }
+                initializeConstantRing();
                 initializeShadingResources();
                 initializeMeshResources();
+                initializeQueryResources();
                 initializeDebugResources();
             }
             initializeTextResources();
@@ -915,12 +1122,29 @@ void main(uint3 id : SV_DispatchThreadID)
         }
 
         void shutdown() override {
+            DebugLog("wrapper cache statistics: textures=%zu, contexts=%zu, samplers=%zu\n",
+                     m_textureWrappers->size(),
+                     m_contextWrappers->size(),
+                     m_biasedSamplers->size());
+            DebugLog("constant ring statistics: %u/%u, uploads=%u, skipped=%u\n",
+                     m_constantRing.peakUsage,
+                     m_constantRing.ringSize,
+                     m_constantRing.numUploads,
+                     m_constantRing.numSkippedUploads);
+            DebugLog("transient texture pool statistics: %zu/%zu\n",
+                     m_transientTextures.size(),
+                     m_transientTextures.peakSize());
+
             // Clear all references that could hold a cyclic reference themselves.
             m_currentComputeShader.reset();
             m_currentQuadShader.reset();
             m_currentDrawRenderTarget.reset();
             m_currentDrawDepthBuffer.reset();
             m_currentMesh.reset();
+            m_textureWrappers->clear();
+            m_contextWrappers->clear();
+            m_biasedSamplers->clear();
+            m_transientTextures.clear();
 
             m_meshModelBuffer.reset();
             m_meshViewProjectionBuffer.reset();
@@ -990,16 +1214,22 @@ void main(uint3 id : SV_DispatchThreadID)
             // Ensure we are not dropping an unfinished context.
             assert(!m_state.isValid());
 
+            if (isEndOfFrame) {
+                closeGpuFrame();
+            }
+
             if (!blocking) {
                 m_context->Flush();
             } else {
                 ComPtr<ID3D11DeviceContext4> Context1;
                 CHECK_HRCMD(m_context->QueryInterface(IID_PPV_ARGS(Context1.ReleaseAndGetAddressOf())));
 
-                wil::unique_handle eventHandle;
-                *eventHandle.put() = CreateEventEx(nullptr, L"flushContext Fence", 0, EVENT_ALL_ACCESS);
-                Context1->Flush1(D3D11_CONTEXT_TYPE_ALL, eventHandle.get());
-                WaitForSingleObject(eventHandle.get(), INFINITE);
+                if (!m_flushEvent) {
+                    *m_flushEvent.put() = CreateEventEx(nullptr, L"flushContext Fence", 0, EVENT_ALL_ACCESS);
+                }
+                Context1->Flush1(D3D11_CONTEXT_TYPE_ALL, m_flushEvent.get());
+                WaitForSingleObject(m_flushEvent.get(), INFINITE);
+                m_numGpuWaitsThisFrame++;
             }
 
             // Workaround: the Oculus OpenXR Runtime for DX11 seems to intercept some of the D3D calls as well. It
@@ -1011,6 +1241,7 @@ void main(uint3 id : SV_DispatchThreadID)
             }
 
             if (isEndOfFrame) {
+                m_transientTextures.endFrame();
                 m_executeDebugWorkload = true;
             }
         }
@@ -1063,8 +1294,31 @@ void main(uint3 id : SV_DispatchThreadID)
             return std::make_shared<D3D11Texture>(shared_from_this(), info, desc, get(texture));
         }
 
+        std::shared_ptr<ITexture> acquireTransientTexture(const XrSwapchainCreateInfo& info,
+                                                          std::string_view debugName) override {
+            return m_transientTextures.acquire(info, [&]() { return createTexture(info, debugName); });
+        }
+
+        void releaseTransientTexture(const std::shared_ptr<ITexture>& texture) override {
+            m_transientTextures.release(texture);
+        }
+
         std::shared_ptr<IShaderBuffer>
         createBuffer(size_t size, std::string_view debugName, const void* initialData, bool immutable) override {
+            // Dynamic buffers are written into the constant ring when supported.
+            if (!immutable && !initialData && m_constantRing.buffer) {
+                const auto desc = CD3D11_BUFFER_DESC(alignTo(static_cast<UINT>(size), 16 * 16),
+                                                     D3D11_BIND_CONSTANT_BUFFER,
+                                                     D3D11_USAGE_DYNAMIC,
+                                                     D3D11_CPU_ACCESS_WRITE);
+                return std::make_shared<D3D11Buffer>(shared_from_this(), desc, m_constantRing);
+            }
+
+            return createStandaloneBuffer(size, debugName, initialData, immutable);
+        }
+
+        std::shared_ptr<IShaderBuffer>
+        createStandaloneBuffer(size_t size, std::string_view debugName, const void* initialData, bool immutable) {
             auto desc = CD3D11_BUFFER_DESC(static_cast<UINT>(size),
                                            D3D11_BIND_CONSTANT_BUFFER,
                                            (initialData && immutable) ? D3D11_USAGE_IMMUTABLE : D3D11_USAGE_DYNAMIC,
@@ -1165,8 +1419,47 @@ void main(uint3 id : SV_DispatchThreadID)
             return std::make_shared<D3D11ComputeShader>(shared_from_this(), get(compiledShader), threadGroups);
         }
 
-        std::shared_ptr<IGpuTimer> createTimer() override {
-            return std::make_shared<D3D11GpuTimer>(shared_from_this());
+        std::shared_future<std::shared_ptr<IQuadShader>>
+        createQuadShaderAsync(const std::filesystem::path& shaderFile,
+                              const std::string& entryPoint,
+                              std::string_view debugName,
+                              const D3D_SHADER_MACRO* defines,
+                              std::filesystem::path includePath = "") override {
+            // A single-threaded device cannot create the shader object from the worker thread.
+            const bool synchronous = (m_device->GetCreationFlags() & D3D11_CREATE_DEVICE_SINGLETHREADED);
+            return utilities::shader::CreateAsync<IQuadShader>(
+                [self = shared_from_this(),
+                 shaderFile,
+                 entryPoint,
+                 debugName = std::string(debugName),
+                 defines = utilities::shader::Defines(defines),
+                 includePath = std::move(includePath)]() {
+                    return self->createQuadShader(shaderFile, entryPoint, debugName, defines.get(), includePath);
+                },
+                synchronous);
+        }
+
+        std::shared_future<std::shared_ptr<IComputeShader>>
+        createComputeShaderAsync(const std::filesystem::path& shaderFile,
+                                 const std::string& entryPoint,
+                                 std::string_view debugName,
+                                 const std::array<unsigned int, 3>& threadGroups,
+                                 const D3D_SHADER_MACRO* defines,
+                                 std::filesystem::path includePath = "") override {
+            // A single-threaded device cannot create the shader object from the worker thread.
+            const bool synchronous = (m_device->GetCreationFlags() & D3D11_CREATE_DEVICE_SINGLETHREADED);
+            return utilities::shader::CreateAsync<IComputeShader>(
+                [self = shared_from_this(),
+                 shaderFile,
+                 entryPoint,
+                 debugName = std::string(debugName),
+                 threadGroups,
+                 defines = utilities::shader::Defines(defines),
+                 includePath = std::move(includePath)]() {
+                    return self->createComputeShader(
+                        shaderFile, entryPoint, debugName, threadGroups, defines.get(), includePath);
+                },
+                synchronous);
         }
 
         void setShader(std::shared_ptr<IQuadShader> shader, SamplerType sampler) override {
@@ -1182,7 +1475,11 @@ void main(uint3 id : SV_DispatchThreadID)
                 m_context->IASetVertexBuffers(0, 0, nullptr, nullptr, nullptr);
                 m_context->IASetInputLayout(nullptr);
                 m_context->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLESTRIP);
-                m_context->VSSetShader(get(m_quadVertexShader), nullptr, 0);
+                // The layered vertex shader draws one instance to the first slice like the regular one.
+                m_context->VSSetShader(m_isRenderTargetArrayIndexSupported ? get(m_quadLayeredVertexShader)
+                                                                           : get(m_quadVertexShader),
+                                       nullptr,
+                                       0);
 
                 // TODO: This is somewhat restrictive, but for now we only support a linear sampler in slot 0.
                 ID3D11SamplerState* const samplers[] = {get(m_samplers[to_integral(sampler)])};
@@ -1223,7 +1520,18 @@ void main(uint3 id : SV_DispatchThreadID)
 
         void setShaderInput(uint32_t slot, std::shared_ptr<IShaderBuffer> input) override {
             ID3D11Buffer* const constantBuffers[] = {input->getAs<D3D11>()};
-            if (m_currentQuadShader) {
+            UINT firstConstant[1], numConstants[1];
+            if (dynamic_cast<D3D11Buffer*>(input.get())->getConstantBufferRange(firstConstant[0], numConstants[0])) {
+                if (m_currentQuadShader) {
+                    m_context1->PSSetConstantBuffers1(
+                        slot, ARRAYSIZE(constantBuffers), constantBuffers, firstConstant, numConstants);
+                } else if (m_currentComputeShader) {
+                    m_context1->CSSetConstantBuffers1(
+                        slot, ARRAYSIZE(constantBuffers), constantBuffers, firstConstant, numConstants);
+                } else {
+                    throw std::runtime_error("No shader is set");
+                }
+            } else if (m_currentQuadShader) {
                 m_context->PSSetConstantBuffers(slot, ARRAYSIZE(constantBuffers), constantBuffers);
             } else if (m_currentComputeShader) {
                 m_context->CSSetConstantBuffers(slot, ARRAYSIZE(constantBuffers), constantBuffers);
@@ -1232,13 +1540,25 @@ void main(uint3 id : SV_DispatchThreadID)
             }
         }
 
-        void setShaderOutput(uint32_t slot, std::shared_ptr<ITexture> output, int32_t slice) override {
+        void setShaderOutput(uint32_t slot,
+                             std::shared_ptr<ITexture> output,
+                             int32_t slice,
+                             const XrRect2Di* viewport) override {
             if (m_currentQuadShader) {
                 if (slot) {
                     throw std::runtime_error("Only use slot 0 for IQuadShader");
                 }
 
-                setRenderTargets(1, &output, &slice);
+                // Draw one instance of the quad per slice, each selecting its slice from the vertex shader.
+                m_currentQuadInstances = 1;
+                if (slice == AllSlices) {
+                    if (!m_isRenderTargetArrayIndexSupported) {
+                        throw std::runtime_error("Drawing to all slices is not supported");
+                    }
+                    m_currentQuadInstances = output->getInfo().arraySize;
+                }
+
+                setRenderTargets(1, &output, &slice, viewport);
 
                 m_context->RSSetState(output->getInfo().sampleCount > 1 ? get(m_quadRasterizerMSAA)
                                                                         : get(m_quadRasterizer));
@@ -1257,7 +1577,7 @@ void main(uint3 id : SV_DispatchThreadID)
 
         void dispatchShader(bool doNotClear) const override {
             if (m_currentQuadShader) {
-                m_context->Draw(3, 0);
+                m_context->DrawInstanced(3, m_currentQuadInstances, 0, 0);
             } else if (m_currentComputeShader) {
                 m_context->Dispatch(m_currentComputeShader->getThreadGroups()[0],
                                     m_currentComputeShader->getThreadGroups()[1],
@@ -1410,13 +1730,15 @@ void main(uint3 id : SV_DispatchThreadID)
 
         void draw(std::shared_ptr<ISimpleMesh> mesh, const XrPosef& pose, XrVector3f scaling, bool noCulling) override {
             if (auto meshData = mesh->getAs<D3D11>()) {
+                if (!m_meshModelBuffer) {
+                    m_meshModelBuffer = createBuffer(sizeof(ModelConstantBuffer), "Model CB", nullptr, false);
+                }
                 if (mesh != m_currentMesh) {
-                    if (!m_meshModelBuffer) {
-                        m_meshModelBuffer = createBuffer(sizeof(ModelConstantBuffer), "Model CB", nullptr, false);
+                    if (!m_constantRing.buffer) {
+                        ID3D11Buffer* const constantBuffers[] = {m_meshModelBuffer->getAs<D3D11>(),
+                                                                 m_meshViewProjectionBuffer->getAs<D3D11>()};
+                        m_context->VSSetConstantBuffers(0, ARRAYSIZE(constantBuffers), constantBuffers);
                     }
-                    ID3D11Buffer* const constantBuffers[] = {m_meshModelBuffer->getAs<D3D11>(),
-                                                             m_meshViewProjectionBuffer->getAs<D3D11>()};
-                    m_context->VSSetConstantBuffers(0, ARRAYSIZE(constantBuffers), constantBuffers);
                     m_context->VSSetShader(get(m_meshVertexShader), nullptr, 0);
                     m_context->PSSetShader(get(m_meshPixelShader), nullptr, 0);
                     m_context->GSSetShader(nullptr, nullptr, 0);
@@ -1439,6 +1761,20 @@ void main(uint3 id : SV_DispatchThreadID)
                                          DirectX::XMMatrixTranspose(scaleMatrix * xr::math::LoadXrPose(pose)));
                 m_meshModelBuffer->uploadData(&model, sizeof(model));
 
+                // The suballocations move with each upload, so they are bound for every draw.
+                if (m_constantRing.buffer) {
+                    // Resolve the view-projection first: renaming the ring would invalidate the model allocation.
+                    ID3D11Buffer* const constantBuffers[] = {m_meshModelBuffer->getAs<D3D11>(),
+                                                             m_meshViewProjectionBuffer->getAs<D3D11>()};
+                    UINT firstConstant[2], numConstants[2];
+                    dynamic_cast<D3D11Buffer*>(m_meshViewProjectionBuffer.get())
+                        ->getConstantBufferRange(firstConstant[1], numConstants[1]);
+                    dynamic_cast<D3D11Buffer*>(m_meshModelBuffer.get())
+                        ->getConstantBufferRange(firstConstant[0], numConstants[0]);
+                    m_context1->VSSetConstantBuffers1(
+                        0, ARRAYSIZE(constantBuffers), constantBuffers, firstConstant, numConstants);
+                }
+
                 m_context->DrawIndexedInstanced(meshData->numIndices, 1, 0, 0, 0);
             }
         }
@@ -1510,13 +1846,99 @@ void main(uint3 id : SV_DispatchThreadID)
         void setMipMapBias(config::MipMapBias biasing, float bias = 0.f) override {
             m_mipMapBiasingType = biasing;
             m_mipMapBias = bias;
+
+            // Invalidate all the biased samplers.
+            m_mipMapBiasGeneration++;
+        }
+
+        uint32_t getNumBiasedSamplers() const override {
+            const uint32_t biasGeneration = m_mipMapBiasGeneration;
+            return (uint32_t)m_biasedSamplers->count([&](const BiasedSampler& biasedSampler) {
+                return biasedSampler.biasGeneration == biasGeneration && biasedSampler.sampler;
+            });
         }
 
-        uint32_t getNumBiasedSamplersThisFrame() const override {
-            return std::exchange(m_numBiasedSamplersThisFrame, 0);
+        DescriptorStatistics getDescriptorStatistics() const override {
+            // D3D11 manages the views.
+            return {};
         }
 
-        void resolveQueries() override {
+        ConstantUploadStatistics getConstantUploadStatisticsThisFrame() const override {
+            ConstantUploadStatistics stats;
+            stats.numUploads =
+                m_constantRing.numUploads - std::exchange(m_lastNumConstantUploads, m_constantRing.numUploads);
+            stats.numSkippedUploads = m_constantRing.numSkippedUploads -
+                                      std::exchange(m_lastNumSkippedConstantUploads, m_constantRing.numSkippedUploads);
+            stats.ringSize = m_constantRing.ringSize;
+            stats.ringPeakUsage = m_constantRing.peakUsage;
+            return stats;
+        }
+
+        HookStatistics getHookStatisticsThisFrame() const override {
+            return m_hookCounters.exchange();
+        }
+
+        void setHookStatisticsEnabled(bool enabled) override {
+            m_hookCounters.isEnabled.store(enabled, std::memory_order_relaxed);
+        }
+
+        uint32_t getNumGpuWaitsThisFrame() const override {
+            return std::exchange(m_numGpuWaitsThisFrame, 0);
+        }
+
+        void startGpuStage(GpuStage stage) override {
+            auto& queries = m_gpuFrameQueries[m_currentGpuFrame];
+            if (queries.frame.isPending) {
+                // The timings of that frame were never read back.
+                queries.frame.reset();
+            }
+            if (const auto index = queries.frame.start(stage)) {
+                if (!queries.isDisjointBegun) {
+                    m_context->Begin(get(queries.disjoint));
+                    queries.isDisjointBegun = true;
+                }
+                m_context->End(get(queries.timestamps[*index]));
+            }
+        }
+
+        void stopGpuStage(GpuStage stage) override {
+            auto& queries = m_gpuFrameQueries[m_currentGpuFrame];
+            if (const auto index = queries.frame.stop(stage)) {
+                m_context->End(get(queries.timestamps[*index]));
+            }
+        }
+
+        bool resolveQueries(GpuStageTimings& timings) override {
+            // The frame about to be recorded reuses the queries of the oldest frame.
+            auto& queries = m_gpuFrameQueries[m_currentGpuFrame];
+            if (!queries.frame.isPending) {
+                return false;
+            }
+            const auto frame = queries.frame;
+            queries.frame.reset();
+
+            // Do not flush: the queries were submitted GpuFrameLatency frames ago, and if the GPU is still behind, we
+            // rather lose the timings than stall.
+            D3D11_QUERY_DATA_TIMESTAMP_DISJOINT disjointData{};
+            if (m_context->GetData(get(queries.disjoint),
+                                   &disjointData,
+                                   sizeof(disjointData),
+                                   D3D11_ASYNC_GETDATA_DONOTFLUSH) != S_OK ||
+                disjointData.Disjoint) {
+                return false;
+            }
+            uint64_t timestamps[GpuFrameTimestamps::MaxTimestamps];
+            for (uint32_t i = 0; i < 2 * frame.numIntervals; i++) {
+                if (m_context->GetData(get(queries.timestamps[i]),
+                                       &timestamps[i],
+                                       sizeof(uint64_t),
+                                       D3D11_ASYNC_GETDATA_DONOTFLUSH) != S_OK) {
+                    return false;
+                }
+            }
+
+            timings = frame.accumulate(timestamps, disjointData.Frequency);
+            return true;
         }
 
         void blockCallbacks() override {
@@ -1547,6 +1969,10 @@ void main(uint3 id : SV_DispatchThreadID)
             return m_allowInterceptor;
         }
 
+        bool isRenderTargetArrayIndexSupported() const override {
+            return m_isRenderTargetArrayIndexSupported;
+        }
+
         uint32_t getBufferAlignmentConstraint() const override {
             return 16;
         }
@@ -1569,11 +1995,14 @@ void main(uint3 id : SV_DispatchThreadID)
             }
 
             if (!m_debugWorkloadParams) {
-                m_debugWorkloadParams = createBuffer(16, "DebugWorkloadParams", nullptr, false);
+                // We might be on the application's rendering thread: do not use the constant ring.
+                m_debugWorkloadParams = createStandaloneBuffer(16, "DebugWorkloadParams", nullptr, false);
             }
 
-            const int cpuLoad = m_configManager->getValue("debug_cpu_load");
-            const int gpuLoad = m_configManager->getValue("debug_gpu_load");
+            // We might be on the application's rendering thread.
+            const auto snapshot = m_configManager->getSnapshot();
+            const int cpuLoad = snapshot.getValue(config::SettingDebugCpuLoad);
+            const int gpuLoad = snapshot.getValue(config::SettingDebugGpuLoad);
 
             if (gpuLoad) {
                 uint32_t param = gpuLoad * 5000;
@@ -1707,9 +2136,64 @@ void main(uint3 id : SV_DispatchThreadID)
 
                 SetDebugName(get(m_quadVertexShader), "Quad PS");
             }
+            {
+                D3D11_FEATURE_DATA_D3D11_OPTIONS3 options{};
+                m_isRenderTargetArrayIndexSupported =
+                    SUCCEEDED(m_device->CheckFeatureSupport(D3D11_FEATURE_D3D11_OPTIONS3, &options, sizeof(options))) &&
+                    options.VPAndRTArrayIndexFromAnyShaderFeedingRasterizer;
+                if (m_isRenderTargetArrayIndexSupported) {
+                    utilities::shader::Defines defines;
+                    defines.add("QUAD_LAYERED", 1);
+
+                    ComPtr<ID3DBlob> vsBytes;
+                    toolkit::utilities::shader::CompileShader(QuadVertexShader.data(),
+                                                              QuadVertexShader.size(),
+                                                              "vsMain",
+                                                              set(vsBytes),
+                                                              defines.get(),
+                                                              nullptr,
+                                                              "vs_5_0");
+
+                    CHECK_HRCMD(m_device->CreateVertexShader(vsBytes->GetBufferPointer(),
+                                                             vsBytes->GetBufferSize(),
+                                                             nullptr,
+                                                             set(m_quadLayeredVertexShader)));
+
+                    SetDebugName(get(m_quadLayeredVertexShader), "Quad Layered VS");
+                } else {
+                    Log("Render target array index from the vertex shader is not supported\n");
+                }
+            }
         }
 
         // Initialize the resources needed for draw() and related calls.
+        void initializeConstantRing() {
+            // Binding at an offset and mapping with NO_OVERWRITE are both optional in Direct3D 11.1. Without them, we
+            // fall back to one dynamic buffer per constant buffer.
+            D3D11_FEATURE_DATA_D3D11_OPTIONS options{};
+            if (FAILED(m_device->CheckFeatureSupport(D3D11_FEATURE_D3D11_OPTIONS, &options, sizeof(options))) ||
+                !options.ConstantBufferOffsetting || !options.MapNoOverwriteOnDynamicConstantBuffer ||
+                FAILED(m_context->QueryInterface(set(m_context1)))) {
+                Log("Constant buffer offsetting is not supported\n");
+                return;
+            }
+
+            m_constantRing.initialize(get(m_device), D3D11_REQ_CONSTANT_BUFFER_ELEMENT_COUNT * 16);
+        }
+
+        void initializeQueryResources() {
+            for (auto& queries : m_gpuFrameQueries) {
+                D3D11_QUERY_DESC queryDesc;
+                ZeroMemory(&queryDesc, sizeof(D3D11_QUERY_DESC));
+                queryDesc.Query = D3D11_QUERY_TIMESTAMP_DISJOINT;
+                CHECK_HRCMD(m_device->CreateQuery(&queryDesc, set(queries.disjoint)));
+                queryDesc.Query = D3D11_QUERY_TIMESTAMP;
+                for (auto& timestamp : queries.timestamps) {
+                    CHECK_HRCMD(m_device->CreateQuery(&queryDesc, set(timestamp)));
+                }
+            }
+        }
+
         void initializeMeshResources() {
             {
                 ComPtr<ID3DBlob> vsBytes;
@@ -1837,14 +2321,13 @@ void main(uint3 id : SV_DispatchThreadID)
                 return;
             }
 
-            ComPtr<ID3D11Device> device;
-            context->GetDevice(set(device));
-            if (device != m_device) {
+            ScopedHookTimer timer(m_hookCounters);
+
+            auto wrappedContext = getWrappedContext(context);
+            if (!wrappedContext) {
                 return;
             }
 
-            auto wrappedContext = std::make_shared<D3D11Context>(shared_from_this(), context);
-
             if (!numViews || !renderTargetViews || !renderTargetViews[0]) {
                 INVOKE_EVENT(unsetRenderTargetEvent, wrappedContext);
                 return;
@@ -1865,18 +2348,13 @@ void main(uint3 id : SV_DispatchThreadID)
             ComPtr<ID3D11Resource> resource;
             renderTargetViews[0]->GetResource(set(resource));
 
-            ComPtr<ID3D11Texture2D> texture;
-            if (FAILED(resource->QueryInterface(set(texture)))) {
+            auto renderTarget = getWrappedTexture(get(resource));
+            if (!renderTarget) {
                 INVOKE_EVENT(unsetRenderTargetEvent, wrappedContext);
                 return;
             }
 
-            D3D11_TEXTURE2D_DESC textureDesc;
-            texture->GetDesc(&textureDesc);
-
-            auto renderTarget = std::make_shared<D3D11Texture>(
-                shared_from_this(), getTextureInfo(textureDesc), textureDesc, get(texture));
-            INVOKE_EVENT(setRenderTargetEvent, wrappedContext, renderTarget);
+            INVOKE_EVENT(setRenderTargetEvent, wrappedContext, holdReference(renderTarget, get(resource)));
         }
 
         void onCopyResource(ID3D11DeviceContext* context,
@@ -1888,108 +2366,157 @@ void main(uint3 id : SV_DispatchThreadID)
                 return;
             }
 
-            ComPtr<ID3D11Device> device;
-            context->GetDevice(set(device));
-            if (device != m_device) {
+            ScopedHookTimer timer(m_hookCounters);
+
+            auto wrappedContext = getWrappedContext(context);
+            if (!wrappedContext) {
                 return;
             }
 
-            ComPtr<ID3D11Texture2D> sourceTexture;
-            if (FAILED(pSrcResource->QueryInterface(set(sourceTexture)))) {
+            auto source = getWrappedTexture(pSrcResource);
+            if (!source) {
                 return;
             }
 
-            ComPtr<ID3D11Texture2D> destinationTexture;
-            if (FAILED(pDstResource->QueryInterface(set(destinationTexture)))) {
+            auto destination = getWrappedTexture(pDstResource);
+            if (!destination) {
                 return;
             }
 
-            auto wrappedContext = std::make_shared<D3D11Context>(shared_from_this(), context);
+            INVOKE_EVENT(copyTextureEvent,
+                         wrappedContext,
+                         holdReference(source, pSrcResource),
+                         holdReference(destination, pDstResource),
+                         SrcSubresource,
+                         DstSubresource);
+        }
 
-            D3D11_TEXTURE2D_DESC sourceTextureDesc;
-            sourceTexture->GetDesc(&sourceTextureDesc);
+#undef INVOKE_EVENT
 
-            auto source = std::make_shared<D3D11Texture>(
-                shared_from_this(), getTextureInfo(sourceTextureDesc), sourceTextureDesc, get(sourceTexture));
+        // Return the wrapper for an application context, or nullptr if the context belongs to another device. The
+        // device check and the allocation of the wrapper only happen the first time a context is seen.
+        std::shared_ptr<D3D11Context> getWrappedContext(ID3D11DeviceContext* context) {
+            std::shared_ptr<D3D11Context> wrappedContext;
+            if (m_contextWrappers->find(context, wrappedContext)) {
+                return wrappedContext;
+            }
 
-            D3D11_TEXTURE2D_DESC destinationTextureDesc;
-            destinationTexture->GetDesc(&destinationTextureDesc);
+            ComPtr<ID3D11Device> device;
+            context->GetDevice(set(device));
+            if (device == m_device) {
+                wrappedContext = std::make_shared<D3D11Context>(shared_from_this(), context, false /* ownsContext */);
+            }
+            m_contextWrappers->insert(context, wrappedContext);
+
+            return wrappedContext;
+        }
+
+        // Return the wrapper for an application resource, or nullptr if the resource is not a 2D texture.
+        std::shared_ptr<D3D11Texture> getWrappedTexture(ID3D11Resource* resource) {
+            std::shared_ptr<D3D11Texture> wrappedTexture;
+            if (m_textureWrappers->find(resource, wrappedTexture)) {
+                return wrappedTexture;
+            }
+
+            ComPtr<ID3D11Texture2D> texture;
+            if (SUCCEEDED(resource->QueryInterface(set(texture)))) {
+                D3D11_TEXTURE2D_DESC textureDesc;
+                texture->GetDesc(&textureDesc);
 
-            auto destination = std::make_shared<D3D11Texture>(shared_from_this(),
-                                                              getTextureInfo(destinationTextureDesc),
-                                                              destinationTextureDesc,
-                                                              get(destinationTexture));
+                wrappedTexture = std::make_shared<D3D11Texture>(shared_from_this(),
+                                                                getTextureInfo(textureDesc),
+                                                                textureDesc,
+                                                                get(texture),
+                                                                false /* ownsTexture */);
+            }
+            m_textureWrappers->insert(resource, wrappedTexture);
 
-            INVOKE_EVENT(copyTextureEvent, wrappedContext, source, destination, SrcSubresource, DstSubresource);
+            return wrappedTexture;
         }
 
-#undef INVOKE_EVENT
+        // The cached wrappers do not reference the resource, but the listeners may keep a texture past the event (eg:
+        // the VRS capture). Hand them a pointer that holds a reference to the resource for as long as they keep it.
+        static std::shared_ptr<ITexture> holdReference(std::shared_ptr<D3D11Texture> wrapper,
+                                                       ID3D11Resource* resource) {
+            ITexture* const texture = wrapper.get();
+            return std::shared_ptr<ITexture>(
+                texture,
+                [wrapper = std::move(wrapper), resource = ComPtr<ID3D11Resource>(resource)](ITexture*) mutable {
+                    wrapper.reset();
+                    resource.Reset();
+                });
+        }
 
         void patchSamplers(ID3D11DeviceContext* context, ID3D11SamplerState** samplers, size_t numSamplers) {
             if (m_blockEvents || m_mipMapBiasingType == config::MipMapBias::Off) {
                 return;
             }
 
-            ComPtr<ID3D11Device> device;
-            context->GetDevice(set(device));
-            if (device != m_device) {
+            ScopedHookTimer timer(m_hookCounters);
+
+            if (!getWrappedContext(context)) {
                 return;
             }
 
+            // A bind is a single lookup per sampler. The replacement sampler is only (re-)created the first time an
+            // application sampler is seen after a change of the settings.
+            const uint32_t biasGeneration = m_mipMapBiasGeneration;
             for (size_t i = 0; i < numSamplers; i++) {
                 if (!samplers[i]) {
                     continue;
                 }
 
-                bool needUpdate = false;
-
-                // Retrieve any previously biased sampler.
-                ComPtr<ID3D11SamplerState> biasedSampler;
-                UINT nDataSize = sizeof(ID3D11SamplerState*);
-                if (SUCCEEDED(
-                        samplers[i]->GetPrivateData(__uuidof(ID3D11SamplerState), &nDataSize, set(biasedSampler))) &&
-                    biasedSampler) {
-                    // Check if the sampler needs to be updated again.
-                    D3D11_SAMPLER_DESC desc;
-                    biasedSampler->GetDesc(&desc);
-                    needUpdate = std::abs(desc.MipLODBias - m_mipMapBias) > FLT_EPSILON;
+                std::shared_ptr<BiasedSampler> biasedSampler;
+                if (!m_biasedSamplers->find(samplers[i], biasedSampler) || !biasedSampler ||
+                    biasedSampler->biasGeneration != biasGeneration) {
+                    biasedSampler = createBiasedSampler(samplers[i], biasGeneration);
+                    m_biasedSamplers->insert(samplers[i], biasedSampler);
                 }
 
-                bool needBiasing = biasedSampler;
-
-                // Create or update the biased sampler.
-                if (!biasedSampler || needUpdate) {
-                    D3D11_SAMPLER_DESC desc;
-                    samplers[i]->GetDesc(&desc);
-
-                    needBiasing = m_mipMapBiasingType == config::MipMapBias::All ||
-                                  (desc.Filter == D3D11_FILTER_ANISOTROPIC ||
-                                   desc.Filter == D3D11_FILTER_COMPARISON_ANISOTROPIC ||
-                                   desc.Filter == D3D11_FILTER_MINIMUM_ANISOTROPIC ||
-                                   desc.Filter == D3D11_FILTER_MAXIMUM_ANISOTROPIC);
-
-                    if (needBiasing) {
-                        // Bias the LOD.
-                        desc.MipLODBias += m_mipMapBias;
-
-                        // Allow negative LOD.
-                        desc.MinLOD -= std::ceilf(m_mipMapBias);
-
-                        const auto hr = m_device->CreateSamplerState(&desc, set(biasedSampler));
-                        if (SUCCEEDED(hr)) {
-                            samplers[i]->SetPrivateDataInterface(__uuidof(ID3D11SamplerState), get(biasedSampler));
-                        } else {
-                            // TODO: We ignore the error for now.
-                            needBiasing = false;
-                        }
-                    }
+                if (biasedSampler->sampler) {
+                    samplers[i] = get(biasedSampler->sampler);
                 }
+            }
+        }
+
+        std::shared_ptr<BiasedSampler> createBiasedSampler(ID3D11SamplerState* sampler, uint32_t biasGeneration) {
+            auto biasedSampler = std::make_shared<BiasedSampler>();
+            biasedSampler->biasGeneration = biasGeneration;
+
+            D3D11_SAMPLER_DESC desc;
+            sampler->GetDesc(&desc);
+
+            const bool needBiasing = m_mipMapBiasingType == config::MipMapBias::All ||
+                                     (desc.Filter == D3D11_FILTER_ANISOTROPIC ||
+                                      desc.Filter == D3D11_FILTER_COMPARISON_ANISOTROPIC ||
+                                      desc.Filter == D3D11_FILTER_MINIMUM_ANISOTROPIC ||
+                                      desc.Filter == D3D11_FILTER_MAXIMUM_ANISOTROPIC);
+
+            if (needBiasing) {
+                // Bias the LOD.
+                desc.MipLODBias += m_mipMapBias;
+
+                // Allow negative LOD.
+                desc.MinLOD -= std::ceilf(m_mipMapBias);
 
-                if (needBiasing) {
-                    samplers[i] = biasedSampler.Get();
-                    m_numBiasedSamplersThisFrame++;
+                // TODO: We ignore the error for now.
+                if (FAILED(m_device->CreateSamplerState(&desc, set(biasedSampler->sampler)))) {
+                    biasedSampler->sampler.Reset();
                 }
             }
+
+            return biasedSampler;
+        }
+
+        void closeGpuFrame() {
+            auto& queries = m_gpuFrameQueries[m_currentGpuFrame];
+            queries.frame.close([&](uint32_t index) { m_context->End(get(queries.timestamps[index])); });
+            if (queries.isDisjointBegun) {
+                m_context->End(get(queries.disjoint));
+                queries.isDisjointBegun = false;
+            }
+
+            m_currentGpuFrame = (m_currentGpuFrame + 1) % ARRAYSIZE(m_gpuFrameQueries);
         }
 
         const ComPtr<ID3D11Device> m_device;
@@ -2001,11 +2528,32 @@ void main(uint3 id : SV_DispatchThreadID)
         GpuArchitecture m_gpuArchitecture;
         const bool m_allowInterceptor;
         uint32_t m_lateInitCountdown{0};
+        wil::unique_handle m_flushEvent;
+        mutable uint32_t m_numGpuWaitsThisFrame{0};
+
+        D3D11ConstantRing m_constantRing;
+        ComPtr<ID3D11DeviceContext1> m_context1;
+        mutable uint32_t m_lastNumConstantUploads{0};
+        mutable uint32_t m_lastNumSkippedConstantUploads{0};
+
+        // A pool of timestamp queries for each frame in-flight, with a single disjoint query per frame.
+        struct GpuFrameQueries {
+            ComPtr<ID3D11Query> disjoint;
+            ComPtr<ID3D11Query> timestamps[GpuFrameTimestamps::MaxTimestamps];
+            GpuFrameTimestamps frame;
+            bool isDisjointBegun{false};
+        };
+        GpuFrameQueries m_gpuFrameQueries[GpuFrameLatency + 1];
+        uint32_t m_currentGpuFrame{0};
+
+        TransientTexturePool m_transientTextures;
 
         ComPtr<ID3D11SamplerState> m_samplers[2];
         ComPtr<ID3D11RasterizerState> m_quadRasterizer;
         ComPtr<ID3D11RasterizerState> m_quadRasterizerMSAA;
         ComPtr<ID3D11VertexShader> m_quadVertexShader;
+        ComPtr<ID3D11VertexShader> m_quadLayeredVertexShader;
+        bool m_isRenderTargetArrayIndexSupported{false};
         ComPtr<ID3D11DepthStencilState> m_reversedZDepthNoStencilTest;
         ComPtr<ID3D11VertexShader> m_meshVertexShader;
         ComPtr<ID3D11PixelShader> m_meshPixelShader;
@@ -2027,13 +2575,21 @@ void main(uint3 id : SV_DispatchThreadID)
 
         config::MipMapBias m_mipMapBiasingType{config::MipMapBias::Off};
         float m_mipMapBias{0.f};
-        mutable uint32_t m_numBiasedSamplersThisFrame{0};
+        std::atomic<uint32_t> m_mipMapBiasGeneration{0};
 
         SetRenderTargetEvent m_setRenderTargetEvent;
         UnsetRenderTargetEvent m_unsetRenderTargetEvent;
         CopyTextureEvent m_copyTextureEvent;
         std::atomic<bool> m_blockEvents{false};
 
+        const std::shared_ptr<WrapperCache<D3D11Texture>> m_textureWrappers =
+            std::make_shared<WrapperCache<D3D11Texture>>();
+        const std::shared_ptr<WrapperCache<D3D11Context>> m_contextWrappers =
+            std::make_shared<WrapperCache<D3D11Context>>();
+        const std::shared_ptr<WrapperCache<BiasedSampler>> m_biasedSamplers =
+            std::make_shared<WrapperCache<BiasedSampler>>();
+        mutable HookCounters m_hookCounters;
+
         ComPtr<ID3D11ComputeShader> m_debugWorkloadShader;
         std::shared_ptr<IShaderBuffer> m_debugWorkloadParams;
         bool m_executeDebugWorkload{false};
@@ -2043,6 +2599,7 @@ void main(uint3 id : SV_DispatchThreadID)
         mutable uint32_t m_currentShaderHighestSRV;
         mutable uint32_t m_currentShaderHighestUAV;
         mutable uint32_t m_currentShaderHighestRTV;
+        uint32_t m_currentQuadInstances{1};
 
         static XrSwapchainCreateInfo getTextureInfo(const D3D11_TEXTURE2D_DESC& textureDesc) {
             XrSwapchainCreateInfo info;
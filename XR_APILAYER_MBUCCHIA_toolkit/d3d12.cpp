@@ -39,8 +39,8 @@ namespace {
     using namespace toolkit::graphics::d3dcommon;
     using namespace toolkit::log;
 
-    constexpr size_t MaxGpuTimers = 256;
-    constexpr size_t MaxModelBuffers = 128;
+    constexpr UINT DescriptorRingSize = 4096;
+    constexpr UINT ConstantRingSize = 1024 * 1024;
 
     // If the application uses the Streamline SDK, some D3D12 objects are shimmed, and this will confuse our Detours
     // logic. Luckily, the Streamline SDK has a secret UUID that can be used to query the underlying interface. From
@@ -60,45 +60,527 @@ namespace {
             resource->SetPrivateData(WKPDID_D3DDebugObjectName, static_cast<UINT>(name.size()), name.data());
     }
 
-    auto descriptorCompare = [](const D3D12_CPU_DESCRIPTOR_HANDLE& left, const D3D12_CPU_DESCRIPTOR_HANDLE& right) {
-        return left.ptr < right.ptr;
+    // A fixed-capacity open-addressing hash table keyed by a non-zero pointer-sized value, for the lookups on the hot
+    // path of the intercepted calls. The probing is lock-free. Each slot's value is guarded by its own spinlock, which
+    // is only held to copy the value in or out, and a slot is re-validated once locked since its key may have changed
+    // in the meantime.
+    // Evicting a key leaves a tombstone in its slot, which is reused by the next key claimed on the same probe
+    // sequence. Keys are only claimed under a mutex (this is the rare case of a key seen for the first time), so that
+    // two threads cannot claim two slots for the same key.
+    // Once the table is full, the keys that do not fit go to an overflow map guarded by the same mutex, which is only
+    // looked up when it is not empty.
+    template <typename Value>
+    class ConcurrentPointerTable {
+      public:
+        ConcurrentPointerTable(uint32_t log2Capacity)
+            : m_shift(64 - log2Capacity), m_mask((size_t(1) << log2Capacity) - 1),
+              m_slots(std::make_unique<Slot[]>(m_mask + 1)) {
+        }
+
+        // Invoke the reader on the value for the key. Returns false if the key is not in the table.
+        template <typename Reader>
+        bool find(uint64_t key, Reader&& reader) const {
+            return access(*this, key, reader);
+        }
+
+        // Invoke the writer on the value for the key, if the key is in the table. Returns false otherwise.
+        template <typename Writer>
+        bool modify(uint64_t key, Writer&& writer) {
+            return access(*this, key, writer);
+        }
+
+        // Invoke the writer on the value for the key, inserting a default value if needed. Returns false if the key
+        // went to the overflow map.
+        template <typename Writer>
+        bool update(uint64_t key, Writer&& writer) {
+            while (true) {
+                Slot* slot = lookup(key);
+                if (!slot) {
+                    std::unique_lock lock(m_overflowLock);
+                    slot = claim(key);
+                    if (!slot) {
+                        writer(m_overflow[key]);
+                        m_hasOverflow.store(true, std::memory_order_release);
+                        return false;
+                    }
+                }
+
+                SlotLock lock(*slot);
+                if (slot->key.load(std::memory_order_relaxed) == key) {
+                    writer(slot->value);
+                    return true;
+                }
+                // The key was evicted since we claimed or found it.
+            }
+        }
+
+        // Evict the key if the predicate accepts its value. The value is destroyed outside of the lock.
+        template <typename Predicate>
+        void evict(uint64_t key, Predicate&& predicate) {
+            Value value;
+            Slot* const slot = lookup(key);
+            if (slot) {
+                SlotLock lock(*slot);
+                if (slot->key.load(std::memory_order_relaxed) == key &&
+                    predicate(static_cast<const Value&>(slot->value))) {
+                    std::swap(value, slot->value);
+                    slot->key.store(Tombstone, std::memory_order_release);
+                    m_size.fetch_sub(1, std::memory_order_relaxed);
+                }
+                return;
+            }
+
+            if (!m_hasOverflow.load(std::memory_order_acquire)) {
+                return;
+            }
+            std::unique_lock lock(m_overflowLock);
+            auto it = m_overflow.find(key);
+            if (it != m_overflow.end() && predicate(static_cast<const Value&>(it->second))) {
+                std::swap(value, it->second);
+                m_overflow.erase(it);
+                m_hasOverflow.store(!m_overflow.empty(), std::memory_order_release);
+            }
+        }
+
+        // Evict all the keys.
+        void clear() {
+            for (size_t i = 0; i <= m_mask; i++) {
+                Value value;
+                {
+                    SlotLock lock(m_slots[i]);
+                    const uint64_t key = m_slots[i].key.load(std::memory_order_relaxed);
+                    if (key && key != Tombstone) {
+                        std::swap(value, m_slots[i].value);
+                        m_slots[i].key.store(Tombstone, std::memory_order_release);
+                        m_size.fetch_sub(1, std::memory_order_relaxed);
+                    }
+                }
+            }
+
+            std::unordered_map<uint64_t, Value> overflow;
+            {
+                std::unique_lock lock(m_overflowLock);
+                std::swap(overflow, m_overflow);
+                m_hasOverflow.store(false, std::memory_order_release);
+            }
+        }
+
+        // The number of keys in the table (excluding the overflow map).
+        size_t size() const {
+            return m_size.load(std::memory_order_relaxed);
+        }
+
+        size_t overflowSize() const {
+            std::unique_lock lock(m_overflowLock);
+            return m_overflow.size();
+        }
+
+      private:
+        // Bound the probing so that a nearly full table does not degrade into a linear search.
+        static constexpr size_t MaxProbes = 64;
+
+        // Neither a pointer nor a descriptor handle.
+        static constexpr uint64_t Tombstone = ~0ull;
+
+        struct Slot {
+            std::atomic<uint64_t> key{0};
+            mutable std::atomic_flag lock = ATOMIC_FLAG_INIT;
+            Value value;
+        };
+
+        struct SlotLock {
+            SlotLock(const Slot& slot) : slot(slot) {
+                while (slot.lock.test_and_set(std::memory_order_acquire)) {
+                    YieldProcessor();
+                }
+            }
+
+            ~SlotLock() {
+                slot.lock.clear(std::memory_order_release);
+            }
+
+            const Slot& slot;
+        };
+
+        size_t hash(uint64_t key) const {
+            // Fibonacci hashing spreads the descriptor handles and COM pointers, which are multiples of a large stride.
+            return (size_t)((key * 0x9E3779B97F4A7C15ull) >> m_shift);
+        }
+
+        // Self is either const (for the readers) or not (for the writers).
+        template <typename Self, typename Accessor>
+        static bool access(Self& self, uint64_t key, Accessor&& accessor) {
+            while (true) {
+                Slot* const slot = self.lookup(key);
+                if (!slot) {
+                    break;
+                }
+
+                SlotLock lock(*slot);
+                if (slot->key.load(std::memory_order_relaxed) == key) {
+                    accessor(slot->value);
+                    return true;
+                }
+                // The key was evicted since we found it, it may have been claimed again in another slot.
+            }
+
+            if (!self.m_hasOverflow.load(std::memory_order_acquire)) {
+                return false;
+            }
+            std::unique_lock lock(self.m_overflowLock);
+            auto it = self.m_overflow.find(key);
+            if (it == self.m_overflow.end()) {
+                return false;
+            }
+            accessor(it->second);
+            return true;
+        }
+
+        // Find the slot holding the key. The probing skips the tombstones and stops at the first free slot.
+        Slot* lookup(uint64_t key) const {
+            assert(key && key != Tombstone);
+
+            size_t index = hash(key);
+            for (size_t i = 0; i < MaxProbes; i++, index = (index + 1) & m_mask) {
+                Slot& slot = m_slots[index];
+                const uint64_t current = slot.key.load(std::memory_order_acquire);
+                if (current == key) {
+                    return &slot;
+                }
+                if (!current) {
+                    break;
+                }
+            }
+            return nullptr;
+        }
+
+        // Claim a slot for the key, preferably the first tombstone of its probe sequence. Must be called with
+        // m_overflowLock held. Returns nullptr if the key is (or must go) in the overflow map.
+        Slot* claim(uint64_t key) {
+            // Another thread may have claimed the key before we took the lock.
+            Slot* const existing = lookup(key);
+            if (existing) {
+                return existing;
+            }
+            if (m_overflow.count(key)) {
+                return nullptr;
+            }
+
+            size_t index = hash(key);
+            for (size_t i = 0; i < MaxProbes; i++, index = (index + 1) & m_mask) {
+                Slot& slot = m_slots[index];
+                uint64_t current = slot.key.load(std::memory_order_acquire);
+                // Only the evictions modify a claimed slot, and only to turn it into a tombstone.
+                while (!current || current == Tombstone) {
+                    if (slot.key.compare_exchange_weak(current, key, std::memory_order_acq_rel)) {
+                        m_size.fetch_add(1, std::memory_order_relaxed);
+                        return &slot;
+                    }
+                }
+            }
+            return nullptr;
+        }
+
+        const uint32_t m_shift;
+        const size_t m_mask;
+        const std::unique_ptr<Slot[]> m_slots;
+        std::atomic<size_t> m_size{0};
+
+        mutable std::mutex m_overflowLock;
+        std::unordered_map<uint64_t, Value> m_overflow;
+        std::atomic<bool> m_hasOverflow{false};
     };
 
+    // A pool of descriptors. Freed descriptors are recycled through a free list. A shader-visible pool is a single
+    // heap (since only one heap of each type can be bound), while the other pools grow by pages when exhausted.
+    // Shader-visible descriptors must not be freed while the GPU may still use them.
+    // Views are released from whichever thread drops the last reference to them (eg: the application's thread when it
+    // destroys a swapchain), so allocations and frees are serialized with a lock.
     struct D3D12Heap {
-        void initialize(ID3D12Device* device, D3D12_DESCRIPTOR_HEAP_TYPE type, UINT numDescriptors = 32) {
-            D3D12_DESCRIPTOR_HEAP_DESC desc;
-            ZeroMemory(&desc, sizeof(desc));
-            heapSize = desc.NumDescriptors = numDescriptors;
-            desc.Type = type;
-            desc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_NONE;
-            if (type == D3D12_DESCRIPTOR_HEAP_TYPE_SAMPLER || type == D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV) {
-                desc.Flags |= D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE;
-            }
-            CHECK_HRCMD(device->CreateDescriptorHeap(&desc, IID_PPV_ARGS(set(heap))));
-            heapStartCPU = heap->GetCPUDescriptorHandleForHeapStart();
-            heapStartGPU = heap->GetGPUDescriptorHandleForHeapStart();
-            heapOffset = 0;
+        void initialize(ID3D12Device* device,
+                        D3D12_DESCRIPTOR_HEAP_TYPE type,
+                        UINT numDescriptors = 32,
+                        bool shaderVisible = false) {
+            this->device = device;
+            this->type = type;
+            this->shaderVisible = shaderVisible;
+            heapSize = numDescriptors;
             descSize = device->GetDescriptorHandleIncrementSize(type);
+            pages.clear();
+            freeList.clear();
+            numAllocated = 0;
+
+            addPage();
+            heap = pages[0];
+            heapStartCPU = heap->GetCPUDescriptorHandleForHeapStart();
+            if (shaderVisible) {
+                heapStartGPU = heap->GetGPUDescriptorHandleForHeapStart();
+            }
         }
 
         void allocate(D3D12_CPU_DESCRIPTOR_HANDLE& desc) {
-            assert((UINT)heapOffset < heapSize);
-            desc = CD3DX12_CPU_DESCRIPTOR_HANDLE(heapStartCPU, heapOffset++, descSize);
+            std::unique_lock lock(mutex);
+
+            if (!freeList.empty()) {
+                desc = freeList.back();
+                freeList.pop_back();
+            } else {
+                if ((UINT)heapOffset == heapSize) {
+                    if (shaderVisible) {
+                        throw std::runtime_error("Shader-visible descriptor heap is full");
+                    }
+                    addPage();
+                }
+                desc = CD3DX12_CPU_DESCRIPTOR_HANDLE(
+                    pages.back()->GetCPUDescriptorHandleForHeapStart(), heapOffset++, descSize);
+            }
+            numAllocated++;
         }
 
-        // TODO: Implement freeing a descriptor
+        void free(D3D12_CPU_DESCRIPTOR_HANDLE desc) {
+            std::unique_lock lock(mutex);
+
+            assert(numAllocated > 0);
+            freeList.push_back(desc);
+            numAllocated--;
+        }
 
         D3D12_GPU_DESCRIPTOR_HANDLE getGPUHandle(D3D12_CPU_DESCRIPTOR_HANDLE cpuHandle) const {
+            assert(shaderVisible);
             INT64 offset = (cpuHandle.ptr - heapStartCPU.ptr) / descSize;
             return CD3DX12_GPU_DESCRIPTOR_HANDLE(heapStartGPU, (INT)offset, descSize);
         }
 
+        UINT getCapacity() const {
+            std::unique_lock lock(mutex);
+
+            return (UINT)pages.size() * heapSize;
+        }
+
+        void addStatistics(DescriptorStatistics& stats) const {
+            std::unique_lock lock(mutex);
+
+            stats.numAllocated += numAllocated;
+            stats.numReserved += (UINT)pages.size() * heapSize;
+            stats.numFree += (uint32_t)freeList.size();
+        }
+
+        void addPage() {
+            D3D12_DESCRIPTOR_HEAP_DESC desc;
+            ZeroMemory(&desc, sizeof(desc));
+            desc.NumDescriptors = heapSize;
+            desc.Type = type;
+            desc.Flags = shaderVisible ? D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE : D3D12_DESCRIPTOR_HEAP_FLAG_NONE;
+            ComPtr<ID3D12DescriptorHeap> page;
+            CHECK_HRCMD(device->CreateDescriptorHeap(&desc, IID_PPV_ARGS(set(page))));
+            pages.push_back(page);
+            heapOffset = 0;
+        }
+
+        ID3D12Device* device{nullptr};
+        D3D12_DESCRIPTOR_HEAP_TYPE type;
+        bool shaderVisible{false};
         UINT heapSize{0};
         ComPtr<ID3D12DescriptorHeap> heap;
+        std::vector<ComPtr<ID3D12DescriptorHeap>> pages;
+        std::vector<D3D12_CPU_DESCRIPTOR_HANDLE> freeList;
         D3D12_CPU_DESCRIPTOR_HANDLE heapStartCPU;
         D3D12_GPU_DESCRIPTOR_HANDLE heapStartGPU;
         INT heapOffset{0};
         UINT descSize;
+        UINT numAllocated{0};
+
+        mutable std::mutex mutex;
+    };
+
+    // A ring of shader-visible descriptors. The descriptors are copied into the ring when bound for a draw or a
+    // dispatch, and each slot is recycled once the command list that referenced it has completed on the GPU.
+    struct D3D12DescriptorRing {
+        void initialize(ID3D12Device* device,
+                        ID3D12Fence* fence,
+                        D3D12_DESCRIPTOR_HEAP_TYPE type,
+                        UINT numDescriptors) {
+            this->device = device;
+            this->fence = fence;
+            this->type = type;
+            ringSize = numDescriptors;
+            descSize = device->GetDescriptorHandleIncrementSize(type);
+
+            D3D12_DESCRIPTOR_HEAP_DESC desc;
+            ZeroMemory(&desc, sizeof(desc));
+            desc.NumDescriptors = numDescriptors;
+            desc.Type = type;
+            desc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE;
+            CHECK_HRCMD(device->CreateDescriptorHeap(&desc, IID_PPV_ARGS(set(heap))));
+            heapStartCPU = heap->GetCPUDescriptorHandleForHeapStart();
+            heapStartGPU = heap->GetGPUDescriptorHandleForHeapStart();
+
+            *event.put() = CreateEventEx(nullptr, L"Descriptor Ring Fence", 0, EVENT_ALL_ACCESS);
+        }
+
+        D3D12_GPU_DESCRIPTOR_HANDLE copy(D3D12_CPU_DESCRIPTOR_HANDLE source) {
+            if (head - tail == ringSize) {
+                reclaim(true /* wait */);
+            }
+
+            const UINT index = (UINT)(head++ % ringSize);
+            device->CopyDescriptorsSimple(
+                1, CD3DX12_CPU_DESCRIPTOR_HANDLE(heapStartCPU, index, descSize), source, type);
+            peakUsage = std::max(peakUsage, (UINT)(head - tail));
+
+            return CD3DX12_GPU_DESCRIPTOR_HANDLE(heapStartGPU, index, descSize);
+        }
+
+        // Mark the end of the slots referenced by the command list that was just submitted.
+        void submit(UINT64 fenceValue) {
+            if (head != (inflight.empty() ? tail : inflight.back().second)) {
+                inflight.push_back(std::make_pair(fenceValue, head));
+            }
+            reclaim(false /* wait */);
+        }
+
+        void reclaim(bool wait) {
+            const auto completedValue = fence->GetCompletedValue();
+            while (!inflight.empty() && inflight.front().first <= completedValue) {
+                tail = inflight.front().second;
+                inflight.pop_front();
+            }
+
+            if (wait && head - tail == ringSize) {
+                // The only way out is to wait for the oldest command list to complete.
+                if (inflight.empty()) {
+                    throw std::runtime_error("Descriptor ring is too small for a single command list");
+                }
+                numStalls++;
+                CHECK_HRCMD(fence->SetEventOnCompletion(inflight.front().first, event.get()));
+                WaitForSingleObject(event.get(), INFINITE);
+                tail = inflight.front().second;
+                inflight.pop_front();
+            }
+        }
+
+        ID3D12Device* device{nullptr};
+        ID3D12Fence* fence{nullptr};
+        D3D12_DESCRIPTOR_HEAP_TYPE type;
+        UINT ringSize{0};
+        ComPtr<ID3D12DescriptorHeap> heap;
+        D3D12_CPU_DESCRIPTOR_HANDLE heapStartCPU;
+        D3D12_GPU_DESCRIPTOR_HANDLE heapStartGPU;
+        UINT descSize;
+        wil::unique_handle event;
+
+        // Monotonic slot counters. The slots in [tail, head) are possibly in use by the GPU.
+        UINT64 head{0};
+        UINT64 tail{0};
+        std::deque<std::pair<UINT64, UINT64>> inflight; // fence value, head at submission
+
+        UINT peakUsage{0};
+        UINT numStalls{0};
+    };
+
+    // A persistently mapped upload heap for the constant buffers, suballocated like the descriptor ring above. The
+    // constant buffer views are pointed to the suballocations.
+    struct D3D12ConstantRing {
+        struct Allocation {
+            UINT64 position;
+            D3D12_GPU_VIRTUAL_ADDRESS gpuAddress;
+            UINT size;
+        };
+
+        void initialize(ID3D12Device* device, ID3D12Fence* fence, UINT size) {
+            this->fence = fence;
+            ringSize = size;
+
+            const auto& heapType = CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD);
+            const auto desc = CD3DX12_RESOURCE_DESC::Buffer(ringSize);
+            CHECK_HRCMD(device->CreateCommittedResource(&heapType,
+                                                        D3D12_HEAP_FLAG_NONE,
+                                                        &desc,
+                                                        D3D12_RESOURCE_STATE_GENERIC_READ,
+                                                        nullptr,
+                                                        IID_PPV_ARGS(set(buffer))));
+            buffer->SetName(L"Constant Ring");
+
+            // Upload heaps can stay mapped for their entire lifetime.
+            D3D12_RANGE noRead{0, 0};
+            CHECK_HRCMD(buffer->Map(0, &noRead, reinterpret_cast<void**>(&cpuAddress)));
+            gpuAddress = buffer->GetGPUVirtualAddress();
+
+            *event.put() = CreateEventEx(nullptr, L"Constant Ring Fence", 0, EVENT_ALL_ACCESS);
+        }
+
+        Allocation allocate(const void* data, size_t size) {
+            const UINT alignedSize = alignTo((UINT)size, D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT);
+            if (alignedSize > ringSize) {
+                throw std::runtime_error("Constant buffer is larger than the ring");
+            }
+
+            // Allocations are contiguous: skip the end of the ring if needed.
+            UINT offset = (UINT)(head % ringSize);
+            if (offset + alignedSize > ringSize) {
+                head += ringSize - offset;
+                offset = 0;
+            }
+            reclaim(alignedSize);
+
+            memcpy(cpuAddress + offset, data, size);
+            const Allocation allocation{head, gpuAddress + offset, alignedSize};
+            head += alignedSize;
+            peakUsage = std::max(peakUsage, (UINT)(head - tail));
+            numUploads++;
+
+            return allocation;
+        }
+
+        // Whether the content of the allocation was not overwritten by a more recent allocation.
+        bool isAlive(const Allocation& allocation) const {
+            return head - allocation.position <= ringSize;
+        }
+
+        // Mark the end of the allocations referenced by the command list that was just submitted.
+        void submit(UINT64 fenceValue) {
+            if (head != (inflight.empty() ? tail : inflight.back().second)) {
+                inflight.push_back(std::make_pair(fenceValue, head));
+            }
+            reclaim(0);
+        }
+
+        void reclaim(UINT required) {
+            const auto completedValue = fence->GetCompletedValue();
+            while (!inflight.empty() && inflight.front().first <= completedValue) {
+                tail = inflight.front().second;
+                inflight.pop_front();
+            }
+
+            while (head + required - tail > ringSize) {
+                // The only way out is to wait for the oldest command list to complete.
+                if (inflight.empty()) {
+                    throw std::runtime_error("Constant ring is too small for a single command list");
+                }
+                numStalls++;
+                CHECK_HRCMD(fence->SetEventOnCompletion(inflight.front().first, event.get()));
+                WaitForSingleObject(event.get(), INFINITE);
+                tail = inflight.front().second;
+                inflight.pop_front();
+            }
+        }
+
+        ID3D12Fence* fence{nullptr};
+        UINT ringSize{0};
+        ComPtr<ID3D12Resource> buffer;
+        uint8_t* cpuAddress{nullptr};
+        D3D12_GPU_VIRTUAL_ADDRESS gpuAddress{0};
+        wil::unique_handle event;
+
+        // Monotonic byte counters. The bytes in [tail, head) are possibly in use by the GPU.
+        UINT64 head{0};
+        UINT64 tail{0};
+        std::deque<std::pair<UINT64, UINT64>> inflight; // fence value, head at submission
+
+        UINT peakUsage{0};
+        UINT numStalls{0};
+        uint32_t numUploads{0};
+        uint32_t numSkippedUploads{0};
     };
 
     // Wrap shader resources, common code for root signature creation.
@@ -212,6 +694,11 @@ namespace {
             return m_device;
         }
 
+        // Like the output format, the vertex shader is set in the pipeline state upon first use.
+        void setVertexShader(ID3DBlob* shaderBytes) {
+            m_psoDesc.VS = {reinterpret_cast<BYTE*>(shaderBytes->GetBufferPointer()), shaderBytes->GetBufferSize()};
+        }
+
         void resolve() override {
             // Create the root signature now.
             D3D12Shader::resolve();
@@ -336,8 +823,13 @@ namespace {
                               public IRenderTargetView,
                               public IDepthStencilView {
       public:
-        D3D12ResourceView(std::shared_ptr<IDevice> device, D3D12_CPU_DESCRIPTOR_HANDLE resourceView)
-            : m_device(device), m_resourceView(resourceView) {
+        D3D12ResourceView(std::shared_ptr<IDevice> device, D3D12_CPU_DESCRIPTOR_HANDLE resourceView, D3D12Heap& heap)
+            : m_device(device), m_resourceView(resourceView), m_heap(heap) {
+        }
+
+        ~D3D12ResourceView() override {
+            // The descriptor is not shader-visible, it can be reused immediately.
+            m_heap.free(m_resourceView);
         }
 
         Api getApi() const override {
@@ -355,6 +847,7 @@ namespace {
       private:
         const std::shared_ptr<IDevice> m_device;
         const D3D12_CPU_DESCRIPTOR_HANDLE m_resourceView;
+        D3D12Heap& m_heap;
     };
 
     // Wrap a texture resource. Obtained from D3D12Device.
@@ -367,15 +860,31 @@ namespace {
                      D3D12_RESOURCE_STATES initialState,
                      D3D12Heap& rtvHeap,
                      D3D12Heap& dsvHeap,
-                     D3D12Heap& rvHeap)
-            : m_device(device), m_info(info), m_textureDesc(textureDesc), m_texture(texture),
+                     D3D12Heap& rvHeap,
+                     bool ownsTexture = true)
+            : m_device(device), m_info(info), m_textureDesc(textureDesc), m_ownsTexture(ownsTexture),
               m_currentState(initialState), m_rtvHeap(rtvHeap), m_dsvHeap(dsvHeap), m_rvHeap(rvHeap) {
+            // A wrapper that does not own the texture must not outlive it (eg: the wrappers cached for the
+            // application's render targets). Holding a reference would otherwise prevent the application from
+            // releasing its resources, for example during a swapchain resize.
+            if (m_ownsTexture) {
+                m_texture = texture;
+            } else {
+                m_texture.Attach(texture);
+            }
+
             m_shaderResourceSubView.resize(info.arraySize);
             m_unorderedAccessSubView.resize(info.arraySize);
             m_renderTargetSubView.resize(info.arraySize);
             m_depthStencilSubView.resize(info.arraySize);
         }
 
+        ~D3D12Texture() override {
+            if (!m_ownsTexture) {
+                m_texture.Detach();
+            }
+        }
+
         Api getApi() const override {
             return Api::D3D12;
         }
@@ -394,25 +903,31 @@ namespace {
 
         std::shared_ptr<IShaderInputTextureView> getShaderResourceView(int32_t slice) const override {
             assert(slice < 0 || m_shaderResourceSubView.size() > size_t(slice));
-            auto& view = slice < 0 ? m_shaderResourceView : m_shaderResourceSubView[slice];
+            auto& view = slice == AllSlices ? m_shaderResourceArrayView
+                         : slice < 0        ? m_shaderResourceView
+                                            : m_shaderResourceSubView[slice];
             if (!view)
-                view = makeShaderInputViewInternal(std::max(slice, 0));
+                view = makeShaderInputViewInternal(slice);
             return view;
         }
 
         std::shared_ptr<IComputeShaderOutputView> getUnorderedAccessView(int32_t slice) const override {
             assert(slice < 0 || m_unorderedAccessSubView.size() > size_t(slice));
-            auto& view = slice < 0 ? m_unorderedAccessView : m_unorderedAccessSubView[slice];
+            auto& view = slice == AllSlices ? m_unorderedAccessArrayView
+                         : slice < 0        ? m_unorderedAccessView
+                                            : m_unorderedAccessSubView[slice];
             if (!view)
-                view = makeUnorderedAccessViewInternal(std::max(slice, 0));
+                view = makeUnorderedAccessViewInternal(slice);
             return view;
         }
 
         std::shared_ptr<IRenderTargetView> getRenderTargetView(int32_t slice) const override {
             assert(slice < 0 || m_renderTargetSubView.size() > size_t(slice));
-            auto& view = slice < 0 ? m_renderTargetView : m_renderTargetSubView[slice];
+            auto& view = slice == AllSlices ? m_renderTargetArrayView
+                         : slice < 0        ? m_renderTargetView
+                                            : m_renderTargetSubView[slice];
             if (!view)
-                view = makeRenderTargetViewInternal(std::max(slice, 0));
+                view = makeRenderTargetViewInternal(slice);
             return view;
         }
 
@@ -590,7 +1105,9 @@ namespace {
         }
 
       private:
-        std::shared_ptr<D3D12ResourceView> makeShaderInputViewInternal(uint32_t slice) const {
+        // With AllSlices, the view covers the whole texture array. Otherwise, it covers one slice (the first one
+        // without a slice).
+        std::shared_ptr<D3D12ResourceView> makeShaderInputViewInternal(int32_t slice) const {
             if (m_textureDesc.Flags & D3D12_RESOURCE_FLAG_DENY_SHADER_RESOURCE) {
                 throw std::runtime_error("Texture was created with D3D12_RESOURCE_FLAG_DENY_SHADER_RESOURCE");
             }
@@ -601,42 +1118,42 @@ namespace {
                 desc.ViewDimension =
                     m_info.arraySize == 1 ? D3D12_SRV_DIMENSION_TEXTURE2D : D3D12_SRV_DIMENSION_TEXTURE2DARRAY;
                 desc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
-                desc.Texture2DArray.ArraySize = 1;
-                desc.Texture2DArray.FirstArraySlice = slice;
+                desc.Texture2DArray.ArraySize = slice == AllSlices ? m_info.arraySize : 1;
+                desc.Texture2DArray.FirstArraySlice = std::max(slice, 0);
                 desc.Texture2DArray.MipLevels = m_info.mipCount;
                 desc.Texture2DArray.MostDetailedMip = D3D12CalcSubresource(0, 0, 0, m_info.mipCount, m_info.arraySize);
 
                 D3D12_CPU_DESCRIPTOR_HANDLE handle;
                 m_rvHeap.allocate(handle);
                 device->CreateShaderResourceView(get(m_texture), &desc, handle);
-                return std::make_shared<D3D12ResourceView>(m_device, handle);
+                return std::make_shared<D3D12ResourceView>(m_device, handle, m_rvHeap);
             }
             return nullptr;
         }
 
-        std::shared_ptr<D3D12ResourceView> makeUnorderedAccessViewInternal(uint32_t slice) const {
+        std::shared_ptr<D3D12ResourceView> makeUnorderedAccessViewInternal(int32_t slice) const {
             if (!(m_textureDesc.Flags & D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS)) {
                 throw std::runtime_error("Texture was not created with D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS");
             }
             if (auto device = m_device->getAs<D3D12>()) {
                 D3D12_UNORDERED_ACCESS_VIEW_DESC desc;
                 ZeroMemory(&desc, sizeof(desc));
-                desc.Format = (DXGI_FORMAT)m_info.format;
+                desc.Format = GetUnorderedAccessViewFormat((DXGI_FORMAT)m_info.format);
                 desc.ViewDimension =
                     m_info.arraySize == 1 ? D3D12_UAV_DIMENSION_TEXTURE2D : D3D12_UAV_DIMENSION_TEXTURE2DARRAY;
-                desc.Texture2DArray.ArraySize = 1;
-                desc.Texture2DArray.FirstArraySlice = slice;
+                desc.Texture2DArray.ArraySize = slice == AllSlices ? m_info.arraySize : 1;
+                desc.Texture2DArray.FirstArraySlice = std::max(slice, 0);
                 desc.Texture2DArray.MipSlice = D3D12CalcSubresource(0, 0, 0, m_info.mipCount, m_info.arraySize);
 
                 D3D12_CPU_DESCRIPTOR_HANDLE handle;
                 m_rvHeap.allocate(handle);
                 device->CreateUnorderedAccessView(get(m_texture), nullptr, &desc, handle);
-                return std::make_shared<D3D12ResourceView>(m_device, handle);
+                return std::make_shared<D3D12ResourceView>(m_device, handle, m_rvHeap);
             }
             return nullptr;
         }
 
-        std::shared_ptr<D3D12ResourceView> makeRenderTargetViewInternal(uint32_t slice) const {
+        std::shared_ptr<D3D12ResourceView> makeRenderTargetViewInternal(int32_t slice) const {
             if (!(m_textureDesc.Flags & D3D12_RESOURCE_FLAG_ALLOW_RENDER_TARGET)) {
                 throw std::runtime_error("Texture was not created with D3D12_RESOURCE_FLAG_ALLOW_RENDER_TARGET");
             }
@@ -646,14 +1163,14 @@ namespace {
                 desc.Format = (DXGI_FORMAT)m_info.format;
                 desc.ViewDimension =
                     m_info.arraySize == 1 ? D3D12_RTV_DIMENSION_TEXTURE2D : D3D12_RTV_DIMENSION_TEXTURE2DARRAY;
-                desc.Texture2DArray.ArraySize = 1;
-                desc.Texture2DArray.FirstArraySlice = slice;
+                desc.Texture2DArray.ArraySize = slice == AllSlices ? m_info.arraySize : 1;
+                desc.Texture2DArray.FirstArraySlice = std::max(slice, 0);
                 desc.Texture2DArray.MipSlice = D3D12CalcSubresource(0, 0, 0, m_info.mipCount, m_info.arraySize);
 
                 D3D12_CPU_DESCRIPTOR_HANDLE handle;
                 m_rtvHeap.allocate(handle);
                 device->CreateRenderTargetView(get(m_texture), &desc, handle);
-                return std::make_shared<D3D12ResourceView>(m_device, handle);
+                return std::make_shared<D3D12ResourceView>(m_device, handle, m_rtvHeap);
             }
             return nullptr;
         }
@@ -675,7 +1192,7 @@ namespace {
                 D3D12_CPU_DESCRIPTOR_HANDLE handle;
                 m_dsvHeap.allocate(handle);
                 device->CreateDepthStencilView(get(m_texture), &desc, handle);
-                return std::make_shared<D3D12ResourceView>(m_device, handle);
+                return std::make_shared<D3D12ResourceView>(m_device, handle, m_dsvHeap);
             }
             return nullptr;
         }
@@ -697,7 +1214,8 @@ namespace {
         const std::shared_ptr<IDevice> m_device;
         const XrSwapchainCreateInfo m_info;
         const D3D12_RESOURCE_DESC m_textureDesc;
-        const ComPtr<ID3D12Resource> m_texture;
+        const bool m_ownsTexture;
+        ComPtr<ID3D12Resource> m_texture;
 
         D3D12_RESOURCE_STATES m_currentState;
         std::vector<D3D12_RESOURCE_STATES> m_stateStack;
@@ -712,10 +1230,13 @@ namespace {
         D3D12Heap& m_rvHeap;
 
         mutable std::shared_ptr<D3D12ResourceView> m_shaderResourceView;
+        mutable std::shared_ptr<D3D12ResourceView> m_shaderResourceArrayView;
         mutable std::vector<std::shared_ptr<D3D12ResourceView>> m_shaderResourceSubView;
         mutable std::shared_ptr<D3D12ResourceView> m_unorderedAccessView;
+        mutable std::shared_ptr<D3D12ResourceView> m_unorderedAccessArrayView;
         mutable std::vector<std::shared_ptr<D3D12ResourceView>> m_unorderedAccessSubView;
         mutable std::shared_ptr<D3D12ResourceView> m_renderTargetView;
+        mutable std::shared_ptr<D3D12ResourceView> m_renderTargetArrayView;
         mutable std::vector<std::shared_ptr<D3D12ResourceView>> m_renderTargetSubView;
         mutable std::shared_ptr<D3D12ResourceView> m_depthStencilView;
         mutable std::vector<std::shared_ptr<D3D12ResourceView>> m_depthStencilSubView;
@@ -735,6 +1256,22 @@ namespace {
               m_rvHeap(rvHeap), m_uploadBuffer(uploadBuffer) {
         }
 
+        // A constant buffer suballocated from the constant ring upon each upload.
+        D3D12Buffer(std::shared_ptr<IDevice> device,
+                    D3D12_RESOURCE_DESC bufferDesc,
+                    D3D12ConstantRing& constantRing,
+                    D3D12Heap& rvHeap)
+            : m_device(device), m_bufferDesc(bufferDesc), m_buffer(constantRing.buffer),
+              m_currentState(D3D12_RESOURCE_STATE_GENERIC_READ), m_rvHeap(rvHeap), m_constantRing(&constantRing),
+              m_shadowData(bufferDesc.Width, 0) {
+        }
+
+        ~D3D12Buffer() override {
+            if (m_constantBufferView) {
+                m_rvHeap.free(m_constantBufferView.value());
+            }
+        }
+
         Api getApi() const override {
             return Api::D3D12;
         }
@@ -756,6 +1293,21 @@ namespace {
         }
 
         void uploadData(const void* buffer, size_t count) override {
+            if (m_constantRing) {
+                count = std::min(count, m_shadowData.size());
+
+                // Keep binding the previous allocation if the content did not change.
+                if (m_allocation && m_constantRing->isAlive(m_allocation.value()) &&
+                    !memcmp(m_shadowData.data(), buffer, count)) {
+                    m_constantRing->numSkippedUploads++;
+                    return;
+                }
+
+                memcpy(m_shadowData.data(), buffer, count);
+                allocate();
+                return;
+            }
+
             if (!m_uploadBuffer) {
                 throw std::runtime_error("Buffer is immutable");
             }
@@ -764,6 +1316,14 @@ namespace {
 
         // TODO: Consider moving this operation up to IShaderBuffer. Will prevent the need for dynamic_cast below.
         D3D12_CPU_DESCRIPTOR_HANDLE getConstantBufferView() const {
+            if (m_constantRing) {
+                // Never uploaded, or overwritten since.
+                if (!m_allocation || !m_constantRing->isAlive(m_allocation.value())) {
+                    allocate();
+                }
+                return m_constantBufferView.value();
+            }
+
             if (!m_constantBufferView) {
                 {
                     D3D12_CPU_DESCRIPTOR_HANDLE handle;
@@ -785,7 +1345,8 @@ namespace {
         void pushState(D3D12_RESOURCE_STATES newState) override {
             m_stateStack.push_back(m_currentState);
 
-            if (newState != m_currentState) {
+            // Resources in an upload heap cannot transition.
+            if (newState != m_currentState && !m_constantRing) {
                 const auto barrier = CD3DX12_RESOURCE_BARRIER::Transition(get(m_buffer), m_currentState, newState);
                 m_device->getContextAs<D3D12>()->ResourceBarrier(1, &barrier);
             }
@@ -797,7 +1358,7 @@ namespace {
             const auto newState = m_stateStack.back();
             m_stateStack.pop_back();
 
-            if (newState != m_currentState) {
+            if (newState != m_currentState && !m_constantRing) {
                 const auto barrier = CD3DX12_RESOURCE_BARRIER::Transition(get(m_buffer), m_currentState, newState);
                 m_device->getContextAs<D3D12>()->ResourceBarrier(1, &barrier);
             }
@@ -810,6 +1371,24 @@ namespace {
         }
 
       private:
+        void allocate() const {
+            m_allocation = m_constantRing->allocate(m_shadowData.data(), m_shadowData.size());
+
+            if (!m_constantBufferView) {
+                D3D12_CPU_DESCRIPTOR_HANDLE handle;
+                m_rvHeap.allocate(handle);
+                m_constantBufferView = handle;
+            }
+
+            // The view is copied to the shader-visible ring when bound, so it can be updated in place.
+            if (auto device = m_device->getAs<D3D12>()) {
+                D3D12_CONSTANT_BUFFER_VIEW_DESC desc;
+                desc.BufferLocation = m_allocation->gpuAddress;
+                desc.SizeInBytes = m_allocation->size;
+                device->CreateConstantBufferView(&desc, m_constantBufferView.value());
+            }
+        }
+
         const std::shared_ptr<IDevice> m_device;
         const D3D12_RESOURCE_DESC m_bufferDesc;
         const ComPtr<ID3D12Resource> m_buffer;
@@ -821,6 +1400,10 @@ namespace {
 
         const ComPtr<ID3D12Resource> m_uploadBuffer;
 
+        D3D12ConstantRing* const m_constantRing{nullptr};
+        std::vector<uint8_t> m_shadowData;
+        mutable std::optional<D3D12ConstantRing::Allocation> m_allocation;
+
         mutable std::optional<D3D12_CPU_DESCRIPTOR_HANDLE> m_constantBufferView;
     };
 
@@ -866,15 +1449,12 @@ namespace {
         mutable struct D3D12::MeshData m_meshData;
     };
 
-    class D3D12GpuTimer : public IGpuTimer {
+    // Wrap an application's command list. The wrapper does not hold a reference to the command list (see
+    // CommandListWrappers), so it must not be used once the command list is destroyed.
+    class D3D12Context : public graphics::IContext {
       public:
-        D3D12GpuTimer(std::shared_ptr<IDevice> device,
-                      ID3D12QueryHeap* queryHeap,
-                      std::function<uint64_t(UINT, UINT)> queryTimestampDelta,
-                      UINT startIndex,
-                      UINT stopIndex)
-            : m_device(device), m_queryHeap(queryHeap), m_queryTimestampDelta(queryTimestampDelta),
-              m_startIndex(startIndex), m_stopIndex(stopIndex) {
+        D3D12Context(std::shared_ptr<IDevice> device, ID3D12GraphicsCommandList* context)
+            : m_device(device), m_context(context) {
         }
 
         Api getApi() const override {
@@ -885,48 +1465,191 @@ namespace {
             return m_device;
         }
 
-        void start() override {
-            m_device->getContextAs<D3D12>()->EndQuery(get(m_queryHeap), D3D12_QUERY_TYPE_TIMESTAMP, m_startIndex);
+        void* getNativePtr() const override {
+            return m_context;
+        }
+
+      private:
+        const std::shared_ptr<IDevice> m_device;
+        ID3D12GraphicsCommandList* const m_context;
+    };
+
+    // The wrappers for the application's command lists, keyed by command list. The entries do not hold a reference to
+    // the command lists, instead they are evicted when the command list is destroyed (see WrapperCacheTag). The
+    // generation tells apart the successive command lists created at the same address.
+    class CommandListWrappers : public IWrapperCache, public std::enable_shared_from_this<CommandListWrappers> {
+      public:
+        struct Entry {
+            uint64_t generation{0};
+            // A known command list may have a null wrapper (eg: a command list from another device).
+            std::shared_ptr<D3D12Context> context;
+        };
+
+        // Returns false if the command list is unknown.
+        bool find(ID3D12GraphicsCommandList* commandList, std::shared_ptr<D3D12Context>& context) const {
+            bool isKnown = false;
+            m_entries.find((uint64_t)commandList, [&](const Entry& entry) {
+                isKnown = entry.generation != 0;
+                context = entry.context;
+            });
+            return isKnown;
+        }
+
+        // Returns the wrapper that ends up in the cache, in case another thread inserted one first.
+        std::shared_ptr<D3D12Context> insert(ID3D12GraphicsCommandList* commandList,
+                                             std::shared_ptr<D3D12Context> context) {
+            uint64_t generation = 0;
+            m_entries.update((uint64_t)commandList, [&](Entry& entry) {
+                if (!entry.generation) {
+                    generation = entry.generation = ++m_generation;
+                    entry.context = context;
+                } else {
+                    context = entry.context;
+                }
+            });
+
+            if (generation) {
+                // Replacing an existing tag releases it, which calls evict(): this must happen outside of the lock.
+                auto tag = Microsoft::WRL::Make<WrapperCacheTag>(weak_from_this(), commandList, generation);
+                commandList->SetPrivateDataInterface(__uuidof(IWrapperCacheTag), get(tag));
+            }
+            return context;
         }
 
-        void stop() override {
-            m_device->getContextAs<D3D12>()->EndQuery(get(m_queryHeap), D3D12_QUERY_TYPE_TIMESTAMP, m_stopIndex);
+        void evict(const void* object, uint64_t generation) override {
+            m_entries.evict((uint64_t)object, [&](const Entry& entry) { return entry.generation == generation; });
         }
 
-        uint64_t query(bool reset) const override {
-            return m_queryTimestampDelta(m_startIndex, m_stopIndex);
+        void clear() {
+            m_entries.clear();
         }
 
       private:
-        const std::shared_ptr<IDevice> m_device;
-        const ComPtr<ID3D12QueryHeap> m_queryHeap;
-        const std::function<uint64_t(UINT, UINT)> m_queryTimestampDelta;
-        const UINT m_startIndex;
-        const UINT m_stopIndex;
+        ConcurrentPointerTable<Entry> m_entries{10};
+        std::atomic<uint64_t> m_generation{0};
     };
 
-    // Wrap a device context.
-    class D3D12Context : public graphics::IContext {
+    // The resources bound to the application's render target descriptors, keyed by descriptor, and the wrappers
+    // created for them. Neither the descriptor nor the wrapper hold a reference to the resource, so the entries
+    // referencing a resource are evicted when the resource is destroyed (see WrapperCacheTag), and when the
+    // application creates another view in the descriptor.
+    class RenderTargetDescriptors : public IWrapperCache,
+                                    public std::enable_shared_from_this<RenderTargetDescriptors> {
       public:
-        D3D12Context(std::shared_ptr<IDevice> device, ID3D12GraphicsCommandList* context)
-            : m_device(device), m_context(context) {
+        struct Entry {
+            ID3D12Resource* resource{nullptr};
+            D3D12_RESOURCE_DESC resourceDesc;
+            std::shared_ptr<D3D12Texture> texture;
+        };
+
+        // Returns false if the entry went to the (slower) overflow map.
+        bool registerView(D3D12_CPU_DESCRIPTOR_HANDLE handle,
+                          ID3D12Resource* resource,
+                          const D3D12_RESOURCE_DESC& resourceDesc) {
+            // Keep the cached wrapper when the application re-creates the same view, and release it outside of the
+            // slot lock otherwise.
+            std::shared_ptr<D3D12Texture> staleTexture;
+            return m_entries.update(handle.ptr, [&](Entry& entry) {
+                if (entry.resource != resource || memcmp(&entry.resourceDesc, &resourceDesc, sizeof(resourceDesc))) {
+                    entry.resource = resource;
+                    entry.resourceDesc = resourceDesc;
+                    std::swap(staleTexture, entry.texture);
+                }
+            });
+        }
+
+        // Return the wrapper for the resource bound to the descriptor, if any. The factory is invoked (outside of the
+        // slot lock) to create the wrapper the first time the descriptor is used.
+        template <typename Factory>
+        std::shared_ptr<D3D12Texture> getTexture(D3D12_CPU_DESCRIPTOR_HANDLE handle,
+                                                 Factory&& factory,
+                                                 ComPtr<ID3D12Resource>& resource) {
+            Entry entry;
+            m_entries.find(handle.ptr, [&](const Entry& cached) { entry = cached; });
+            if (!entry.resource) {
+                return nullptr;
+            }
+            resource = entry.resource;
+            if (entry.texture) {
+                return entry.texture;
+            }
+
+            auto texture = factory(entry);
+
+            // Another thread may have created a wrapper first, or the application may have re-created the view in the
+            // meantime (then the wrapper is only used for this call).
+            std::shared_ptr<D3D12Texture> existingTexture;
+            bool inserted = false;
+            m_entries.modify(handle.ptr, [&](Entry& cached) {
+                if (cached.resource != entry.resource ||
+                    memcmp(&cached.resourceDesc, &entry.resourceDesc, sizeof(entry.resourceDesc))) {
+                    return;
+                }
+                if (!cached.texture) {
+                    cached.texture = texture;
+                    inserted = true;
+                } else {
+                    existingTexture = cached.texture;
+                }
+            });
+
+            if (inserted) {
+                trackResource(get(resource), handle.ptr);
+            }
+            return existingTexture ? existingTexture : texture;
         }
 
-        Api getApi() const override {
-            return Api::D3D12;
+        void evict(const void* object, uint64_t /* generation */) override {
+            std::vector<uint64_t> descriptors;
+            {
+                std::unique_lock lock(m_resourcesLock);
+                auto it = m_resources.find(object);
+                if (it == m_resources.end()) {
+                    return;
+                }
+                std::swap(descriptors, it->second);
+                m_resources.erase(it);
+            }
+
+            for (const auto descriptor : descriptors) {
+                m_entries.evict(descriptor, [&](const Entry& entry) { return entry.resource == object; });
+            }
         }
 
-        std::shared_ptr<IDevice> getDevice() const override {
-            return m_device;
+        void clear() {
+            m_entries.clear();
+
+            std::unique_lock lock(m_resourcesLock);
+            m_resources.clear();
         }
 
-        void* getNativePtr() const override {
-            return get(m_context);
+        size_t size() const {
+            return m_entries.size();
         }
 
       private:
-        const std::shared_ptr<IDevice> m_device;
-        const ComPtr<ID3D12GraphicsCommandList> m_context;
+        // Remember which descriptors reference the resource, and tag the resource the first time.
+        void trackResource(ID3D12Resource* resource, uint64_t descriptor) {
+            {
+                std::unique_lock lock(m_resourcesLock);
+                auto& descriptors = m_resources[resource];
+                const bool isTagged = !descriptors.empty();
+                if (std::find(descriptors.cbegin(), descriptors.cend(), descriptor) == descriptors.cend()) {
+                    descriptors.push_back(descriptor);
+                }
+                if (isTagged) {
+                    return;
+                }
+            }
+
+            auto tag = Microsoft::WRL::Make<WrapperCacheTag>(weak_from_this(), resource, 0);
+            resource->SetPrivateDataInterface(__uuidof(IWrapperCacheTag), get(tag));
+        }
+
+        ConcurrentPointerTable<Entry> m_entries{14};
+
+        std::mutex m_resourcesLock;
+        std::unordered_map<const void*, std::vector<uint64_t>> m_resources;
     };
 
     class D3D12Device : public IDevice, public std::enable_shared_from_this<D3D12Device> {
@@ -935,8 +1658,17 @@ namespace {
         // processing in two due to text rendering, so multiply this number by 2. Oh and also we have the app GPU
         // timer, so multiply again by 2.
         // We also perform eye tracked foveated rendering mask update in this context, which is dependent on the number
-        // of passes rendered by the app and the number of masks being used per frame. We chose 24 as a wide default.
-        static constexpr size_t NumInflightContexts = 8 + 24;
+        // of passes rendered by the app and the number of masks being used per frame. We chose 24 as a wide default
+        // (see SettingInflightContexts).
+        // Each allocator is only reset once the GPU has completed its previous command list, so a smaller number only
+        // trades memory for more frequent waits.
+        static constexpr int MinInflightContexts = 2;
+        static constexpr int MaxInflightContexts = 128;
+
+        struct MipMapBiasSettings {
+            config::MipMapBias type{config::MipMapBias::Off};
+            float bias{0.f};
+        };
 
       public:
         D3D12Device(ID3D12Device* device,
@@ -985,14 +1717,15 @@ namespace {
             }
 
             // Initialize the command lists and heaps.
+            // The resource views are kept in CPU-only heaps, and they are copied to the shader-visible ring upon use.
             m_rtvHeap.initialize(get(m_device), D3D12_DESCRIPTOR_HEAP_TYPE_RTV, 128);
             m_dsvHeap.initialize(get(m_device), D3D12_DESCRIPTOR_HEAP_TYPE_DSV, 128);
-            m_rvHeap.initialize(get(m_device), D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV, 128 + MaxModelBuffers);
-            m_samplerHeap.initialize(get(m_device), D3D12_DESCRIPTOR_HEAP_TYPE_SAMPLER);
+            m_rvHeap.initialize(get(m_device), D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV, 128);
+            m_samplerHeap.initialize(get(m_device), D3D12_DESCRIPTOR_HEAP_TYPE_SAMPLER, 32, true /* shaderVisible */);
             {
                 D3D12_QUERY_HEAP_DESC desc;
                 ZeroMemory(&desc, sizeof(desc));
-                desc.Count = MaxGpuTimers * 2;
+                desc.Count = ARRAYSIZE(m_gpuFrameQueries) * GpuFrameTimestamps::MaxTimestamps;
                 desc.NodeMask = 0;
                 desc.Type = D3D12_QUERY_HEAP_TYPE_TIMESTAMP;
                 m_device->CreateQueryHeap(&desc, IID_PPV_ARGS(set(m_queryHeap)));
@@ -1011,11 +1744,14 @@ namespace {
                                                                   IID_PPV_ARGS(set(m_queryReadbackBuffer))));
                     m_queryReadbackBuffer->SetName(L"Query Readback Buffer");
                 }
-
-                ZeroMemory(m_queryBuffer, sizeof(m_queryBuffer));
             }
             {
-                for (uint32_t i = 0; i < NumInflightContexts; i++) {
+                const size_t numInflightContexts = std::clamp(
+                    configManager->getValue(config::SettingInflightContexts), MinInflightContexts, MaxInflightContexts);
+                m_commandAllocator.resize(numInflightContexts);
+                m_commandList.resize(numInflightContexts);
+                m_commandAllocatorFenceValue.resize(numInflightContexts, 0);
+                for (uint32_t i = 0; i < numInflightContexts; i++) {
                     CHECK_HRCMD(m_device->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_DIRECT,
                                                                  IID_PPV_ARGS(&m_commandAllocator[i])));
                     CHECK_HRCMD(m_device->CreateCommandList(0,
@@ -1054,6 +1790,10 @@ namespace {
             }
 
             CHECK_HRCMD(m_device->CreateFence(0, D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(set(m_fence))));
+            *m_fenceEvent.put() = CreateEventEx(nullptr, L"flushContext Fence", 0, EVENT_ALL_ACCESS);
+            m_rvRing.initialize(
+                get(m_device), get(m_fence), D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV, DescriptorRingSize);
+            m_constantRing.initialize(get(m_device), get(m_fence), ConstantRingSize);
 
             initializeInterceptor();
             initializeShadingResources();
@@ -1067,17 +1807,27 @@ namespace {
 
         void shutdown() override {
             // Log some statistics for sizing.
-            DebugLog("heap statistics: samp=%u/%u, rtv=%u/%u, dsv=%u/%u, rv=%u/%u, query=%u/%u\n",
-                     m_samplerHeap.heapOffset,
-                     m_samplerHeap.heapSize,
-                     m_rtvHeap.heapOffset,
-                     m_rtvHeap.heapSize,
-                     m_dsvHeap.heapOffset,
-                     m_dsvHeap.heapSize,
-                     m_rvHeap.heapOffset,
-                     m_rvHeap.heapSize,
-                     m_nextGpuTimestampIndex,
-                     ARRAYSIZE(m_queryBuffer));
+            DebugLog("heap statistics: samp=%u/%u, rtv=%u/%u, dsv=%u/%u, rv=%u/%u, ring=%u/%u (%u stalls)\n",
+                     m_samplerHeap.numAllocated,
+                     m_samplerHeap.getCapacity(),
+                     m_rtvHeap.numAllocated,
+                     m_rtvHeap.getCapacity(),
+                     m_dsvHeap.numAllocated,
+                     m_dsvHeap.getCapacity(),
+                     m_rvHeap.numAllocated,
+                     m_rvHeap.getCapacity(),
+                     m_rvRing.peakUsage,
+                     m_rvRing.ringSize,
+                     m_rvRing.numStalls);
+            DebugLog("constant ring statistics: %u/%u (%u stalls), uploads=%u, skipped=%u\n",
+                     m_constantRing.peakUsage,
+                     m_constantRing.ringSize,
+                     m_constantRing.numStalls,
+                     m_constantRing.numUploads,
+                     m_constantRing.numSkippedUploads);
+            DebugLog("transient texture pool statistics: %zu/%zu\n",
+                     m_transientTextures.size(),
+                     m_transientTextures.peakSize());
 
             // Clear all references that could hold a cyclic reference themselves.
             m_currentComputeShader.reset();
@@ -1085,14 +1835,13 @@ namespace {
             m_currentDrawRenderTarget.reset();
             m_currentDrawDepthBuffer.reset();
             m_currentTextRenderTarget.reset();
+            m_renderTargetDescriptors->clear();
+            m_commandListWrappers->clear();
+            m_transientTextures.clear();
 
             m_currentMesh.reset();
-            for (uint32_t i = 0; i < ARRAYSIZE(m_meshViewProjectionBuffer); i++) {
-                m_meshViewProjectionBuffer[i].reset();
-            }
-            for (uint32_t i = 0; i < ARRAYSIZE(m_meshModelBuffer); i++) {
-                m_meshModelBuffer[i].reset();
-            }
+            m_meshViewProjectionBuffer.reset();
+            m_meshModelBuffer.reset();
 
             m_device->SetPrivateDataInterface(IID_ID3D12CommandQueue, nullptr);
         }
@@ -1153,13 +1902,20 @@ namespace {
 
         void flushContext(bool blocking, bool isEndOfFrame = false) override {
             if (isEndOfFrame) {
-                // Resolve the timers.
-                m_context->ResolveQueryData(get(m_queryHeap),
-                                            D3D12_QUERY_TYPE_TIMESTAMP,
-                                            0,
-                                            m_nextGpuTimestampIndex,
-                                            get(m_queryReadbackBuffer),
-                                            0);
+                // Resolve all the timestamps of the frame in a single batch.
+                auto& queries = m_gpuFrameQueries[m_currentGpuFrame];
+                const UINT base = getGpuFrameQueryBase(m_currentGpuFrame);
+                queries.frame.close([&](uint32_t index) {
+                    m_context->EndQuery(get(m_queryHeap), D3D12_QUERY_TYPE_TIMESTAMP, base + index);
+                });
+                if (queries.frame.isPending) {
+                    m_context->ResolveQueryData(get(m_queryHeap),
+                                                D3D12_QUERY_TYPE_TIMESTAMP,
+                                                base,
+                                                2 * queries.frame.numIntervals,
+                                                get(m_queryReadbackBuffer),
+                                                base * sizeof(uint64_t));
+                }
             }
 
             CHECK_HRCMD(m_context->Close());
@@ -1167,19 +1923,30 @@ namespace {
             ID3D12CommandList* const lists[] = {get(m_context)};
             m_queue->ExecuteCommandLists(ARRAYSIZE(lists), lists);
 
+            // Every submission is tracked, so that the allocator and the descriptors it references can be recycled.
+            m_queue->Signal(get(m_fence), ++m_fenceValue);
+            m_commandAllocatorFenceValue[m_currentContext] = m_fenceValue;
+            m_rvRing.submit(m_fenceValue);
+            m_constantRing.submit(m_fenceValue);
+
+            if (isEndOfFrame) {
+                // The timestamps can be read back once this submission completes.
+                m_gpuFrameQueries[m_currentGpuFrame].fenceValue = m_fenceValue;
+                m_currentGpuFrame = (m_currentGpuFrame + 1) % ARRAYSIZE(m_gpuFrameQueries);
+
+                m_transientTextures.endFrame();
+            }
+
             if (blocking) {
-                m_queue->Signal(get(m_fence), ++m_fenceValue);
-                if (m_fence->GetCompletedValue() < m_fenceValue) {
-                    wil::unique_handle eventHandle;
-                    *eventHandle.put() = CreateEventEx(nullptr, L"flushContext Fence", 0, EVENT_ALL_ACCESS);
-                    CHECK_HRCMD(m_fence->SetEventOnCompletion(m_fenceValue, eventHandle.get()));
-                    WaitForSingleObject(eventHandle.get(), INFINITE);
-                }
+                waitForFence(m_fenceValue);
             }
 
-            if (++m_currentContext == NumInflightContexts) {
+            if (++m_currentContext == m_commandList.size()) {
                 m_currentContext = 0;
             }
+
+            // The allocator cannot be reset while the GPU may still execute its previous command list.
+            waitForFence(m_commandAllocatorFenceValue[m_currentContext]);
             CHECK_HRCMD(m_commandAllocator[m_currentContext]->Reset());
             CHECK_HRCMD(m_commandList[m_currentContext]->Reset(get(m_commandAllocator[m_currentContext]), nullptr));
             m_context = m_commandList[m_currentContext];
@@ -1274,11 +2041,25 @@ namespace {
                 shared_from_this(), info, desc, get(texture), initialState, m_rtvHeap, m_dsvHeap, m_rvHeap);
         }
 
+        std::shared_ptr<ITexture> acquireTransientTexture(const XrSwapchainCreateInfo& info,
+                                                          std::string_view debugName) override {
+            return m_transientTextures.acquire(info, [&]() { return createTexture(info, debugName); });
+        }
+
+        void releaseTransientTexture(const std::shared_ptr<ITexture>& texture) override {
+            m_transientTextures.release(texture);
+        }
+
         std::shared_ptr<IShaderBuffer>
         createBuffer(size_t size, std::string_view debugName, const void* initialData, bool immutable) override {
             const auto desc =
                 CD3DX12_RESOURCE_DESC::Buffer(alignTo(size, D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT));
 
+            // Dynamic buffers are written directly into the constant ring, without a copy on the GPU timeline.
+            if (!immutable && !initialData) {
+                return std::make_shared<D3D12Buffer>(shared_from_this(), desc, m_constantRing, m_rvHeap);
+            }
+
             ComPtr<ID3D12Resource> buffer;
             {
                 const auto& heapType = CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT);
@@ -1390,16 +2171,42 @@ namespace {
                 shared_from_this(), desc, get(csBytes), debugName, threadGroups);
         }
 
-        std::shared_ptr<IGpuTimer> createTimer() override {
-            assert(m_nextGpuTimestampIndex < ARRAYSIZE(m_queryBuffer));
-            const UINT startGpuTimestampIndex = m_nextGpuTimestampIndex++;
-            const UINT stopGpuTimestampIndex = m_nextGpuTimestampIndex++;
-            return std::make_shared<D3D12GpuTimer>(
-                shared_from_this(),
-                get(m_queryHeap),
-                [&](UINT startIndex, UINT stopIndex) { return queryTimeStampDelta(startIndex, stopIndex); },
-                startGpuTimestampIndex,
-                stopGpuTimestampIndex);
+        std::shared_future<std::shared_ptr<IQuadShader>>
+        createQuadShaderAsync(const std::filesystem::path& shaderFile,
+                              const std::string& entryPoint,
+                              std::string_view debugName,
+                              const D3D_SHADER_MACRO* defines,
+                              std::filesystem::path includePath = "") override {
+            // The pipeline state is only created upon first use, on the application's thread.
+            return utilities::shader::CreateAsync<IQuadShader>(
+                [self = shared_from_this(),
+                 shaderFile,
+                 entryPoint,
+                 debugName = std::string(debugName),
+                 defines = utilities::shader::Defines(defines),
+                 includePath = std::move(includePath)]() {
+                    return self->createQuadShader(shaderFile, entryPoint, debugName, defines.get(), includePath);
+                });
+        }
+
+        std::shared_future<std::shared_ptr<IComputeShader>>
+        createComputeShaderAsync(const std::filesystem::path& shaderFile,
+                                 const std::string& entryPoint,
+                                 std::string_view debugName,
+                                 const std::array<unsigned int, 3>& threadGroups,
+                                 const D3D_SHADER_MACRO* defines,
+                                 std::filesystem::path includePath = "") override {
+            return utilities::shader::CreateAsync<IComputeShader>(
+                [self = shared_from_this(),
+                 shaderFile,
+                 entryPoint,
+                 debugName = std::string(debugName),
+                 threadGroups,
+                 defines = utilities::shader::Defines(defines),
+                 includePath = std::move(includePath)]() {
+                    return self->createComputeShader(
+                        shaderFile, entryPoint, debugName, threadGroups, defines.get(), includePath);
+                });
         }
 
         void setShader(std::shared_ptr<IQuadShader> shader, SamplerType sampler) override {
@@ -1408,7 +2215,7 @@ namespace {
             m_currentRootSlot = 0;
 
             ID3D12DescriptorHeap* const heaps[] = {
-                get(m_rvHeap.heap),
+                get(m_rvRing.heap),
                 get(m_samplerHeap.heap),
             };
             m_context->SetDescriptorHeaps(ARRAYSIZE(heaps), heaps);
@@ -1439,7 +2246,7 @@ namespace {
             m_currentRootSlot = 0;
 
             ID3D12DescriptorHeap* const heaps[] = {
-                get(m_rvHeap.heap),
+                get(m_rvRing.heap),
                 get(m_samplerHeap.heap),
             };
             m_context->SetDescriptorHeaps(ARRAYSIZE(heaps), heaps);
@@ -1472,7 +2279,7 @@ namespace {
                 m_currentShaderResources.push_back(input);
 
                 const auto pView = input->getShaderResourceView(slice)->getAs<D3D12>();
-                const auto descriptorHandle = m_rvHeap.getGPUHandle(*pView);
+                const auto descriptorHandle = m_rvRing.copy(*pView);
                 if (!d3d12Shader->needsResolve()) {
                     if (m_currentComputeShader) {
                         m_context->SetComputeRootDescriptorTable(m_currentRootSlot++, descriptorHandle);
@@ -1496,7 +2303,7 @@ namespace {
                 m_currentShaderResources2.push_back(input);
 
                 const auto pBuffer = dynamic_cast<D3D12Buffer*>(input.get());
-                const auto descriptorHandle = m_rvHeap.getGPUHandle(pBuffer->getConstantBufferView());
+                const auto descriptorHandle = m_rvRing.copy(pBuffer->getConstantBufferView());
                 if (!d3d12Shader->needsResolve()) {
                     if (m_currentComputeShader) {
                         m_context->SetComputeRootDescriptorTable(m_currentRootSlot++, descriptorHandle);
@@ -1511,13 +2318,30 @@ namespace {
             }
         }
 
-        void setShaderOutput(uint32_t slot, std::shared_ptr<ITexture> output, int32_t slice) override {
+        void setShaderOutput(uint32_t slot,
+                             std::shared_ptr<ITexture> output,
+                             int32_t slice,
+                             const XrRect2Di* viewport) override {
             if (m_currentQuadShader) {
                 if (!slot) {
-                    setRenderTargets(1, &output, &slice);
-                    auto d3d12Shader = dynamic_cast<D3D12Shader*>(m_currentQuadShader.get());
+                    // Draw one instance of the quad per slice, each selecting its slice from the vertex shader.
+                    m_currentQuadInstances = 1;
+                    if (slice == AllSlices) {
+                        if (!m_isRenderTargetArrayIndexSupported) {
+                            throw std::runtime_error("Drawing to all slices is not supported");
+                        }
+                        m_currentQuadInstances = output->getInfo().arraySize;
+                    }
+
+                    setRenderTargets(1, &output, &slice, viewport);
+                    auto d3d12Shader = dynamic_cast<D3D12QuadShader*>(m_currentQuadShader.get());
                     if (d3d12Shader->needsResolve()) {
                         d3d12Shader->setOutputFormat(output->getInfo());
+                        // The layered vertex shader draws one instance to the first slice like the regular one, so
+                        // the pipeline state works with and without AllSlices.
+                        if (m_isRenderTargetArrayIndexSupported) {
+                            d3d12Shader->setVertexShader(get(m_quadLayeredVertexShaderBytes));
+                        }
                     }
                 } else {
                     throw std::runtime_error("Only use slot 0 for IQuadShader");
@@ -1527,7 +2351,7 @@ namespace {
                 m_currentShaderResources.push_back(output);
 
                 const auto pView = output->getUnorderedAccessView(slice)->getAs<D3D12>();
-                auto descriptorHandle = m_rvHeap.getGPUHandle(*pView);
+                auto descriptorHandle = m_rvRing.copy(*pView);
                 auto d3d12Shader = dynamic_cast<D3D12Shader*>(m_currentComputeShader.get());
                 if (!d3d12Shader->needsResolve()) {
                     m_context->SetComputeRootDescriptorTable(m_currentRootSlot++, descriptorHandle);
@@ -1549,7 +2373,7 @@ namespace {
                     d3d12Shader->resolve();
                 }
                 if (m_currentQuadShader) {
-                    m_context->DrawInstanced(3, 1, 0, 0);
+                    m_context->DrawInstanced(3, m_currentQuadInstances, 0, 0);
 
                 } else if (m_currentComputeShader) {
                     m_context->Dispatch(m_currentComputeShader->getThreadGroups()[0],
@@ -1697,15 +2521,11 @@ namespace {
                 DirectX::XMMatrixTranspose(xr::math::LoadInvertedXrPose(view.Pose) *
                                            xr::math::ComposeProjectionMatrix(view.Fov, view.NearFar)));
 
-            m_currentMeshViewProjectionBuffer++;
-            if (m_currentMeshViewProjectionBuffer >= ARRAYSIZE(m_meshViewProjectionBuffer)) {
-                m_currentMeshViewProjectionBuffer = 0;
-            }
-            if (!m_meshViewProjectionBuffer[m_currentMeshViewProjectionBuffer]) {
-                m_meshViewProjectionBuffer[m_currentMeshViewProjectionBuffer] =
+            if (!m_meshViewProjectionBuffer) {
+                m_meshViewProjectionBuffer =
                     createBuffer(sizeof(ViewProjectionConstantBuffer), "ViewProjection CB", nullptr, false);
             }
-            m_meshViewProjectionBuffer[m_currentMeshViewProjectionBuffer]->uploadData(&staging, sizeof(staging));
+            m_meshViewProjectionBuffer->uploadData(&staging, sizeof(staging));
 
             m_currentDrawDepthBufferIsInverted = view.NearFar.Near > view.NearFar.Far;
         }
@@ -1771,15 +2591,14 @@ namespace {
                 m_context->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
 
                 ID3D12DescriptorHeap* const heaps[] = {
-                    get(m_rvHeap.heap),
+                    get(m_rvRing.heap),
                 };
                 m_context->SetDescriptorHeaps(ARRAYSIZE(heaps), heaps);
 
                 {
-                    auto d3d12Buffer =
-                        dynamic_cast<D3D12Buffer*>(m_meshViewProjectionBuffer[m_currentMeshViewProjectionBuffer].get());
+                    auto d3d12Buffer = dynamic_cast<D3D12Buffer*>(m_meshViewProjectionBuffer.get());
                     const auto& handle = d3d12Buffer->getConstantBufferView();
-                    m_context->SetGraphicsRootDescriptorTable(1, m_rvHeap.getGPUHandle(handle));
+                    m_context->SetGraphicsRootDescriptorTable(1, m_rvRing.copy(handle));
                 }
 
                 m_currentMesh = mesh;
@@ -1790,21 +2609,16 @@ namespace {
             DirectX::XMStoreFloat4x4(&model.Model,
                                      DirectX::XMMatrixTranspose(scaleMatrix * xr::math::LoadXrPose(pose)));
 
-            m_currentMeshModelBuffer++;
-            if (m_currentMeshModelBuffer >= ARRAYSIZE(m_meshModelBuffer)) {
-                m_currentMeshModelBuffer = 0;
-            }
-
-            if (!m_meshModelBuffer[m_currentMeshModelBuffer]) {
-                m_meshModelBuffer[m_currentMeshModelBuffer] =
-                    createBuffer(sizeof(ModelConstantBuffer), "Model CB", nullptr, false);
+            // Each upload lands in a new suballocation of the constant ring, so one buffer serves all the draws.
+            if (!m_meshModelBuffer) {
+                m_meshModelBuffer = createBuffer(sizeof(ModelConstantBuffer), "Model CB", nullptr, false);
             }
-            m_meshModelBuffer[m_currentMeshModelBuffer]->uploadData(&model, sizeof(model));
+            m_meshModelBuffer->uploadData(&model, sizeof(model));
 
             {
-                auto d3d12Buffer = dynamic_cast<D3D12Buffer*>(m_meshModelBuffer[m_currentMeshModelBuffer].get());
+                auto d3d12Buffer = dynamic_cast<D3D12Buffer*>(m_meshModelBuffer.get());
                 const auto& handle = d3d12Buffer->getConstantBufferView();
-                m_context->SetGraphicsRootDescriptorTable(0, m_rvHeap.getGPUHandle(handle));
+                m_context->SetGraphicsRootDescriptorTable(0, m_rvRing.copy(handle));
             }
 
             m_context->DrawIndexedInstanced(meshData->numIndices, 1, 0, 0, 0);
@@ -1912,26 +2726,103 @@ namespace {
             m_isRenderingText = false;
         }
 
+        // The samplers are biased when they are created (see patchSampler() and patchRootSignature()), so a change
+        // of the settings only applies to the samplers created afterwards.
         void setMipMapBias(config::MipMapBias biasing, float bias = 0.f) override {
-            // TODO: Implement mip-map bias.
+            m_mipMapBiasSettings = MipMapBiasSettings{biasing, bias};
+
+            // Only count the samplers biased with the new settings.
+            m_mipMapBiasGeneration++;
+            m_samplerDescriptors.clear();
+            m_numBiasedSamplers = 0;
+            m_numBiasedStaticSamplers = 0;
         }
 
-        uint32_t getNumBiasedSamplersThisFrame() const override {
-            // TODO: Implement mip-map bias.
-            return 0;
+        uint32_t getNumBiasedSamplers() const override {
+            return std::max(m_numBiasedSamplers.load(), 0) + m_numBiasedStaticSamplers;
         }
 
-        void resolveQueries() override {
-            if (m_nextGpuTimestampIndex == 0) {
-                return;
+        HookStatistics getHookStatisticsThisFrame() const override {
+            return m_hookCounters.exchange();
+        }
+
+        void setHookStatisticsEnabled(bool enabled) override {
+            m_hookCounters.isEnabled.store(enabled, std::memory_order_relaxed);
+        }
+
+        uint32_t getNumGpuWaitsThisFrame() const override {
+            return std::exchange(m_numGpuWaitsThisFrame, 0);
+        }
+
+        ConstantUploadStatistics getConstantUploadStatisticsThisFrame() const override {
+            ConstantUploadStatistics stats;
+            stats.numUploads =
+                m_constantRing.numUploads - std::exchange(m_lastNumConstantUploads, m_constantRing.numUploads);
+            stats.numSkippedUploads = m_constantRing.numSkippedUploads -
+                                      std::exchange(m_lastNumSkippedConstantUploads, m_constantRing.numSkippedUploads);
+            stats.ringSize = m_constantRing.ringSize;
+            stats.ringPeakUsage = m_constantRing.peakUsage;
+            stats.numRingStalls = m_constantRing.numStalls;
+            return stats;
+        }
+
+        DescriptorStatistics getDescriptorStatistics() const override {
+            DescriptorStatistics stats;
+            for (const auto heap : {&m_rtvHeap, &m_dsvHeap, &m_rvHeap}) {
+                heap->addStatistics(stats);
+            }
+            stats.ringSize = m_rvRing.ringSize;
+            stats.ringPeakUsage = m_rvRing.peakUsage;
+            stats.numRingStalls = m_rvRing.numStalls;
+            return stats;
+        }
+
+        void startGpuStage(GpuStage stage) override {
+            auto& queries = m_gpuFrameQueries[m_currentGpuFrame];
+            if (queries.frame.isPending) {
+                // The timings of that frame were never read back.
+                queries.frame.reset();
+            }
+            if (const auto index = queries.frame.start(stage)) {
+                m_context->EndQuery(get(m_queryHeap),
+                                    D3D12_QUERY_TYPE_TIMESTAMP,
+                                    getGpuFrameQueryBase(m_currentGpuFrame) + *index);
             }
+        }
 
-            // Readback the previous set of timers. The queries are resolved in flushContext().
+        void stopGpuStage(GpuStage stage) override {
+            auto& queries = m_gpuFrameQueries[m_currentGpuFrame];
+            if (const auto index = queries.frame.stop(stage)) {
+                m_context->EndQuery(get(m_queryHeap),
+                                    D3D12_QUERY_TYPE_TIMESTAMP,
+                                    getGpuFrameQueryBase(m_currentGpuFrame) + *index);
+            }
+        }
+
+        bool resolveQueries(GpuStageTimings& timings) override {
+            // The frame about to be recorded reuses the queries of the oldest frame.
+            auto& queries = m_gpuFrameQueries[m_currentGpuFrame];
+            if (!queries.frame.isPending) {
+                return false;
+            }
+            const auto frame = queries.frame;
+            queries.frame.reset();
+
+            // The queries were resolved in flushContext() GpuFrameLatency frames ago. If the GPU is still behind, we
+            // rather lose the timings than stall.
+            if (m_fence->GetCompletedValue() < queries.fenceValue) {
+                return false;
+            }
+
+            const UINT base = getGpuFrameQueryBase(m_currentGpuFrame);
             uint64_t* mappedBuffer;
-            D3D12_RANGE range{0, sizeof(uint64_t) * m_nextGpuTimestampIndex};
+            D3D12_RANGE range{base * sizeof(uint64_t), (base + 2 * frame.numIntervals) * sizeof(uint64_t)};
             CHECK_HRCMD(m_queryReadbackBuffer->Map(0, &range, reinterpret_cast<void**>(&mappedBuffer)));
-            memcpy(m_queryBuffer, mappedBuffer, range.End);
-            m_queryReadbackBuffer->Unmap(0, nullptr);
+            timings = frame.accumulate(mappedBuffer + base, m_gpuTickFrequency);
+            D3D12_RANGE noWrite{0, 0};
+            m_queryReadbackBuffer->Unmap(0, &noWrite);
+
+            return true;
         }
 
         void blockCallbacks() override {
@@ -1962,6 +2853,10 @@ namespace {
             return m_allowInterceptor;
         }
 
+        bool isRenderTargetArrayIndexSupported() const override {
+            return m_isRenderTargetArrayIndexSupported;
+        }
+
         uint32_t getBufferAlignmentConstraint() const override {
             return D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT;
         }
@@ -1982,6 +2877,15 @@ namespace {
         }
 
       private:
+        // Only block the CPU if the GPU has not reached the fence value yet.
+        void waitForFence(UINT64 value) {
+            if (m_fence->GetCompletedValue() < value) {
+                m_numGpuWaitsThisFrame++;
+                CHECK_HRCMD(m_fence->SetEventOnCompletion(value, m_fenceEvent.get()));
+                WaitForSingleObject(m_fenceEvent.get(), INFINITE);
+            }
+        }
+
         void initializeInterceptor() {
             if (!m_allowInterceptor) {
                 return;
@@ -2003,6 +2907,16 @@ namespace {
                                20,
                                hooked_ID3D12Device_CreateRenderTargetView,
                                g_original_ID3D12Device_CreateRenderTargetView);
+            DetourMethodAttach(get(m_realDevice),
+                               // Method offset is 7 + method index (0-based) for ID3D12Device.
+                               22,
+                               hooked_ID3D12Device_CreateSampler,
+                               g_original_ID3D12Device_CreateSampler);
+            DetourMethodAttach(get(m_realDevice),
+                               // Method offset is 7 + method index (0-based) for ID3D12Device.
+                               16,
+                               hooked_ID3D12Device_CreateRootSignature,
+                               g_original_ID3D12Device_CreateRootSignature);
             DetourMethodAttach(get(realContext),
                                // Method offset is 10 + method index (0-based) for ID3D12GraphicsCommandList.
                                16,
@@ -2024,6 +2938,16 @@ namespace {
                                20,
                                hooked_ID3D12Device_CreateRenderTargetView,
                                g_original_ID3D12Device_CreateRenderTargetView);
+            DetourMethodDetach(get(m_realDevice),
+                               // Method offset is 7 + method index (0-based) for ID3D12Device.
+                               22,
+                               hooked_ID3D12Device_CreateSampler,
+                               g_original_ID3D12Device_CreateSampler);
+            DetourMethodDetach(get(m_realDevice),
+                               // Method offset is 7 + method index (0-based) for ID3D12Device.
+                               16,
+                               hooked_ID3D12Device_CreateRootSignature,
+                               g_original_ID3D12Device_CreateRootSignature);
             DetourMethodDetach(get(realContext),
                                // Method offset is 10 + method index (0-based) for ID3D12GraphicsCommandList.
                                16,
@@ -2075,6 +2999,37 @@ namespace {
                     CHECK_HRESULT(hr, "Failed to compile shader");
                 }
             }
+            {
+                // Without support in the hardware, the runtime would emulate it with a geometry shader.
+                D3D12_FEATURE_DATA_D3D12_OPTIONS options{};
+                m_isRenderTargetArrayIndexSupported =
+                    SUCCEEDED(m_device->CheckFeatureSupport(D3D12_FEATURE_D3D12_OPTIONS, &options, sizeof(options))) &&
+                    options.VPAndRTArrayIndexFromAnyShaderFeedingRasterizerSupportedWithoutGSEmulation;
+                if (m_isRenderTargetArrayIndexSupported) {
+                    const D3D_SHADER_MACRO defines[] = {{"QUAD_LAYERED", "1"}, {nullptr, nullptr}};
+
+                    ComPtr<ID3DBlob> errors;
+                    const HRESULT hr = D3DCompile(QuadVertexShader.data(),
+                                                  QuadVertexShader.length(),
+                                                  nullptr,
+                                                  defines,
+                                                  nullptr,
+                                                  "vsMain",
+                                                  "vs_5_0",
+                                                  D3DCOMPILE_ENABLE_STRICTNESS | D3DCOMPILE_WARNINGS_ARE_ERRORS,
+                                                  0,
+                                                  set(m_quadLayeredVertexShaderBytes),
+                                                  set(errors));
+                    if (FAILED(hr)) {
+                        if (errors) {
+                            Log("%s", (char*)errors->GetBufferPointer());
+                        }
+                        CHECK_HRESULT(hr, "Failed to compile shader");
+                    }
+                } else {
+                    Log("Render target array index from the vertex shader is not supported\n");
+                }
+            }
         }
 
         // Initialize the calls needed for draw() and related calls.
@@ -2156,8 +3111,8 @@ namespace {
             }
         }
 
-        uint64_t queryTimeStampDelta(UINT startIndex, UINT stopIndex) const {
-            return ((m_queryBuffer[stopIndex] - m_queryBuffer[startIndex]) * 1000000) / m_gpuTickFrequency;
+        static UINT getGpuFrameQueryBase(uint32_t frame) {
+            return frame * GpuFrameTimestamps::MaxTimestamps;
         }
 
         void registerRenderTargetView(ID3D12Resource* resource,
@@ -2167,6 +3122,8 @@ namespace {
                 return;
             }
 
+            ScopedHookTimer timer(m_hookCounters);
+
             ComPtr<ID3D12Device> device;
             CHECK_HRCMD(resource->GetDevice(IID_PPV_ARGS(set(device))));
             if (device != m_realDevice) {
@@ -2175,18 +3132,154 @@ namespace {
 
             D3D12_RESOURCE_DESC resourceDesc = resource->GetDesc();
             if (resourceDesc.Dimension == D3D12_RESOURCE_DIMENSION_TEXTURE2D) {
-                const size_t sizeBefore = m_renderTargetResourceDescriptors.size();
-                {
-                    std::unique_lock lock(m_renderTargetResourceDescriptorsLock);
-
-                    m_renderTargetResourceDescriptors.insert_or_assign(handle, std::make_pair(resource, resourceDesc));
-                    if (sizeBefore && !(sizeBefore % 100) && m_renderTargetResourceDescriptors.size() != sizeBefore) {
-                        Log("Dictionary of render target resource descriptor now at %zu elements\n", sizeBefore + 1);
+                const size_t sizeBefore = m_renderTargetDescriptors->size();
+                if (!m_renderTargetDescriptors->registerView(handle, resource, resourceDesc)) {
+                    if (!m_loggedRenderTargetDescriptorsFull.exchange(true)) {
+                        Log("Dictionary of render target resource descriptor is full, using the slow path\n");
                     }
+                } else if (sizeBefore && !(sizeBefore % 100) && m_renderTargetDescriptors->size() != sizeBefore) {
+                    Log("Dictionary of render target resource descriptor now at %zu elements\n", sizeBefore + 1);
                 }
             }
         }
 
+        // Return the wrapper for an application command list, or nullptr if the command list belongs to another
+        // device. The device check and the allocation of the wrapper only happen the first time a command list is
+        // seen.
+        std::shared_ptr<D3D12Context> getWrappedContext(ID3D12GraphicsCommandList* context) {
+            std::shared_ptr<D3D12Context> wrappedContext;
+            if (m_commandListWrappers->find(context, wrappedContext)) {
+                return wrappedContext;
+            }
+
+            ComPtr<ID3D12Device> device;
+            CHECK_HRCMD(context->GetDevice(IID_PPV_ARGS(set(device))));
+            if (device == m_realDevice) {
+                wrappedContext = std::make_shared<D3D12Context>(shared_from_this(), context);
+            }
+
+            return m_commandListWrappers->insert(context, wrappedContext);
+        }
+
+        static bool needsBiasing(const MipMapBiasSettings& settings, D3D12_FILTER filter) {
+            return settings.type == config::MipMapBias::All ||
+                   (filter == D3D12_FILTER_ANISOTROPIC || filter == D3D12_FILTER_COMPARISON_ANISOTROPIC ||
+                    filter == D3D12_FILTER_MINIMUM_ANISOTROPIC || filter == D3D12_FILTER_MAXIMUM_ANISOTROPIC);
+        }
+
+        // Bias a sampler created by the application in one of its descriptors. The table of sampler descriptors
+        // remembers which descriptors hold a sampler biased with the current settings.
+        bool patchSampler(ID3D12Device* device,
+                          const D3D12_SAMPLER_DESC& desc,
+                          D3D12_CPU_DESCRIPTOR_HANDLE handle,
+                          D3D12_SAMPLER_DESC& biasedDesc) {
+            const uint32_t biasGeneration = m_mipMapBiasGeneration;
+            const MipMapBiasSettings settings = m_mipMapBiasSettings;
+            if (m_blockEvents || settings.type == config::MipMapBias::Off || device != get(m_realDevice)) {
+                return false;
+            }
+
+            ScopedHookTimer timer(m_hookCounters);
+
+            const bool isBiased = needsBiasing(settings, desc.Filter);
+            if (isBiased) {
+                biasedDesc = desc;
+
+                // Bias the LOD.
+                biasedDesc.MipLODBias += settings.bias;
+
+                // Allow negative LOD.
+                biasedDesc.MinLOD -= std::ceilf(settings.bias);
+            }
+
+            // Only count the samplers that are recorded in the table (possibly in its overflow map), so that
+            // re-creating a sampler in the same descriptor does not count it twice. Only the biased samplers are
+            // recorded, so that the table does not fill up with the descriptors the application no longer uses.
+            const auto updateCount = [&](const SamplerDescriptor& entry) {
+                const bool wasBiased = entry.isBiased && entry.biasGeneration == biasGeneration;
+                // The count was reset if the settings changed in the meantime.
+                if (biasGeneration == m_mipMapBiasGeneration) {
+                    m_numBiasedSamplers += (int)isBiased - (int)wasBiased;
+                }
+            };
+            if (isBiased) {
+                m_samplerDescriptors.update(handle.ptr, [&](SamplerDescriptor& entry) {
+                    updateCount(entry);
+                    entry.biasGeneration = biasGeneration;
+                    entry.isBiased = true;
+                });
+            } else {
+                m_samplerDescriptors.evict(handle.ptr, [&](const SamplerDescriptor& entry) {
+                    updateCount(entry);
+                    return true;
+                });
+            }
+
+            return isBiased;
+        }
+
+        // Bias the static samplers of a root signature created by the application. Returns a null blob if the root
+        // signature is left untouched.
+        ComPtr<ID3DBlob> patchRootSignature(ID3D12Device* device, const void* blob, SIZE_T blobSize) {
+            const MipMapBiasSettings settings = m_mipMapBiasSettings;
+            if (m_blockEvents || settings.type == config::MipMapBias::Off || device != get(m_realDevice)) {
+                return nullptr;
+            }
+
+            ScopedHookTimer timer(m_hookCounters);
+
+            ComPtr<ID3D12VersionedRootSignatureDeserializer> deserializer;
+            const D3D12_VERSIONED_ROOT_SIGNATURE_DESC* rootSignatureDesc = nullptr;
+            if (FAILED(D3D12CreateVersionedRootSignatureDeserializer(
+                    blob, blobSize, IID_PPV_ARGS(set(deserializer)))) ||
+                FAILED(deserializer->GetUnconvertedRootSignatureDesc(&rootSignatureDesc))) {
+                return nullptr;
+            }
+
+            D3D12_VERSIONED_ROOT_SIGNATURE_DESC desc = *rootSignatureDesc;
+            std::vector<D3D12_STATIC_SAMPLER_DESC> staticSamplers;
+            if (desc.Version == D3D_ROOT_SIGNATURE_VERSION_1_0) {
+                staticSamplers.assign(desc.Desc_1_0.pStaticSamplers,
+                                      desc.Desc_1_0.pStaticSamplers + desc.Desc_1_0.NumStaticSamplers);
+            } else if (desc.Version == D3D_ROOT_SIGNATURE_VERSION_1_1) {
+                staticSamplers.assign(desc.Desc_1_1.pStaticSamplers,
+                                      desc.Desc_1_1.pStaticSamplers + desc.Desc_1_1.NumStaticSamplers);
+            } else {
+                return nullptr;
+            }
+
+            uint32_t numBiased = 0;
+            for (auto& sampler : staticSamplers) {
+                if (needsBiasing(settings, sampler.Filter)) {
+                    sampler.MipLODBias += settings.bias;
+                    sampler.MinLOD -= std::ceilf(settings.bias);
+                    numBiased++;
+                }
+            }
+            if (!numBiased) {
+                return nullptr;
+            }
+
+            if (desc.Version == D3D_ROOT_SIGNATURE_VERSION_1_0) {
+                desc.Desc_1_0.pStaticSamplers = staticSamplers.data();
+            } else {
+                desc.Desc_1_1.pStaticSamplers = staticSamplers.data();
+            }
+
+            ComPtr<ID3DBlob> serializedRootSignature;
+            ComPtr<ID3DBlob> errors;
+            if (FAILED(D3D12SerializeVersionedRootSignature(&desc, set(serializedRootSignature), set(errors)))) {
+                if (errors) {
+                    Log("Failed to bias the static samplers: %s\n", (char*)errors->GetBufferPointer());
+                }
+                return nullptr;
+            }
+
+            m_numBiasedStaticSamplers += numBiased;
+
+            return serializedRootSignature;
+        }
+
 #define INVOKE_EVENT(event, ...)                                                                                       \
     do {                                                                                                               \
         if (!m_blockEvents && m_##event) {                                                                             \
@@ -2201,42 +3294,55 @@ namespace {
                                 const D3D12_CPU_DESCRIPTOR_HANDLE* renderTargetHandles,
                                 BOOL singleHandleToDescriptorRange,
                                 const D3D12_CPU_DESCRIPTOR_HANDLE* depthStencilHandle) {
-            ComPtr<ID3D12Device> device;
-            CHECK_HRCMD(context->GetDevice(IID_PPV_ARGS(set(device))));
-            if (device != m_realDevice) {
+            // Nothing to do if nobody listens.
+            if (m_blockEvents || (!m_setRenderTargetEvent && !m_unsetRenderTargetEvent)) {
                 return;
             }
 
-            auto wrappedContext = std::make_shared<D3D12Context>(shared_from_this(), context);
+            ScopedHookTimer timer(m_hookCounters);
+
+            auto wrappedContext = getWrappedContext(context);
+            if (!wrappedContext) {
+                return;
+            }
 
             if (!numRenderTargetDescriptors) {
                 INVOKE_EVENT(unsetRenderTargetEvent, wrappedContext);
                 return;
             }
 
-            std::shared_ptr<D3D12Texture> renderTarget;
-            {
-                std::unique_lock lock(m_renderTargetResourceDescriptorsLock);
-
-                auto it = m_renderTargetResourceDescriptors.find(renderTargetHandles[0]);
-                if (it == m_renderTargetResourceDescriptors.cend()) {
-                    INVOKE_EVENT(unsetRenderTargetEvent, wrappedContext);
-                    return;
-                }
-
-                ID3D12Resource* const resource = it->second.first;
-                const D3D12_RESOURCE_DESC& resourceDesc = it->second.second;
-
-                renderTarget = std::make_shared<D3D12Texture>(shared_from_this(),
-                                                              getTextureInfo(resourceDesc),
-                                                              resourceDesc,
-                                                              resource,
-                                                              D3D12_RESOURCE_STATE_COMMON, /* Conservative. */
-                                                              m_rtvHeap,
-                                                              m_dsvHeap,
-                                                              m_rvHeap);
+            // The wrapper is created the first time the descriptor is used, and reused until the application
+            // re-creates a view in the descriptor or destroys the resource.
+            ComPtr<ID3D12Resource> resource;
+            auto cachedRenderTarget = m_renderTargetDescriptors->getTexture(
+                renderTargetHandles[0],
+                [&](const RenderTargetDescriptors::Entry& entry) {
+                    return std::make_shared<D3D12Texture>(shared_from_this(),
+                                                          getTextureInfo(entry.resourceDesc),
+                                                          entry.resourceDesc,
+                                                          entry.resource,
+                                                          D3D12_RESOURCE_STATE_COMMON, /* Conservative. */
+                                                          m_rtvHeap,
+                                                          m_dsvHeap,
+                                                          m_rvHeap,
+                                                          false /* ownsTexture */);
+                },
+                resource);
+            if (!cachedRenderTarget) {
+                INVOKE_EVENT(unsetRenderTargetEvent, wrappedContext);
+                return;
             }
 
+            // The cached wrapper does not reference the resource, but the listeners may keep the render target past
+            // this call (eg: the VRS capture). Hand them a pointer that holds a reference to the resource for as long
+            // as they keep it.
+            std::shared_ptr<ITexture> renderTarget(
+                cachedRenderTarget.get(),
+                [wrapper = cachedRenderTarget, resource = std::move(resource)](ITexture*) mutable {
+                    wrapper.reset();
+                    resource.Reset();
+                });
+
             INVOKE_EVENT(setRenderTargetEvent, wrappedContext, renderTarget);
         }
 
@@ -2245,13 +3351,16 @@ namespace {
                            ID3D12Resource* pDstResource,
                            UINT SrcSubresource = 0,
                            UINT DstSubresource = 0) {
-            ComPtr<ID3D12Device> device;
-            CHECK_HRCMD(context->GetDevice(IID_PPV_ARGS(set(device))));
-            if (device != m_realDevice) {
+            if (m_blockEvents || !m_copyTextureEvent) {
                 return;
             }
 
-            auto wrappedContext = std::make_shared<D3D12Context>(shared_from_this(), context);
+            ScopedHookTimer timer(m_hookCounters);
+
+            auto wrappedContext = getWrappedContext(context);
+            if (!wrappedContext) {
+                return;
+            }
 
             const D3D12_RESOURCE_DESC& sourceTextureDesc = pSrcResource->GetDesc();
             auto source = std::make_shared<D3D12Texture>(shared_from_this(),
@@ -2287,8 +3396,9 @@ namespace {
         const bool m_allowInterceptor;
         const bool m_needInteropCopy;
 
-        ComPtr<ID3D12CommandAllocator> m_commandAllocator[NumInflightContexts];
-        ComPtr<ID3D12GraphicsCommandList> m_commandList[NumInflightContexts];
+        std::vector<ComPtr<ID3D12CommandAllocator>> m_commandAllocator;
+        std::vector<ComPtr<ID3D12GraphicsCommandList>> m_commandList;
+        std::vector<UINT64> m_commandAllocatorFenceValue;
         size_t m_currentContext{0};
 
         ComPtr<ID3D12GraphicsCommandList> m_context;
@@ -2296,14 +3406,16 @@ namespace {
         D3D12Heap m_dsvHeap;
         D3D12Heap m_rvHeap;
         D3D12Heap m_samplerHeap;
+        D3D12DescriptorRing m_rvRing;
+        D3D12ConstantRing m_constantRing;
         ComPtr<ID3D12QueryHeap> m_queryHeap;
         ComPtr<ID3D12Resource> m_queryReadbackBuffer;
         ComPtr<ID3DBlob> m_quadVertexShaderBytes;
+        ComPtr<ID3DBlob> m_quadLayeredVertexShaderBytes;
+        bool m_isRenderTargetArrayIndexSupported{false};
         D3D12_CPU_DESCRIPTOR_HANDLE m_samplers[2];
-        std::shared_ptr<IShaderBuffer> m_meshViewProjectionBuffer[4];
-        uint32_t m_currentMeshViewProjectionBuffer{0};
-        std::shared_ptr<IShaderBuffer> m_meshModelBuffer[MaxModelBuffers];
-        uint32_t m_currentMeshModelBuffer{0};
+        std::shared_ptr<IShaderBuffer> m_meshViewProjectionBuffer;
+        std::shared_ptr<IShaderBuffer> m_meshModelBuffer;
         ComPtr<ID3DBlob> m_meshRendererVertexShaderBytes;
         std::vector<D3D12_INPUT_ELEMENT_DESC> m_meshRendererInputLayout;
         ComPtr<ID3DBlob> m_meshRendererPixelShaderBytes;
@@ -2312,11 +3424,22 @@ namespace {
         ComPtr<ID3D12PipelineState> m_meshRendererNoCullingPipelineState;
         ComPtr<ID3D12Fence> m_fence;
         UINT64 m_fenceValue{0};
-
-        UINT m_nextGpuTimestampIndex{0};
-        uint64_t m_queryBuffer[MaxGpuTimers * 2];
+        wil::unique_handle m_fenceEvent;
+        mutable uint32_t m_numGpuWaitsThisFrame{0};
+        mutable uint32_t m_lastNumConstantUploads{0};
+        mutable uint32_t m_lastNumSkippedConstantUploads{0};
+
+        // The timestamp query heap and its readback buffer are partitioned between the frames in-flight.
+        struct GpuFrameQueries {
+            GpuFrameTimestamps frame;
+            UINT64 fenceValue{0};
+        };
+        GpuFrameQueries m_gpuFrameQueries[GpuFrameLatency + 1];
+        uint32_t m_currentGpuFrame{0};
         uint64_t m_gpuTickFrequency{0};
 
+        TransientTexturePool m_transientTextures;
+
         std::shared_ptr<IDevice> m_textDevice;
         ComPtr<ID3D11On12Device> m_textInteropDevice;
         bool m_isRenderingText{false};
@@ -2335,17 +3458,32 @@ namespace {
         mutable std::vector<std::shared_ptr<ITexture>> m_currentShaderResources;
         mutable std::vector<std::shared_ptr<IShaderBuffer>> m_currentShaderResources2;
         uint32_t m_currentRootSlot;
+        uint32_t m_currentQuadInstances{1};
 
         SetRenderTargetEvent m_setRenderTargetEvent;
         UnsetRenderTargetEvent m_unsetRenderTargetEvent;
         CopyTextureEvent m_copyTextureEvent;
         std::atomic<bool> m_blockEvents{false};
 
-        std::map<D3D12_CPU_DESCRIPTOR_HANDLE,
-                 std::pair<ID3D12Resource*, D3D12_RESOURCE_DESC>,
-                 decltype(descriptorCompare)>
-            m_renderTargetResourceDescriptors{descriptorCompare};
-        std::mutex m_renderTargetResourceDescriptorsLock;
+        const std::shared_ptr<RenderTargetDescriptors> m_renderTargetDescriptors =
+            std::make_shared<RenderTargetDescriptors>();
+        std::atomic<bool> m_loggedRenderTargetDescriptorsFull{false};
+        const std::shared_ptr<CommandListWrappers> m_commandListWrappers = std::make_shared<CommandListWrappers>();
+        mutable HookCounters m_hookCounters;
+
+        // The settings are changed from the frame thread while the application's threads create samplers, so they are
+        // published together.
+        std::atomic<MipMapBiasSettings> m_mipMapBiasSettings{MipMapBiasSettings{}};
+        std::atomic<uint32_t> m_mipMapBiasGeneration{0};
+
+        struct SamplerDescriptor {
+            uint32_t biasGeneration{0};
+            bool isBiased{false};
+        };
+        ConcurrentPointerTable<SamplerDescriptor> m_samplerDescriptors{14};
+        // Descriptors can be overwritten from several threads, so this count may transiently go negative.
+        std::atomic<int> m_numBiasedSamplers{0};
+        std::atomic<uint32_t> m_numBiasedStaticSamplers{0};
 
         friend std::shared_ptr<ITexture> toolkit::graphics::WrapD3D12Texture(std::shared_ptr<IDevice> device,
                                                                              const XrSwapchainCreateInfo& info,
@@ -2415,6 +3553,69 @@ namespace {
                 local, "ID3D12Device_CreateRenderTargetView", TLPArg(DestDescriptor.ptr, "Descriptor"));
         }
 
+        DECLARE_DETOUR_FUNCTION(static void,
+                                STDMETHODCALLTYPE,
+                                ID3D12Device_CreateSampler,
+                                ID3D12Device* Device,
+                                const D3D12_SAMPLER_DESC* pDesc,
+                                D3D12_CPU_DESCRIPTOR_HANDLE DestDescriptor) {
+            TraceLocalActivity(local);
+            TraceLoggingWriteStart(local,
+                                   "ID3D12Device_CreateSampler",
+                                   TLPArg(Device, "Device"),
+                                   TLPArg(DestDescriptor.ptr, "Descriptor"));
+
+            assert(g_instance);
+            D3D12_SAMPLER_DESC biasedDesc;
+            const bool isBiased = pDesc && g_instance->patchSampler(Device, *pDesc, DestDescriptor, biasedDesc);
+
+            assert(g_original_ID3D12Device_CreateSampler);
+            g_original_ID3D12Device_CreateSampler(Device, isBiased ? &biasedDesc : pDesc, DestDescriptor);
+
+            TraceLoggingWriteStop(local, "ID3D12Device_CreateSampler", TLArg(isBiased, "Biased"));
+        }
+
+        DECLARE_DETOUR_FUNCTION(static HRESULT,
+                                STDMETHODCALLTYPE,
+                                ID3D12Device_CreateRootSignature,
+                                ID3D12Device* Device,
+                                UINT nodeMask,
+                                const void* pBlobWithRootSignature,
+                                SIZE_T blobLengthInBytes,
+                                REFIID riid,
+                                void** ppvRootSignature) {
+            TraceLocalActivity(local);
+            TraceLoggingWriteStart(local,
+                                   "ID3D12Device_CreateRootSignature",
+                                   TLPArg(Device, "Device"),
+                                   TLArg(blobLengthInBytes, "BlobLength"));
+
+            assert(g_instance);
+            const auto biasedRootSignature =
+                pBlobWithRootSignature
+                    ? g_instance->patchRootSignature(Device, pBlobWithRootSignature, blobLengthInBytes)
+                    : nullptr;
+
+            assert(g_original_ID3D12Device_CreateRootSignature);
+            const HRESULT hr =
+                biasedRootSignature
+                    ? g_original_ID3D12Device_CreateRootSignature(Device,
+                                                                  nodeMask,
+                                                                  biasedRootSignature->GetBufferPointer(),
+                                                                  biasedRootSignature->GetBufferSize(),
+                                                                  riid,
+                                                                  ppvRootSignature)
+                    : g_original_ID3D12Device_CreateRootSignature(
+                          Device, nodeMask, pBlobWithRootSignature, blobLengthInBytes, riid, ppvRootSignature);
+
+            TraceLoggingWriteStop(local,
+                                  "ID3D12Device_CreateRootSignature",
+                                  TLArg(!!biasedRootSignature, "Biased"),
+                                  TLArg((int32_t)hr, "Result"));
+
+            return hr;
+        }
+
         DECLARE_DETOUR_FUNCTION(static void,
                                 STDMETHODCALLTYPE,
                                 ID3D12GraphicsCommandList_OMSetRenderTargets,
@@ -2,6 +2,8 @@
 
 #include "pch.h"
 
+#include "interfaces.h"
+
 namespace toolkit::graphics::d3dcommon {
     struct ModelConstantBuffer {
         DirectX::XMFLOAT4X4 Model;
@@ -11,6 +13,258 @@ namespace toolkit::graphics::d3dcommon {
         DirectX::XMFLOAT4X4 ViewProjection;
     };
 
+    // Counters for the interception hooks, which may run on any of the application's threads. The hooks are only
+    // timed while the statistics are displayed or recorded.
+    struct HookCounters {
+        std::atomic<bool> isEnabled{false};
+        std::atomic<uint32_t> numCalls{0};
+        // Individual calls are much shorter than a microsecond.
+        std::atomic<uint64_t> cpuTimeNs{0};
+
+        HookStatistics exchange() {
+            HookStatistics stats;
+            stats.numCalls = numCalls.exchange(0);
+            stats.cpuTimeUs = cpuTimeNs.exchange(0) / 1000;
+            return stats;
+        }
+    };
+
+    // Account for one call to a hook and the time spent in it.
+    class ScopedHookTimer {
+      public:
+        ScopedHookTimer(HookCounters& counters)
+            : m_counters(counters), m_isEnabled(counters.isEnabled.load(std::memory_order_relaxed)) {
+            if (m_isEnabled) {
+                m_start = std::chrono::steady_clock::now();
+            }
+        }
+
+        ~ScopedHookTimer() {
+            if (!m_isEnabled) {
+                return;
+            }
+
+            const auto elapsed = std::chrono::steady_clock::now() - m_start;
+            m_counters.numCalls++;
+            m_counters.cpuTimeNs += std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count();
+        }
+
+      private:
+        HookCounters& m_counters;
+        const bool m_isEnabled;
+        std::chrono::steady_clock::time_point m_start;
+    };
+
+    // A tag attached to the application's objects with SetPrivateDataInterface(), in order to be notified when they
+    // are destroyed.
+    struct DECLSPEC_UUID("5B0DF8A6-3C4E-4B8B-9E52-77C1D0A4F0E3") IWrapperCacheTag : IUnknown {};
+
+    struct IWrapperCache {
+        virtual ~IWrapperCache() = default;
+        virtual void evict(const void* object, uint64_t generation) = 0;
+    };
+
+    class WrapperCacheTag
+        : public Microsoft::WRL::RuntimeClass<Microsoft::WRL::RuntimeClassFlags<Microsoft::WRL::ClassicCom>,
+                                              IWrapperCacheTag> {
+      public:
+        WrapperCacheTag(std::weak_ptr<IWrapperCache> cache, const void* object, uint64_t generation)
+            : m_cache(cache), m_object(object), m_generation(generation) {
+        }
+
+        ~WrapperCacheTag() {
+            if (auto cache = m_cache.lock()) {
+                cache->evict(m_object, m_generation);
+            }
+        }
+
+      private:
+        const std::weak_ptr<IWrapperCache> m_cache;
+        const void* const m_object;
+        const uint64_t m_generation;
+    };
+
+    // Unordered access views cannot use a sRGB format. A typeless texture is written through a UNORM view instead, and
+    // the shader encodes the colors.
+    inline DXGI_FORMAT GetUnorderedAccessViewFormat(DXGI_FORMAT format) {
+        switch (format) {
+        case DXGI_FORMAT_R8G8B8A8_UNORM_SRGB:
+            return DXGI_FORMAT_R8G8B8A8_UNORM;
+        case DXGI_FORMAT_B8G8R8A8_UNORM_SRGB:
+            return DXGI_FORMAT_B8G8R8A8_UNORM;
+        case DXGI_FORMAT_B8G8R8X8_UNORM_SRGB:
+            return DXGI_FORMAT_B8G8R8X8_UNORM;
+        default:
+            return format;
+        }
+    }
+
+    // Bookkeeping of the GPU timestamps recorded during one frame. Each interval of a stage uses a pair of consecutive
+    // timestamps, and all the timestamps of the frame are resolved in a single batch.
+    struct GpuFrameTimestamps {
+        static constexpr uint32_t MaxIntervals = 32;
+        static constexpr uint32_t MaxTimestamps = MaxIntervals * 2;
+
+        struct Interval {
+            GpuStage stage;
+            bool isComplete;
+        };
+
+        Interval intervals[MaxIntervals];
+        uint32_t numIntervals{0};
+        std::optional<uint32_t> openIntervals[to_integral(GpuStage::MaxValue)];
+
+        // The frame was closed and its timestamps have not been read back yet.
+        bool isPending{false};
+
+        void reset() {
+            numIntervals = 0;
+            for (auto& openInterval : openIntervals) {
+                openInterval.reset();
+            }
+            isPending = false;
+        }
+
+        // Returns the index of the timestamp to write, if any.
+        std::optional<uint32_t> start(GpuStage stage) {
+            if (openIntervals[to_integral(stage)] || numIntervals == MaxIntervals) {
+                return {};
+            }
+            intervals[numIntervals] = {stage, false};
+            openIntervals[to_integral(stage)] = numIntervals;
+            return 2 * numIntervals++;
+        }
+
+        // Returns the index of the timestamp to write, if any.
+        std::optional<uint32_t> stop(GpuStage stage) {
+            auto& openInterval = openIntervals[to_integral(stage)];
+            if (!openInterval) {
+                return {};
+            }
+            const uint32_t index = *openInterval;
+            openInterval.reset();
+            intervals[index].isComplete = true;
+            return 2 * index + 1;
+        }
+
+        // Intervals still open are discarded, however their stop timestamp is written so that all timestamps of the
+        // frame can be resolved.
+        void close(const std::function<void(uint32_t)>& writeTimestamp) {
+            for (auto& openInterval : openIntervals) {
+                if (openInterval) {
+                    writeTimestamp(2 * *openInterval + 1);
+                    openInterval.reset();
+                }
+            }
+            isPending = numIntervals > 0;
+        }
+
+        GpuStageTimings accumulate(const uint64_t* timestamps, uint64_t frequency) const {
+            GpuStageTimings timings;
+            for (uint32_t i = 0; i < numIntervals; i++) {
+                const uint64_t start = timestamps[2 * i];
+                const uint64_t stop = timestamps[2 * i + 1];
+                if (intervals[i].isComplete && stop >= start) {
+                    timings.durationUs[to_integral(intervals[i].stage)] += ((stop - start) * 1000000) / frequency;
+                }
+            }
+            return timings;
+        }
+    };
+
+    // The pool behind IDevice::acquireTransientTexture().
+    class TransientTexturePool {
+      public:
+        // Textures that are not used for that many frames are destroyed (eg: after a change of resolution).
+        static constexpr uint64_t MaxUnusedFrames = 90;
+
+        std::shared_ptr<ITexture> acquire(const XrSwapchainCreateInfo& info,
+                                          const std::function<std::shared_ptr<ITexture>()>& create) {
+            auto& entries = m_entries[getKey(info)];
+            for (auto& entry : entries) {
+                if (!entry.isInUse) {
+                    entry.isInUse = true;
+                    entry.lastUsedFrame = m_frame;
+                    return entry.texture;
+                }
+            }
+
+            entries.push_back({create(), true, m_frame});
+            m_numTextures++;
+            m_peakNumTextures = std::max(m_peakNumTextures, m_numTextures);
+            return entries.back().texture;
+        }
+
+        void release(const std::shared_ptr<ITexture>& texture) {
+            // The texture might report a different description than the one it was created from (eg: format
+            // override), so we cannot use its key.
+            for (auto& [key, entries] : m_entries) {
+                for (auto& entry : entries) {
+                    if (entry.texture == texture) {
+                        entry.isInUse = false;
+                        return;
+                    }
+                }
+            }
+        }
+
+        // Return all the textures to the pool.
+        void endFrame() {
+            m_frame++;
+            for (auto it = m_entries.begin(); it != m_entries.end();) {
+                auto& entries = it->second;
+                for (auto entry = entries.begin(); entry != entries.end();) {
+                    entry->isInUse = false;
+                    if (m_frame - entry->lastUsedFrame > MaxUnusedFrames) {
+                        entry = entries.erase(entry);
+                        m_numTextures--;
+                    } else {
+                        entry++;
+                    }
+                }
+                it = entries.empty() ? m_entries.erase(it) : std::next(it);
+            }
+        }
+
+        void clear() {
+            m_entries.clear();
+            m_numTextures = 0;
+        }
+
+        size_t size() const {
+            return m_numTextures;
+        }
+
+        size_t peakSize() const {
+            return m_peakNumTextures;
+        }
+
+      private:
+        // Width, height, format, usage, array size, mip count, sample count.
+        using Key = std::tuple<uint32_t, uint32_t, int64_t, XrSwapchainUsageFlags, uint32_t, uint32_t, uint32_t>;
+
+        struct Entry {
+            std::shared_ptr<ITexture> texture;
+            bool isInUse;
+            uint64_t lastUsedFrame;
+        };
+
+        static Key getKey(const XrSwapchainCreateInfo& info) {
+            return {info.width,
+                    info.height,
+                    info.format,
+                    info.usageFlags,
+                    info.arraySize,
+                    info.mipCount,
+                    info.sampleCount};
+        }
+
+        std::map<Key, std::vector<Entry>> m_entries;
+        uint64_t m_frame{0};
+        size_t m_numTextures{0};
+        size_t m_peakNumTextures{0};
+    };
+
     const std::string_view MeshShaders = R"_(
 struct VSOutput {
     float4 Pos : SV_POSITION;
@@ -39,11 +293,24 @@ float4 psMain(VSOutput input) : SV_TARGET {
 }
 )_";
 
+    // With QUAD_LAYERED, each instance of the quad is drawn to the render target slice of the same index.
     const std::string_view QuadVertexShader = R"_(
-void vsMain(in uint id : SV_VertexID, out float4 position : SV_Position, out float2 texcoord : TEXCOORD0)
+void vsMain(in uint id : SV_VertexID,
+#if QUAD_LAYERED
+            in uint instance : SV_InstanceID,
+#endif
+            out float4 position : SV_Position,
+            out float2 texcoord : TEXCOORD0
+#if QUAD_LAYERED
+            , out uint slice : SV_RenderTargetArrayIndex
+#endif
+            )
 {
     texcoord = float2((id == 1) ? 2.0 : 0.0, (id == 2) ? 2.0 : 0.0);
     position = float4(texcoord * float2(2.0, -2.0) + float2(-1.0, 1.0), 0.0, 1.0);
+#if QUAD_LAYERED
+    slice = instance;
+#endif
 }
 )_";
 } // namespace toolkit::graphics::d3dcommon
@@ -32,6 +32,7 @@ namespace toolkit {
     namespace utilities {
 
         std::optional<int> RegGetDword(HKEY hKey, const std::wstring& subKey, const std::wstring& value);
+        std::map<std::string, int, std::less<>> RegGetDwords(HKEY hKey, const std::wstring& subKey);
         void RegSetDword(HKEY hKey, const std::wstring& subKey, const std::wstring& value, DWORD dwordValue);
         void
         RegSetString(HKEY hKey, const std::wstring& subKey, const std::wstring& value, const std::string& stringValue);
@@ -39,6 +40,7 @@ namespace toolkit {
         void RegDeleteKey(HKEY hKey, const std::wstring& subKey);
 
         std::shared_ptr<ICpuTimer> CreateCpuTimer();
+        std::shared_ptr<IFrameLimiter> CreateFrameLimiter();
 
         uint32_t GetScaledInputSize(uint32_t outputSize, int scalePercent, uint32_t blockSize);
 
@@ -60,7 +62,13 @@ namespace toolkit {
 
     namespace config {
 
+        std::shared_ptr<IConfigStore> CreateRegistryConfigStore(const std::string& appName);
+        std::shared_ptr<IConfigStore> CreateFileConfigStore(const std::filesystem::path& path,
+                                                            std::shared_ptr<IConfigStore> fallback = nullptr);
+        std::shared_ptr<IConfigStore> CreateConfigStore(const std::string& appName);
         std::shared_ptr<IConfigManager> CreateConfigManager(const std::string& appName);
+        std::shared_ptr<IConfigManager> CreateConfigManager(const std::string& appName,
+                                                            std::shared_ptr<IConfigStore> store);
 
         std::pair<uint32_t, uint32_t> GetScaledDimensions(
             int settingScaling, int settingAnamophic, uint32_t outputWidth, uint32_t outputHeight, uint32_t blockSize);
@@ -182,6 +190,9 @@ namespace toolkit {
         std::shared_ptr<IMenuHandler> CreateMenuHandler(std::shared_ptr<toolkit::config::IConfigManager> configManager,
                                                         std::shared_ptr<toolkit::graphics::IDevice> device,
                                                         const MenuInfo& menuInfo);
+
+        std::shared_ptr<ITelemetryRecorder> CreateTelemetryRecorder(const std::filesystem::path& path,
+                                                                    uint32_t capacity);
     } // namespace menu
 
 } // namespace toolkit
@@ -79,6 +79,8 @@ XrResult __declspec(dllexport) XRAPI_CALL
     CreateDirectoryA((localAppData / "stats").string().c_str(), nullptr);
     CreateDirectoryA((localAppData / "screenshots").string().c_str(), nullptr);
     CreateDirectoryA((localAppData / "configs").string().c_str(), nullptr);
+    CreateDirectoryA((localAppData / "traces").string().c_str(), nullptr);
+    CreateDirectoryA((localAppData / "shader_cache").string().c_str(), nullptr);
 
     // Start logging to file.
     if (!logStream.is_open()) {
@@ -39,14 +39,6 @@ namespace {
     using namespace toolkit::graphics;
     using namespace toolkit::log;
 
-    struct FSRConstants {
-        uint32_t Const0[4];
-        uint32_t Const1[4];
-        uint32_t Const2[4];
-        uint32_t Const3[4];
-        uint32_t Const4[4];
-    };
-
     class FSRUpscaler : public IImageProcessor {
       public:
         FSRUpscaler(std::shared_ptr<IConfigManager> configManager,
@@ -54,15 +46,25 @@ namespace {
                     int settingScaling,
                     int settingAnamorphic)
             : m_configManager(configManager), m_device(graphicsDevice),
-              m_isSharpenOnly(settingScaling == 100 && settingAnamorphic <= 0) {
+              m_isSharpenOnly(settingScaling == 100 && settingAnamorphic <= 0),
+              m_isFused(!m_isSharpenOnly && configManager->getValue(SettingFusedUpscaling)) {
             initializeScaler();
         }
 
         void reload() override {
-            initializeScaler();
+            // The current shaders are used until the new ones are compiled.
+            createShaders();
         }
 
         void update() override {
+            utilities::shader::ResolveAsync(m_pendingShaderEASU, m_shaderEASU);
+            utilities::shader::ResolveAsync(m_pendingShaderRCAS, m_shaderRCAS);
+            for (size_t i = 0; i < std::size(m_shaderFused); i++) {
+                utilities::shader::ResolveAsync(m_pendingShaderFused[i], m_shaderFused[i]);
+            }
+            utilities::shader::ResolveAsync(m_pendingShaderEASUStereo, m_shaderEASUStereo);
+            utilities::shader::ResolveAsync(m_pendingShaderRCASStereo, m_shaderRCASStereo);
+            utilities::shader::ResolveAsync(m_pendingShaderFusedStereo, m_shaderFusedStereo);
         }
 
         void process(std::shared_ptr<ITexture> input,
@@ -70,15 +72,168 @@ namespace {
                      std::vector<std::shared_ptr<ITexture>>& textures,
                      std::array<uint8_t, 1024>& blob,
                      std::optional<utilities::Eye> eye = std::nullopt) override {
+            processInternal(input, output, blob, eye);
+        }
+
+        bool getFusedPostProcess(FusedPostProcess& postProcess,
+                                 std::optional<utilities::Eye> eye = std::nullopt) const override {
+            return false;
+        }
+
+        bool processFused(std::shared_ptr<ITexture> input,
+                          std::shared_ptr<ITexture> output,
+                          std::vector<std::shared_ptr<ITexture>>& textures,
+                          std::array<uint8_t, 1024>& blob,
+                          const FusedPostProcess& postProcess,
+                          std::optional<utilities::Eye> eye = std::nullopt) override {
+            if (!m_isFused || !(output->getInfo().usageFlags & XR_SWAPCHAIN_USAGE_UNORDERED_ACCESS_BIT)) {
+                return false;
+            }
+
+            const auto threadGroups = updateConfig(input, output, blob, eye);
+            m_postProcessBuffer->uploadData(&postProcess.constants, sizeof(postProcess.constants));
+
+            // Permutation 1 applies the color gains only, permutation 2 applies all the adjustments.
+            const auto& shader = m_shaderFused[postProcess.isEnabled ? 2 : 1];
+            shader->updateThreadGroups(threadGroups);
+            m_device->setShader(shader, SamplerType::LinearClamp);
+            m_device->setShaderInput(0, m_configBuffer);
+            m_device->setShaderInput(1, m_postProcessBuffer);
+            m_device->setShaderInput(0, input);
+            m_device->setShaderOutput(0, output);
+            m_device->dispatchShader();
+
+            return true;
+        }
+
+        void setFoveation(const std::optional<Foveation>& foveation, utilities::Eye eye) override {
+            m_foveation[(size_t)eye] = foveation;
+        }
+
+        bool isStereoSupported() const override {
+            // The stereo shaders are not waited for, the per-eye path is used until they are ready.
+            if (m_isFused) {
+                return !!m_shaderFusedStereo;
+            }
+            return (m_isSharpenOnly || m_shaderEASUStereo) && m_shaderRCASStereo;
+        }
+
+        void processStereo(std::shared_ptr<ITexture> input,
+                           const StereoViews& inputViews,
+                           std::shared_ptr<ITexture> output,
+                           const StereoViews& outputViews,
+                           std::vector<std::shared_ptr<ITexture>>& textures,
+                           std::array<uint8_t, 1024>& blob) override {
+            processInternal(input, output, blob, std::nullopt, &inputViews, &outputViews);
+        }
+
+      private:
+        // In stereo, the views locate both eyes in the input and the output.
+        void processInternal(std::shared_ptr<ITexture> input,
+                             std::shared_ptr<ITexture> output,
+                             std::array<uint8_t, 1024>& blob,
+                             std::optional<utilities::Eye> eye,
+                             const StereoViews* inputViews = nullptr,
+                             const StereoViews* outputViews = nullptr) {
+            const bool isStereo = inputViews && outputViews;
+            const auto threadGroups = updateConfig(input, output, blob, eye, inputViews, outputViews);
+
+            if (m_isFused) {
+                const auto& shader = isStereo ? m_shaderFusedStereo : m_shaderFused[0];
+                shader->updateThreadGroups(threadGroups);
+                m_device->setShader(shader, SamplerType::LinearClamp);
+                m_device->setShaderInput(0, m_configBuffer);
+                if (isStereo) {
+                    setStereoViews(*inputViews, *outputViews);
+                    m_device->setShaderInput(0, input, AllSlices);
+                    m_device->setShaderOutput(0, output, AllSlices);
+                } else {
+                    m_device->setShaderInput(0, input);
+                    m_device->setShaderOutput(0, output);
+                }
+                m_device->dispatchShader();
+                return;
+            }
+
+            // Get the intermediate texture from the device's pool. In stereo, it has one slice per eye.
+            std::shared_ptr<ITexture> intermediate;
+            StereoViews intermediateViews{};
+            if (!m_isSharpenOnly) {
+                auto createInfo = output->getInfo();
+
+                // Good balance between visuals and performance.
+                createInfo.format = m_device->getTextureFormat(TextureFormat::R16G16B16A16_UNORM);
+                if (isStereo) {
+                    createInfo.width = outputViews->extent.width;
+                    createInfo.height = outputViews->extent.height;
+                    createInfo.arraySize = utilities::ViewCount;
+                    for (uint32_t i = 0; i < utilities::ViewCount; i++) {
+                        intermediateViews.slice[i] = i;
+                    }
+                    intermediateViews.extent = outputViews->extent;
+                }
+
+                createInfo.usageFlags = XR_SWAPCHAIN_USAGE_SAMPLED_BIT | XR_SWAPCHAIN_USAGE_UNORDERED_ACCESS_BIT;
+                intermediate = m_device->acquireTransientTexture(createInfo, "FSR Intermediate TEX2D");
+
+                const auto& shaderEASU = isStereo ? m_shaderEASUStereo : m_shaderEASU;
+                shaderEASU->updateThreadGroups(threadGroups);
+                m_device->setShader(shaderEASU, SamplerType::LinearClamp);
+                m_device->setShaderInput(0, m_configBuffer);
+                if (isStereo) {
+                    setStereoViews(*inputViews, intermediateViews);
+                    m_device->setShaderInput(0, input, AllSlices);
+                    m_device->setShaderOutput(0, intermediate, AllSlices);
+                } else {
+                    m_device->setShaderInput(0, input);
+                    m_device->setShaderOutput(0, intermediate);
+                }
+                m_device->dispatchShader();
+            }
+
+            const auto& shaderRCAS = isStereo ? m_shaderRCASStereo : m_shaderRCAS;
+            shaderRCAS->updateThreadGroups(threadGroups);
+            m_device->setShader(shaderRCAS, SamplerType::LinearClamp);
+            m_device->setShaderInput(0, m_configBuffer);
+            if (isStereo) {
+                setStereoViews(m_isSharpenOnly ? *inputViews : intermediateViews, *outputViews);
+                m_device->setShaderInput(0, m_isSharpenOnly ? input : intermediate, AllSlices);
+                m_device->setShaderOutput(0, output, AllSlices);
+            } else {
+                m_device->setShaderInput(0, m_isSharpenOnly ? input : intermediate);
+                m_device->setShaderOutput(0, output);
+            }
+            m_device->dispatchShader();
+
+            if (intermediate) {
+                m_device->releaseTransientTexture(intermediate);
+            }
+        }
+
+        void setStereoViews(const StereoViews& inputViews, const StereoViews& outputViews) {
+            const auto stereo = MakeStereoConstants(inputViews, outputViews);
+            m_stereoBuffer->uploadData(&stereo, sizeof(stereo));
+            m_device->setShaderInput(2, m_stereoBuffer);
+        }
+
+        // Fill the constants for this image (or both eyes in stereo), and return the dispatch size.
+        std::array<unsigned int, 3> updateConfig(std::shared_ptr<ITexture> input,
+                                                 std::shared_ptr<ITexture> output,
+                                                 std::array<uint8_t, 1024>& blob,
+                                                 std::optional<utilities::Eye> eye,
+                                                 const StereoViews* inputViews = nullptr,
+                                                 const StereoViews* outputViews = nullptr) {
             // We need to use a per-instance blob.
             static_assert(sizeof(FSRConstants) <= 1024);
             FSRConstants* const config = reinterpret_cast<FSRConstants*>(blob.data());
 
-            // Update the scaler's configuration specifically for this image.
-            const auto inputWidth = input->getInfo().width;
-            const auto inputHeight = input->getInfo().height;
-            const auto outputWidth = output->getInfo().width;
-            const auto outputHeight = output->getInfo().height;
+            // Update the scaler's configuration specifically for this image. In stereo, the shaders address the region
+            // of each eye like a whole texture.
+            const bool isStereo = inputViews && outputViews;
+            const auto inputWidth = isStereo ? (uint32_t)inputViews->extent.width : input->getInfo().width;
+            const auto inputHeight = isStereo ? (uint32_t)inputViews->extent.height : input->getInfo().height;
+            const auto outputWidth = isStereo ? (uint32_t)outputViews->extent.width : output->getInfo().width;
+            const auto outputHeight = isStereo ? (uint32_t)outputViews->extent.height : output->getInfo().height;
             const float sharpness = m_configManager->getValue(SettingSharpness) / 100.f;
 
             if (!m_isSharpenOnly) {
@@ -97,6 +252,26 @@ namespace {
             const auto attenuation = 1.f - AClampF1(sharpness, 0, 1);
             FsrRcasCon(config->Const4, static_cast<AF1>(attenuation));
 
+            // Outside of the foveated region, bilinear filtering is followed by a lighter RCAS (each stop of
+            // attenuation halves the sharpening). Without upscaling, RCAS is the same everywhere.
+            FsrRcasCon(config->Const5, static_cast<AF1>(attenuation + 1.f));
+            for (size_t slice = 0; slice < utilities::ViewCount; slice++) {
+                // In stereo, the slice is the eye.
+                const auto& foveation = m_foveation[isStereo ? slice : (size_t)eye.value_or(utilities::Eye::Both)];
+                if (!m_isSharpenOnly && foveation) {
+                    config->Foveation[slice][0] = foveation->gaze.x;
+                    config->Foveation[slice][1] = foveation->gaze.y;
+                    config->Foveation[slice][2] = foveation->ring.x;
+                    config->Foveation[slice][3] = foveation->ring.y;
+                } else {
+                    std::fill_n(config->Foveation[slice], std::size(config->Foveation[slice]), 0.f);
+                }
+            }
+
+            // The fused path may write directly to a sRGB swapchain, through a UNORM view.
+            std::fill_n(config->OutputFlags, std::size(config->OutputFlags), 0u);
+            config->OutputFlags[0] = m_isFused && m_device->isTextureFormatSRGB(output->getInfo().format);
+
             // TODO:
             // The AMD FSR sample is using a value in the constant buffer to correct the output color accordingly.
             // We're replacing the constant with a shader compilation define because the project code is not HDR
@@ -110,47 +285,52 @@ namespace {
 
             // This value is the image region dimension that each thread group of the FSR shader operates on
             const auto threadGroupWorkRegionDim = 16u;
-            const std::array<unsigned int, 3> threadGroups = {
-                (outputWidth + (threadGroupWorkRegionDim - 1)) / threadGroupWorkRegionDim,  // dispatchX
-                (outputHeight + (threadGroupWorkRegionDim - 1)) / threadGroupWorkRegionDim, // dispatchY
-                1};
-
-            // Create the intermediate texture if needed.
-            if (!m_isSharpenOnly) {
-                const auto outputInfo = output->getInfo();
-                if (textures.empty() || textures[0]->getInfo().width != outputInfo.width ||
-                    textures[0]->getInfo().height != outputInfo.height) {
-                    textures.clear();
-                    auto createInfo = outputInfo;
-
-                    // Good balance between visuals and performance.
-                    createInfo.format = m_device->getTextureFormat(TextureFormat::R16G16B16A16_UNORM);
+            return {(outputWidth + (threadGroupWorkRegionDim - 1)) / threadGroupWorkRegionDim,  // dispatchX
+                    (outputHeight + (threadGroupWorkRegionDim - 1)) / threadGroupWorkRegionDim, // dispatchY
+                    isStereo ? utilities::ViewCount : 1};                                       // one slice per eye
+        }
 
-                    createInfo.usageFlags = XR_SWAPCHAIN_USAGE_SAMPLED_BIT | XR_SWAPCHAIN_USAGE_UNORDERED_ACCESS_BIT;
-                    textures.push_back(m_device->createTexture(createInfo, "FSR Intermediate TEX2D"));
+        void initializeScaler() {
+            createShaders();
+            if (!m_isFused) {
+                utilities::shader::ResolveAsync(m_pendingShaderEASU, m_shaderEASU, true /* wait */);
+                utilities::shader::ResolveAsync(m_pendingShaderRCAS, m_shaderRCAS, true /* wait */);
+            } else {
+                for (size_t i = 0; i < std::size(m_shaderFused); i++) {
+                    utilities::shader::ResolveAsync(m_pendingShaderFused[i], m_shaderFused[i], true /* wait */);
                 }
-
-                m_shaderEASU->updateThreadGroups(threadGroups);
-                m_device->setShader(m_shaderEASU, SamplerType::LinearClamp);
-                m_device->setShaderInput(0, m_configBuffer);
-                m_device->setShaderInput(0, input);
-                m_device->setShaderOutput(0, textures[0]);
-                m_device->dispatchShader();
+                m_postProcessBuffer = m_device->createBuffer(sizeof(PostProcessConstants), "FSR Postprocess CB");
             }
 
-            m_shaderRCAS->updateThreadGroups(threadGroups);
-            m_device->setShader(m_shaderRCAS, SamplerType::LinearClamp);
-            m_device->setShaderInput(0, m_configBuffer);
-            m_device->setShaderInput(0, m_isSharpenOnly ? input : textures[0]);
-            m_device->setShaderOutput(0, output);
-            m_device->dispatchShader();
+            m_configBuffer = m_device->createBuffer(sizeof(FSRConstants), "FSR Constants CB");
+            m_stereoBuffer = m_device->createBuffer(sizeof(StereoConstants), "FSR Stereo CB");
         }
 
-      private:
-        void initializeScaler() {
+        void createShaders() {
             const auto shadersDir = dllHome / "shaders";
             const auto shaderFile = shadersDir / "FSR.hlsl";
 
+            if (m_isFused) {
+                utilities::shader::Defines defines;
+                defines.add("FSR_THREAD_GROUP_SIZE", 64);
+                defines.add("SAMPLE_SLOW_FALLBACK", 1);
+                defines.add("SAMPLE_FUSED", 1);
+                defines.add("PASS_THROUGH_USE_GAINS", true);
+                defines.add("SAMPLE_POST_PROCESS", 0);
+                for (size_t i = 0; i < std::size(m_shaderFused); i++) {
+                    defines.set("SAMPLE_POST_PROCESS", i);
+                    m_pendingShaderFused[i] = m_device->createComputeShaderAsync(
+                        shaderFile, "mainFusedCS", fmt::format("FSR Fused {} CS", i), {}, defines.get());
+                }
+
+                // The stereo pass writes to an intermediate texture array, the post-processing is done separately.
+                defines.set("SAMPLE_POST_PROCESS", 0);
+                defines.add("SAMPLE_STEREO", 1);
+                m_pendingShaderFusedStereo = m_device->createComputeShaderAsync(
+                    shaderFile, "mainFusedCS", "FSR Fused Stereo CS", {}, defines.get());
+                return;
+            }
+
             // EASU/RCAS common
             utilities::shader::Defines defines;
             defines.add("FSR_THREAD_GROUP_SIZE", 64);
@@ -161,24 +341,49 @@ namespace {
             defines.add("SAMPLE_RCAS", 0);
             defines.add("SAMPLE_EASU", 1);
             defines.add("SAMPLE_HDR_OUTPUT", 0);
-            m_shaderEASU = m_device->createComputeShader(shaderFile, "mainCS", "FSR EASU CS", {}, defines.get());
+            m_pendingShaderEASU =
+                m_device->createComputeShaderAsync(shaderFile, "mainCS", "FSR EASU CS", {}, defines.get());
+            {
+                utilities::shader::Defines stereoDefines(defines.get());
+                stereoDefines.add("SAMPLE_STEREO", 1);
+                m_pendingShaderEASUStereo = m_device->createComputeShaderAsync(
+                    shaderFile, "mainCS", "FSR EASU Stereo CS", {}, stereoDefines.get());
+            }
 
             // RCAS specific
             defines.set("SAMPLE_EASU", 0);
             defines.set("SAMPLE_RCAS", 1);
             defines.add("SAMPLE_HDR_OUTPUT", 1);
-            m_shaderRCAS = m_device->createComputeShader(shaderFile, "mainCS", "FSR RCAS CS", {}, defines.get());
-
-            m_configBuffer = m_device->createBuffer(sizeof(FSRConstants), "FSR Constants CB");
+            m_pendingShaderRCAS =
+                m_device->createComputeShaderAsync(shaderFile, "mainCS", "FSR RCAS CS", {}, defines.get());
+            defines.add("SAMPLE_STEREO", 1);
+            m_pendingShaderRCASStereo =
+                m_device->createComputeShaderAsync(shaderFile, "mainCS", "FSR RCAS Stereo CS", {}, defines.get());
         }
 
         const std::shared_ptr<IConfigManager> m_configManager;
         const std::shared_ptr<IDevice> m_device;
         const bool m_isSharpenOnly;
+        const bool m_isFused;
 
         std::shared_ptr<IComputeShader> m_shaderEASU;
         std::shared_ptr<IComputeShader> m_shaderRCAS;
+        std::shared_future<std::shared_ptr<IComputeShader>> m_pendingShaderEASU;
+        std::shared_future<std::shared_ptr<IComputeShader>> m_pendingShaderRCAS;
+        // Without post-processing, with the color gains only, with all the adjustments.
+        std::shared_ptr<IComputeShader> m_shaderFused[3];
+        std::shared_future<std::shared_ptr<IComputeShader>> m_pendingShaderFused[3];
+        std::shared_ptr<IComputeShader> m_shaderEASUStereo;
+        std::shared_ptr<IComputeShader> m_shaderRCASStereo;
+        std::shared_ptr<IComputeShader> m_shaderFusedStereo;
+        std::shared_future<std::shared_ptr<IComputeShader>> m_pendingShaderEASUStereo;
+        std::shared_future<std::shared_ptr<IComputeShader>> m_pendingShaderRCASStereo;
+        std::shared_future<std::shared_ptr<IComputeShader>> m_pendingShaderFusedStereo;
         std::shared_ptr<IShaderBuffer> m_configBuffer;
+        std::shared_ptr<IShaderBuffer> m_postProcessBuffer;
+        std::shared_ptr<IShaderBuffer> m_stereoBuffer;
+
+        std::optional<Foveation> m_foveation[utilities::ViewCount + 1];
     };
 
 } // namespace
@@ -26,6 +26,7 @@
 #include "interfaces.h"
 #include "layer.h"
 #include "log.h"
+#include "profiler.h"
 
 namespace {
 
@@ -418,6 +419,8 @@ namespace {
         }
 
         void sync(XrTime frameTime, XrTime now, const XrActionsSyncInfo& syncInfo) override {
+            ProfileZone("HandTracker::sync");
+
             // Arbitrarily choose this place to handle configuration input.
             if (m_configSocket != INVALID_SOCKET) {
                 struct sockaddr_in saddr;
@@ -36,14 +36,6 @@ namespace {
     using namespace toolkit::graphics;
     using namespace toolkit::log;
 
-    struct alignas(16) ImageProcessorConfig {
-        XrVector4f Params1; // Contrast, Brightness, Exposure, Saturation (-1..+1 params)
-        XrVector4f Params2; // ColorGainR, ColorGainG, ColorGainB (-1..+1 params)
-        XrVector4f Params3; // Highlights, Shadows, Vibrance (0..1 params), UseCA (0 = off, 1 = on)
-        XrVector4f Params4; // ChromaticCorrectionR, ChromaticCorrectionG, ChromaticCorrectionB (-1..+1 params)
-                            // Eye (0 = left, 1 = right)
-    };
-
     class ImageProcessor : public IImageProcessor {
       public:
         ImageProcessor(std::shared_ptr<IConfigManager> configManager, std::shared_ptr<IDevice> graphicsDevice)
@@ -53,10 +45,17 @@ namespace {
         }
 
         void reload() override {
-            createRenderResources();
+            // The current shaders are used until the new ones are compiled.
+            createShaders();
         }
 
         void update() override {
+            for (size_t i = 0; i < std::size(m_shaders); i++) {
+                utilities::shader::ResolveAsync(m_pendingShaders[i], m_shaders[i]);
+                utilities::shader::ResolveAsync(m_pendingShadersStereo[i], m_shadersStereo[i]);
+                utilities::shader::ResolveAsync(m_pendingShadersLayered[i], m_shadersLayered[i]);
+            }
+
             // Generic implementation to support more than just Off/On modes in the future.
             const auto mode = m_configManager->getEnumValue<PostProcessType>(config::SettingPostProcess);
             const auto hasModeChanged = mode != m_mode;
@@ -64,7 +63,12 @@ namespace {
             if (hasModeChanged)
                 m_mode = mode;
 
-            if (hasModeChanged || checkUpdateConfig(mode)) {
+            // Only look at the individual settings when one of them changed.
+            const auto configGeneration = m_configManager->getGeneration(SettingGroup::PostProcess);
+            const auto hasConfigChanged = configGeneration != m_configGeneration;
+            m_configGeneration = configGeneration;
+
+            if (hasModeChanged || (hasConfigChanged && checkUpdateConfig(mode))) {
                 updateConfig();
             }
         }
@@ -74,28 +78,117 @@ namespace {
                      std::vector<std::shared_ptr<ITexture>>& textures,
                      std::array<uint8_t, 1024>& blob,
                      std::optional<utilities::Eye> eye = std::nullopt) override {
+            processInternal(input, output, blob, eye.value_or(utilities::Eye::Both));
+        }
+
+        bool getFusedPostProcess(FusedPostProcess& postProcess,
+                                 std::optional<utilities::Eye> eye = std::nullopt) const override {
+            // The chromatic aberration correction samples away from each pixel.
+            if (m_mode == PostProcessType::CACorrection) {
+                return false;
+            }
+
+            postProcess.constants = m_config;
+            postProcess.constants.Params4.w = (float)eye.value_or(utilities::Eye::Both);
+            postProcess.isEnabled = m_mode == PostProcessType::On;
+            return true;
+        }
+
+        bool processFused(std::shared_ptr<ITexture> input,
+                          std::shared_ptr<ITexture> output,
+                          std::vector<std::shared_ptr<ITexture>>& textures,
+                          std::array<uint8_t, 1024>& blob,
+                          const FusedPostProcess& postProcess,
+                          std::optional<utilities::Eye> eye = std::nullopt) override {
+            return false;
+        }
+
+        void setFoveation(const std::optional<Foveation>& foveation, utilities::Eye eye) override {
+        }
+
+        bool isStereoSupported() const override {
+            // The stereo shaders are not waited for, the per-eye path is used until they are ready.
+            return !!m_shadersStereo[m_mode == PostProcessType::On];
+        }
+
+        void processStereo(std::shared_ptr<ITexture> input,
+                           const StereoViews& inputViews,
+                           std::shared_ptr<ITexture> output,
+                           const StereoViews& outputViews,
+                           std::vector<std::shared_ptr<ITexture>>& textures,
+                           std::array<uint8_t, 1024>& blob) override {
+            const auto stereo = MakeStereoConstants(inputViews, outputViews);
+            m_cbStereo->uploadData(&stereo, sizeof(stereo));
+
+            // Both eyes are drawn at once when each is in its own slice of the output, at the same location. Otherwise
+            // (or without the layered shaders), the quad is drawn once per eye.
+            const auto usePostProcess = m_mode == PostProcessType::On;
+            const bool isLayered = m_shadersLayered[usePostProcess] &&
+                                   output->getInfo().arraySize == utilities::ViewCount && outputViews.slice[0] == 0 &&
+                                   outputViews.slice[1] == 1 && outputViews.offset[0].x == outputViews.offset[1].x &&
+                                   outputViews.offset[0].y == outputViews.offset[1].y;
+            if (isLayered) {
+                processInternal(input, output, blob, utilities::Eye::Both, &outputViews, true /* isLayered */);
+            } else {
+                for (uint32_t eye = 0; eye < utilities::ViewCount; eye++) {
+                    processInternal(input, output, blob, (utilities::Eye)eye, &outputViews);
+                }
+            }
+        }
+
+      private:
+        // In stereo, the output views locate the eyes in the output, and the eye is the render target slice when the
+        // draw is layered.
+        void processInternal(std::shared_ptr<ITexture> input,
+                             std::shared_ptr<ITexture> output,
+                             std::array<uint8_t, 1024>& blob,
+                             utilities::Eye eye,
+                             const StereoViews* outputViews = nullptr,
+                             bool isLayered = false) {
             // We need to use a per-instance blob.
-            static_assert(sizeof(ImageProcessorConfig) <= 1024);
-            ImageProcessorConfig* const config = reinterpret_cast<ImageProcessorConfig*>(blob.data());
+            static_assert(sizeof(PostProcessConstants) <= 1024);
+            PostProcessConstants* const config = reinterpret_cast<PostProcessConstants*>(blob.data());
 
             memcpy(config, &m_config, sizeof(m_config));
 
             // Patch the eye.
-            config->Params4.w = (float)eye.value_or(utilities::Eye::Both);
+            config->Params4.w = (float)eye;
 
             // TODO: We can use an IShaderBuffer cache per swapchain and avoid this every frame.
             m_cbParams->uploadData(config, sizeof(*config));
 
             const auto usePostProcess = m_mode == PostProcessType::On;
-            m_device->setShader(m_shaders[usePostProcess], SamplerType::LinearClamp);
+            const auto& shaders = !outputViews ? m_shaders : isLayered ? m_shadersLayered : m_shadersStereo;
+            m_device->setShader(shaders[usePostProcess], SamplerType::LinearClamp);
             m_device->setShaderInput(0, m_cbParams);
-            m_device->setShaderInput(0, input);
-            m_device->setShaderOutput(0, output);
+            if (outputViews) {
+                const auto view = isLayered ? 0 : (uint32_t)eye;
+                const XrRect2Di viewport{outputViews->offset[view], outputViews->extent};
+                m_device->setShaderInput(1, m_cbStereo);
+                m_device->setShaderInput(0, input, AllSlices);
+                m_device->setShaderOutput(0, output, isLayered ? AllSlices : outputViews->slice[view], &viewport);
+            } else {
+                m_device->setShaderInput(0, input);
+                m_device->setShaderOutput(0, output);
+            }
             m_device->dispatchShader();
         }
 
-      private:
         void createRenderResources() {
+            createShaders();
+            for (size_t i = 0; i < std::size(m_shaders); i++) {
+                utilities::shader::ResolveAsync(m_pendingShaders[i], m_shaders[i], true /* wait */);
+            }
+
+            // TODO: For now, we're going to require that all image processing shaders share the same configuration
+            // structure.
+            m_cbParams = m_device->createBuffer(sizeof(PostProcessConstants), "Postprocess CB");
+            m_cbStereo = m_device->createBuffer(sizeof(StereoConstants), "Postprocess Stereo CB");
+
+            updateConfig();
+        }
+
+        void createShaders() {
             const auto shadersDir = dllHome / "shaders";
             const auto shaderFile = shadersDir / "postprocess.hlsl";
 
@@ -104,14 +197,24 @@ namespace {
             // defines.add("POST_PROCESS_DST_SRGB", true);
 
             defines.add("PASS_THROUGH_USE_GAINS", true);
-            m_shaders[0] = m_device->createQuadShader(shaderFile, "mainPassThrough", "Passthrough PS", defines.get());
-            m_shaders[1] = m_device->createQuadShader(shaderFile, "mainPostProcess", "Postprocess PS", defines.get());
-
-            // TODO: For now, we're going to require that all image processing shaders share the same configuration
-            // structure.
-            m_cbParams = m_device->createBuffer(sizeof(ImageProcessorConfig), "Postprocess CB");
-
-            updateConfig();
+            m_pendingShaders[0] =
+                m_device->createQuadShaderAsync(shaderFile, "mainPassThrough", "Passthrough PS", defines.get());
+            m_pendingShaders[1] =
+                m_device->createQuadShaderAsync(shaderFile, "mainPostProcess", "Postprocess PS", defines.get());
+
+            defines.add("POST_PROCESS_STEREO", true);
+            m_pendingShadersStereo[0] =
+                m_device->createQuadShaderAsync(shaderFile, "mainPassThrough", "Passthrough Stereo PS", defines.get());
+            m_pendingShadersStereo[1] =
+                m_device->createQuadShaderAsync(shaderFile, "mainPostProcess", "Postprocess Stereo PS", defines.get());
+
+            if (m_device->isRenderTargetArrayIndexSupported()) {
+                defines.add("POST_PROCESS_LAYERED", true);
+                m_pendingShadersLayered[0] = m_device->createQuadShaderAsync(
+                    shaderFile, "mainPassThrough", "Passthrough Layered PS", defines.get());
+                m_pendingShadersLayered[1] = m_device->createQuadShaderAsync(
+                    shaderFile, "mainPostProcess", "Postprocess Layered PS", defines.get());
+            }
         }
 
         bool checkUpdateConfig(PostProcessType mode) const {
@@ -180,19 +283,25 @@ namespace {
                 static const char* lut[] = {"", "_u1", "_u2", "_u3", "_u4"}; // placeholder up to 4
                 const auto suffix = lut[std::min(index, std::size(lut))];
 
-                return {XMINT4(configManager->getValue(SettingPostContrast + suffix),
-                               configManager->getValue(SettingPostBrightness + suffix),
-                               configManager->getValue(SettingPostExposure + suffix),
-                               configManager->getValue(SettingPostSaturation + suffix)),
+                // The base settings use the fast path, the user presets are looked up by name.
+                const auto getValue = [&](Setting setting) {
+                    return index == 0 ? configManager->getValue(setting)
+                                      : configManager->getValue(std::string(setting) + suffix);
+                };
+
+                return {XMINT4(getValue(SettingPostContrast),
+                               getValue(SettingPostBrightness),
+                               getValue(SettingPostExposure),
+                               getValue(SettingPostSaturation)),
 
-                        XMINT4(configManager->getValue(SettingPostColorGainR + suffix),
-                               configManager->getValue(SettingPostColorGainG + suffix),
-                               configManager->getValue(SettingPostColorGainB + suffix),
+                        XMINT4(getValue(SettingPostColorGainR),
+                               getValue(SettingPostColorGainG),
+                               getValue(SettingPostColorGainB),
                                0),
 
-                        XMINT4(configManager->getValue(SettingPostHighlights + suffix),
-                               configManager->getValue(SettingPostShadows + suffix),
-                               configManager->getValue(SettingPostVibrance + suffix),
+                        XMINT4(getValue(SettingPostHighlights),
+                               getValue(SettingPostShadows),
+                               getValue(SettingPostVibrance),
                                0)};
             }
             return {XMINT4(500, 500, 500, 500), XMINT4(500, 500, 500, 0), XMINT4(1000, 0, 0, 0)};
@@ -227,10 +336,17 @@ namespace {
         const std::array<DirectX::XMINT4, 3> m_userParams;
 
         std::shared_ptr<IQuadShader> m_shaders[2]; // off, on
+        std::shared_future<std::shared_ptr<IQuadShader>> m_pendingShaders[2];
+        std::shared_ptr<IQuadShader> m_shadersStereo[2]; // off, on
+        std::shared_future<std::shared_ptr<IQuadShader>> m_pendingShadersStereo[2];
+        std::shared_ptr<IQuadShader> m_shadersLayered[2]; // off, on
+        std::shared_future<std::shared_ptr<IQuadShader>> m_pendingShadersLayered[2];
         std::shared_ptr<IShaderBuffer> m_cbParams;
+        std::shared_ptr<IShaderBuffer> m_cbStereo;
 
         PostProcessType m_mode{PostProcessType::Off};
-        ImageProcessorConfig m_config{};
+        uint64_t m_configGeneration{0};
+        PostProcessConstants m_config{};
     };
 
 } // namespace
@@ -88,6 +88,104 @@ namespace toolkit {
         // A CPU synchronous timer.
         struct ICpuTimer : public ITimer {};
 
+        // A fixed-size histogram with log-scale buckets, for recording durations (or any positive value) at constant
+        // cost. Each power of 2 is split in 8 linear sub-buckets, giving at most 12.5% error on the reported values.
+        class LogHistogram {
+            static constexpr uint32_t SubBucketBits = 3;
+            static constexpr uint32_t SubBucketCount = 1 << SubBucketBits;
+            static constexpr uint32_t MaxExponent = 32;
+
+          public:
+            static constexpr uint32_t BucketCount = (MaxExponent - SubBucketBits + 1) * SubBucketCount;
+
+            void record(uint64_t value) {
+                m_buckets[getBucketIndex(value)]++;
+                m_count++;
+                m_max = std::max(m_max, value);
+            }
+
+            // Returns the upper bound of the bucket containing the requested percentile (0-100), capped to the
+            // largest recorded value.
+            uint64_t getPercentile(uint32_t percentile) const {
+                if (!m_count) {
+                    return 0;
+                }
+
+                const uint64_t rank = std::max((m_count * percentile + 99) / 100, uint64_t(1));
+                uint64_t seen = 0;
+                for (uint32_t i = 0; i < BucketCount; i++) {
+                    seen += m_buckets[i];
+                    if (seen >= rank) {
+                        return std::min(getBucketUpperBound(i), m_max);
+                    }
+                }
+                return m_max;
+            }
+
+            uint64_t getMax() const {
+                return m_max;
+            }
+
+            uint64_t getCount() const {
+                return m_count;
+            }
+
+            void reset() {
+                m_buckets.fill(0);
+                m_count = 0;
+                m_max = 0;
+            }
+
+            static uint32_t getBucketIndex(uint64_t value) {
+                if (value < SubBucketCount) {
+                    return static_cast<uint32_t>(value);
+                }
+
+                uint32_t exponent = 0;
+                for (uint64_t v = value; v >>= 1;) {
+                    exponent++;
+                }
+                if (exponent >= MaxExponent) {
+                    return BucketCount - 1;
+                }
+
+                // The top bit is implied, the next bits select the sub-bucket.
+                const uint32_t subBucket =
+                    static_cast<uint32_t>(value >> (exponent - SubBucketBits)) & (SubBucketCount - 1);
+                return (exponent - SubBucketBits + 1) * SubBucketCount + subBucket;
+            }
+
+            static uint64_t getBucketUpperBound(uint32_t index) {
+                if (index < SubBucketCount) {
+                    return index;
+                }
+
+                const uint32_t exponent = index / SubBucketCount + SubBucketBits - 1;
+                const uint64_t subBucket = index % SubBucketCount;
+                const uint64_t width = uint64_t(1) << (exponent - SubBucketBits);
+                return (uint64_t(1) << exponent) + (subBucket + 1) * width - 1;
+            }
+
+          private:
+            std::array<uint32_t, BucketCount> m_buckets{};
+            uint64_t m_count{0};
+            uint64_t m_max{0};
+        };
+
+        // A frame rate limiter, pacing calls to wait() to a target period.
+        struct IFrameLimiter {
+            virtual ~IFrameLimiter() = default;
+
+            // Block until one period past the previous deadline, minus the lead time.
+            virtual void wait(std::chrono::microseconds period, std::chrono::microseconds lead) = 0;
+            virtual void reset() = 0;
+
+            // Wake-up error for the last call to wait() (positive when late).
+            virtual std::chrono::microseconds getLastWakeUpError() const = 0;
+            // Time spent spinning for the last call to wait().
+            virtual std::chrono::microseconds getLastSpinTime() const = 0;
+        };
+
         // [-1,+1] (+up) -> [0..1] (+dn)
         inline constexpr XrVector2f NdcToScreen(XrVector2f v) {
             return {(v.x + 1.f) * 0.5f, (v.y - 1.f) * -0.5f};
@@ -102,99 +200,158 @@ namespace toolkit {
 
     namespace config {
 
-        const std::string SettingFirstRun = "first_run2";
-        const std::string SettingDeveloper = "developer";
-        const std::string SettingReloadShaders = "reload_shaders";
-        const std::string SettingScreenshotEnabled = "enable_screenshot";
-        const std::string SettingScreenshotFileFormat = "screenshot_fileformat";
-        const std::string SettingScreenshotEye = "screenshot_eye";
-        const std::string SettingScreenshotKey = "key_screenshot";
-        const std::string SettingKeyCtrlModifier = "ctrl_modifier";
-        const std::string SettingKeyAltModifier = "alt_modifier";
-        const std::string SettingMenuKeyUp = "key_up";
-        const std::string SettingMenuKeyDown = "key_menu";
-        const std::string SettingMenuKeyLeft = "key_left";
-        const std::string SettingMenuKeyRight = "key_right";
-        const std::string SettingMenuEyeVisibility = "menu_eye";
-        const std::string SettingMenuEyeOffset = "menu_eye_offset";
-        const std::string SettingMenuDistance = "menu_distance";
-        const std::string SettingMenuOpacity = "menu_opacity";
-        const std::string SettingMenuLegacyMode = "menu_legacy_mode";
-        const std::string SettingOverlayType = "overlay";
-        const std::string SettingOverlayShowClock = "overlay_show_clock";
-        const std::string SettingOverlayXOffset = "overlay_x_offset";
-        const std::string SettingOverlayYOffset = "overlay_y_offset";
-        const std::string SettingMenuFontSize = "font_size2";
-        const std::string SettingMenuTimeout = "menu_timeout";
-        const std::string SettingMenuExpert = "expert_menu";
-        const std::string SettingScalingType = "scaling_type";
-        const std::string SettingScaling = "scaling";
-        const std::string SettingAnamorphic = "anamorphic";
-        const std::string SettingSharpness = "sharpness";
-        const std::string SettingMipMapBias = "mipmap_bias";
-        const std::string SettingICD = "world_scale";
-        const std::string SettingFOVType = "fov_type";
-        const std::string SettingFOV = "fov";
-        const std::string SettingFOVUp = "fov_up";
-        const std::string SettingFOVDown = "fov_down";
-        const std::string SettingFOVLeftLeft = "fov_ll";
-        const std::string SettingFOVLeftRight = "fov_lr";
-        const std::string SettingFOVRightLeft = "fov_rl";
-        const std::string SettingFOVRightRight = "fov_rr";
-        const std::string SettingZoom = "zoom";
-        const std::string SettingDisableHAM = "disable_ham";
-        const std::string SettingBlindEye = "blind_eye";
-        const std::string SettingHandTrackingEnabled = "enable_hand_tracking";
-        const std::string SettingHandVisibilityAndSkinTone = "hand_visibility";
-        const std::string SettingHandOcclusion = "hand_occlusion";
-        const std::string SettingHandTimeout = "hand_timeout";
-        const std::string SettingPredictionDampen = "prediction_dampen";
-        const std::string SettingBypassMsftHandInteractionCheck = "allow_msft_hand_interaction";
-        const std::string SettingBypassMsftEyeGazeInteractionCheck = "allow_msft_eye_gaze_interaction";
-        const std::string SettingMotionReprojection = "motion_reprojection";
-        const std::string SettingMotionReprojectionRate = "motion_reprojection_rate";
-        const std::string SettingVRS = "vrs";
-        const std::string SettingVRSQuality = "vrs_quality";
-        const std::string SettingVRSPattern = "vrs_pattern";
-        const std::string SettingVRSOuter = "vrs_outer";
-        const std::string SettingVRSOuterRadius = "vrs_outer_radius";
-        const std::string SettingVRSMiddle = "vrs_middle";
-        const std::string SettingVRSInnerRadius = "vrs_inner_radius";
-        const std::string SettingVRSInner = "vrs_inner";
-        const std::string SettingVRSXOffset = "vrs_x_offset";
-        const std::string SettingVRSXScale = "vrs_x_scale";
-        const std::string SettingVRSYOffset = "vrs_y_offset";
-        const std::string SettingVRSPreferHorizontal = "vrs_prefer_horizontal";
-        const std::string SettingVRSLeftRightBias = "vrs_lr_bias";
-        const std::string SettingVRSScaleFilter = "vrs_scale_filter2";
-        const std::string SettingVRSCullHAM = "vrs_cull_mask";
-        const std::string SettingPostProcess = "post_process";
-        const std::string SettingPostSunGlasses = "post_sunglasses";
-        const std::string SettingPostContrast = "post_contrast";
-        const std::string SettingPostBrightness = "post_brightness";
-        const std::string SettingPostExposure = "post_exposure";
-        const std::string SettingPostSaturation = "post_saturation";
-        const std::string SettingPostVibrance = "post_vibrance";
-        const std::string SettingPostColorGainR = "post_gain_r";
-        const std::string SettingPostColorGainG = "post_gain_g";
-        const std::string SettingPostColorGainB = "post_gain_b";
-        const std::string SettingPostHighlights = "post_highlights";
-        const std::string SettingPostShadows = "post_shadows";
-        const std::string SettingPostChromaticCorrectionR = "post_ca_r";
-        const std::string SettingPostChromaticCorrectionB = "post_ca_b";
-        const std::string SettingEyeTrackingEnabled = "eye_tracking";
-        const std::string SettingEyeProjectionDistance = "eye_projection";
-        const std::string SettingEyeDebug = "eye_debug";
-        const std::string SettingEyeDebugWithController = "eye_controller_debug";
-        const std::string SettingResolutionOverride = "override_resolution";
-        const std::string SettingResolutionHeight = "resolution_height";
-        const std::string SettingDisableInterceptor = "disable_interceptor";
-        const std::string SettingRecordStats = "record_stats";
-        const std::string SettingHighRateStats = "high_rate_stats";
-        const std::string SettingFrameThrottling = "frame_throttle";
-        const std::string SettingTurboMode = "turbo";
-        const std::string SettingTargetFrameRate = "target_rate";
-        const std::string SettingTargetFrameRate2 = "target_rate2";
+        // All the settings known at compile time. Each setting gets a handle (eg: SettingScaling) that can be used to
+        // access its value through a flat table, without any string manipulation.
+#define TOOLKIT_CONFIG_SETTINGS(X)                                                                                     \
+    X(FirstRun, "first_run2")                                                                                          \
+    X(Developer, "developer")                                                                                          \
+    X(ReloadShaders, "reload_shaders")                                                                                 \
+    X(ScreenshotEnabled, "enable_screenshot")                                                                          \
+    X(ScreenshotFileFormat, "screenshot_fileformat")                                                                   \
+    X(ScreenshotEye, "screenshot_eye")                                                                                 \
+    X(ScreenshotKey, "key_screenshot")                                                                                 \
+    X(KeyCtrlModifier, "ctrl_modifier")                                                                                \
+    X(KeyAltModifier, "alt_modifier")                                                                                  \
+    X(MenuKeyUp, "key_up")                                                                                             \
+    X(MenuKeyDown, "key_menu")                                                                                         \
+    X(MenuKeyLeft, "key_left")                                                                                         \
+    X(MenuKeyRight, "key_right")                                                                                       \
+    X(MenuEyeVisibility, "menu_eye")                                                                                   \
+    X(MenuEyeOffset, "menu_eye_offset")                                                                                \
+    X(MenuDistance, "menu_distance")                                                                                   \
+    X(MenuOpacity, "menu_opacity")                                                                                     \
+    X(MenuLegacyMode, "menu_legacy_mode")                                                                              \
+    X(OverlayType, "overlay")                                                                                          \
+    X(OverlayShowClock, "overlay_show_clock")                                                                          \
+    X(OverlayXOffset, "overlay_x_offset")                                                                              \
+    X(OverlayYOffset, "overlay_y_offset")                                                                              \
+    X(MenuFontSize, "font_size2")                                                                                      \
+    X(MenuTimeout, "menu_timeout")                                                                                     \
+    X(MenuExpert, "expert_menu")                                                                                       \
+    X(ScalingType, "scaling_type")                                                                                     \
+    X(Scaling, "scaling")                                                                                              \
+    X(Anamorphic, "anamorphic")                                                                                        \
+    X(Sharpness, "sharpness")                                                                                          \
+    X(MipMapBias, "mipmap_bias")                                                                                       \
+    X(UpscalingFoveated, "upscaling_foveated")                                                                         \
+    X(ICD, "world_scale")                                                                                              \
+    X(FOVType, "fov_type")                                                                                             \
+    X(FOV, "fov")                                                                                                      \
+    X(FOVUp, "fov_up")                                                                                                 \
+    X(FOVDown, "fov_down")                                                                                             \
+    X(FOVLeftLeft, "fov_ll")                                                                                           \
+    X(FOVLeftRight, "fov_lr")                                                                                          \
+    X(FOVRightLeft, "fov_rl")                                                                                          \
+    X(FOVRightRight, "fov_rr")                                                                                         \
+    X(Zoom, "zoom")                                                                                                    \
+    X(DisableHAM, "disable_ham")                                                                                       \
+    X(BlindEye, "blind_eye")                                                                                           \
+    X(HandTrackingEnabled, "enable_hand_tracking")                                                                     \
+    X(HandVisibilityAndSkinTone, "hand_visibility")                                                                    \
+    X(HandOcclusion, "hand_occlusion")                                                                                 \
+    X(HandTimeout, "hand_timeout")                                                                                     \
+    X(PredictionDampen, "prediction_dampen")                                                                           \
+    X(BypassMsftHandInteractionCheck, "allow_msft_hand_interaction")                                                   \
+    X(BypassMsftEyeGazeInteractionCheck, "allow_msft_eye_gaze_interaction")                                            \
+    X(MotionReprojection, "motion_reprojection")                                                                       \
+    X(MotionReprojectionRate, "motion_reprojection_rate")                                                              \
+    X(VRS, "vrs")                                                                                                      \
+    X(VRSQuality, "vrs_quality")                                                                                       \
+    X(VRSPattern, "vrs_pattern")                                                                                       \
+    X(VRSOuter, "vrs_outer")                                                                                           \
+    X(VRSOuterRadius, "vrs_outer_radius")                                                                              \
+    X(VRSMiddle, "vrs_middle")                                                                                         \
+    X(VRSInnerRadius, "vrs_inner_radius")                                                                              \
+    X(VRSInner, "vrs_inner")                                                                                           \
+    X(VRSXOffset, "vrs_x_offset")                                                                                      \
+    X(VRSXScale, "vrs_x_scale")                                                                                        \
+    X(VRSYOffset, "vrs_y_offset")                                                                                      \
+    X(VRSPreferHorizontal, "vrs_prefer_horizontal")                                                                    \
+    X(VRSLeftRightBias, "vrs_lr_bias")                                                                                 \
+    X(VRSScaleFilter, "vrs_scale_filter2")                                                                             \
+    X(VRSCullHAM, "vrs_cull_mask")                                                                                     \
+    X(PostProcess, "post_process")                                                                                     \
+    X(PostSunGlasses, "post_sunglasses")                                                                               \
+    X(PostContrast, "post_contrast")                                                                                   \
+    X(PostBrightness, "post_brightness")                                                                               \
+    X(PostExposure, "post_exposure")                                                                                   \
+    X(PostSaturation, "post_saturation")                                                                               \
+    X(PostVibrance, "post_vibrance")                                                                                   \
+    X(PostColorGainR, "post_gain_r")                                                                                   \
+    X(PostColorGainG, "post_gain_g")                                                                                   \
+    X(PostColorGainB, "post_gain_b")                                                                                   \
+    X(PostHighlights, "post_highlights")                                                                               \
+    X(PostShadows, "post_shadows")                                                                                     \
+    X(PostChromaticCorrectionR, "post_ca_r")                                                                           \
+    X(PostChromaticCorrectionB, "post_ca_b")                                                                           \
+    X(EyeTrackingEnabled, "eye_tracking")                                                                              \
+    X(EyeProjectionDistance, "eye_projection")                                                                         \
+    X(EyeDebug, "eye_debug")                                                                                           \
+    X(EyeDebugWithController, "eye_controller_debug")                                                                  \
+    X(ResolutionOverride, "override_resolution")                                                                       \
+    X(ResolutionHeight, "resolution_height")                                                                           \
+    X(DisableInterceptor, "disable_interceptor")                                                                       \
+    X(RecordStats, "record_stats")                                                                                     \
+    X(HighRateStats, "high_rate_stats")                                                                                \
+    X(FrameThrottling, "frame_throttle")                                                                               \
+    X(TurboMode, "turbo")                                                                                              \
+    X(TargetFrameRate, "target_rate")                                                                                  \
+    X(TargetFrameRate2, "target_rate2")                                                                                \
+    /* Developer settings, not exposed through the menu. */                                                            \
+    X(KeyMenuGen, "key_menu_gen")                                                                                      \
+    X(DisableFrameAnalyzer, "disable_frame_analyzer")                                                                  \
+    X(Canting, "canting")                                                                                              \
+    X(VRSCapture, "vrs_capture")                                                                                       \
+    X(ForceVPRTPath, "force_vprt_path")                                                                                \
+    X(DroolonPort, "droolon_port")                                                                                     \
+    X(AllowCACorrection, "allow_ca_correction")                                                                        \
+    X(Profiler, "profiler")                                                                                            \
+    X(ProfilerKey, "key_profiler")                                                                                     \
+    X(DebugCpuLoad, "debug_cpu_load")                                                                                  \
+    X(DebugGpuLoad, "debug_gpu_load")                                                                                  \
+    X(InflightContexts, "inflight_contexts")                                                                           \
+    X(FusedUpscaling, "fused_upscaling")                                                                               \
+    X(FusedPostProcessBenchmark, "fused_postprocess_benchmark")
+
+        enum class SettingId : uint32_t {
+#define DECLARE_SETTING_ID(id, name) id,
+            TOOLKIT_CONFIG_SETTINGS(DECLARE_SETTING_ID)
+#undef DECLARE_SETTING_ID
+            MaxValue
+        };
+
+        // A handle to a setting from the registry above.
+        struct Setting {
+            SettingId id{SettingId::MaxValue};
+            std::string_view name;
+
+            bool isValid() const {
+                return id != SettingId::MaxValue;
+            }
+
+            // Slow path, for code that needs the name (eg: derived or legacy keys).
+            operator std::string() const {
+                return std::string(name);
+            }
+        };
+
+        constexpr bool operator==(const Setting& a, const Setting& b) {
+            return a.id == b.id;
+        }
+
+        constexpr bool operator!=(const Setting& a, const Setting& b) {
+            return a.id != b.id;
+        }
+
+#define DECLARE_SETTING(id, name) constexpr Setting Setting##id{SettingId::id, name};
+        TOOLKIT_CONFIG_SETTINGS(DECLARE_SETTING)
+#undef DECLARE_SETTING
+
+        // Find the handle for a setting name, if the setting is known at compile time.
+        std::optional<Setting> FindSetting(std::string_view name);
+
+        // Groups of related settings, whose changes can be tracked together.
+        enum class SettingGroup : uint32_t { PostProcess = 0, VRS, FOV, Hands, MaxValue };
 
         enum class OffOnType { Off = 0, On, MaxValue };
         enum class NoYesType { No = 0, Yes, MaxValue };
@@ -222,6 +379,50 @@ namespace toolkit {
         template <typename ConfigEnumType>
         extern std::string_view to_string_view(ConfigEnumType);
 
+        // An immutable copy of the values of all the settings from the registry above, that can be read from any
+        // thread.
+        struct ConfigSnapshot {
+            uint64_t generation{0};
+            std::array<int, to_integral(SettingId::MaxValue)> values{};
+
+            int getValue(Setting setting) const {
+                return values[to_integral(setting.id)];
+            }
+
+            template <typename T, std::enable_if_t<std::is_enum<T>::value, bool> = true>
+            T getEnumValue(Setting setting) const {
+                const auto value = getValue(setting);
+                return static_cast<T>(std::clamp(value, std::underlying_type_t<T>(0), to_integral(T::MaxValue) - 1));
+            }
+        };
+
+        // A backing storage for the configuration values.
+        struct IConfigStore {
+            virtual ~IConfigStore() = default;
+
+            // Load all the values from the backing storage at once. Reads are then served from this snapshot.
+            virtual void reload() = 0;
+            virtual std::optional<int> read(std::string_view name) const = 0;
+
+            // Machine-wide options (safe mode, developer mode...), regardless of the application.
+            virtual std::optional<int> readGlobal(std::string_view name) const = 0;
+
+            // All the values of the application, without the machine-wide ones (to migrate between stores).
+            virtual std::map<std::string, int, std::less<>> readAll() const = 0;
+
+            // Modifications might be deferred until the next flush().
+            virtual void write(std::string_view name, int value) = 0;
+            virtual void remove(std::string_view name) = 0;
+            virtual void removeAll() = 0;
+            virtual void flush() = 0;
+
+            // Invoke a callback when the backing storage is modified by another process.
+            virtual void watch(std::function<void()> onChanged) = 0;
+
+            // Advertise the running application (for the companion app).
+            virtual void setActiveSession(const std::string& appName) = 0;
+        };
+
         struct IConfigManager {
             virtual ~IConfigManager() = default;
 
@@ -231,8 +432,15 @@ namespace toolkit {
 
             virtual void setActiveSession(const std::string& appName) = 0;
 
-            virtual void setDefault(const std::string& name, int value) = 0;
+            // Accessors for settings from the registry. These are the fast path and should be preferred.
+            virtual void setDefault(Setting setting, int value) = 0;
+            virtual int getValue(Setting setting) const = 0;
+            virtual int peekValue(Setting setting) const = 0;
+            virtual void setValue(Setting setting, int value, bool noCommitDelay = false) = 0;
+            virtual bool hasChanged(Setting setting) const = 0;
 
+            // Accessors by name. Names of settings from the registry are forwarded to the accessors above.
+            virtual void setDefault(const std::string& name, int value) = 0;
             virtual int getValue(const std::string& name) const = 0;
             virtual int peekValue(const std::string& name) const = 0;
             virtual void setValue(const std::string& name, int value, bool noCommitDelay = false) = 0;
@@ -246,19 +454,31 @@ namespace toolkit {
             virtual bool isSafeMode() const = 0;
             virtual bool isDeveloper() const = 0;
 
-            template <typename T, std::enable_if_t<std::is_enum<T>::value, bool> = true>
-            void setEnumDefault(const std::string& name, T value) {
+            // Generation counters, incremented whenever a value (or a value within a group) changes. Consumers can
+            // compare against the last generation they observed instead of checking each setting.
+            virtual uint64_t getGeneration() const = 0;
+            virtual uint64_t getGeneration(SettingGroup group) const = 0;
+
+            // Publish a snapshot of the current values. Must be called from the frame thread, once per frame.
+            virtual void publishSnapshot() = 0;
+
+            // Retrieve a copy of the last published snapshot. This is lock-free and can be used from any thread (eg:
+            // from the application's rendering hooks).
+            virtual ConfigSnapshot getSnapshot() const = 0;
+
+            template <typename T, typename Key, std::enable_if_t<std::is_enum<T>::value, bool> = true>
+            void setEnumDefault(const Key& name, T value) {
                 setDefault(name, static_cast<int>(to_integral(value)));
             }
 
-            template <typename T, std::enable_if_t<std::is_enum<T>::value, bool> = true>
-            T getEnumValue(const std::string& name) const {
+            template <typename T, typename Key, std::enable_if_t<std::is_enum<T>::value, bool> = true>
+            T getEnumValue(const Key& name) const {
                 const auto value = getValue(name);
                 return static_cast<T>(std::clamp(value, std::underlying_type_t<T>(0), to_integral(T::MaxValue) - 1));
             }
 
-            template <typename T, std::enable_if_t<std::is_enum<T>::value, bool> = true>
-            T peekEnumValue(const std::string& name) const {
+            template <typename T, typename Key, std::enable_if_t<std::is_enum<T>::value, bool> = true>
+            T peekEnumValue(const Key& name) const {
                 const auto value = peekValue(name);
                 return static_cast<T>(std::clamp(value, std::underlying_type_t<T>(0), to_integral(T::MaxValue) - 1));
             }
@@ -350,6 +570,46 @@ namespace toolkit {
 
         enum class FrameAnalyzerHeuristic { Unknown, ForwardRender, DeferredCopy, Fallback };
 
+        // Usage of the descriptor heaps (D3D12 only).
+        struct DescriptorStatistics {
+            uint32_t numAllocated{0};
+            uint32_t numReserved{0};
+            // Descriptors returned to the free lists. A high count relative to the reserved descriptors indicates
+            // fragmentation.
+            uint32_t numFree{0};
+            uint32_t ringSize{0};
+            uint32_t ringPeakUsage{0};
+            uint32_t numRingStalls{0};
+        };
+
+        // Usage of the constant buffer upload ring.
+        struct ConstantUploadStatistics {
+            uint32_t numUploads{0};
+            // Uploads that were skipped because the content of the buffer did not change.
+            uint32_t numSkippedUploads{0};
+            uint32_t ringSize{0};
+            uint32_t ringPeakUsage{0};
+            uint32_t numRingStalls{0};
+        };
+
+        // Cost of the interception of the application's rendering calls.
+        struct HookStatistics {
+            uint32_t numCalls{0};
+            uint64_t cpuTimeUs{0};
+        };
+
+        // The stages of our processing that are timed on the GPU.
+        enum class GpuStage : uint32_t { App = 0, Upscaling, PostProcessing, Overlay, VRSMask, MaxValue };
+
+        // The xrWaitFrame() loop might cause to have 2 frames in-flight, so the GPU timestamps of a frame are only read
+        // back that many frames later.
+        constexpr uint32_t GpuFrameLatency = 2;
+
+        // The GPU time spent in each stage during one frame.
+        struct GpuStageTimings {
+            uint64_t durationUs[to_integral(GpuStage::MaxValue)]{0};
+        };
+
         struct IDevice;
         struct ITexture;
 
@@ -446,6 +706,10 @@ namespace toolkit {
             }
         };
 
+        // The slice to request for a view of all the slices of a texture array. The views of a texture array requested
+        // without a slice only cover its first slice.
+        constexpr int32_t AllSlices = -2;
+
         // A texture, plain and simple!
         struct ITexture {
             virtual ~ITexture() = default;
@@ -520,12 +784,6 @@ namespace toolkit {
             }
         };
 
-        // A GPU asynchronous timer.
-        struct IGpuTimer : public ITimer {
-            virtual Api getApi() const = 0;
-            virtual std::shared_ptr<IDevice> getDevice() const = 0;
-        };
-
         // A graphics execution context (eg: command list).
         struct IContext {
             virtual ~IContext() = default;
@@ -564,6 +822,13 @@ namespace toolkit {
                                                             uint32_t imageSize = 0,
                                                             const void* initialData = nullptr) = 0;
 
+            // Intermediate textures are shared between all users asking for the same description. They are returned
+            // to the pool at the end of the frame, or earlier with releaseTransientTexture() so that the next user
+            // within the same frame reuses the same texture.
+            virtual std::shared_ptr<ITexture> acquireTransientTexture(const XrSwapchainCreateInfo& info,
+                                                                      std::string_view debugName) = 0;
+            virtual void releaseTransientTexture(const std::shared_ptr<ITexture>& texture) = 0;
+
             virtual std::shared_ptr<IShaderBuffer> createBuffer(size_t size,
                                                                 std::string_view debugName,
                                                                 const void* initialData = nullptr,
@@ -586,7 +851,26 @@ namespace toolkit {
                                                                         const D3D_SHADER_MACRO* defines = nullptr,
                                                                         std::filesystem::path includePath = "") = 0;
 
-            virtual std::shared_ptr<IGpuTimer> createTimer() = 0;
+            // Compile the shader on a worker thread. The shader is only returned through the future.
+            virtual std::shared_future<std::shared_ptr<IQuadShader>>
+            createQuadShaderAsync(const std::filesystem::path& shaderFile,
+                                  const std::string& entryPoint,
+                                  std::string_view debugName,
+                                  const D3D_SHADER_MACRO* defines = nullptr,
+                                  std::filesystem::path includePath = "") = 0;
+
+            virtual std::shared_future<std::shared_ptr<IComputeShader>>
+            createComputeShaderAsync(const std::filesystem::path& shaderFile,
+                                     const std::string& entryPoint,
+                                     std::string_view debugName,
+                                     const std::array<unsigned int, 3>& threadGroups,
+                                     const D3D_SHADER_MACRO* defines = nullptr,
+                                     std::filesystem::path includePath = "") = 0;
+
+            // A stage may be timed several times per frame (eg: once per eye), and its durations are summed. The frame
+            // is closed by flushContext() at the end of the frame.
+            virtual void startGpuStage(GpuStage stage) = 0;
+            virtual void stopGpuStage(GpuStage stage) = 0;
 
             // Must be invoked prior to setting the input/output.
             virtual void setShader(std::shared_ptr<IQuadShader> shader, SamplerType sampler) = 0;
@@ -596,7 +880,12 @@ namespace toolkit {
 
             virtual void setShaderInput(uint32_t slot, std::shared_ptr<ITexture> input, int32_t slice = -1) = 0;
             virtual void setShaderInput(uint32_t slot, std::shared_ptr<IShaderBuffer> input) = 0;
-            virtual void setShaderOutput(uint32_t slot, std::shared_ptr<ITexture> output, int32_t slice = -1) = 0;
+            // For quad shaders, the output may be restricted to a region of the texture. With AllSlices, the quad is
+            // drawn once per slice (see isRenderTargetArrayIndexSupported()).
+            virtual void setShaderOutput(uint32_t slot,
+                                         std::shared_ptr<ITexture> output,
+                                         int32_t slice = -1,
+                                         const XrRect2Di* viewport = nullptr) = 0;
 
             virtual void dispatchShader(bool doNotClear = false) const = 0;
 
@@ -641,9 +930,16 @@ namespace toolkit {
             virtual void flushText() = 0;
 
             virtual void setMipMapBias(config::MipMapBias biasing, float bias = 0.f) = 0;
-            virtual uint32_t getNumBiasedSamplersThisFrame() const = 0;
+            virtual uint32_t getNumBiasedSamplers() const = 0;
+            virtual DescriptorStatistics getDescriptorStatistics() const = 0;
+            virtual ConstantUploadStatistics getConstantUploadStatisticsThisFrame() const = 0;
+            virtual HookStatistics getHookStatisticsThisFrame() const = 0;
+            virtual void setHookStatisticsEnabled(bool enabled) = 0;
+            virtual uint32_t getNumGpuWaitsThisFrame() const = 0;
 
-            virtual void resolveQueries() = 0;
+            // Read back the timings of the frame closed GpuFrameLatency frames ago. Never waits for the GPU: returns
+            // false if the timings are not available (yet).
+            virtual bool resolveQueries(GpuStageTimings& timings) = 0;
 
             virtual void blockCallbacks() = 0;
             virtual void unblockCallbacks() = 0;
@@ -666,6 +962,11 @@ namespace toolkit {
 
             virtual bool isEventsSupported() const = 0;
 
+            // Whether the vertex shader of the quad shaders can select the render target slice, so that a quad shader
+            // can draw all the slices of its output at once. The pixel shader may then read the slice from its
+            // SV_RenderTargetArrayIndex input.
+            virtual bool isRenderTargetArrayIndexSupported() const = 0;
+
             virtual uint32_t getBufferAlignmentConstraint() const = 0;
             virtual uint32_t getTextureAlignmentConstraint() const = 0;
 
@@ -686,6 +987,78 @@ namespace toolkit {
             }
         };
 
+        // The constant buffer of FSR.hlsl, filled with FsrEasuCon() and FsrRcasCon().
+        struct FSRConstants {
+            uint32_t Const0[4];
+            uint32_t Const1[4];
+            uint32_t Const2[4];
+            uint32_t Const3[4];
+            uint32_t Const4[4];
+            uint32_t Const5[4];
+            float Foveation[utilities::ViewCount][4]; // per slice
+            uint32_t OutputFlags[4];
+        };
+
+        // The constant buffer of CAS.hlsl, filled with CasSetup().
+        struct CASConstants {
+            uint32_t Const0[4];
+            uint32_t Const1[4];
+        };
+
+        // The constant buffer of postprocess.hlsl.
+        struct alignas(16) PostProcessConstants {
+            XrVector4f Params1; // Contrast, Brightness, Exposure, Saturation (-1..+1 params)
+            XrVector4f Params2; // ColorGainR, ColorGainG, ColorGainB (-1..+1 params)
+            XrVector4f Params3; // Highlights, Shadows, Vibrance (0..1 params), UseCA (0 = off, 1 = on)
+            XrVector4f Params4; // ChromaticCorrectionR, ChromaticCorrectionG, ChromaticCorrectionB (-1..+1 params)
+                                // Eye (0 = left, 1 = right)
+        };
+
+        // The post-processing of an image, to be applied by the upscaler as part of its last pass.
+        struct FusedPostProcess {
+            PostProcessConstants constants;
+            // Whether the color adjustments are applied, in addition to the color gains.
+            bool isEnabled{false};
+        };
+
+        // Where the images of both eyes are in a texture: each eye in its own slice of a texture array, or side by side in
+        // a double-wide texture. Both images have the same size.
+        struct StereoViews {
+            XrOffset2Di offset[utilities::ViewCount];
+            int32_t slice[utilities::ViewCount];
+            XrExtent2Di extent;
+        };
+
+        // The constant buffer of the stereo permutations of the shaders, indexed by eye.
+        struct StereoConstants {
+            int32_t InputView[utilities::ViewCount][4];  // x, y, slice
+            int32_t OutputView[utilities::ViewCount][4]; // x, y, slice
+            int32_t ViewExtent[4];                       // Input width, height, output width, height
+        };
+
+        inline StereoConstants MakeStereoConstants(const StereoViews& inputViews, const StereoViews& outputViews) {
+            StereoConstants constants{};
+            for (uint32_t eye = 0; eye < utilities::ViewCount; eye++) {
+                constants.InputView[eye][0] = inputViews.offset[eye].x;
+                constants.InputView[eye][1] = inputViews.offset[eye].y;
+                constants.InputView[eye][2] = inputViews.slice[eye];
+                constants.OutputView[eye][0] = outputViews.offset[eye].x;
+                constants.OutputView[eye][1] = outputViews.offset[eye].y;
+                constants.OutputView[eye][2] = outputViews.slice[eye];
+            }
+            constants.ViewExtent[0] = inputViews.extent.width;
+            constants.ViewExtent[1] = inputViews.extent.height;
+            constants.ViewExtent[2] = outputViews.extent.width;
+            constants.ViewExtent[3] = outputViews.extent.height;
+            return constants;
+        }
+
+        // The region of an image to process at full quality, in the terms of the VRS inner ring.
+        struct Foveation {
+            XrVector2f gaze; // ndc
+            XrVector2f ring; // 1/(a^2), 1/(b^2)
+        };
+
         // A texture post-processor.
         struct IImageProcessor {
             virtual ~IImageProcessor() = default;
@@ -697,6 +1070,34 @@ namespace toolkit {
                                  std::vector<std::shared_ptr<ITexture>>& textures,
                                  std::array<uint8_t, 1024>& blob,
                                  std::optional<utilities::Eye> eye = std::nullopt) = 0;
+
+            // For post-processors: describe the processing of an image. Returns false if it cannot be done by the
+            // upscaler (ie: it is not a per-pixel operation).
+            virtual bool getFusedPostProcess(FusedPostProcess& postProcess,
+                                             std::optional<utilities::Eye> eye = std::nullopt) const = 0;
+
+            // For upscalers: like process(), then apply the post-processing before writing to the output (which must
+            // support unordered access). Returns false if not supported, and nothing was processed.
+            virtual bool processFused(std::shared_ptr<ITexture> input,
+                                      std::shared_ptr<ITexture> output,
+                                      std::vector<std::shared_ptr<ITexture>>& textures,
+                                      std::array<uint8_t, 1024>& blob,
+                                      const FusedPostProcess& postProcess,
+                                      std::optional<utilities::Eye> eye = std::nullopt) = 0;
+
+            // For upscalers: restrict the high-quality kernel to the given region for the next images of an eye, or
+            // process the whole images at full quality when not set.
+            virtual void setFoveation(const std::optional<Foveation>& foveation, utilities::Eye eye) = 0;
+
+            // Like process(), for both eyes at once, with the images of both eyes in the same input and output textures.
+            // Only valid when isStereoSupported() returns true.
+            virtual bool isStereoSupported() const = 0;
+            virtual void processStereo(std::shared_ptr<ITexture> input,
+                                       const StereoViews& inputViews,
+                                       std::shared_ptr<ITexture> output,
+                                       const StereoViews& outputViews,
+                                       std::vector<std::shared_ptr<ITexture>>& textures,
+                                       std::array<uint8_t, 1024>& blob) = 0;
         };
 
         struct IFrameAnalyzer {
@@ -744,6 +1145,9 @@ namespace toolkit {
             virtual void updateGazeLocation(XrVector2f gaze, utilities::Eye eye) = 0;
             virtual void setViewProjectionCenters(XrVector2f left, XrVector2f right) = 0;
 
+            // Get the gaze location and the inner ring for an eye. Returns false when VRS is off.
+            virtual bool getFoveation(Foveation& foveation, utilities::Eye eye) const = 0;
+
             virtual uint8_t getMaxRate() const = 0;
 
             virtual uint32_t getActualRenderWidth() const = 0;
@@ -841,6 +1245,35 @@ namespace toolkit {
 
     namespace menu {
 
+        // The timings for which the distribution over each statistics window is reported.
+        enum class TimingStat : uint32_t {
+            AppCpu = 0,
+            RenderCpu,
+            AppGpu,
+            WaitCpu,
+            EndFrameCpu,
+            ScalerGpu,
+            PostProcessorGpu,
+            OverlayCpu,
+            OverlayGpu,
+            HandTrackingCpu,
+            VRSGpu,
+
+            MaxValue
+        };
+
+        inline constexpr std::string_view TimingStatNames[] = {
+            "app CPU", "rdr CPU", "app GPU", "wait", "lay CPU", "scl GPU", "pst GPU", "ovl CPU", "ovl GPU", "hnd CPU",
+            "vrs GPU"};
+        static_assert(std::size(TimingStatNames) == to_integral(TimingStat::MaxValue));
+
+        struct TimingPercentiles {
+            uint64_t p50{0};
+            uint64_t p95{0};
+            uint64_t p99{0};
+            uint64_t max{0};
+        };
+
         struct MenuStatistics {
             uint64_t appCpuTimeUs{0};
             uint64_t renderCpuTimeUs{0};
@@ -851,6 +1284,7 @@ namespace toolkit {
             uint64_t overlayCpuTimeUs{0};
             uint64_t overlayGpuTimeUs{0};
             uint64_t handTrackingCpuTimeUs{0};
+            uint64_t vrsGpuTimeUs{0};
             uint64_t predictionTimeUs{0};
 
             float fps{0.0f};
@@ -866,6 +1300,65 @@ namespace toolkit {
             bool hasDepthBuffer[utilities::ViewCount]{false, false};
             graphics::FrameAnalyzerHeuristic frameAnalyzerHeuristic{graphics::FrameAnalyzerHeuristic::Unknown};
             bool isFramePipeliningDetected{false};
+            uint32_t numTurboStalls{0};
+            uint64_t frameThrottleJitterUs{0};
+            uint64_t frameThrottleMaxJitterUs{0};
+            uint64_t frameThrottleSpinUs{0};
+            graphics::DescriptorStatistics descriptors;
+            graphics::ConstantUploadStatistics constantUploads;
+            graphics::HookStatistics hooks;
+            uint32_t numGpuWaits{0};
+
+            TimingPercentiles timingPercentiles[to_integral(TimingStat::MaxValue)];
+        };
+
+        // A per-frame record of the statistics, as written to the telemetry file. This structure is written as-is, so
+        // any change to its layout must bump TelemetryVersion (and update scripts\convert_telemetry.py).
+        constexpr uint32_t TelemetryVersion = 3;
+        struct FrameRecord {
+            uint64_t frameIndex;
+            int64_t timeUs;
+            XrTime predictedDisplayTime;
+            uint64_t timingsUs[to_integral(TimingStat::MaxValue)];
+            uint64_t predictionTimeUs;
+            int64_t frameThrottleWakeUpErrorUs;
+            uint64_t frameThrottleSpinUs;
+            uint64_t vramUsedSize;
+            float icd;
+            XrFovf fov[utilities::ViewCount];
+            uint32_t numBiasedSamplers;
+            uint32_t numRenderTargetsWithVRS;
+            uint32_t actualRenderWidth;
+            uint32_t numTurboStalls;
+            uint8_t vramUsedPercent;
+            uint8_t frameAnalyzerHeuristic;
+            // Bit 0: frame pipelining detected, bits 1-4: color/depth buffer for left/right eye.
+            uint8_t flags;
+            uint8_t reserved;
+            // Version 3.
+            uint64_t hookCpuTimeUs;
+            uint32_t numHookCalls;
+            uint32_t numGpuWaits;
+            uint32_t numDescriptorsAllocated;
+            uint32_t numDescriptorsReserved;
+            uint32_t numDescriptorsFree;
+            uint32_t descriptorRingSize;
+            uint32_t descriptorRingPeakUsage;
+            uint32_t numDescriptorRingStalls;
+            uint32_t numConstantUploads;
+            uint32_t numSkippedConstantUploads;
+            uint32_t constantRingSize;
+            uint32_t constantRingPeakUsage;
+            uint32_t numConstantRingStalls;
+            uint32_t reserved2;
+        };
+        static_assert(sizeof(FrameRecord) == 264);
+
+        // A recorder for the per-frame statistics.
+        struct ITelemetryRecorder {
+            virtual ~ITelemetryRecorder() = default;
+
+            virtual void record(const FrameRecord& record) = 0;
         };
 
         // A menu handler.
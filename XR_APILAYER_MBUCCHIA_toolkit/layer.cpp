@@ -29,6 +29,7 @@
 #include "interfaces.h"
 #include "layer.h"
 #include "log.h"
+#include "profiler.h"
 
 namespace {
 
@@ -37,15 +38,27 @@ namespace {
     using namespace xr::math;
     using namespace toolkit::math;
 
-    // The xrWaitFrame() loop might cause to have 2 frames in-flight, so we want to delay the GPU timer re-use by those
-    // 2 frames.
-    constexpr uint32_t GpuTimerLatency = 2;
+    // Enough frames for 30 minutes at 120Hz.
+    constexpr uint32_t TelemetryCapacity = 120 * 60 * 30;
+
+    // Gather the timings accumulated in the statistics, in menu::TimingStat order.
+    void GetTimings(const menu::MenuStatistics& stats, uint64_t timings[to_integral(menu::TimingStat::MaxValue)]) {
+        timings[to_integral(menu::TimingStat::AppCpu)] = stats.appCpuTimeUs;
+        timings[to_integral(menu::TimingStat::RenderCpu)] = stats.renderCpuTimeUs;
+        timings[to_integral(menu::TimingStat::AppGpu)] = stats.appGpuTimeUs;
+        timings[to_integral(menu::TimingStat::WaitCpu)] = stats.waitCpuTimeUs;
+        timings[to_integral(menu::TimingStat::EndFrameCpu)] = stats.endFrameCpuTimeUs;
+        timings[to_integral(menu::TimingStat::ScalerGpu)] = stats.processorGpuTimeUs[0];
+        timings[to_integral(menu::TimingStat::PostProcessorGpu)] = stats.processorGpuTimeUs[1];
+        timings[to_integral(menu::TimingStat::OverlayCpu)] = stats.overlayCpuTimeUs;
+        timings[to_integral(menu::TimingStat::OverlayGpu)] = stats.overlayGpuTimeUs;
+        timings[to_integral(menu::TimingStat::HandTrackingCpu)] = stats.handTrackingCpuTimeUs;
+        timings[to_integral(menu::TimingStat::VRSGpu)] = stats.vrsGpuTimeUs;
+    }
 
     struct SwapchainImages {
         std::shared_ptr<graphics::ITexture> appTexture;
         std::shared_ptr<graphics::ITexture> runtimeTexture;
-        std::shared_ptr<graphics::IGpuTimer> upscalingTimers[utilities::ViewCount];
-        std::shared_ptr<graphics::IGpuTimer> postProcessingTimers[utilities::ViewCount];
     };
 
     struct SwapchainState {
@@ -53,11 +66,6 @@ namespace {
         uint32_t acquiredImageIndex{0};
         bool delayedRelease{false};
 
-        // Intermediate textures for processing.
-        std::shared_ptr<graphics::ITexture> nonVPRTInputTexture;
-        std::shared_ptr<graphics::ITexture> nonVPRTOutputTexture;
-        std::shared_ptr<graphics::ITexture> upscaledTexture;
-
         // Intermediate textures than can be used for state in the image processors.
         std::vector<std::shared_ptr<graphics::ITexture>> upscalerTextures;
         std::vector<std::shared_ptr<graphics::ITexture>> postProcessorTextures;
@@ -74,7 +82,7 @@ namespace {
         OpenXrLayer() = default;
 
         void setOptionsDefaults() {
-            m_configManager->setDefault("key_menu_gen", 1);
+            m_configManager->setDefault(config::SettingKeyMenuGen, 1);
             m_configManager->setDefault(config::SettingFirstRun, 0);
             m_configManager->setDefault(config::SettingDeveloper, 0);
 
@@ -122,6 +130,7 @@ namespace {
             m_configManager->setDefault(config::SettingScaling, 100);
             m_configManager->setDefault(config::SettingAnamorphic, -100);
             m_configManager->setDefault(config::SettingSharpness, 20);
+            m_configManager->setDefault(config::SettingUpscalingFoveated, 0);
             // We default mip-map biasing to Off with OpenComposite since it's causing issues with certain apps. Users
             // have the (Expert) option to turn it back on.
             m_configManager->setEnumDefault(config::SettingMipMapBias,
@@ -165,16 +174,16 @@ namespace {
 
             // TODO: Appearance (User)
 #if 0
-            m_configManager->setDefault(config::SettingPostContrast + "_u1", 500);
-            m_configManager->setDefault(config::SettingPostBrightness + "_u1", 500);
-            m_configManager->setDefault(config::SettingPostExposure + "_u1", 500);
-            m_configManager->setDefault(config::SettingPostSaturation + "_u1", 500);
-            m_configManager->setDefault(config::SettingPostColorGainR + "_u1", 500);
-            m_configManager->setDefault(config::SettingPostColorGainG + "_u1", 500);
-            m_configManager->setDefault(config::SettingPostColorGainB + "_u1", 500);
-            m_configManager->setDefault(config::SettingPostVibrance + "_u1", 0);
-            m_configManager->setDefault(config::SettingPostHighlights + "_u1", 1000);
-            m_configManager->setDefault(config::SettingPostShadows + "_u1", 0);
+            m_configManager->setDefault(std::string(config::SettingPostContrast) + "_u1", 500);
+            m_configManager->setDefault(std::string(config::SettingPostBrightness) + "_u1", 500);
+            m_configManager->setDefault(std::string(config::SettingPostExposure) + "_u1", 500);
+            m_configManager->setDefault(std::string(config::SettingPostSaturation) + "_u1", 500);
+            m_configManager->setDefault(std::string(config::SettingPostColorGainR) + "_u1", 500);
+            m_configManager->setDefault(std::string(config::SettingPostColorGainG) + "_u1", 500);
+            m_configManager->setDefault(std::string(config::SettingPostColorGainB) + "_u1", 500);
+            m_configManager->setDefault(std::string(config::SettingPostVibrance) + "_u1", 0);
+            m_configManager->setDefault(std::string(config::SettingPostHighlights) + "_u1", 1000);
+            m_configManager->setDefault(std::string(config::SettingPostShadows) + "_u1", 0);
 #endif
             // Misc features.
             m_configManager->setDefault(config::SettingICD, 1000);
@@ -208,13 +217,18 @@ namespace {
                                                                                                                   : 0);
             // We disable the frame analyzer when using OpenComposite, because the app does not see the OpenXR
             // textures anyways.
-            m_configManager->setDefault("disable_frame_analyzer",
+            m_configManager->setDefault(config::SettingDisableFrameAnalyzer,
                                         m_isOpenComposite || m_applicationName == "DCS World");
-            m_configManager->setDefault("canting", 0);
-            m_configManager->setDefault("vrs_capture", 0);
-            m_configManager->setDefault("force_vprt_path", 0);
-            m_configManager->setDefault("droolon_port", 5347);
-            m_configManager->setDefault("allow_ca_correction", 0);
+            m_configManager->setDefault(config::SettingCanting, 0);
+            m_configManager->setDefault(config::SettingVRSCapture, 0);
+            m_configManager->setDefault(config::SettingForceVPRTPath, 0);
+            m_configManager->setDefault(config::SettingDroolonPort, 5347);
+            m_configManager->setDefault(config::SettingAllowCACorrection, 0);
+            m_configManager->setDefault(config::SettingProfiler, 0);
+            m_configManager->setDefault(config::SettingProfilerKey, VK_F10);
+            m_configManager->setDefault(config::SettingInflightContexts, 8 + 24);
+            m_configManager->setDefault(config::SettingFusedUpscaling, 1);
+            m_configManager->setDefault(config::SettingFusedPostProcessBenchmark, 0);
 
             // Workaround: the first versions of the toolkit used a different representation for the world scale.
             // Migrate the value upon first run.
@@ -228,6 +242,9 @@ namespace {
             // Commit any update above. This is needed for apps that create an instance, destroy it right away
             // without submitting a frame, then create a new one.
             m_configManager->tick();
+
+            // The application's rendering hooks might read the settings before the first frame.
+            m_configManager->publishSnapshot();
         }
 
         XrResult xrCreateInstance(const XrInstanceCreateInfo* createInfo) override {
@@ -306,6 +323,7 @@ namespace {
                 m_keyModifiers.push_back(VK_MENU);
             }
             m_keyScreenshot = m_configManager->getValue(config::SettingScreenshotKey);
+            m_keyProfiler = m_configManager->getValue(config::SettingProfilerKey);
 
             // We must initialize hand and eye tracking early on, because the application can start creating actions etc
             // before creating the session.
@@ -359,7 +377,7 @@ namespace {
                     CHECK_XRCMD(OpenXrApi::xrGetSystemProperties(GetXrInstance(), systemId, &systemProperties));
                     if (std::string(systemProperties.systemName).find("aapvr") != std::string::npos) {
                         aSeeVRInitParam param;
-                        param.ports[0] = m_configManager->getValue("droolon_port");
+                        param.ports[0] = m_configManager->getValue(config::SettingDroolonPort);
                         Log("--> aSeeVR_connect_server(%d)\n", param.ports[0]);
                         const auto code = aSeeVR_connect_server(&param);
                         m_hasPimaxEyeTracker = code == ASEEVR_RETURN_CODE::success;
@@ -403,6 +421,8 @@ namespace {
         }
 
         ~OpenXrLayer() override {
+            stopAsyncWaitThread();
+
             if (m_configManager) {
                 m_configManager->setActiveSession("");
             }
@@ -751,7 +771,7 @@ namespace {
                     m_postProcessor = graphics::CreateImageProcessor(m_configManager, m_graphicsDevice);
 
                     if (m_graphicsDevice->isEventsSupported()) {
-                        if (!m_configManager->getValue("disable_frame_analyzer")) {
+                        if (!m_configManager->getValue(config::SettingDisableFrameAnalyzer)) {
                             graphics::FrameAnalyzerHeuristic heuristic = graphics::FrameAnalyzerHeuristic::Unknown;
 
                             // TODO: Override heuristic per-app if needed.
@@ -831,11 +851,6 @@ namespace {
                     m_performanceCounters.overlayCpuTimer = utilities::CreateCpuTimer();
                     m_performanceCounters.handTrackingTimer = utilities::CreateCpuTimer();
 
-                    for (unsigned int i = 0; i <= GpuTimerLatency; i++) {
-                        m_performanceCounters.appGpuTimer[i] = m_graphicsDevice->createTimer();
-                        m_performanceCounters.overlayGpuTimer[i] = m_graphicsDevice->createTimer();
-                    }
-
                     m_performanceCounters.lastWindowStart = std::chrono::steady_clock::now();
 
                     {
@@ -865,7 +880,7 @@ namespace {
                         // Our HAM override does not seem to work with OpenComposite.
                         menuInfo.isVisibilityMaskOverrideSupported = !m_isOpenComposite && m_hasVisibilityMaskKHR;
                         menuInfo.isCACorrectionNeed = m_configManager->isDeveloper() || m_systemName == "AERO" ||
-                                                      m_configManager->getValue("allow_ca_correction");
+                                                      m_configManager->getValue(config::SettingAllowCACorrection);
                         menuInfo.runtimeName = m_runtimeName;
 
                         m_menuHandler = menu::CreateMenuHandler(m_configManager, m_graphicsDevice, menuInfo);
@@ -923,6 +938,7 @@ namespace {
 
                 // Bump up timer precision for this process.
                 utilities::EnableHighPrecisionTimer();
+                m_frameLimiter = utilities::CreateFrameLimiter();
 
                 if (m_variableRateShader) {
                     m_variableRateShader->beginSession(session);
@@ -960,10 +976,10 @@ namespace {
 
                 // Wait for any pending operation to complete.
                 if (m_graphicsDevice) {
-                    if (m_asyncWaitPromise.valid()) {
-                        m_asyncWaitPromise.wait_for(5s);
-                        m_asyncWaitPromise = {};
+                    if (hasAsyncWait()) {
+                        waitAsyncWait(5s);
                     }
+                    stopAsyncWaitThread();
 
                     m_graphicsDevice->blockCallbacks();
                     m_graphicsDevice->flushContext(true);
@@ -994,10 +1010,6 @@ namespace {
                 m_postProcessor.reset();
                 m_frameAnalyzer.reset();
                 m_variableRateShader.reset();
-                for (unsigned int i = 0; i <= GpuTimerLatency; i++) {
-                    m_performanceCounters.appGpuTimer[i].reset();
-                    m_performanceCounters.overlayGpuTimer[i].reset();
-                }
                 m_performanceCounters.appCpuTimer.reset();
                 m_performanceCounters.renderCpuTimer.reset();
                 m_performanceCounters.waitCpuTimer.reset();
@@ -1087,9 +1099,21 @@ namespace {
 
                 // The post processor will draw a full-screen quad onto the final swapchain.
                 chainCreateInfo.usageFlags |= XR_SWAPCHAIN_USAGE_COLOR_ATTACHMENT_BIT;
+
+                // The fused upscaler writes the final swapchain directly.
+                if (m_upscaleMode == config::ScalingType::FSR &&
+                    m_configManager->getValue(config::SettingFusedUpscaling)) {
+                    chainCreateInfo.usageFlags |= XR_SWAPCHAIN_USAGE_UNORDERED_ACCESS_BIT;
+                }
             }
 
-            const XrResult result = OpenXrApi::xrCreateSwapchain(session, &chainCreateInfo, swapchain);
+            XrResult result = OpenXrApi::xrCreateSwapchain(session, &chainCreateInfo, swapchain);
+            if (XR_FAILED(result) && (chainCreateInfo.usageFlags & ~createInfo->usageFlags &
+                                      XR_SWAPCHAIN_USAGE_UNORDERED_ACCESS_BIT)) {
+                Log("Failed to create swapchain with unordered access, post-processing will not be fused\n");
+                chainCreateInfo.usageFlags &= ~XR_SWAPCHAIN_USAGE_UNORDERED_ACCESS_BIT;
+                result = OpenXrApi::xrCreateSwapchain(session, &chainCreateInfo, swapchain);
+            }
             if (XR_SUCCEEDED(result)) {
                 uint32_t imageCount;
                 CHECK_XRCMD(OpenXrApi::xrEnumerateSwapchainImages(*swapchain, 0, &imageCount, nullptr));
@@ -1123,6 +1147,13 @@ namespace {
 
                         // Make sure to create the app texture typeless.
                         overrideFormat = (int64_t)desc.Format;
+
+                        // A sRGB swapchain can only be written through a UNORM view of a typeless texture.
+                        if (!(desc.BindFlags & D3D11_BIND_UNORDERED_ACCESS) ||
+                            (m_graphicsDevice->isTextureFormatSRGB(chainCreateInfo.format) &&
+                             desc.Format == chainCreateInfo.format)) {
+                            chainCreateInfo.usageFlags &= ~XR_SWAPCHAIN_USAGE_UNORDERED_ACCESS_BIT;
+                        }
                     }
 
                     for (uint32_t i = 0; i < imageCount; i++) {
@@ -1160,6 +1191,13 @@ namespace {
 
                         // Make sure to create the app texture typeless.
                         overrideFormat = (int64_t)desc.Format;
+
+                        // A sRGB swapchain can only be written through a UNORM view of a typeless texture.
+                        if (!(desc.Flags & D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS) ||
+                            (m_graphicsDevice->isTextureFormatSRGB(chainCreateInfo.format) &&
+                             desc.Format == chainCreateInfo.format)) {
+                            chainCreateInfo.usageFlags &= ~XR_SWAPCHAIN_USAGE_UNORDERED_ACCESS_BIT;
+                        }
                     }
 
                     for (uint32_t i = 0; i < imageCount; i++) {
@@ -1199,11 +1237,6 @@ namespace {
 
                         images.appTexture = m_graphicsDevice->createTexture(
                             inputCreateInfo, fmt::format("App swapchain {} TEX2D", i), overrideFormat);
-
-                        for (uint32_t i = 0; i < utilities::ViewCount; i++) {
-                            images.upscalingTimers[i] = m_graphicsDevice->createTimer();
-                            images.postProcessingTimers[i] = m_graphicsDevice->createTimer();
-                        }
                     } else {
                         images.appTexture = images.runtimeTexture;
                     }
@@ -1224,11 +1257,11 @@ namespace {
             {
                 std::unique_lock lock(m_frameLock);
 
-                if (m_asyncWaitPromise.valid()) {
+                if (hasAsyncWait()) {
                     TraceLocalActivity(local);
 
                     TraceLoggingWriteStart(local, "AsyncWaitNow");
-                    m_asyncWaitPromise.wait();
+                    waitAsyncWait();
                     TraceLoggingWriteStop(local, "AsyncWaitNow");
                 }
             }
@@ -1722,7 +1755,7 @@ namespace {
                 }
 
                 // Override the canting angle if requested.
-                const int cantOverride = m_configManager->getValue("canting");
+                const int cantOverride = m_configManager->getValue(config::SettingCanting);
                 if (cantOverride != 0) {
                     const float angle = (float)(cantOverride * (M_PI / 180));
 
@@ -2101,7 +2134,10 @@ namespace {
 
             TraceLoggingWrite(g_traceProvider, "xrWaitFrame", TLPArg(session, "Session"));
 
+            ProfileZone("xrWaitFrame");
+
             const auto lastFrameWaitTimestamp = m_lastFrameWaitTimestamp;
+            bool isThrottled = false;
             if (isVrSession(session)) {
                 if (m_graphicsDevice) {
                     m_performanceCounters.appCpuTimer->stop();
@@ -2109,16 +2145,27 @@ namespace {
                 }
 
                 // Do throttling if needed.
-                if (m_isFrameThrottlingPossible) {
+                if (m_isFrameThrottlingPossible && m_frameLimiter) {
                     const auto frameThrottling = m_configManager->getValue(config::SettingFrameThrottling);
                     if (frameThrottling < config::MaxFrameRate) {
-                        // TODO: Try to reduce latency by slowing slewing to reduce the predictedDisplayTime.
-
-                        const auto target =
-                            m_lastFrameWaitTimestamp +
-                            std::chrono::microseconds(1000000 / frameThrottling + m_frameThrottleSleepOffset) -
-                            500us /* "running start" */;
-                        std::this_thread::sleep_until(target);
+                        ProfileZone("FrameThrottle");
+
+                        // Wake up ahead of the deadline by the lead time ("running start"), so that the runtime's
+                        // xrWaitFrame() absorbs the remainder.
+                        m_frameLimiter->wait(std::chrono::microseconds(1000000 / frameThrottling), m_frameThrottleLead);
+                        isThrottled = true;
+
+                        const auto wakeUpError = m_frameLimiter->getLastWakeUpError().count();
+                        const uint64_t jitter = std::abs(wakeUpError);
+                        m_stats.frameThrottleJitterUs += jitter;
+                        m_stats.frameThrottleMaxJitterUs = std::max(m_stats.frameThrottleMaxJitterUs, jitter);
+                        m_stats.frameThrottleSpinUs += m_frameLimiter->getLastSpinTime().count();
+                        TraceLoggingWrite(g_traceProvider,
+                                          "FrameThrottle",
+                                          TLArg(wakeUpError, "WakeUpErrorUs"),
+                                          TLArg(m_frameThrottleLead.count(), "LeadUs"));
+                    } else {
+                        m_frameLimiter->reset();
                     }
                 }
                 m_lastFrameWaitTimestamp = std::chrono::steady_clock::now();
@@ -2129,16 +2176,17 @@ namespace {
             std::unique_lock lock(m_frameLock);
 
             XrResult result = XR_ERROR_RUNTIME_FAILURE;
-            if (isVrSession(session) && m_asyncWaitPromise.valid()) {
+            if (isVrSession(session) && hasAsyncWait()) {
                 TraceLoggingWrite(g_traceProvider, "AsyncWaitMode");
 
-                // In Turbo mode, we accept pipelining of exactly one frame.
+                // In Turbo mode, we accept pipelining of exactly one frame. The runtime blocks any xrWaitFrame()
+                // until the xrBeginFrame() of the previous one, so the wait thread cannot run further ahead.
                 if (m_asyncWaitPolled) {
                     TraceLocalActivity(local);
 
                     // On second frame poll, we must wait.
                     TraceLoggingWriteStart(local, "AsyncWaitNow");
-                    m_asyncWaitPromise.wait();
+                    waitAsyncWait();
                     TraceLoggingWriteStop(local, "AsyncWaitNow");
                 }
                 m_asyncWaitPolled = true;
@@ -2146,7 +2194,7 @@ namespace {
                 // In Turbo mode, we don't actually wait, we make up a predicted time.
                 std::unique_lock lock(m_asyncWaitLock);
                 frameState->predictedDisplayTime =
-                    m_asyncWaitCompleted
+                    m_asyncWaitCompleted == m_asyncWaitRequested
                         ? m_lastPredictedDisplayTime
                         : (m_lastPredictedDisplayTime + (m_lastFrameWaitTimestamp - lastFrameWaitTimestamp).count());
                 frameState->predictedDisplayPeriod = m_lastPredictedDisplayPeriod;
@@ -2161,6 +2209,18 @@ namespace {
                     // We must always store those values to properly handle transitions into Turbo Mode.
                     m_lastPredictedDisplayTime = frameState->predictedDisplayTime;
                     m_lastPredictedDisplayPeriod = frameState->predictedDisplayPeriod;
+
+                    // Reduce latency by slowly slewing the lead time, thus reducing the predictedDisplayTime relative
+                    // to when the application starts its frame. We aim for the runtime to still block us for a short
+                    // time, and we back off quickly when it no longer does (meaning we woke up too late).
+                    if (isThrottled) {
+                        const auto runtimeWait = std::chrono::steady_clock::now() - m_lastFrameWaitTimestamp;
+                        if (runtimeWait > 1ms) {
+                            m_frameThrottleLead = std::max(m_frameThrottleLead - 20us, 0us);
+                        } else if (runtimeWait < 200us) {
+                            m_frameThrottleLead = std::min(m_frameThrottleLead + 200us, 2000us);
+                        }
+                    }
                 }
             }
             if (XR_SUCCEEDED(result) && isVrSession(session)) {
@@ -2234,7 +2294,7 @@ namespace {
             }
 
             XrResult result = XR_ERROR_RUNTIME_FAILURE;
-            if (isVrSession(session) && m_asyncWaitPromise.valid()) {
+            if (isVrSession(session) && hasAsyncWait()) {
                 // In turbo mode, we do nothing here.
                 TraceLoggingWrite(g_traceProvider, "AsyncWaitMode");
                 result = XR_SUCCESS;
@@ -2249,9 +2309,7 @@ namespace {
 
                 if (m_graphicsDevice) {
                     m_performanceCounters.renderCpuTimer->start();
-                    m_stats.appGpuTimeUs +=
-                        m_performanceCounters.appGpuTimer[m_performanceCounters.gpuTimerIndex]->query();
-                    m_performanceCounters.appGpuTimer[m_performanceCounters.gpuTimerIndex]->start();
+                    m_graphicsDevice->startGpuStage(graphics::GpuStage::App);
 
                     // With D3D12, we want to make sure the query is enqueued now.
                     if (m_graphicsDevice->getApi() == graphics::Api::D3D12) {
@@ -2306,13 +2364,23 @@ namespace {
             const auto numFrames = ++m_performanceCounters.numFrames;
 
             if (m_graphicsDevice) {
-                m_stats.numBiasedSamplers = m_graphicsDevice->getNumBiasedSamplersThisFrame();
+                m_stats.numBiasedSamplers = m_graphicsDevice->getNumBiasedSamplers();
+                m_stats.descriptors = m_graphicsDevice->getDescriptorStatistics();
+                m_stats.constantUploads = m_graphicsDevice->getConstantUploadStatisticsThisFrame();
+                m_stats.hooks = m_graphicsDevice->getHookStatisticsThisFrame();
+                // Timing the hooks is not free, only do it when the statistics are displayed or recorded.
+                m_graphicsDevice->setHookStatisticsEnabled(
+                    m_telemetry || m_configManager->getEnumValue<config::OverlayType>(config::SettingOverlayType) ==
+                                       config::OverlayType::Developer);
+                m_stats.numGpuWaits = m_graphicsDevice->getNumGpuWaitsThisFrame();
             }
 
             if (m_variableRateShader) {
                 m_stats.actualRenderWidth = m_variableRateShader->getActualRenderWidth();
             }
 
+            m_stats.numTurboStalls += m_asyncWaitStalls.exchange(0, std::memory_order_relaxed);
+
             if (m_frameAnalyzer) {
                 m_stats.frameAnalyzerHeuristic = m_frameAnalyzer->getCurrentHeuristic();
             }
@@ -2326,12 +2394,82 @@ namespace {
                     m_logStats.open(logFile, std::ios_base::ate);
 
                     // Write headers.
-                    m_logStats << "time,FPS,appCPU (us),renderCPU (us),appGPU (us),VRAM (MB),VRAM (%)\n";
+                    m_logStats << "time,FPS,appCPU (us),renderCPU (us),appGPU (us),VRAM (MB),VRAM (%)";
+                    for (const auto& name : menu::TimingStatNames) {
+                        m_logStats << "," << name << " p50 (us)," << name << " p95 (us)," << name << " p99 (us),"
+                                   << name << " max (us)";
+                    }
+                    m_logStats << "\n";
+
+                    // The per-frame records go to a binary file, see scripts\convert_telemetry.py.
+                    m_telemetry = menu::CreateTelemetryRecorder(localAppData / "stats" / (std::string(buf) + ".bin"),
+                                                                TelemetryCapacity);
+                    m_performanceCounters.telemetryStart = std::chrono::steady_clock::now();
+                    m_performanceCounters.telemetryFrameIndex = 0;
                 } else {
                     m_logStats.close();
+                    m_telemetry.reset();
                 }
             }
 
+            // The statistics only hold sums over the window, so we use the amount accumulated since the previous
+            // frame.
+            const auto& lastStats = m_performanceCounters.lastFrameStats;
+            uint64_t timings[to_integral(menu::TimingStat::MaxValue)];
+            GetTimings(m_stats, timings);
+            {
+                uint64_t lastTimings[to_integral(menu::TimingStat::MaxValue)];
+                GetTimings(lastStats, lastTimings);
+                for (uint32_t i = 0; i < std::size(timings); i++) {
+                    timings[i] -= lastTimings[i];
+                    m_performanceCounters.timingHistograms[i].record(timings[i]);
+                }
+            }
+
+            if (m_telemetry) {
+                menu::FrameRecord record{};
+                record.frameIndex = m_performanceCounters.telemetryFrameIndex++;
+                record.timeUs = std::chrono::duration_cast<std::chrono::microseconds>(
+                                    now - m_performanceCounters.telemetryStart)
+                                    .count();
+                record.predictedDisplayTime = m_waitedFrameTime;
+                std::copy(std::begin(timings), std::end(timings), record.timingsUs);
+                record.predictionTimeUs = m_stats.predictionTimeUs - lastStats.predictionTimeUs;
+                if (m_frameLimiter) {
+                    record.frameThrottleWakeUpErrorUs = m_frameLimiter->getLastWakeUpError().count();
+                    record.frameThrottleSpinUs = m_frameLimiter->getLastSpinTime().count();
+                }
+                record.vramUsedSize = m_performanceCounters.lastVramUsedSize;
+                record.icd = m_stats.icd;
+                record.fov[0] = m_stats.fov[0];
+                record.fov[1] = m_stats.fov[1];
+                record.numBiasedSamplers = m_stats.numBiasedSamplers;
+                record.numRenderTargetsWithVRS = m_stats.numRenderTargetsWithVRS - lastStats.numRenderTargetsWithVRS;
+                record.actualRenderWidth = m_stats.actualRenderWidth;
+                record.numTurboStalls = m_stats.numTurboStalls - lastStats.numTurboStalls;
+                record.vramUsedPercent = m_performanceCounters.lastVramUsedPercent;
+                record.frameAnalyzerHeuristic = static_cast<uint8_t>(m_stats.frameAnalyzerHeuristic);
+                record.flags = (m_stats.isFramePipeliningDetected ? 1 : 0) | (m_stats.hasColorBuffer[0] ? 2 : 0) |
+                               (m_stats.hasDepthBuffer[0] ? 4 : 0) | (m_stats.hasColorBuffer[1] ? 8 : 0) |
+                               (m_stats.hasDepthBuffer[1] ? 16 : 0);
+                record.hookCpuTimeUs = m_stats.hooks.cpuTimeUs;
+                record.numHookCalls = m_stats.hooks.numCalls;
+                record.numGpuWaits = m_stats.numGpuWaits;
+                record.numDescriptorsAllocated = m_stats.descriptors.numAllocated;
+                record.numDescriptorsReserved = m_stats.descriptors.numReserved;
+                record.numDescriptorsFree = m_stats.descriptors.numFree;
+                record.descriptorRingSize = m_stats.descriptors.ringSize;
+                record.descriptorRingPeakUsage = m_stats.descriptors.ringPeakUsage;
+                record.numDescriptorRingStalls = m_stats.descriptors.numRingStalls;
+                record.numConstantUploads = m_stats.constantUploads.numUploads;
+                record.numSkippedConstantUploads = m_stats.constantUploads.numSkippedUploads;
+                record.constantRingSize = m_stats.constantUploads.ringSize;
+                record.constantRingPeakUsage = m_stats.constantUploads.ringPeakUsage;
+                record.numConstantRingStalls = m_stats.constantUploads.numRingStalls;
+                m_telemetry->record(record);
+            }
+            m_performanceCounters.lastFrameStats = m_stats;
+
             const bool highRate = m_configManager->getValue(config::SettingHighRateStats);
             if ((now - m_performanceCounters.lastWindowStart) >= (highRate ? 100ms : 1s)) {
                 const auto duration = now - m_performanceCounters.lastWindowStart;
@@ -2352,7 +2490,18 @@ namespace {
                 m_stats.overlayCpuTimeUs /= numFrames;
                 m_stats.overlayGpuTimeUs /= numFrames;
                 m_stats.handTrackingCpuTimeUs /= numFrames;
+                m_stats.vrsGpuTimeUs /= numFrames;
                 m_stats.predictionTimeUs /= numFrames;
+                m_stats.frameThrottleJitterUs /= numFrames;
+                m_stats.frameThrottleSpinUs /= numFrames;
+                for (uint32_t i = 0; i < to_integral(menu::TimingStat::MaxValue); i++) {
+                    auto& histogram = m_performanceCounters.timingHistograms[i];
+                    m_stats.timingPercentiles[i] = {histogram.getPercentile(50),
+                                                    histogram.getPercentile(95),
+                                                    histogram.getPercentile(99),
+                                                    histogram.getMax()};
+                    histogram.reset();
+                }
                 if (highRate) {
                     // We must still do a rolling average for the FPS otherwise the values are all over the place.
                     m_performanceCounters.frameRates.push_front(std::make_pair(duration, numFrames));
@@ -2373,6 +2522,8 @@ namespace {
                 }
 
                 m_graphicsDevice->getVRAMUsage(m_stats.vramUsedSize, m_stats.vramUsedPercent);
+                m_performanceCounters.lastVramUsedSize = m_stats.vramUsedSize;
+                m_performanceCounters.lastVramUsedPercent = m_stats.vramUsedPercent;
 
                 // When CPU-bound, do not bother giving a (false) GPU time for D3D12
                 if (m_graphicsDevice->getApi() == graphics::Api::D3D12 &&
@@ -2380,6 +2531,8 @@ namespace {
                     m_stats.appGpuTimeUs = 0;
                 }
 
+                TraceLoggingWrite(g_traceProvider, "Statistics", TLArg(m_stats.numTurboStalls, "TurboStalls"));
+
                 if (m_menuHandler) {
                     m_menuHandler->updateStatistics(m_stats);
                 }
@@ -2391,12 +2544,38 @@ namespace {
                     size_t offset = std::strftime(buf, sizeof(buf), "%Y-%m-%d %H:%M:%S %z", std::localtime(&now));
                     m_logStats << buf << "," << std::fixed << std::setprecision(1) << m_stats.fps << ","
                                << m_stats.appCpuTimeUs << "," << m_stats.renderCpuTimeUs << "," << m_stats.appGpuTimeUs
-                               << "," << m_stats.vramUsedSize / (1024 * 1024) << "," << (int)m_stats.vramUsedPercent
-                               << "\n";
+                               << "," << m_stats.vramUsedSize / (1024 * 1024) << "," << (int)m_stats.vramUsedPercent;
+                    for (const auto& percentiles : m_stats.timingPercentiles) {
+                        m_logStats << "," << percentiles.p50 << "," << percentiles.p95 << "," << percentiles.p99 << ","
+                                   << percentiles.max;
+                    }
+                    m_logStats << "\n";
+                }
+
+                // Compare the GPU time of the upscaling and post-processing when fused and when in separate passes,
+                // by alternating between the two with each window. The GPU timings lag GpuFrameLatency frames behind,
+                // which is negligible over a window.
+                if (m_configManager->getValue(config::SettingFusedPostProcessBenchmark)) {
+                    auto& counters = m_performanceCounters;
+                    const size_t mode = counters.benchmarkSeparatePostProcess ? 1 : 0;
+                    counters.benchmarkGpuTimeUs[mode] += m_stats.processorGpuTimeUs[0] + m_stats.processorGpuTimeUs[1];
+                    counters.benchmarkWindows[mode]++;
+                    counters.benchmarkSeparatePostProcess = !counters.benchmarkSeparatePostProcess;
+
+                    if (counters.benchmarkWindows[1] == 10) {
+                        Log("Upscaling and post-processing GPU time: fused %lluus, separate %lluus\n",
+                            counters.benchmarkGpuTimeUs[0] / counters.benchmarkWindows[0],
+                            counters.benchmarkGpuTimeUs[1] / counters.benchmarkWindows[1]);
+                        counters.benchmarkWindows[0] = counters.benchmarkWindows[1] = 0;
+                        counters.benchmarkGpuTimeUs[0] = counters.benchmarkGpuTimeUs[1] = 0;
+                    }
+                } else {
+                    m_performanceCounters.benchmarkSeparatePostProcess = false;
                 }
 
                 // Start from fresh!
                 memset(&m_stats, 0, sizeof(m_stats));
+                memset(&m_performanceCounters.lastFrameStats, 0, sizeof(m_performanceCounters.lastFrameStats));
             }
 
             if (m_handTracker && m_menuHandler) {
@@ -2484,6 +2663,9 @@ namespace {
             if (m_variableRateShader) {
                 m_variableRateShader->update();
             }
+
+            // Make the values visible to the application's rendering threads.
+            m_configManager->publishSnapshot();
         }
 
         void takeScreenshot(std::shared_ptr<graphics::ITexture> texture,
@@ -2532,6 +2714,7 @@ namespace {
             path.replace_extension(fileExtension);
 
             // Handle VPRT.
+            std::shared_ptr<graphics::ITexture> cropped;
             auto info = texture->getInfo();
             if (info.arraySize > 1 || viewport.offset.x || viewport.offset.y || info.width != viewport.extent.width ||
                 info.height != viewport.extent.height) {
@@ -2539,12 +2722,32 @@ namespace {
                 info.arraySize = 1;
                 info.width = viewport.extent.width;
                 info.height = viewport.extent.height;
-                auto cropped = m_graphicsDevice->createTexture(info, "Screenshot");
+                cropped = m_graphicsDevice->acquireTransientTexture(info, "Screenshot");
                 texture->copyTo(viewport.offset.x, viewport.offset.y, srcSlice, cropped);
                 texture = cropped;
             }
 
             texture->saveToFile(path);
+
+            if (cropped) {
+                m_graphicsDevice->releaseTransientTexture(cropped);
+            }
+        }
+
+        void exportProfilerTrace() {
+            const std::time_t now = std::time(nullptr);
+            char buf[1024];
+            std::strftime(buf, sizeof(buf), "_%Y%m%d_%H%M%S.json", std::localtime(&now));
+
+            // Using std::filesystem automatically filters out unwanted app name chars.
+            std::string sanitizedName = m_applicationName;
+            std::replace(sanitizedName.begin(), sanitizedName.end(), '.', '_');
+            const auto path = localAppData / "traces" / (sanitizedName + buf);
+            if (profiler::ExportChromeTrace(path)) {
+                Log("Profiler trace saved to '%s'\n", path.string().c_str());
+            } else {
+                Log("Failed to save profiler trace to '%s'\n", path.string().c_str());
+            }
         }
 
         XrResult xrEndFrame(XrSession session, const XrFrameEndInfo* frameEndInfo) override {
@@ -2562,6 +2765,8 @@ namespace {
                 return OpenXrApi::xrEndFrame(session, frameEndInfo);
             }
 
+            ProfileZone("xrEndFrame");
+
             std::unique_lock lock(m_frameLock);
 
             m_isInFrame = false;
@@ -2570,15 +2775,11 @@ namespace {
 
             m_performanceCounters.renderCpuTimer->stop();
             m_stats.renderCpuTimeUs += m_performanceCounters.renderCpuTimer->query();
-            m_performanceCounters.appGpuTimer[m_performanceCounters.gpuTimerIndex]->stop();
+            m_graphicsDevice->stopGpuStage(graphics::GpuStage::App);
 
             m_stats.endFrameCpuTimeUs += m_performanceCounters.endFrameCpuTimer->query();
             m_performanceCounters.endFrameCpuTimer->start();
 
-            // Toggle to the next set of GPU timers.
-            m_performanceCounters.gpuTimerIndex = (m_performanceCounters.gpuTimerIndex + 1) % (GpuTimerLatency + 1);
-            m_graphicsDevice->resolveQueries();
-
             if (m_frameAnalyzer) {
                 m_frameAnalyzer->prepareForEndFrame();
             }
@@ -2635,6 +2836,8 @@ namespace {
 
             // Apply the processing chain to all the (supported) layers.
             for (uint32_t i = 0; i < chainFrameEndInfo.layerCount; i++) {
+                ProfileZone("ProcessLayer");
+
                 if (chainFrameEndInfo.layers[i]->type == XR_TYPE_COMPOSITION_LAYER_PROJECTION) {
                     const XrCompositionLayerProjection* proj =
                         reinterpret_cast<const XrCompositionLayerProjection*>(chainFrameEndInfo.layers[i]);
@@ -2668,6 +2871,70 @@ namespace {
                             m_stats.hasColorBuffer[(int)utilities::Eye::Right] = true;
                     }
 
+                    const bool isUpscaling = m_upscaleMode == config::ScalingType::NIS ||
+                                             m_upscaleMode == config::ScalingType::FSR ||
+                                             m_upscaleMode == config::ScalingType::CAS;
+                    float horizontalScaleFactor = 1.f;
+                    float verticalScaleFactor = 1.f;
+                    if (isUpscaling) {
+                        std::tie(horizontalScaleFactor, verticalScaleFactor) =
+                            config::GetScalingFactors(m_settingScaling, m_settingAnamorphic);
+                    }
+
+                    // When both eyes have the same size, either in their own slices of a texture array or side by
+                    // side in a double-wide texture, and all the processors support it, both eyes are processed at once
+                    // (with the left eye). Other layouts use the per-eye path.
+                    bool isStereo = false;
+                    graphics::StereoViews inputViews{};
+                    graphics::StereoViews outputViews{};
+                    if ((useTextureArrays || useDoubleWide) &&
+                        !m_configManager->getValue(config::SettingForceVPRTPath) &&
+                        m_postProcessor->isStereoSupported() && (!m_upscaler || m_upscaler->isStereoSupported())) {
+                        auto swapchainIt = m_swapchains.find(proj->views[0].subImage.swapchain);
+                        if (swapchainIt != m_swapchains.end()) {
+                            const auto& swapchainState = swapchainIt->second;
+                            const auto& runtimeInfo =
+                                swapchainState.images[swapchainState.acquiredImageIndex].runtimeTexture->getInfo();
+
+                            const auto& left = proj->views[0].subImage;
+                            const auto& right = proj->views[1].subImage;
+                            inputViews.extent = left.imageRect.extent;
+                            outputViews.extent = left.imageRect.extent;
+                            if (isUpscaling) {
+                                outputViews.extent.width = roundUp(
+                                    (uint32_t)std::ceil(inputViews.extent.width * horizontalScaleFactor), 2);
+                                outputViews.extent.height = roundUp(
+                                    (uint32_t)std::ceil(inputViews.extent.height * verticalScaleFactor), 2);
+                            }
+
+                            // The regions of the eyes must not overlap, in the input and the output.
+                            isStereo = left.imageRect.extent.width == right.imageRect.extent.width &&
+                                       left.imageRect.extent.height == right.imageRect.extent.height &&
+                                       (left.imageArrayIndex != right.imageArrayIndex ||
+                                        std::abs(left.imageRect.offset.x - right.imageRect.offset.x) >=
+                                            left.imageRect.extent.width ||
+                                        std::abs(left.imageRect.offset.y - right.imageRect.offset.y) >=
+                                            left.imageRect.extent.height);
+                            for (uint32_t eye = 0; eye < utilities::ViewCount; eye++) {
+                                const auto& subImage = proj->views[eye].subImage;
+                                inputViews.offset[eye] = subImage.imageRect.offset;
+                                inputViews.slice[eye] = subImage.imageArrayIndex;
+                                outputViews.offset[eye].x =
+                                    (int32_t)std::ceil(subImage.imageRect.offset.x * horizontalScaleFactor);
+                                outputViews.offset[eye].y =
+                                    (int32_t)std::ceil(subImage.imageRect.offset.y * verticalScaleFactor);
+                                outputViews.slice[eye] = subImage.imageArrayIndex;
+
+                                // Unlike the per-eye path, the output is not cropped to fit in the swapchain.
+                                isStereo = isStereo &&
+                                           outputViews.offset[eye].x + outputViews.extent.width <=
+                                               (int32_t)runtimeInfo.width &&
+                                           outputViews.offset[eye].y + outputViews.extent.height <=
+                                               (int32_t)runtimeInfo.height;
+                            }
+                        }
+                    }
+
                     assert(proj->viewCount == utilities::ViewCount);
                     for (uint32_t eye = 0; eye < utilities::ViewCount; eye++) {
                         const XrCompositionLayerProjectionView& view = proj->views[eye];
@@ -2744,43 +3011,46 @@ namespace {
                             swapchainState.registeredWithFrameAnalyzer = true;
                         }
 
-                        // Detect whether the input uses a viewport (VP) or a texture array render target (RT)
+                        // Detect whether the input uses a viewport (VP) or a texture array render target (RT).
                         const bool isVPRT =
-                            view.subImage.imageArrayIndex > 0 || view.subImage.imageRect.offset.x ||
-                            view.subImage.imageRect.offset.y ||
-                            view.subImage.imageRect.extent.width != swapchainImages.appTexture->getInfo().width ||
-                            view.subImage.imageRect.extent.height != swapchainImages.appTexture->getInfo().height ||
-                            m_configManager->getValue("force_vprt_path");
+                            !isStereo &&
+                            (view.subImage.imageArrayIndex > 0 || view.subImage.imageRect.offset.x ||
+                             view.subImage.imageRect.offset.y ||
+                             view.subImage.imageRect.extent.width != swapchainImages.appTexture->getInfo().width ||
+                             view.subImage.imageRect.extent.height != swapchainImages.appTexture->getInfo().height ||
+                             m_configManager->getValue(config::SettingForceVPRTPath));
+
+                        // In stereo, both eyes were processed with the left eye.
+                        const bool isProcessed = isStereo && eye != 0;
 
                         std::shared_ptr<graphics::ITexture> nextInput = swapchainImages.appTexture;
                         std::shared_ptr<graphics::ITexture> finalOutput = swapchainImages.runtimeTexture;
 
-                        float horizontalScaleFactor = 1.f;
-                        float verticalScaleFactor = 1.f;
                         uint32_t scaledOutputWidth = view.subImage.imageRect.extent.width;
                         uint32_t scaledOutputHeight = view.subImage.imageRect.extent.height;
-                        if (m_upscaleMode == config::ScalingType::NIS 
-                            || m_upscaleMode == config::ScalingType::FSR
-                            || m_upscaleMode == config::ScalingType::CAS
-                        ) {
-                            std::tie(horizontalScaleFactor, verticalScaleFactor) =
-                                config::GetScalingFactors(m_settingScaling, m_settingAnamorphic);
+                        if (isStereo) {
+                            scaledOutputWidth = outputViews.extent.width;
+                            scaledOutputHeight = outputViews.extent.height;
 
+                            // Patch the top-left corner offset.
+                            correctedProjectionViews[eye].subImage.imageRect.offset = outputViews.offset[eye];
+                        } else if (isUpscaling) {
                             scaledOutputWidth = roundUp(
                                 (uint32_t)std::ceil(view.subImage.imageRect.extent.width * horizontalScaleFactor), 2);
                             scaledOutputHeight = roundUp(
                                 (uint32_t)std::ceil(view.subImage.imageRect.extent.height * verticalScaleFactor), 2);
                         }
 
+                        // The intermediate textures come from the device's pool, and they are returned to it once
+                        // this view is processed, so that the other views and swapchains can reuse them.
+                        std::vector<std::shared_ptr<graphics::ITexture>> transientTextures;
+
                         // Copy the VPRT app input into an intermediate buffer if needed.
                         // TODO: This is a naive solution to uniformely support the same time of input/output for all
                         // upscalers and post-processor.
                         if (isVPRT) {
-                            if (!swapchainState.nonVPRTInputTexture ||
-                                view.subImage.imageRect.extent.width !=
-                                    swapchainState.nonVPRTInputTexture->getInfo().width ||
-                                view.subImage.imageRect.extent.height !=
-                                    swapchainState.nonVPRTInputTexture->getInfo().height) {
+                            std::shared_ptr<graphics::ITexture> nonVPRTInputTexture;
+                            {
                                 auto createInfo = swapchainImages.appTexture->getInfo();
 
                                 // Single-surface, full (input) screen.
@@ -2794,15 +3064,13 @@ namespace {
                                 createInfo.usageFlags =
                                     XR_SWAPCHAIN_USAGE_TRANSFER_DST_BIT | XR_SWAPCHAIN_USAGE_SAMPLED_BIT;
 
-                                swapchainState.nonVPRTInputTexture =
-                                    m_graphicsDevice->createTexture(createInfo, "Non-VPRT Input TEX2D");
+                                nonVPRTInputTexture =
+                                    m_graphicsDevice->acquireTransientTexture(createInfo, "Non-VPRT Input TEX2D");
+                                transientTextures.push_back(nonVPRTInputTexture);
                             }
 
                             // Patch the top-left corner offset.
-                            if (m_upscaleMode == config::ScalingType::NIS ||
-                                m_upscaleMode == config::ScalingType::FSR ||
-                                m_upscaleMode == config::ScalingType::CAS    
-                            ) {
+                            if (isUpscaling) {
                                 correctedProjectionViews[eye].subImage.imageRect.offset.x = (uint32_t)std::ceil(
                                     correctedProjectionViews[eye].subImage.imageRect.offset.x * horizontalScaleFactor);
                                 correctedProjectionViews[eye].subImage.imageRect.offset.y = (uint32_t)std::ceil(
@@ -2821,9 +3089,8 @@ namespace {
                                                      correctedProjectionViews[eye].subImage.imageRect.offset.y;
                             }
 
-                            if (!swapchainState.nonVPRTOutputTexture ||
-                                scaledOutputWidth != swapchainState.nonVPRTOutputTexture->getInfo().width ||
-                                scaledOutputHeight != swapchainState.nonVPRTOutputTexture->getInfo().height) {
+                            std::shared_ptr<graphics::ITexture> nonVPRTOutputTexture;
+                            {
                                 auto createInfo = swapchainImages.appTexture->getInfo();
 
                                 // Single-surface, full (output) screen.
@@ -2838,71 +3105,121 @@ namespace {
                                                         XR_SWAPCHAIN_USAGE_SAMPLED_BIT |
                                                         XR_SWAPCHAIN_USAGE_COLOR_ATTACHMENT_BIT;
 
-                                swapchainState.nonVPRTOutputTexture =
-                                    m_graphicsDevice->createTexture(createInfo, "Non-VPRT Output TEX2D");
+                                nonVPRTOutputTexture =
+                                    m_graphicsDevice->acquireTransientTexture(createInfo, "Non-VPRT Output TEX2D");
+                                transientTextures.push_back(nonVPRTOutputTexture);
                             }
 
                             swapchainImages.appTexture->copyTo(view.subImage.imageRect.offset.x,
                                                                view.subImage.imageRect.offset.y,
                                                                view.subImage.imageArrayIndex,
-                                                               swapchainState.nonVPRTInputTexture);
+                                                               nonVPRTInputTexture);
 
-                            nextInput = swapchainState.nonVPRTInputTexture;
-                            finalOutput = swapchainState.nonVPRTOutputTexture;
+                            nextInput = nonVPRTInputTexture;
+                            finalOutput = nonVPRTOutputTexture;
                         }
 
-                        // Perform upscaling.
-                        if (m_upscaler) {
-                            if (!swapchainState.upscaledTexture ||
-                                scaledOutputWidth != swapchainState.upscaledTexture->getInfo().width ||
-                                scaledOutputHeight != swapchainState.upscaledTexture->getInfo().height) {
-                                auto createInfo = swapchainImages.appTexture->getInfo();
+                        // Perform upscaling, with the post-processing in the same pass when the upscaler supports it.
+                        bool isPostProcessed = false;
+                        if (m_upscaler && !isProcessed) {
+                            m_graphicsDevice->startGpuStage(graphics::GpuStage::Upscaling);
+
+                            // Foveated upscaling follows the VRS inner ring, whether fixed or eye-tracked.
+                            const bool useFoveation = m_variableRateShader &&
+                                                      m_configManager->getValue(config::SettingUpscalingFoveated);
+                            for (uint32_t i = 0; i < utilities::ViewCount; i++) {
+                                graphics::Foveation foveation;
+                                if (useFoveation && m_variableRateShader->getFoveation(foveation, (utilities::Eye)i)) {
+                                    m_upscaler->setFoveation(foveation, (utilities::Eye)i);
+                                } else {
+                                    m_upscaler->setFoveation(std::nullopt, (utilities::Eye)i);
+                                }
+                            }
 
-                                // Single-surface, full (output) screen.
-                                createInfo.arraySize = 1;
-                                createInfo.width = scaledOutputWidth;
-                                createInfo.height = scaledOutputHeight;
+                            // The runtime swapchain is not written to directly in stereo.
+                            graphics::FusedPostProcess postProcess;
+                            if (!isStereo && !m_performanceCounters.benchmarkSeparatePostProcess &&
+                                (finalOutput->getInfo().usageFlags & XR_SWAPCHAIN_USAGE_UNORDERED_ACCESS_BIT) &&
+                                m_postProcessor->getFusedPostProcess(postProcess, (utilities::Eye)eye)) {
+                                isPostProcessed = m_upscaler->processFused(nextInput,
+                                                                           finalOutput,
+                                                                           swapchainState.upscalerTextures,
+                                                                           swapchainState.upscalerBlob,
+                                                                           postProcess,
+                                                                           (utilities::Eye)eye);
+                            }
 
-                                // Upscaler will write to as UAV. Then the post-processor will sample.
-                                createInfo.usageFlags =
-                                    XR_SWAPCHAIN_USAGE_UNORDERED_ACCESS_BIT | XR_SWAPCHAIN_USAGE_SAMPLED_BIT;
+                            if (!isPostProcessed) {
+                                std::shared_ptr<graphics::ITexture> upscaledTexture;
+                                graphics::StereoViews upscaledViews{};
+                                {
+                                    auto createInfo = swapchainImages.appTexture->getInfo();
+
+                                    // Single-surface (one slice per eye in stereo), full (output) screen.
+                                    createInfo.arraySize = isStereo ? utilities::ViewCount : 1;
+                                    createInfo.width = scaledOutputWidth;
+                                    createInfo.height = scaledOutputHeight;
+
+                                    // Upscaler will write to as UAV. Then the post-processor will sample.
+                                    createInfo.usageFlags =
+                                        XR_SWAPCHAIN_USAGE_UNORDERED_ACCESS_BIT | XR_SWAPCHAIN_USAGE_SAMPLED_BIT;
+
+                                    if (m_graphicsDevice->isTextureFormatSRGB(createInfo.format)) {
+                                        // Good balance between visuals and performance.
+                                        createInfo.format = m_graphicsDevice->getTextureFormat(
+                                            graphics::TextureFormat::R10G10B10A2_UNORM);
+                                    }
 
-                                if (m_graphicsDevice->isTextureFormatSRGB(createInfo.format)) {
-                                    // Good balance between visuals and performance.
-                                    createInfo.format =
-                                        m_graphicsDevice->getTextureFormat(graphics::TextureFormat::R10G10B10A2_UNORM);
-                                }
+                                    upscaledTexture =
+                                        m_graphicsDevice->acquireTransientTexture(createInfo, "Upscaled TEX2D");
+                                    transientTextures.push_back(upscaledTexture);
 
-                                swapchainState.upscaledTexture =
-                                    m_graphicsDevice->createTexture(createInfo, "Upscaled TEX2D");
-                            }
+                                    for (uint32_t i = 0; i < utilities::ViewCount; i++) {
+                                        upscaledViews.slice[i] = i;
+                                    }
+                                    upscaledViews.extent = outputViews.extent;
+                                }
 
-                            auto timer = swapchainImages.upscalingTimers[eye].get();
-                            m_stats.processorGpuTimeUs[0] += timer->query();
+                                if (isStereo) {
+                                    m_upscaler->processStereo(nextInput,
+                                                              inputViews,
+                                                              upscaledTexture,
+                                                              upscaledViews,
+                                                              swapchainState.upscalerTextures,
+                                                              swapchainState.upscalerBlob);
+                                    inputViews = upscaledViews;
+                                } else {
+                                    m_upscaler->process(nextInput,
+                                                        upscaledTexture,
+                                                        swapchainState.upscalerTextures,
+                                                        swapchainState.upscalerBlob,
+                                                        (utilities::Eye)eye);
+                                }
 
-                            timer->start();
-                            m_upscaler->process(nextInput,
-                                                swapchainState.upscaledTexture,
-                                                swapchainState.upscalerTextures,
-                                                swapchainState.upscalerBlob,
-                                                (utilities::Eye)eye);
-                            timer->stop();
+                                nextInput = upscaledTexture;
+                            }
 
-                            nextInput = swapchainState.upscaledTexture;
+                            m_graphicsDevice->stopGpuStage(graphics::GpuStage::Upscaling);
                         }
 
                         // Do post-processing and color conversion.
-                        {
-                            auto timer = swapchainImages.postProcessingTimers[eye].get();
-                            m_stats.processorGpuTimeUs[1] += timer->query();
-
-                            timer->start();
-                            m_postProcessor->process(nextInput,
-                                                     finalOutput,
-                                                     swapchainState.postProcessorTextures,
-                                                     swapchainState.postProcessorBlob,
-                                                     (utilities::Eye)eye);
-                            timer->stop();
+                        if (!isPostProcessed && !isProcessed) {
+                            m_graphicsDevice->startGpuStage(graphics::GpuStage::PostProcessing);
+                            if (isStereo) {
+                                m_postProcessor->processStereo(nextInput,
+                                                               inputViews,
+                                                               finalOutput,
+                                                               outputViews,
+                                                               swapchainState.postProcessorTextures,
+                                                               swapchainState.postProcessorBlob);
+                            } else {
+                                m_postProcessor->process(nextInput,
+                                                         finalOutput,
+                                                         swapchainState.postProcessorTextures,
+                                                         swapchainState.postProcessorBlob,
+                                                         (utilities::Eye)eye);
+                            }
+                            m_graphicsDevice->stopGpuStage(graphics::GpuStage::PostProcessing);
                         }
 
                         // Copy the output back into the VPRT runtime swapchain is needed.
@@ -2913,6 +3230,10 @@ namespace {
                                                 view.subImage.imageArrayIndex);
                         }
 
+                        for (const auto& texture : transientTextures) {
+                            m_graphicsDevice->releaseTransientTexture(texture);
+                        }
+
                         // Patch the resolution.
                         correctedProjectionViews[eye].subImage.imageRect.extent.width = scaledOutputWidth;
                         correctedProjectionViews[eye].subImage.imageRect.extent.height = scaledOutputHeight;
@@ -2922,7 +3243,7 @@ namespace {
                         depthForOverlay[eye] = depthBuffer;
 
                         // Patch the eye poses.
-                        if (m_configManager->getValue("canting")) {
+                        if (m_configManager->getValue(config::SettingCanting)) {
                             correctedProjectionViews[eye].pose = m_posesForFrame[eye].pose;
                         }
 
@@ -3026,17 +3347,17 @@ namespace {
             // Render our overlays.
             bool needMenuSwapchainDelayedRelease = false;
             {
+                ProfileZone("Overlay");
+
                 const bool drawHands = m_handTracker && m_configManager->peekEnumValue<config::HandTrackingVisibility>(
                                                             config::SettingHandVisibilityAndSkinTone) !=
                                                             config::HandTrackingVisibility::Hidden;
                 const bool drawEyeGaze = m_eyeTracker && m_configManager->getValue(config::SettingEyeDebug);
 
                 m_stats.overlayCpuTimeUs += m_performanceCounters.overlayCpuTimer->query();
-                m_stats.overlayGpuTimeUs +=
-                    m_performanceCounters.overlayGpuTimer[m_performanceCounters.gpuTimerIndex]->query();
 
                 m_performanceCounters.overlayCpuTimer->start();
-                m_performanceCounters.overlayGpuTimer[m_performanceCounters.gpuTimerIndex]->start();
+                m_graphicsDevice->startGpuStage(graphics::GpuStage::Overlay);
 
                 if (textureForOverlay[0]) {
                     const bool useTextureArrays =
@@ -3179,7 +3500,7 @@ namespace {
                 }
 
                 m_performanceCounters.overlayCpuTimer->stop();
-                m_performanceCounters.overlayGpuTimer[m_performanceCounters.gpuTimerIndex]->stop();
+                m_graphicsDevice->stopGpuStage(graphics::GpuStage::Overlay);
             }
 
             // Whether the menu is available or not, we can still use that top-most texture for screenshot.
@@ -3199,14 +3520,34 @@ namespace {
                     takeScreenshot(textureForOverlay[1], "R", viewportForOverlay[1]);
                 }
 
-                if (m_variableRateShader && m_configManager->getValue("vrs_capture")) {
+                if (m_variableRateShader && m_configManager->getValue(config::SettingVRSCapture)) {
                     m_variableRateShader->startCapture();
                 }
             }
 
+            if (m_configManager->hasChanged(config::SettingProfiler)) {
+                profiler::Enable(m_configManager->getValue(config::SettingProfiler));
+            }
+            if (utilities::UpdateKeyState(m_requestProfilerKeyState, m_keyModifiers, m_keyProfiler, false) &&
+                profiler::IsEnabled()) {
+                exportProfilerTrace();
+            }
+
             m_graphicsDevice->restoreContext();
             m_graphicsDevice->flushContext(false, true);
 
+            // Collect the GPU timings from the frame GpuFrameLatency frames ago. The frame that just closed will be
+            // collected GpuFrameLatency frames from now.
+            graphics::GpuStageTimings gpuTimings;
+            if (m_graphicsDevice->resolveQueries(gpuTimings)) {
+                m_stats.appGpuTimeUs += gpuTimings.durationUs[to_integral(graphics::GpuStage::App)];
+                m_stats.processorGpuTimeUs[0] += gpuTimings.durationUs[to_integral(graphics::GpuStage::Upscaling)];
+                m_stats.processorGpuTimeUs[1] +=
+                    gpuTimings.durationUs[to_integral(graphics::GpuStage::PostProcessing)];
+                m_stats.overlayGpuTimeUs += gpuTimings.durationUs[to_integral(graphics::GpuStage::Overlay)];
+                m_stats.vrsGpuTimeUs += gpuTimings.durationUs[to_integral(graphics::GpuStage::VRSMask)];
+            }
+
             // Release the swapchain images now, as we are really done this time.
             for (auto& swapchain : m_swapchains) {
                 if (swapchain.second.delayedRelease) {
@@ -3241,7 +3582,7 @@ namespace {
 #endif
 
             {
-                if (m_asyncWaitPromise.valid()) {
+                if (hasAsyncWait()) {
                     TraceLocalActivity(local);
 
                     // This is the latest point we must have fully waited a frame before proceeding.
@@ -3251,10 +3592,11 @@ namespace {
                     // refrain from enqueing a second wait further down. This isn't a pretty solution, but it is simple
                     // and it seems to work effectively (minus the 1s freeze observed in-game).
                     TraceLoggingWriteStart(local, "AsyncWaitNow");
-                    const auto ready = m_asyncWaitPromise.wait_for(1s) == std::future_status::ready;
+                    const auto ready = waitAsyncWait(1s);
                     TraceLoggingWriteStop(local, "AsyncWaitNow", TLArg(ready, "Ready"));
                     if (ready) {
-                        m_asyncWaitPromise = {};
+                        std::unique_lock lock(m_asyncWaitLock);
+                        m_asyncWaitConsumed = m_asyncWaitCompleted;
                     }
 
                     CHECK_XRCMD(OpenXrApi::xrBeginFrame(m_vrSession, nullptr));
@@ -3264,30 +3606,20 @@ namespace {
 
                 m_graphicsDevice->unblockCallbacks();
 
-                if (m_configManager->getValue(config::SettingTurboMode) && !m_asyncWaitPromise.valid()) {
+                if (m_configManager->getValue(config::SettingTurboMode) && !hasAsyncWait()) {
                     m_asyncWaitPolled = false;
-                    m_asyncWaitCompleted = false;
 
-                    // In Turbo mode, we kick off a wait thread immediately.
+                    // In Turbo mode, we kick off a wait immediately.
                     TraceLoggingWrite(g_traceProvider, "AsyncWaitStart");
-                    m_asyncWaitPromise = std::async(std::launch::async, [&] {
-                        TraceLocalActivity(local);
-
-                        XrFrameState frameState{XR_TYPE_FRAME_STATE};
-                        TraceLoggingWriteStart(local, "AsyncWaitFrame");
-                        CHECK_XRCMD(OpenXrApi::xrWaitFrame(m_vrSession, nullptr, &frameState));
-                        TraceLoggingWriteStop(local,
-                                              "AsyncWaitFrame",
-                                              TLArg(frameState.predictedDisplayTime, "PredictedDisplayTime"),
-                                              TLArg(frameState.predictedDisplayPeriod, "PredictedDisplayPeriod"));
-                        {
-                            std::unique_lock lock(m_asyncWaitLock);
-                            m_lastPredictedDisplayTime = frameState.predictedDisplayTime;
-                            m_lastPredictedDisplayPeriod = frameState.predictedDisplayPeriod;
-
-                            m_asyncWaitCompleted = true;
-                        }
-                    });
+                    if (!m_asyncWaitThread.joinable()) {
+                        m_asyncWaitStop = false;
+                        m_asyncWaitThread = std::thread([this] { asyncWaitThread(); });
+                    }
+                    {
+                        std::unique_lock lock(m_asyncWaitLock);
+                        m_asyncWaitRequested++;
+                    }
+                    m_asyncWaitWakeup.notify_one();
                 }
 
                 return result;
@@ -3295,6 +3627,90 @@ namespace {
         }
 
       private:
+        // Whether there is an xrWaitFrame() call from the Turbo mode thread that was not followed by an xrBeginFrame().
+        bool hasAsyncWait() {
+            std::unique_lock lock(m_asyncWaitLock);
+            return m_asyncWaitRequested != m_asyncWaitConsumed;
+        }
+
+        // Wait for the pending xrWaitFrame() from the Turbo mode thread to complete. Returns false upon timeout.
+        bool waitAsyncWait(std::chrono::milliseconds timeout = std::chrono::milliseconds::max()) {
+            std::unique_lock lock(m_asyncWaitLock);
+
+            const auto isCompleted = [&] { return m_asyncWaitCompleted == m_asyncWaitRequested; };
+            if (isCompleted()) {
+                return true;
+            }
+
+            // Our caller is stalled by the wait thread. This can be any of the application's threads, the count is
+            // published to the statistics from the frame thread.
+            m_asyncWaitStalls.fetch_add(1, std::memory_order_relaxed);
+            TraceLoggingWrite(g_traceProvider, "AsyncWaitStall");
+
+            if (timeout == std::chrono::milliseconds::max()) {
+                m_asyncWaitDone.wait(lock, isCompleted);
+                return true;
+            }
+            return m_asyncWaitDone.wait_for(lock, timeout, isCompleted);
+        }
+
+        void stopAsyncWaitThread() {
+            if (!m_asyncWaitThread.joinable()) {
+                return;
+            }
+
+            {
+                std::unique_lock lock(m_asyncWaitLock);
+                m_asyncWaitStop = true;
+            }
+            m_asyncWaitWakeup.notify_one();
+            m_asyncWaitThread.join();
+
+            std::unique_lock lock(m_asyncWaitLock);
+            m_asyncWaitConsumed = m_asyncWaitRequested = m_asyncWaitCompleted;
+        }
+
+        // The Turbo mode thread, calling xrWaitFrame() ahead of the application. There can only be one pending
+        // xrWaitFrame() at a time, since the runtime will block until the matching xrBeginFrame().
+        void asyncWaitThread() {
+            std::unique_lock lock(m_asyncWaitLock);
+            while (true) {
+                m_asyncWaitWakeup.wait(lock,
+                                       [&] { return m_asyncWaitStop || m_asyncWaitCompleted != m_asyncWaitRequested; });
+                if (m_asyncWaitStop) {
+                    break;
+                }
+                lock.unlock();
+
+                TraceLocalActivity(local);
+                ProfileZone("AsyncWaitFrame");
+
+                XrFrameState frameState{XR_TYPE_FRAME_STATE};
+                TraceLoggingWriteStart(local, "AsyncWaitFrame");
+                XrResult result = XR_ERROR_RUNTIME_FAILURE;
+                try {
+                    result = OpenXrApi::xrWaitFrame(m_vrSession, nullptr, &frameState);
+                } catch (std::exception& exc) {
+                    Log("xrWaitFrame: %s\n", exc.what());
+                }
+                TraceLoggingWriteStop(local,
+                                      "AsyncWaitFrame",
+                                      TLArg(xr::ToCString(result), "Result"),
+                                      TLArg(frameState.predictedDisplayTime, "PredictedDisplayTime"),
+                                      TLArg(frameState.predictedDisplayPeriod, "PredictedDisplayPeriod"));
+
+                lock.lock();
+                if (XR_SUCCEEDED(result)) {
+                    m_lastPredictedDisplayTime = frameState.predictedDisplayTime;
+                    m_lastPredictedDisplayPeriod = frameState.predictedDisplayPeriod;
+                }
+
+                // Always signal completion, to never leave the frame loop waiting.
+                m_asyncWaitCompleted++;
+                m_asyncWaitDone.notify_all();
+            }
+        }
+
         bool isVrSystem(XrSystemId systemId) const {
             return systemId == m_vrSystemId;
         }
@@ -3420,14 +3836,23 @@ namespace {
         XrVector2f m_eyeGaze[utilities::ViewCount];
         XrView m_posesForFrame[utilities::ViewCount];
         std::chrono::time_point<std::chrono::steady_clock> m_lastFrameWaitTimestamp{};
-        uint32_t m_frameThrottleSleepOffset{0};
+        std::shared_ptr<utilities::IFrameLimiter> m_frameLimiter;
+        std::chrono::microseconds m_frameThrottleLead{500};
 
+        // Turbo mode. Each xrWaitFrame() from the wait thread is requested, then completed, then consumed by the
+        // matching xrBeginFrame() (all counted monotonically).
+        std::thread m_asyncWaitThread;
         std::mutex m_asyncWaitLock;
-        std::future<void> m_asyncWaitPromise;
+        std::condition_variable m_asyncWaitWakeup;
+        std::condition_variable m_asyncWaitDone;
+        uint64_t m_asyncWaitRequested{0};
+        uint64_t m_asyncWaitCompleted{0};
+        uint64_t m_asyncWaitConsumed{0};
+        bool m_asyncWaitStop{false};
         XrTime m_lastPredictedDisplayTime{0};
         XrTime m_lastPredictedDisplayPeriod{0};
         bool m_asyncWaitPolled{false};
-        bool m_asyncWaitCompleted{false};
+        std::atomic<uint32_t> m_asyncWaitStalls{0};
 
         std::shared_ptr<config::IConfigManager> m_configManager;
 
@@ -3457,27 +3882,40 @@ namespace {
         std::shared_ptr<menu::IMenuHandler> m_menuHandler;
         int m_menuLingering{0};
         bool m_requestScreenShotKeyState{false};
+        int m_keyProfiler;
+        bool m_requestProfilerKeyState{false};
 
         struct {
             std::shared_ptr<utilities::ICpuTimer> appCpuTimer;
             std::shared_ptr<utilities::ICpuTimer> renderCpuTimer;
-            std::shared_ptr<graphics::IGpuTimer> appGpuTimer[GpuTimerLatency + 1];
             std::shared_ptr<utilities::ICpuTimer> waitCpuTimer;
             std::shared_ptr<utilities::ICpuTimer> endFrameCpuTimer;
             std::shared_ptr<utilities::ICpuTimer> overlayCpuTimer;
-            std::shared_ptr<graphics::IGpuTimer> overlayGpuTimer[GpuTimerLatency + 1];
             std::shared_ptr<utilities::ICpuTimer> handTrackingTimer;
 
-            unsigned int gpuTimerIndex{0};
             std::chrono::steady_clock::time_point lastWindowStart;
             std::deque<std::pair<std::chrono::steady_clock::duration, uint32_t>> frameRates;
             uint32_t framesInPeriod{0};
             std::chrono::steady_clock::duration timePeriod{0s};
             uint32_t numFrames{0};
+
+            utilities::LogHistogram timingHistograms[to_integral(menu::TimingStat::MaxValue)];
+            menu::MenuStatistics lastFrameStats{};
+            uint64_t lastVramUsedSize{0};
+            uint8_t lastVramUsedPercent{0};
+
+            std::chrono::steady_clock::time_point telemetryStart;
+            uint64_t telemetryFrameIndex{0};
+
+            // See SettingFusedPostProcessBenchmark. Index 0 is for the fused post-processing, 1 for the separate pass.
+            bool benchmarkSeparatePostProcess{false};
+            uint64_t benchmarkGpuTimeUs[2]{};
+            uint32_t benchmarkWindows[2]{};
         } m_performanceCounters;
 
         menu::MenuStatistics m_stats{};
         std::ofstream m_logStats;
+        std::shared_ptr<menu::ITelemetryRecorder> m_telemetry;
         bool m_hasPerformanceCounterKHR{false};
         bool m_hasVisibilityMaskKHR{false};
     };
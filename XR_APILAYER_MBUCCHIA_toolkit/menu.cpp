@@ -27,6 +27,7 @@
 #include "factories.h"
 #include "interfaces.h"
 #include "log.h"
+#include "profiler.h"
 
 namespace {
 
@@ -118,8 +119,8 @@ namespace {
         MenuIndent indent;
         std::string title;
         MenuEntryType type;
-#define BUTTON_OR_SEPARATOR "", 0, 0, MenuEntry::FmtNone
-        std::string configName;
+#define BUTTON_OR_SEPARATOR {}, 0, 0, MenuEntry::FmtNone
+        Setting configName;
         int minValue;
         int maxValue;
         std::function<std::string(int)> valueToString;
@@ -156,7 +157,7 @@ namespace {
             m_lastInput = std::chrono::steady_clock::now();
 
             // We display the hint for menu hotkeys for the first few runs.
-            const int keyMenuGen = m_configManager->getValue("key_menu_gen");
+            const int keyMenuGen = m_configManager->getValue(SettingKeyMenuGen);
             if (keyMenuGen != m_configManager->getValue(SettingFirstRun)) {
                 m_state = MenuState::Splash;
             }
@@ -190,7 +191,7 @@ namespace {
             m_menuEntries.push_back({MenuIndent::NoIndent,
                                      "",
                                      MenuEntryType::Tabs,
-                                     "",
+                                     {},
                                      0,
                                      ARRAYSIZE(tabs) - (m_configManager->isDeveloper() ? 1 : 2),
                                      [&](int value) { return std::string(tabs[value]); }});
@@ -244,7 +245,7 @@ namespace {
                     Log("Opening menu\n");
 
                     // Clear the "first run" until the menu key is reconfigured.
-                    m_configManager->setValue(SettingFirstRun, m_configManager->getValue("key_menu_gen"));
+                    m_configManager->setValue(SettingFirstRun, m_configManager->getValue(SettingKeyMenuGen));
 
                     m_needRestart = checkNeedRestartCondition();
                     m_resetTextLayout = m_resetBackgroundLayout = true;
@@ -357,6 +358,8 @@ namespace {
         }
 
         void render(std::shared_ptr<ITexture> renderTarget, std::optional<utilities::Eye> eye) const override {
+            ProfileZone("MenuHandler::render");
+
             const auto& viewportSize = m_device->getViewportSize();
 
             // Legacy menu support.
@@ -981,10 +984,27 @@ namespace {
                                 TIMING_STAT("pst GPU", processorGpuTimeUs[1]);
                                 TIMING_STAT("ovl CPU", overlayCpuTimeUs);
                                 TIMING_STAT("ovl GPU", overlayGpuTimeUs);
+                                TIMING_STAT("vrs GPU", vrsGpuTimeUs);
                                 if (m_isHandTrackingSupported) {
                                     TIMING_STAT("hnd CPU", handTrackingCpuTimeUs);
                                 }
 
+                                // Distribution over the window (p50/p95/p99/max).
+                                for (uint32_t i = 0; i < to_integral(TimingStat::MaxValue); i++) {
+                                    const auto& percentiles = m_stats.timingPercentiles[i];
+                                    if (!percentiles.max) {
+                                        continue;
+                                    }
+                                    m_device->drawString(fmt::format("{}: {}/{}/{}/{}",
+                                                                     TimingStatNames[i],
+                                                                     percentiles.p50,
+                                                                     percentiles.p95,
+                                                                     percentiles.p99,
+                                                                     percentiles.max),
+                                                         OVERLAY_COMMON);
+                                    top += 1.05f * fontSize;
+                                }
+
                                 m_device->drawString(fmt::format("{}{} / {}{}",
                                                                  m_stats.hasColorBuffer[0] ? "C" : "_",
                                                                  m_stats.hasDepthBuffer[0] ? "D" : "_",
@@ -1007,6 +1027,60 @@ namespace {
                                                      OVERLAY_COMMON);
                                 top += 1.05f * fontSize;
 
+                                m_device->drawString(fmt::format("hooks: {} ({} us)",
+                                                                 m_stats.hooks.numCalls,
+                                                                 m_stats.hooks.cpuTimeUs),
+                                                     OVERLAY_COMMON);
+                                top += 1.05f * fontSize;
+                                m_device->drawString(fmt::format("GPU waits: {}", m_stats.numGpuWaits),
+                                                     OVERLAY_COMMON);
+                                top += 1.05f * fontSize;
+                                m_device->drawString(fmt::format("CB uploads: {} (skip {})",
+                                                                 m_stats.constantUploads.numUploads,
+                                                                 m_stats.constantUploads.numSkippedUploads),
+                                                     OVERLAY_COMMON);
+                                top += 1.05f * fontSize;
+
+                                if (m_stats.constantUploads.ringSize) {
+                                    m_device->drawString(fmt::format("CB ring: {}/{} (stalls {})",
+                                                                     m_stats.constantUploads.ringPeakUsage,
+                                                                     m_stats.constantUploads.ringSize,
+                                                                     m_stats.constantUploads.numRingStalls),
+                                                         OVERLAY_COMMON);
+                                    top += 1.05f * fontSize;
+                                }
+
+                                if (m_stats.descriptors.numReserved) {
+                                    m_device->drawString(fmt::format("desc: {}/{} (free {})",
+                                                                     m_stats.descriptors.numAllocated,
+                                                                     m_stats.descriptors.numReserved,
+                                                                     m_stats.descriptors.numFree),
+                                                         OVERLAY_COMMON);
+                                    top += 1.05f * fontSize;
+                                    m_device->drawString(fmt::format("desc ring: {}/{} (stalls {})",
+                                                                     m_stats.descriptors.ringPeakUsage,
+                                                                     m_stats.descriptors.ringSize,
+                                                                     m_stats.descriptors.numRingStalls),
+                                                         OVERLAY_COMMON);
+                                    top += 1.05f * fontSize;
+                                }
+
+                                if (m_configManager->peekValue(SettingTurboMode)) {
+                                    m_device->drawString(fmt::format("turbo stalls: {}", m_stats.numTurboStalls),
+                                                         OVERLAY_COMMON);
+                                    top += 1.05f * fontSize;
+                                }
+                                if (m_configManager->peekValue(SettingFrameThrottling) < MaxFrameRate) {
+                                    m_device->drawString(fmt::format("thr jitter: {} (max {})",
+                                                                     m_stats.frameThrottleJitterUs,
+                                                                     m_stats.frameThrottleMaxJitterUs),
+                                                         OVERLAY_COMMON);
+                                    top += 1.05f * fontSize;
+                                    m_device->drawString(fmt::format("thr spin: {}", m_stats.frameThrottleSpinUs),
+                                                         OVERLAY_COMMON);
+                                    top += 1.05f * fontSize;
+                                }
+
 #undef TIMING_STAT
 
                                 top += 1.05f * fontSize;
@@ -1176,6 +1250,7 @@ namespace {
             m_originalScalingType = getCurrentScalingType();
             m_originalScalingValue = getCurrentScaling();
             m_originalAnamorphicValue = getCurrentAnamorphic();
+            m_originalMipMapBias = m_configManager->peekValue(SettingMipMapBias);
             m_useAnamorphic = m_originalAnamorphicValue > 0 ? 1 : 0;
 
             m_menuEntries.push_back({MenuIndent::OptionIndent,
@@ -1196,7 +1271,7 @@ namespace {
                 m_menuEntries.push_back({MenuIndent::SubGroupIndent,
                                          "Anamorphic",
                                          MenuEntryType::Choice,
-                                         "",
+                                         {},
                                          0,
                                          MenuEntry::LastVal<OffOnType>(),
                                          MenuEntry::FmtEnum<OffOnType>});
@@ -1255,19 +1330,32 @@ namespace {
                                          100,
                                          MenuEntry::FmtPercent});
 
-                // TODO: Mip-map biasing is only supported on D3D11.
-                if (m_device->getApi() == Api::D3D11) {
-                    MenuGroup mipmappingGroup(this, [&] { return getCurrentScaling() != 100; });
+                // Foveated upscaling sub-group (uses the foveated rendering rings).
+                if (menuInfo.variableRateShaderMaxRate) {
+                    MenuGroup foveatedGroup(this, [&] {
+                        return getCurrentScalingType() == ScalingType::FSR && getCurrentScaling() != 100;
+                    });
                     m_menuEntries.push_back({MenuIndent::SubGroupIndent,
-                                             "Mip-map bias",
-                                             MenuEntryType::Slider,
-                                             SettingMipMapBias,
+                                             "Foveated upscaling",
+                                             MenuEntryType::Choice,
+                                             SettingUpscalingFoveated,
                                              0,
-                                             MenuEntry::LastVal<MipMapBias>(),
-                                             MenuEntry::FmtEnum<MipMapBias>});
+                                             MenuEntry::LastVal<OffOnType>(),
+                                             MenuEntry::FmtEnum<OffOnType>});
                     m_menuEntries.back().expert = true;
-                    mipmappingGroup.finalize();
+                    foveatedGroup.finalize();
                 }
+
+                MenuGroup mipmappingGroup(this, [&] { return getCurrentScaling() != 100; });
+                m_menuEntries.push_back({MenuIndent::SubGroupIndent,
+                                         "Mip-map bias",
+                                         MenuEntryType::Slider,
+                                         SettingMipMapBias,
+                                         0,
+                                         MenuEntry::LastVal<MipMapBias>(),
+                                         MenuEntry::FmtEnum<MipMapBias>});
+                m_menuEntries.back().expert = true;
+                mipmappingGroup.finalize();
                 upscalingGroup.finalize();
             }
 
@@ -1959,14 +2047,14 @@ namespace {
             m_menuEntries.push_back({MenuIndent::OptionIndent,
                                      "Simulate canting",
                                      MenuEntryType::Slider,
-                                     "canting",
+                                     SettingCanting,
                                      -90,
                                      90,
                                      [](int value) { return fmt::format("{}\xB0", value); }});
             m_menuEntries.push_back({MenuIndent::OptionIndent,
                                      "Force VPRT path*",
                                      MenuEntryType::Choice,
-                                     "force_vprt_path",
+                                     SettingForceVPRTPath,
                                      0,
                                      MenuEntry::LastVal<OffOnType>(),
                                      MenuEntry::FmtEnum<OffOnType>});
@@ -1994,17 +2082,24 @@ namespace {
             m_menuEntries.push_back({MenuIndent::OptionIndent,
                                      "Debug CPU Load",
                                      MenuEntryType::Slider,
-                                     "debug_cpu_load",
+                                     SettingDebugCpuLoad,
                                      0,
                                      1000,
                                      MenuEntry::FmtDecimal<0>});
             m_menuEntries.push_back({MenuIndent::OptionIndent,
                                      "Debug GPU Load",
                                      MenuEntryType::Slider,
-                                     "debug_gpu_load",
+                                     SettingDebugGpuLoad,
                                      0,
                                      1000,
                                      MenuEntry::FmtDecimal<0>});
+            m_menuEntries.push_back({MenuIndent::OptionIndent,
+                                     "Fused post-processing A/B",
+                                     MenuEntryType::Choice,
+                                     SettingFusedPostProcessBenchmark,
+                                     0,
+                                     MenuEntry::LastVal<OffOnType>(),
+                                     MenuEntry::FmtEnum<OffOnType>});
 
             m_menuEntries.push_back(
                 {MenuIndent::OptionIndent, "Reload Shaders", MenuEntryType::ReloadShaders, BUTTON_OR_SEPARATOR});
@@ -2111,6 +2206,13 @@ namespace {
                 return true;
             }
 
+            // With D3D12, the bias is applied when the application creates its samplers and root signatures, which
+            // most applications only do when loading.
+            if (m_device->getApi() == Api::D3D12 && m_originalScalingType != ScalingType::None &&
+                m_originalMipMapBias != m_configManager->peekValue(SettingMipMapBias)) {
+                return true;
+            }
+
             if (m_configManager->peekValue(SettingResolutionOverride) &&
                 m_originalResolutionHeight != m_configManager->peekValue(SettingResolutionHeight)) {
                 return true;
@@ -2168,6 +2270,7 @@ namespace {
         ScalingType m_originalScalingType{ScalingType::None};
         int m_originalScalingValue{0};
         int m_originalAnamorphicValue{0};
+        int m_originalMipMapBias{0};
         int m_useAnamorphic{0};
 
         bool m_originalHandTrackingEnabled{false};
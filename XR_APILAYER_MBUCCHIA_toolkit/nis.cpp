@@ -54,10 +54,12 @@ namespace {
         }
 
         void reload() override {
-            initializeScaler();
+            // The current shader is used until the new one is compiled.
+            createShaders();
         }
 
         void update() override {
+            utilities::shader::ResolveAsync(m_pendingShader, m_shader);
         }
 
         void process(std::shared_ptr<ITexture> input,
@@ -119,8 +121,51 @@ namespace {
             m_device->dispatchShader();
         }
 
+        bool getFusedPostProcess(FusedPostProcess& postProcess,
+                                 std::optional<utilities::Eye> eye = std::nullopt) const override {
+            return false;
+        }
+
+        bool processFused(std::shared_ptr<ITexture> input,
+                          std::shared_ptr<ITexture> output,
+                          std::vector<std::shared_ptr<ITexture>>& textures,
+                          std::array<uint8_t, 1024>& blob,
+                          const FusedPostProcess& postProcess,
+                          std::optional<utilities::Eye> eye = std::nullopt) override {
+            return false;
+        }
+
+        void setFoveation(const std::optional<Foveation>& foveation, utilities::Eye eye) override {
+        }
+
+        bool isStereoSupported() const override {
+            // The NIS kernel only reads from and writes to 2D textures.
+            return false;
+        }
+
+        void processStereo(std::shared_ptr<ITexture> input,
+                           const StereoViews& inputViews,
+                           std::shared_ptr<ITexture> output,
+                           const StereoViews& outputViews,
+                           std::vector<std::shared_ptr<ITexture>>& textures,
+                           std::array<uint8_t, 1024>& blob) override {
+            throw std::runtime_error("Stereo processing is not supported");
+        }
+
       private:
         void initializeScaler() {
+            createShaders();
+            utilities::shader::ResolveAsync(m_pendingShader, m_shader, true /* wait */);
+
+            // create coefficient inputs for NISScaler only
+            if (!m_isSharpenOnly) {
+                initializeCoefficients();
+            }
+
+            m_configBuffer = m_device->createBuffer(sizeof(NISConfig), "NIS Configuration CB");
+        }
+
+        void createShaders() {
             const auto shadersDir = dllHome / "shaders";
             const auto shaderFile = shadersDir / "NIS.hlsl";
 
@@ -143,17 +188,8 @@ namespace {
             defines.add("NIS_BLOCK_HEIGHT", m_optimalBlockHeight);
             defines.add("NIS_THREAD_GROUP_SIZE", opt.GetOptimalThreadGroupSize());
 
-            if (!m_isSharpenOnly) {
-                m_shader = m_device->createComputeShader(shaderFile, "main", "NISScaler CS", {}, defines.get());
-
-                // create coefficient inputs for NISScaler only
-                initializeCoefficients();
-
-            } else {
-                m_shader = m_device->createComputeShader(shaderFile, "main", "NISSharpen CS", {}, defines.get());
-            }
-
-            m_configBuffer = m_device->createBuffer(sizeof(NISConfig), "NIS Configuration CB");
+            m_pendingShader = m_device->createComputeShaderAsync(
+                shaderFile, "main", !m_isSharpenOnly ? "NISScaler CS" : "NISSharpen CS", {}, defines.get());
         }
 
         void initializeCoefficients() {
@@ -202,6 +238,7 @@ namespace {
         const bool m_isSharpenOnly;
 
         std::shared_ptr<IComputeShader> m_shader;
+        std::shared_future<std::shared_ptr<IComputeShader>> m_pendingShader;
         uint32_t m_optimalBlockWidth;
         uint32_t m_optimalBlockHeight;
         std::shared_ptr<IShaderBuffer> m_configBuffer;
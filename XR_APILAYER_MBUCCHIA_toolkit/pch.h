@@ -27,9 +27,11 @@
 #include <array>
 #include <atomic>
 #include <bit>
+#include <bitset>
 #include <chrono>
 #define _USE_MATH_DEFINES
 #include <cmath>
+#include <condition_variable>
 #include <cstdarg>
 #include <ctime>
 #include <deque>
@@ -37,6 +39,8 @@
 #include <iostream>
 #include <filesystem>
 #include <fstream>
+#include <functional>
+#include <future>
 #include <sstream>
 #include <string>
 #include <map>
@@ -44,7 +48,9 @@
 #include <mutex>
 #include <optional>
 #include <set>
+#include <shared_mutex>
 #include <thread>
+#include <unordered_map>
 #include <vector>
 
 using namespace std::chrono_literals;
@@ -57,6 +63,8 @@ using namespace std::chrono_literals;
 #include <wrl.h>
 #include <winsock2.h>
 #include <ws2tcpip.h>
+#include <bcrypt.h>
+#include <wil/filesystem.h>
 #include <wil/registry.h>
 
 using Microsoft::WRL::ComPtr;
@@ -23,17 +23,55 @@
 
 // clang-format off
 
-cbuffer config : register(b0) {
+// This file is also included by FSR.hlsl for the fused upscaling and post-processing, with
+// POST_PROCESS_FUNCTIONS_ONLY defined and the constant buffer at POST_PROCESS_CONFIG_REGISTER.
+#ifndef POST_PROCESS_CONFIG_REGISTER
+#define POST_PROCESS_CONFIG_REGISTER b0
+#endif
+
+cbuffer config : register(POST_PROCESS_CONFIG_REGISTER) {
     float4 Params1;  // Contrast, Brightness, Exposure, Saturation (-1..+1 params)
     float4 Params2;  // ColorGainR, ColorGainG, ColorGainB (-1..+1 params)
     float4 Params3;  // Highlights, Shadows, Vibrance (0..1 params), UseCA (0 = off, 1 = on)
     float4 Params4;  // ChromaticCorrectionR, ChromaticCorrectionG, ChromaticCorrectionB (-1..+1 params), Eye (0 = left, 1 = right)
 };
 
+#ifndef POST_PROCESS_FUNCTIONS_ONLY
 SamplerState sourceSampler : register(s0);
 
+// With POST_PROCESS_LAYERED, both eyes are drawn at once, the eye being the render target slice.
+#if POST_PROCESS_LAYERED
+#define EYE_INPUT , in uint eye : SV_RenderTargetArrayIndex
+#define EYE eye
+#else
+#define EYE_INPUT
+#define EYE ((uint)Params4.w)
+#endif
+
+#if POST_PROCESS_STEREO
+// Both eyes are in the same source texture, each in a region of a slice. The samples are clamped to the region of the
+// eye, like the sampler clamps them to the texture otherwise.
+cbuffer stereo : register(b1) {
+    int4 InputView[2];  // per eye: x, y, slice
+    int4 OutputView[2]; // per eye: x, y, slice (the render target and the viewport select the eye)
+    int4 ViewExtent;    // input width, height, output width, height
+};
+
+Texture2DArray sourceTexture : register(t0);
+
+float4 SampleSource(float2 texcoord, uint eye) {
+    uint width, height, slices;
+    sourceTexture.GetDimensions(width, height, slices);
+    const float2 origin = InputView[eye].xy;
+    const float2 pos = clamp(origin + texcoord * ViewExtent.xy, origin + 0.5, origin + ViewExtent.xy - 0.5);
+    return sourceTexture.Sample(sourceSampler, float3(pos / float2(width, height), InputView[eye].z));
+}
+#define SAMPLE_TEXTURE(texcoord) SampleSource((texcoord), EYE)
+#else
 Texture2D sourceTexture : register(t0);
 #define SAMPLE_TEXTURE(texcoord) sourceTexture.Sample(sourceSampler, (texcoord))
+#endif
+#endif
 
 #ifndef FLT_EPSILON
 #define FLT_EPSILON     1.192092896e-07
@@ -155,9 +193,7 @@ float3 AdjustHighlightsShadows(float3 color, float2 amount) {
   return (color/luma) * (h + s - luma);
 }
 
-float4 mainPostProcess(in float4 position : SV_POSITION, in float2 texcoord : TEXCOORD0) : SV_TARGET {
-  float3 color = SAMPLE_TEXTURE(texcoord).rgb;
-
+float3 PostProcess(float3 color) {
 #ifdef POST_PROCESS_SRC_SRGB
   color = srgb2linear(color);
  #endif
@@ -186,15 +222,40 @@ float4 mainPostProcess(in float4 position : SV_POSITION, in float2 texcoord : TE
   color = linear2srgb(color);
 #endif
 
-  return float4(saturate(color), 1.0);
+  return saturate(color);
+}
+
+float3 PassThrough(float3 color) {
+#ifdef PASS_THROUGH_USE_GAINS
+#ifdef POST_PROCESS_SRC_SRGB
+  color = srgb2linear(color);
+#endif
+
+  // adjust color input gains.
+  if (any(Params2.rgb)) {
+    color = AdjustGains(color, Params2.rgb);
+  }
+
+#ifdef POST_PROCESS_DST_SRGB
+  color = linear2srgb(color);
+#endif
+
+#endif
+
+  return saturate(color);
+}
+
+#ifndef POST_PROCESS_FUNCTIONS_ONLY
+float4 mainPostProcess(in float4 position : SV_POSITION, in float2 texcoord : TEXCOORD0 EYE_INPUT) : SV_TARGET {
+  return float4(PostProcess(SAMPLE_TEXTURE(texcoord).rgb), 1.0);
 }
 
-float4 mainPassThrough(in float4 position : SV_POSITION, in float2 texcoord : TEXCOORD0) : SV_TARGET {
+float4 mainPassThrough(in float4 position : SV_POSITION, in float2 texcoord : TEXCOORD0 EYE_INPUT) : SV_TARGET {
 
   float3 color;
   if (Params3.w) {
     float2 correctionOrigin = float2(0.313, 0.42);
-    if (Params4.w) {
+    if (EYE) {
         correctionOrigin.x = 1 - correctionOrigin.x;
     }
 
@@ -210,23 +271,8 @@ float4 mainPassThrough(in float4 position : SV_POSITION, in float2 texcoord : TE
     color = SAMPLE_TEXTURE(texcoord).rgb;
   }
 
-#ifdef PASS_THROUGH_USE_GAINS
-#ifdef POST_PROCESS_SRC_SRGB
-  color = srgb2linear(color);
-#endif
-
-  // adjust color input gains.
-  if (any(Params2.rgb)) {
-    color = AdjustGains(color, Params2.rgb);
-  }
-
-#ifdef POST_PROCESS_DST_SRGB
-  color = linear2srgb(color);
-#endif
-
-#endif
-
-  return float4(saturate(color), 1.0);
+  return float4(PassThrough(color), 1.0);
 }
+#endif
 
 // clang-format on
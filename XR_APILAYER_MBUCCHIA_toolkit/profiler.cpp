@@ -0,0 +1,182 @@
+// MIT License
+//
+// Copyright(c) 2021 Matthieu Bucchianeri
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this softwareand associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright noticeand this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include "profiler.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace {
+
+    using namespace toolkit::profiler;
+
+    // Enough for a few seconds of frames on each thread.
+    constexpr uint64_t ZonesPerThread = 16384;
+
+    struct Zone {
+        const char* name;
+        int64_t startNs;
+        int64_t endNs;
+    };
+
+    // A ring of zones for one thread. Only the owning thread writes to it, so recording a zone takes no lock. The
+    // fields are atomics so that the export can read them concurrently, and the relaxed stores compile to plain moves.
+    struct ThreadBuffer {
+        struct Slot {
+            std::atomic<const char*> name{nullptr};
+            std::atomic<int64_t> startNs{0};
+            std::atomic<int64_t> endNs{0};
+        };
+
+        std::unique_ptr<Slot[]> slots{new Slot[ZonesPerThread]};
+        std::atomic<uint64_t> count{0};
+        uint32_t threadIndex{0};
+
+        void record(const char* name, int64_t startNs, int64_t endNs) {
+            const uint64_t index = count.load(std::memory_order_relaxed);
+            auto& slot = slots[index % ZonesPerThread];
+            slot.name.store(name, std::memory_order_relaxed);
+            slot.startNs.store(startNs, std::memory_order_relaxed);
+            slot.endNs.store(endNs, std::memory_order_relaxed);
+            count.store(index + 1, std::memory_order_release);
+        }
+
+        // Copy the zones held in the ring. The owning thread may keep recording, so the oldest zones that were
+        // overwritten during the copy are dropped.
+        void collect(std::vector<std::pair<uint32_t, Zone>>& zones) const {
+            const uint64_t end = count.load(std::memory_order_acquire);
+            const uint64_t begin = end > ZonesPerThread ? end - ZonesPerThread : 0;
+
+            const size_t offset = zones.size();
+            for (uint64_t i = begin; i < end; i++) {
+                const auto& slot = slots[i % ZonesPerThread];
+                zones.push_back(std::make_pair(threadIndex,
+                                               Zone{slot.name.load(std::memory_order_relaxed),
+                                                    slot.startNs.load(std::memory_order_relaxed),
+                                                    slot.endNs.load(std::memory_order_relaxed)}));
+            }
+
+            std::atomic_thread_fence(std::memory_order_acquire);
+            const uint64_t newEnd = count.load(std::memory_order_relaxed);
+            const uint64_t overwritten = newEnd > ZonesPerThread ? std::min(newEnd - ZonesPerThread, end) : 0;
+            if (overwritten > begin) {
+                zones.erase(zones.begin() + offset, zones.begin() + offset + (overwritten - begin));
+            }
+        }
+    };
+
+    // The registry is only locked when a thread records its first zone, and during export.
+    std::mutex g_buffersMutex;
+    std::vector<std::shared_ptr<ThreadBuffer>> g_buffers;
+
+    ThreadBuffer& GetThreadBuffer() {
+        // The buffer is kept alive by the registry after the thread exits, so its zones can still be exported.
+        thread_local std::shared_ptr<ThreadBuffer> buffer;
+        if (!buffer) {
+            buffer = std::make_shared<ThreadBuffer>();
+
+            std::unique_lock lock(g_buffersMutex);
+            buffer->threadIndex = static_cast<uint32_t>(g_buffers.size());
+            g_buffers.push_back(buffer);
+        }
+        return *buffer;
+    }
+
+    // Escape a zone name for JSON.
+    std::string Escape(const char* name) {
+        std::string escaped;
+        for (const char* c = name; *c; c++) {
+            if (*c == '"' || *c == '\\') {
+                escaped += '\\';
+            }
+            escaped += *c;
+        }
+        return escaped;
+    }
+
+} // namespace
+
+namespace toolkit::profiler {
+
+    std::atomic<bool> g_enabled{false};
+
+    void Enable(bool enable) {
+        g_enabled.store(enable, std::memory_order_relaxed);
+    }
+
+    void RecordZone(const char* name, int64_t startNs, int64_t endNs) {
+        GetThreadBuffer().record(name, startNs, endNs);
+    }
+
+    bool ExportChromeTrace(const std::filesystem::path& path) {
+        std::vector<std::shared_ptr<ThreadBuffer>> buffers;
+        {
+            std::unique_lock lock(g_buffersMutex);
+            buffers = g_buffers;
+        }
+
+        // Merge the zones from all the threads.
+        std::vector<std::pair<uint32_t, Zone>> zones;
+        for (const auto& buffer : buffers) {
+            buffer->collect(zones);
+        }
+        std::stable_sort(zones.begin(), zones.end(), [](const auto& a, const auto& b) {
+            return a.second.startNs < b.second.startNs;
+        });
+        const int64_t origin = zones.empty() ? 0 : zones.front().second.startNs;
+
+        std::ofstream file(path, std::ios_base::out | std::ios_base::trunc);
+        if (!file.is_open()) {
+            return false;
+        }
+
+        file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+        bool first = true;
+        for (const auto& [threadIndex, zone] : zones) {
+            if (!first) {
+                file << ",";
+            }
+            first = false;
+
+            // Complete events ("X"), with timestamps in microseconds.
+            char buf[128];
+            snprintf(buf,
+                     sizeof(buf),
+                     "\",\"ph\":\"X\",\"pid\":0,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}",
+                     threadIndex,
+                     (zone.startNs - origin) / 1000.0,
+                     (zone.endNs - zone.startNs) / 1000.0);
+            file << "\n{\"name\":\"" << Escape(zone.name) << buf;
+        }
+        file << "\n]}\n";
+
+        return file.good();
+    }
+
+} // namespace toolkit::profiler
@@ -0,0 +1,92 @@
+// MIT License
+//
+// Copyright(c) 2021 Matthieu Bucchianeri
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this softwareand associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright noticeand this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+// This header is included from hot paths and from the tests, so it only depends on the standard library.
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+
+// A lightweight CPU zone profiler. Zones are recorded into thread-local buffers when the profiler is enabled, without
+// any lock, and the buffers of all the threads are merged when exported as a Chrome trace (chrome://tracing or
+// https://ui.perfetto.dev).
+// When the profiler is disabled, a zone costs a single relaxed load. Define TOOLKIT_DISABLE_PROFILER to compile out
+// all the zones.
+namespace toolkit::profiler {
+
+    extern std::atomic<bool> g_enabled;
+
+    inline bool IsEnabled() {
+        return g_enabled.load(std::memory_order_relaxed);
+    }
+
+    void Enable(bool enable);
+
+    // Record a zone with timestamps from Now().
+    void RecordZone(const char* name, int64_t startNs, int64_t endNs);
+
+    // Export all the zones currently held in the buffers as a Chrome trace_event JSON file, sorted by start time.
+    bool ExportChromeTrace(const std::filesystem::path& path);
+
+    inline int64_t Now() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                   std::chrono::steady_clock::now().time_since_epoch())
+            .count();
+    }
+
+    class ScopedZone {
+      public:
+        // The name must be a string literal (or outlive the profiler).
+        explicit ScopedZone(const char* name) {
+            if (IsEnabled()) {
+                m_name = name;
+                m_start = Now();
+            }
+        }
+
+        ~ScopedZone() {
+            if (m_name) {
+                RecordZone(m_name, m_start, Now());
+            }
+        }
+
+        ScopedZone(const ScopedZone&) = delete;
+        ScopedZone& operator=(const ScopedZone&) = delete;
+
+      private:
+        const char* m_name{nullptr};
+        int64_t m_start{0};
+    };
+
+} // namespace toolkit::profiler
+
+#define PROFILER_CONCAT_INNER(a, b) a##b
+#define PROFILER_CONCAT(a, b) PROFILER_CONCAT_INNER(a, b)
+
+#ifndef TOOLKIT_DISABLE_PROFILER
+#define ProfileZone(name) toolkit::profiler::ScopedZone PROFILER_CONCAT(_profileZone, __LINE__)(name)
+#else
+#define ProfileZone(name)
+#endif
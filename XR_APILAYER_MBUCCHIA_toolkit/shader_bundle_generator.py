@@ -0,0 +1,176 @@
+# MIT License
+#
+# Copyright(c) 2021-2022 Matthieu Bucchianeri
+#
+# Permission is hereby granted, free of charge, to any person obtaining a copy
+# of this softwareand associated documentation files(the "Software"), to deal
+# in the Software without restriction, including without limitation the rights
+# to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+# copies of the Software, and to permit persons to whom the Software is
+# furnished to do so, subject to the following conditions :
+#
+# The above copyright noticeand this permission notice shall be included in all
+# copies or substantial portions of the Software.
+#
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+# IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+# AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+# LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+# OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+# SOFTWARE.
+
+# Compiles the known shader permutations offline and packs them into a bundle that is embedded in the layer DLL.
+#
+# Usage: shader_bundle_generator.py <fxc.exe> <shaders dir> <output file> <Debug|Release>
+#
+# The bundle layout must match the one parsed in utilities.cpp:
+#   header:  uint32 magic ('XRSB'), uint32 version, uint32 count, uint32 reserved
+#   entries: uint32 keyOffset, uint32 keySize, uint32 dataOffset, uint32 dataSize, uint8 sourceHash[32]
+#   followed by the keys and the bytecode.
+# The key is "<file>|<entry point>|<target>|<NAME=VALUE;...>", with the defines in the order they are passed to
+# CompileShader().
+# The source hash covers the shader file and all the files it includes, see source_hash().
+
+import hashlib
+import itertools
+import os
+import re
+import struct
+import subprocess
+import sys
+import tempfile
+
+BundleMagic = 0x42535258 # 'XRSB'
+BundleVersion = 2
+
+# The permutations below must be kept in sync with the Defines built in the corresponding modules. A permutation that
+# is missing here is not an error: the shader is simply compiled at runtime (and cached on disk).
+def permutations():
+    # fsr.cpp
+    common = [('FSR_THREAD_GROUP_SIZE', '64'), ('SAMPLE_SLOW_FALLBACK', '1'), ('SAMPLE_BILINEAR', '0')]
+    for stereo in [[], [('SAMPLE_STEREO', '1')]]:
+        yield ('FSR.hlsl', 'mainCS', 'cs_5_0',
+               common + [('SAMPLE_RCAS', '0'), ('SAMPLE_EASU', '1'), ('SAMPLE_HDR_OUTPUT', '0')] + stereo)
+        yield ('FSR.hlsl', 'mainCS', 'cs_5_0',
+               common + [('SAMPLE_RCAS', '1'), ('SAMPLE_EASU', '0'), ('SAMPLE_HDR_OUTPUT', '0'),
+                         ('SAMPLE_HDR_OUTPUT', '1')] + stereo)
+    for postProcess in ['0', '1', '2']:
+        yield ('FSR.hlsl', 'mainFusedCS', 'cs_5_0',
+               [('FSR_THREAD_GROUP_SIZE', '64'), ('SAMPLE_SLOW_FALLBACK', '1'), ('SAMPLE_FUSED', '1'),
+                ('PASS_THROUGH_USE_GAINS', '1'), ('SAMPLE_POST_PROCESS', postProcess)])
+    # The stereo variant never fuses the post-processing.
+    yield ('FSR.hlsl', 'mainFusedCS', 'cs_5_0',
+           [('FSR_THREAD_GROUP_SIZE', '64'), ('SAMPLE_SLOW_FALLBACK', '1'), ('SAMPLE_FUSED', '1'),
+            ('PASS_THROUGH_USE_GAINS', '1'), ('SAMPLE_POST_PROCESS', '0'), ('SAMPLE_STEREO', '1')])
+
+    # nis.cpp: block size and thread group size from NISOptimizer (NVIDIA vs AMD/Intel).
+    for scaler, threadGroupSize in itertools.product(['1', '0'], ['128', '256']):
+        yield ('NIS.hlsl', 'main', 'cs_5_0',
+               [('NIS_SCALER', scaler), ('NIS_HDR_MODE', '0'), ('NIS_BLOCK_WIDTH', '32'), ('NIS_BLOCK_HEIGHT', '24'),
+                ('NIS_THREAD_GROUP_SIZE', threadGroupSize)])
+
+    # cas.cpp
+    for sharpenOnly, stereo in itertools.product(['0', '1'], [[], [('CAS_SAMPLE_STEREO', '1')]]):
+        yield ('CAS.hlsl', 'mainCS', 'cs_5_0',
+               [('CAS_THREAD_GROUP_SIZE', '64'), ('CAS_SAMPLE_FP16', '0'), ('CAS_SAMPLE_SHARPEN_ONLY', sharpenOnly)] +
+               stereo)
+
+    # vrs.cpp: the tile size depends on the GPU and API.
+    for tileSize in ['8', '16', '32']:
+        yield ('VRS.hlsl', 'mainCS', 'cs_5_0',
+               [('VRS_TILE_X', tileSize), ('VRS_TILE_Y', tileSize), ('VRS_NUM_RATES', '3'), ('VRS_NUM_THREADS_X', '8'),
+                ('VRS_NUM_THREADS_Y', '8')])
+
+    # imageprocess.cpp: the layered permutation is only used when the device supports it.
+    for entryPoint, stereo in itertools.product(['mainPassThrough', 'mainPostProcess'],
+                                                [[], [('POST_PROCESS_STEREO', '1')],
+                                                 [('POST_PROCESS_STEREO', '1'), ('POST_PROCESS_LAYERED', '1')]]):
+        yield ('postprocess.hlsl', entryPoint, 'ps_5_0', [('PASS_THROUGH_USE_GAINS', '1')] + stereo)
+
+IncludePattern = re.compile(rb'^[ \t]*#[ \t]*include[ \t]*"([^"\r\n]+)"', re.MULTILINE)
+
+# Must match ComputeSourceHash() in utilities.cpp: the SHA-256 of each file of the include closure, visited depth-first
+# in the order of the #include directives (each file only once), as "<name>\0<contents>". Includes are resolved
+# relative to the including file, and the directives are followed regardless of the preprocessor conditions.
+def source_hash(shaderPath):
+    sha = hashlib.sha256()
+    visited = set()
+
+    def visit(path, name):
+        key = os.path.normcase(os.path.normpath(path))
+        if key in visited:
+            return
+        visited.add(key)
+
+        sha.update(name + b'\0')
+        try:
+            with open(path, 'rb') as f:
+                contents = f.read()
+        except OSError:
+            # Same as the runtime: a missing include only contributes its name.
+            return
+        sha.update(contents)
+        for include in IncludePattern.findall(contents):
+            visit(os.path.join(os.path.dirname(path), include.decode('utf-8')), include)
+
+    visit(shaderPath, os.path.basename(shaderPath).encode('utf-8'))
+    return sha.digest()
+
+def make_key(shaderFile, entryPoint, target, defines):
+    return '{}|{}|{}|{}'.format(shaderFile, entryPoint, target, ''.join('{}={};'.format(n, v) for n, v in defines))
+
+# Must match the flags used in CompileShaderCached().
+def compiler_flags(configuration):
+    flags = ['/nologo', '/Zpc', '/Ges', '/WX']
+    if configuration == 'Debug':
+        flags += ['/Od', '/Zi']
+    else:
+        flags += ['/O3']
+    return flags
+
+def compile_shader(fxc, shadersDir, configuration, shaderFile, entryPoint, target, defines):
+    with tempfile.TemporaryDirectory() as tempDir:
+        output = os.path.join(tempDir, 'shader.cso')
+        command = [fxc] + compiler_flags(configuration) + ['/T', target, '/E', entryPoint, '/Fo', output]
+        for name, value in defines:
+            command += ['/D', '{}={}'.format(name, value)]
+        command.append(os.path.join(shadersDir, shaderFile))
+        subprocess.run(command, check=True)
+        with open(output, 'rb') as f:
+            return f.read()
+
+if __name__ == '__main__':
+    if len(sys.argv) != 5:
+        raise Exception('Usage: {} <fxc.exe> <shaders dir> <output file> <Debug|Release>'.format(sys.argv[0]))
+    fxc, shadersDir, outputFile, configuration = sys.argv[1:]
+
+    sourceHashes = {}
+    entries = []
+    for shaderFile, entryPoint, target, defines in permutations():
+        if shaderFile not in sourceHashes:
+            sourceHashes[shaderFile] = source_hash(os.path.join(shadersDir, shaderFile))
+        key = make_key(shaderFile, entryPoint, target, defines).encode('utf-8')
+        bytecode = compile_shader(fxc, shadersDir, configuration, shaderFile, entryPoint, target, defines)
+        entries.append((key, sourceHashes[shaderFile], bytecode))
+
+    headerFormat = '<4I'
+    entryFormat = '<4I32s'
+    offset = struct.calcsize(headerFormat) + len(entries) * struct.calcsize(entryFormat)
+
+    table = bytearray()
+    payload = bytearray()
+    for key, sourceHash, bytecode in entries:
+        keyOffset = offset + len(payload)
+        payload += key
+        # Keep the bytecode DWORD-aligned.
+        payload += b'\0' * (-(offset + len(payload)) % 4)
+        dataOffset = offset + len(payload)
+        payload += bytecode
+        table += struct.pack(entryFormat, keyOffset, len(key), dataOffset, len(bytecode), sourceHash)
+
+    os.makedirs(os.path.dirname(os.path.abspath(outputFile)), exist_ok=True)
+    with open(outputFile, 'wb') as f:
+        f.write(struct.pack(headerFormat, BundleMagic, BundleVersion, len(entries), 0))
+        f.write(table)
+        f.write(payload)
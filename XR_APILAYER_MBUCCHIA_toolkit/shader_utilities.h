@@ -36,6 +36,7 @@ namespace toolkit::utilities::shader {
                        ID3DInclude* includes = nullptr,
                        const char* target = "cs_5_0");
 
+    // Shaders compiled from memory can only #include through the include handler.
     void CompileShader(const void* data,
                        size_t size,
                        const char* entryPoint,
@@ -84,6 +85,15 @@ namespace toolkit::utilities::shader {
 
     class Defines {
       public:
+        Defines() = default;
+
+        // Take a copy of a null-terminated list, so that it can outlive the caller's.
+        Defines(const D3D_SHADER_MACRO* defines) {
+            for (auto define = defines; define && define->Name; define++) {
+                m_definesVector.push_back({define->Name, define->Definition ? define->Definition : ""});
+            }
+        }
+
         template <typename T>
         void add(const std::string& define, const T& val) {
             m_definesVector.push_back({define, toStr(val)});
@@ -103,4 +113,41 @@ namespace toolkit::utilities::shader {
         mutable std::unique_ptr<D3D_SHADER_MACRO[]> m_defines;
     };
 
+    // Run a shader creation on a worker thread, or right away when the device cannot be used concurrently.
+    template <typename Shader, typename Create>
+    std::shared_future<std::shared_ptr<Shader>> CreateAsync(Create&& create, bool synchronous = false) {
+        if (synchronous) {
+            std::promise<std::shared_ptr<Shader>> promise;
+            try {
+                promise.set_value(create());
+            } catch (...) {
+                promise.set_exception(std::current_exception());
+            }
+            return promise.get_future().share();
+        }
+        return std::async(std::launch::async, std::forward<Create>(create)).share();
+    }
+
+    // Swap in a shader created asynchronously once it is ready. Until then (or if the compilation failed), the
+    // current shader is kept. Failures are only fatal when there is no shader to fall back to.
+    template <typename Shader>
+    void ResolveAsync(std::shared_future<std::shared_ptr<Shader>>& pending,
+                      std::shared_ptr<Shader>& shader,
+                      bool wait = false) {
+        if (!pending.valid() || (!wait && pending.wait_for(std::chrono::seconds(0)) != std::future_status::ready)) {
+            return;
+        }
+
+        try {
+            shader = pending.get();
+        } catch (std::exception& exc) {
+            if (!shader) {
+                pending = {};
+                throw;
+            }
+            Log("Failed to compile shader, keeping the previous one: %s\n", exc.what());
+        }
+        pending = {};
+    }
+
 } // namespace toolkit::utilities::shader
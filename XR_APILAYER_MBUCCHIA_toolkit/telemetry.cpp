@@ -0,0 +1,123 @@
+// MIT License
+//
+// Copyright(c) 2021-2022 Matthieu Bucchianeri
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this softwareand associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright noticeand this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "pch.h"
+
+#include "factories.h"
+#include "interfaces.h"
+#include "log.h"
+
+namespace {
+
+    using namespace toolkit;
+    using namespace toolkit::menu;
+    using namespace toolkit::log;
+
+    // A telemetry recorder writing to a memory-mapped ring file. Recording a frame is a copy into the mapping, the
+    // write-back to disk is left to the OS.
+    // The format is a header followed by a ring of FrameRecord. The header's writeIndex is the total number of records
+    // written, so the ring holds the records [max(writeIndex - capacity, 0), writeIndex) at (index % capacity).
+    class TelemetryRecorder : public ITelemetryRecorder {
+        static constexpr uint32_t Magic = 0x4d545258; // 'XRTM'
+
+        struct FileHeader {
+            uint32_t magic;
+            uint32_t version;
+            uint32_t recordSize;
+            uint32_t capacity;
+            volatile uint64_t writeIndex;
+            int64_t startTime;
+            uint8_t reserved[32];
+        };
+        static_assert(sizeof(FileHeader) == 64);
+
+      public:
+        TelemetryRecorder(const std::filesystem::path& path, uint32_t capacity) : m_capacity(capacity) {
+            // Allow reading the file while it is being recorded.
+            wil::unique_hfile file(CreateFileW(path.c_str(),
+                                               GENERIC_READ | GENERIC_WRITE,
+                                               FILE_SHARE_READ,
+                                               nullptr,
+                                               CREATE_ALWAYS,
+                                               FILE_ATTRIBUTE_NORMAL,
+                                               nullptr));
+            if (!file) {
+                Log("Failed to create telemetry file: %d\n", GetLastError());
+                return;
+            }
+
+            const uint64_t fileSize = sizeof(FileHeader) + uint64_t(capacity) * sizeof(FrameRecord);
+            wil::unique_handle mapping(CreateFileMappingW(
+                file.get(), nullptr, PAGE_READWRITE, (DWORD)(fileSize >> 32), (DWORD)fileSize, nullptr));
+            if (!mapping) {
+                Log("Failed to map telemetry file: %d\n", GetLastError());
+                return;
+            }
+
+            m_view.reset(reinterpret_cast<uint8_t*>(MapViewOfFile(mapping.get(), FILE_MAP_WRITE, 0, 0, 0)));
+            if (!m_view) {
+                Log("Failed to map telemetry file: %d\n", GetLastError());
+                return;
+            }
+
+            m_header = reinterpret_cast<FileHeader*>(m_view.get());
+            m_records = reinterpret_cast<FrameRecord*>(m_view.get() + sizeof(FileHeader));
+
+            m_header->magic = Magic;
+            m_header->version = TelemetryVersion;
+            m_header->recordSize = sizeof(FrameRecord);
+            m_header->capacity = capacity;
+            m_header->writeIndex = 0;
+            m_header->startTime = std::time(nullptr);
+
+            Log("Recording telemetry to '%s'\n", path.string().c_str());
+        }
+
+        void record(const FrameRecord& record) override {
+            if (!m_header) {
+                return;
+            }
+
+            // Publish the record only after it is fully written.
+            const uint64_t index = m_header->writeIndex;
+            m_records[index % m_capacity] = record;
+            MemoryBarrier();
+            m_header->writeIndex = index + 1;
+        }
+
+      private:
+        const uint32_t m_capacity;
+
+        wil::unique_mapview_ptr<uint8_t> m_view;
+        FileHeader* m_header{nullptr};
+        FrameRecord* m_records{nullptr};
+    };
+
+} // namespace
+
+namespace toolkit::menu {
+
+    std::shared_ptr<ITelemetryRecorder> CreateTelemetryRecorder(const std::filesystem::path& path, uint32_t capacity) {
+        return std::make_shared<TelemetryRecorder>(path, capacity);
+    }
+
+} // namespace toolkit::menu
@@ -25,8 +25,10 @@
 
 #include "factories.h"
 #include "interfaces.h"
+#include "layer.h"
 #include "shader_utilities.h"
 #include "log.h"
+#include "resource.h"
 
 namespace {
 
@@ -56,6 +58,120 @@ namespace {
         mutable clock::duration m_duration{0};
     };
 
+    // A hybrid sleep/spin frame limiter. The coarse part of the wait uses a high resolution waitable timer, and the
+    // last stretch is spent spinning. The sleep margin (how early to stop sleeping) is learnt from the observed
+    // oversleep, and a slow integrator corrects the remaining wake-up error.
+    class FrameLimiter : public IFrameLimiter {
+        using clock = std::chrono::steady_clock;
+
+        static constexpr auto MinSleepMargin = std::chrono::microseconds(200);
+        static constexpr auto MaxSleepMargin = std::chrono::microseconds(3000);
+        static constexpr auto MaxCorrection = std::chrono::microseconds(500);
+
+      public:
+        FrameLimiter() {
+            m_timer.reset(
+                CreateWaitableTimerExW(nullptr, nullptr, CREATE_WAITABLE_TIMER_HIGH_RESOLUTION, TIMER_ALL_ACCESS));
+            if (!m_timer) {
+                // High resolution timers require Windows 10 1803.
+                m_timer.reset(CreateWaitableTimerExW(nullptr, nullptr, 0, TIMER_ALL_ACCESS));
+            }
+        }
+
+        void wait(std::chrono::microseconds period, std::chrono::microseconds lead) override {
+            auto now = clock::now();
+
+            // (Re)start the pacing when we are not yet started, when the period changed, or when we fell behind by
+            // more than a frame.
+            if (m_deadline == clock::time_point{} || period != m_period || now > m_deadline + period) {
+                m_deadline = now;
+                m_period = period;
+                m_lastWakeUpError = {};
+                m_lastSpinTime = {};
+                return;
+            }
+
+            m_deadline += period;
+            const auto target = m_deadline - lead + m_correction;
+
+            // Coarse sleep.
+            const auto sleepUntil = target - m_sleepMargin;
+            if (now < sleepUntil) {
+                sleep(sleepUntil - now);
+
+                // Learn the oversleep (exponential moving average of the mean and the deviation), and keep a margin
+                // that absorbs most of it.
+                const auto afterSleep = clock::now();
+                const auto oversleep =
+                    std::chrono::duration_cast<std::chrono::microseconds>(afterSleep - sleepUntil).count();
+                m_oversleepMeanUs += (oversleep - m_oversleepMeanUs) / 8.0;
+                m_oversleepDevUs += (std::abs(oversleep - m_oversleepMeanUs) - m_oversleepDevUs) / 8.0;
+                m_sleepMargin = std::clamp(std::chrono::microseconds(static_cast<int64_t>(
+                                               m_oversleepMeanUs + 2.0 * m_oversleepDevUs)),
+                                           MinSleepMargin,
+                                           MaxSleepMargin);
+            }
+
+            // Fine spin for the last stretch.
+            const auto spinStart = clock::now();
+            while ((now = clock::now()) < target) {
+                if (target - now > std::chrono::microseconds(100)) {
+                    SwitchToThread();
+                } else {
+                    YieldProcessor();
+                }
+            }
+
+            m_lastSpinTime = std::chrono::duration_cast<std::chrono::microseconds>(now - spinStart);
+
+            // Slowly correct the systematic wake-up error (eg: when the spin overshoots). The deadlines themselves
+            // advance by exactly one period, so the error does not accumulate over frames.
+            m_lastWakeUpError = std::chrono::duration_cast<std::chrono::microseconds>(now - (m_deadline - lead));
+            m_correction = std::clamp(m_correction - m_lastWakeUpError / 16, -MaxCorrection, MaxCorrection);
+        }
+
+        void reset() override {
+            m_deadline = {};
+        }
+
+        std::chrono::microseconds getLastWakeUpError() const override {
+            return m_lastWakeUpError;
+        }
+
+        std::chrono::microseconds getLastSpinTime() const override {
+            return m_lastSpinTime;
+        }
+
+      private:
+        void sleep(clock::duration duration) {
+            if (m_timer) {
+                // Relative due time, in 100ns units.
+                LARGE_INTEGER dueTime;
+                dueTime.QuadPart = -std::max(
+                    std::chrono::duration_cast<std::chrono::duration<int64_t, std::ratio<1, 10000000>>>(duration)
+                        .count(),
+                    int64_t(1));
+                if (SetWaitableTimerEx(m_timer.get(), &dueTime, 0, nullptr, nullptr, nullptr, 0)) {
+                    WaitForSingleObject(m_timer.get(), INFINITE);
+                    return;
+                }
+            }
+            std::this_thread::sleep_for(duration);
+        }
+
+        wil::unique_handle m_timer;
+
+        clock::time_point m_deadline{};
+        std::chrono::microseconds m_period{0};
+        std::chrono::microseconds m_correction{0};
+        std::chrono::microseconds m_sleepMargin{1000};
+        double m_oversleepMeanUs{0.0};
+        double m_oversleepDevUs{0.0};
+
+        std::chrono::microseconds m_lastWakeUpError{0};
+        std::chrono::microseconds m_lastSpinTime{0};
+    };
+
 } // namespace
 
 namespace toolkit::config {
@@ -124,6 +240,49 @@ namespace toolkit::utilities {
         return data;
     }
 
+    std::map<std::string, int, std::less<>> RegGetDwords(HKEY hKey, const std::wstring& subKey) {
+        std::map<std::string, int, std::less<>> values;
+
+        HKEY key;
+        if (::RegOpenKeyEx(hKey, subKey.c_str(), 0, KEY_READ, &key) != ERROR_SUCCESS) {
+            return values;
+        }
+
+        DWORD maxNameLength = 0;
+        ::RegQueryInfoKey(key,
+                          nullptr,
+                          nullptr,
+                          nullptr,
+                          nullptr,
+                          nullptr,
+                          nullptr,
+                          nullptr,
+                          &maxNameLength,
+                          nullptr,
+                          nullptr,
+                          nullptr);
+
+        std::wstring name(maxNameLength + 1, L'\0');
+        for (DWORD i = 0;; i++) {
+            DWORD nameLength = (DWORD)name.size();
+            DWORD type;
+            DWORD data{};
+            DWORD dataSize = sizeof(data);
+            LONG retCode = ::RegEnumValue(
+                key, i, name.data(), &nameLength, nullptr, &type, reinterpret_cast<LPBYTE>(&data), &dataSize);
+            if (retCode == ERROR_NO_MORE_ITEMS) {
+                break;
+            }
+            if (retCode == ERROR_SUCCESS && type == REG_DWORD) {
+                values.insert_or_assign(xr::wide_to_utf8(std::wstring(name.data(), nameLength)), data);
+            }
+        }
+
+        ::RegCloseKey(key);
+
+        return values;
+    }
+
     void RegSetDword(HKEY hKey, const std::wstring& subKey, const std::wstring& value, DWORD dwordValue) {
         DWORD dataSize = sizeof(dwordValue);
         LONG retCode = ::RegSetKeyValue(hKey, subKey.c_str(), value.c_str(), REG_DWORD, &dwordValue, dataSize);
@@ -157,6 +316,10 @@ namespace toolkit::utilities {
         return std::make_shared<CpuTimer>();
     }
 
+    std::shared_ptr<IFrameLimiter> CreateFrameLimiter() {
+        return std::make_shared<FrameLimiter>();
+    }
+
     uint32_t GetScaledInputSize(uint32_t outputSize, int scalePercent, uint32_t blockSize) {
         scalePercent = abs(scalePercent);
         auto size = scalePercent >= 100 ? (outputSize * 100u) / scalePercent : (outputSize * scalePercent) / 100u;
@@ -370,14 +533,188 @@ namespace toolkit::utilities {
 
 } // namespace toolkit::utilities
 
-namespace toolkit::utilities::shader {
+namespace {
 
-    void CompileShader(const std::filesystem::path& shaderFile,
-                       const char* entryPoint,
-                       ID3DBlob** blob,
-                       const D3D_SHADER_MACRO* defines /*= nullptr*/,
-                       ID3DInclude* includes /* = nullptr*/,
-                       const char* target /* = "cs_5_0"*/) {
+    using namespace toolkit::log;
+
+    // An on-disk cache of compiled shaders. Each entry is a separate file named after the SHA-256 of everything that
+    // affects the compilation (the preprocessed source with all includes and defines resolved, the entry point, the
+    // target, the flags and the compiler version). Entries are immutable once written and they are published with an
+    // atomic rename, so several processes can share the cache without any locking.
+    // The cache is capped in size: entries are touched when they are loaded, and the least recently used ones (by
+    // last write time) are deleted when a new entry pushes the cache over the limit.
+    constexpr uint32_t ShaderCacheMagic = 0x43535258; // 'XRSC'
+    constexpr uint32_t ShaderCacheVersion = 1;
+    constexpr uint64_t ShaderCacheMaxSize = 64 * 1024 * 1024;
+
+    using ShaderCacheKey = std::array<uint8_t, 32>;
+
+    struct ShaderCacheHeader {
+        uint32_t magic;
+        uint32_t version;
+        ShaderCacheKey key;
+        uint32_t size;
+        uint32_t reserved;
+    };
+
+    std::optional<ShaderCacheKey> ComputeShaderCacheKey(ID3DBlob* preprocessed,
+                                                        const char* entryPoint,
+                                                        const char* target,
+                                                        DWORD flags) {
+        wil::unique_bcrypt_algorithm algorithm;
+        wil::unique_bcrypt_hash hash;
+        if (!BCRYPT_SUCCESS(BCryptOpenAlgorithmProvider(&algorithm, BCRYPT_SHA256_ALGORITHM, nullptr, 0)) ||
+            !BCRYPT_SUCCESS(BCryptCreateHash(algorithm.get(), &hash, nullptr, 0, nullptr, 0, 0))) {
+            return {};
+        }
+
+        const auto update = [&](const void* data, size_t size) {
+            return BCRYPT_SUCCESS(BCryptHashData(hash.get(), (PUCHAR)data, (ULONG)size, 0));
+        };
+        const uint32_t versions[] = {ShaderCacheVersion, D3D_COMPILER_VERSION, flags};
+        if (!update(versions, sizeof(versions)) || !update(entryPoint, strlen(entryPoint) + 1) ||
+            !update(target, strlen(target) + 1) ||
+            !update(preprocessed->GetBufferPointer(), preprocessed->GetBufferSize())) {
+            return {};
+        }
+
+        ShaderCacheKey key;
+        if (!BCRYPT_SUCCESS(BCryptFinishHash(hash.get(), key.data(), (ULONG)key.size(), 0))) {
+            return {};
+        }
+        return key;
+    }
+
+    std::filesystem::path GetShaderCachePath(const ShaderCacheKey& key) {
+        std::string name;
+        for (const auto byte : key) {
+            name += fmt::format("{:02x}", byte);
+        }
+        return toolkit::localAppData / "shader_cache" / (name + ".cso");
+    }
+
+    bool LoadFromShaderCache(const ShaderCacheKey& key, ID3DBlob** blob) {
+        const auto path = GetShaderCachePath(key);
+        wil::unique_hfile file(CreateFileW(path.c_str(),
+                                           GENERIC_READ,
+                                           FILE_SHARE_READ | FILE_SHARE_DELETE,
+                                           nullptr,
+                                           OPEN_EXISTING,
+                                           FILE_ATTRIBUTE_NORMAL,
+                                           nullptr));
+        if (!file) {
+            return false;
+        }
+
+        ShaderCacheHeader header{};
+        DWORD read = 0;
+        if (!ReadFile(file.get(), &header, sizeof(header), &read, nullptr) || read != sizeof(header) ||
+            header.magic != ShaderCacheMagic || header.version != ShaderCacheVersion || header.key != key) {
+            return false;
+        }
+
+        ComPtr<ID3DBlob> data;
+        if (FAILED(D3DCreateBlob(header.size, set(data))) ||
+            !ReadFile(file.get(), data->GetBufferPointer(), header.size, &read, nullptr) || read != header.size) {
+            return false;
+        }
+
+        *blob = data.Detach();
+
+        // Mark the entry as recently used, so it is the last one to be trimmed.
+        std::error_code ec;
+        std::filesystem::last_write_time(path, std::filesystem::file_time_type::clock::now(), ec);
+
+        return true;
+    }
+
+    // Delete the least recently used entries until the cache fits within ShaderCacheMaxSize.
+    void TrimShaderCache() {
+        struct Entry {
+            std::filesystem::path path;
+            std::filesystem::file_time_type lastWriteTime;
+            uintmax_t size;
+        };
+
+        std::vector<Entry> entries;
+        uintmax_t totalSize = 0;
+        std::error_code ec;
+        for (std::filesystem::directory_iterator it(toolkit::localAppData / "shader_cache", ec), end; !ec && it != end;
+             it.increment(ec)) {
+            if (it->path().extension() != ".cso") {
+                continue;
+            }
+
+            // The entry may have been deleted by another process.
+            std::error_code entryEc;
+            Entry entry{it->path(), it->last_write_time(entryEc), it->file_size(entryEc)};
+            if (entryEc) {
+                continue;
+            }
+            totalSize += entry.size;
+            entries.push_back(std::move(entry));
+        }
+        if (totalSize <= ShaderCacheMaxSize) {
+            return;
+        }
+
+        std::sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) {
+            return a.lastWriteTime < b.lastWriteTime;
+        });
+        for (const auto& entry : entries) {
+            if (totalSize <= ShaderCacheMaxSize) {
+                break;
+            }
+
+            // Entries are opened with FILE_SHARE_DELETE, so this does not disturb a concurrent load.
+            if (std::filesystem::remove(entry.path, ec)) {
+                TraceLoggingWrite(g_traceProvider, "ShaderCache_Trim", TLArg(entry.path.string().c_str(), "Path"));
+            }
+            totalSize -= entry.size;
+        }
+    }
+
+    void StoreToShaderCache(const ShaderCacheKey& key, ID3DBlob* blob) {
+        const auto path = GetShaderCachePath(key);
+
+        // Write to a file that is unique to this thread, then publish it. If another process published the same entry
+        // first, we simply discard ours.
+        auto tempPath = path;
+        tempPath += fmt::format(".{}.{}.tmp", GetCurrentProcessId(), GetCurrentThreadId());
+        {
+            wil::unique_hfile file(CreateFileW(
+                tempPath.c_str(), GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr));
+            if (!file) {
+                return;
+            }
+
+            const ShaderCacheHeader header{
+                ShaderCacheMagic, ShaderCacheVersion, key, static_cast<uint32_t>(blob->GetBufferSize()), 0};
+            DWORD written = 0;
+            if (!WriteFile(file.get(), &header, sizeof(header), &written, nullptr) || written != sizeof(header) ||
+                !WriteFile(file.get(), blob->GetBufferPointer(), header.size, &written, nullptr) ||
+                written != header.size) {
+                file.reset();
+                DeleteFileW(tempPath.c_str());
+                return;
+            }
+        }
+        if (!MoveFileExW(tempPath.c_str(), path.c_str(), 0)) {
+            DeleteFileW(tempPath.c_str());
+            return;
+        }
+
+        TrimShaderCache();
+    }
+
+    void CompileShaderCached(const void* data,
+                             size_t size,
+                             const char* sourceName,
+                             const char* entryPoint,
+                             ID3DBlob** blob,
+                             const D3D_SHADER_MACRO* defines,
+                             ID3DInclude* includes,
+                             const char* target) {
         DWORD flags =
             D3DCOMPILE_PACK_MATRIX_COLUMN_MAJOR | D3DCOMPILE_ENABLE_STRICTNESS | D3DCOMPILE_WARNINGS_ARE_ERRORS;
 #ifdef _DEBUG
@@ -385,51 +722,310 @@ namespace toolkit::utilities::shader {
 #else
         flags |= D3DCOMPILE_OPTIMIZATION_LEVEL3;
 #endif
-        if (!includes) {
+        if (!includes && sourceName) {
+            // Note: relative includes are derived from sourceName.
             includes = D3D_COMPILE_STANDARD_FILE_INCLUDE;
         }
 
+        // Preprocessing is cheap compared to the compilation, and it gives us a key that covers all the includes (as
+        // resolved by the include handler) and defines.
+        std::optional<ShaderCacheKey> key;
+        {
+            ComPtr<ID3DBlob> preprocessed;
+            if (SUCCEEDED(D3DPreprocess(data, size, sourceName, defines, includes, set(preprocessed), nullptr))) {
+                key = ComputeShaderCacheKey(get(preprocessed), entryPoint, target, flags);
+            }
+        }
+        if (key && LoadFromShaderCache(*key, blob)) {
+            TraceLoggingWrite(g_traceProvider,
+                              "ShaderCache_Hit",
+                              TLArg(sourceName ? sourceName : "", "Source"),
+                              TLArg(entryPoint, "Entry"));
+            return;
+        }
+
         ComPtr<ID3DBlob> cdErrorBlob;
         const HRESULT hr =
-            D3DCompileFromFile(shaderFile.c_str(), defines, includes, entryPoint, target, flags, 0, blob, &cdErrorBlob);
+            D3DCompile(data, size, sourceName, defines, includes, entryPoint, target, flags, 0, blob, &cdErrorBlob);
 
         if (FAILED(hr)) {
             if (cdErrorBlob) {
                 Log("%s", (char*)cdErrorBlob->GetBufferPointer());
             }
-            CHECK_HRESULT(hr, "Failed to compile shader file");
+            CHECK_HRESULT(hr, "Failed to compile shader");
+        }
+
+        TraceLoggingWrite(g_traceProvider,
+                          "ShaderCache_Miss",
+                          TLArg(sourceName ? sourceName : "", "Source"),
+                          TLArg(entryPoint, "Entry"));
+        if (key) {
+            StoreToShaderCache(*key, *blob);
         }
     }
 
-    void CompileShader(const void* data,
-                       size_t size,
+    // The bundle of precompiled shaders embedded in the DLL (see shader_bundle_generator.py). Each entry is keyed by
+    // the file name, entry point, target and defines, and it records the hash of the source files it was compiled from
+    // (including the headers), so that modifications made to the shaders after installation are still picked up.
+    constexpr uint32_t ShaderBundleMagic = 0x42535258; // 'XRSB'
+    constexpr uint32_t ShaderBundleVersion = 2;
+
+    struct ShaderBundleHeader {
+        uint32_t magic;
+        uint32_t version;
+        uint32_t count;
+        uint32_t reserved;
+    };
+
+    struct ShaderBundleEntry {
+        uint32_t keyOffset;
+        uint32_t keySize;
+        uint32_t dataOffset;
+        uint32_t dataSize;
+        std::array<uint8_t, 32> sourceHash;
+    };
+
+    using ShaderBundle = std::map<std::string, const ShaderBundleEntry*, std::less<>>;
+
+    const uint8_t* LoadShaderBundle(ShaderBundle& bundle) {
+        HMODULE module;
+        if (!GetModuleHandleExA(GET_MODULE_HANDLE_EX_FLAG_FROM_ADDRESS | GET_MODULE_HANDLE_EX_FLAG_UNCHANGED_REFCOUNT,
+                                (LPCSTR)&LoadShaderBundle,
+                                &module)) {
+            return nullptr;
+        }
+
+        // The resource memory remains valid for as long as the DLL is loaded.
+        const auto resource = FindResource(module, MAKEINTRESOURCE(IDR_SHADER_BUNDLE), RT_RCDATA);
+        const auto handle = resource ? LoadResource(module, resource) : nullptr;
+        const auto data = handle ? reinterpret_cast<const uint8_t*>(LockResource(handle)) : nullptr;
+        if (!data) {
+            return nullptr;
+        }
+        const size_t size = SizeofResource(module, resource);
+
+        ShaderBundleHeader header;
+        if (size < sizeof(header)) {
+            return nullptr;
+        }
+        memcpy(&header, data, sizeof(header));
+        if (header.magic != ShaderBundleMagic || header.version != ShaderBundleVersion ||
+            size < sizeof(header) + header.count * sizeof(ShaderBundleEntry)) {
+            Log("Shader bundle is invalid\n");
+            return nullptr;
+        }
+
+        const auto entries = reinterpret_cast<const ShaderBundleEntry*>(data + sizeof(header));
+        for (uint32_t i = 0; i < header.count; i++) {
+            const auto& entry = entries[i];
+            if ((uint64_t)entry.keyOffset + entry.keySize > size ||
+                (uint64_t)entry.dataOffset + entry.dataSize > size) {
+                Log("Shader bundle is invalid\n");
+                bundle.clear();
+                return nullptr;
+            }
+            bundle.insert_or_assign(
+                std::string(reinterpret_cast<const char*>(data + entry.keyOffset), entry.keySize), &entry);
+        }
+
+        return data;
+    }
+
+    // Returns the file names from the #include "..." directives, in order. The preprocessor conditions are ignored.
+    std::vector<std::string> FindIncludes(const std::string& source) {
+        std::vector<std::string> includes;
+        size_t lineStart = 0;
+        while (lineStart < source.size()) {
+            size_t lineEnd = source.find('\n', lineStart);
+            if (lineEnd == std::string::npos) {
+                lineEnd = source.size();
+            }
+
+            const auto skipBlanks = [&](size_t pos) {
+                while (pos < lineEnd && (source[pos] == ' ' || source[pos] == '\t')) {
+                    pos++;
+                }
+                return pos;
+            };
+            size_t pos = skipBlanks(lineStart);
+            if (pos < lineEnd && source[pos] == '#') {
+                pos = skipBlanks(pos + 1);
+                if (source.compare(pos, 7, "include") == 0) {
+                    pos = skipBlanks(pos + 7);
+                    if (pos < lineEnd && source[pos] == '"') {
+                        const size_t nameEnd = source.find_first_of("\"\r", pos + 1);
+                        if (nameEnd != std::string::npos && nameEnd < lineEnd && source[nameEnd] == '"' &&
+                            nameEnd > pos + 1) {
+                            includes.push_back(source.substr(pos + 1, nameEnd - pos - 1));
+                        }
+                    }
+                }
+            }
+
+            lineStart = lineEnd + 1;
+        }
+        return includes;
+    }
+
+    // Must match source_hash() in shader_bundle_generator.py: the hash covers the shader file and all the files it
+    // includes (depth-first, each file only once), as "<name>\0<contents>". Includes are resolved relative to the
+    // including file, like D3D_COMPILE_STANDARD_FILE_INCLUDE does, unless a custom include handler is given: the
+    // contents are then the ones it resolves, so that a handler pointing to other headers than the bundle was built
+    // with invalidates the entry.
+    std::optional<std::array<uint8_t, 32>> ComputeSourceHash(const std::filesystem::path& shaderFile,
+                                                             const std::string& source,
+                                                             ID3DInclude* includes) {
+        wil::unique_bcrypt_algorithm algorithm;
+        wil::unique_bcrypt_hash hash;
+        if (!BCRYPT_SUCCESS(BCryptOpenAlgorithmProvider(&algorithm, BCRYPT_SHA256_ALGORITHM, nullptr, 0)) ||
+            !BCRYPT_SUCCESS(BCryptCreateHash(algorithm.get(), &hash, nullptr, 0, nullptr, 0, 0))) {
+            return {};
+        }
+
+        const auto update = [&](const void* data, size_t size) {
+            return BCRYPT_SUCCESS(BCryptHashData(hash.get(), (PUCHAR)data, (ULONG)size, 0));
+        };
+
+        std::set<std::wstring> visited;
+        std::function<bool(const std::filesystem::path&, const std::string&, const std::string*)> visit =
+            [&](const std::filesystem::path& path, const std::string& name, const std::string* contents) {
+                auto key = path.lexically_normal().wstring();
+                std::transform(key.begin(), key.end(), key.begin(), towlower);
+                if (!visited.insert(key).second) {
+                    return true;
+                }
+
+                if (!update(name.c_str(), name.size() + 1)) {
+                    return false;
+                }
+
+                std::string included;
+                if (!contents) {
+                    // A missing include only contributes its name.
+                    if (includes && includes != D3D_COMPILE_STANDARD_FILE_INCLUDE) {
+                        LPCVOID data = nullptr;
+                        UINT bytes = 0;
+                        try {
+                            if (FAILED(includes->Open(D3D_INCLUDE_LOCAL, name.c_str(), nullptr, &data, &bytes))) {
+                                return true;
+                            }
+                        } catch (std::runtime_error&) {
+                            // IncludeHeader throws when the file is not found.
+                            return true;
+                        }
+                        included.assign(reinterpret_cast<const char*>(data), bytes);
+                        includes->Close(data);
+                    } else {
+                        std::ifstream file(path, std::ios_base::binary);
+                        if (!file.is_open()) {
+                            return true;
+                        }
+                        included.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+                    }
+                    contents = &included;
+                }
+                if (!update(contents->data(), contents->size())) {
+                    return false;
+                }
+
+                for (const auto& include : FindIncludes(*contents)) {
+                    if (!visit(path.parent_path() / include, include, nullptr)) {
+                        return false;
+                    }
+                }
+                return true;
+            };
+
+        std::array<uint8_t, 32> digest;
+        if (!visit(shaderFile, shaderFile.filename().string(), &source) ||
+            !BCRYPT_SUCCESS(BCryptFinishHash(hash.get(), digest.data(), (ULONG)digest.size(), 0))) {
+            return {};
+        }
+        return digest;
+    }
+
+    bool LoadFromShaderBundle(const std::filesystem::path& shaderFile,
+                              const std::string& source,
+                              const char* entryPoint,
+                              ID3DBlob** blob,
+                              const D3D_SHADER_MACRO* defines,
+                              ID3DInclude* includes,
+                              const char* target) {
+        static std::once_flag once;
+        static ShaderBundle bundle;
+        static const uint8_t* bundleData = nullptr;
+        std::call_once(once, [] { bundleData = LoadShaderBundle(bundle); });
+        if (!bundleData) {
+            return false;
+        }
+
+        // Must match make_key() in shader_bundle_generator.py.
+        std::string key = fmt::format("{}|{}|{}|", shaderFile.filename().string(), entryPoint, target);
+        for (auto define = defines; define && define->Name; define++) {
+            key += fmt::format("{}={};", define->Name, define->Definition ? define->Definition : "");
+        }
+
+        const auto it = bundle.find(key);
+        if (it == bundle.end()) {
+            return false;
+        }
+
+        // The shader was modified since the bundle was built.
+        const auto& entry = *it->second;
+        const auto sourceHash = ComputeSourceHash(shaderFile, source, includes);
+        if (!sourceHash || *sourceHash != entry.sourceHash) {
+            return false;
+        }
+
+        ComPtr<ID3DBlob> data;
+        if (FAILED(D3DCreateBlob(entry.dataSize, set(data)))) {
+            return false;
+        }
+        memcpy(data->GetBufferPointer(), bundleData + entry.dataOffset, entry.dataSize);
+
+        TraceLoggingWrite(g_traceProvider,
+                          "ShaderBundle_Hit",
+                          TLArg(shaderFile.string().c_str(), "Source"),
+                          TLArg(entryPoint, "Entry"));
+        *blob = data.Detach();
+        return true;
+    }
+
+} // namespace
+
+namespace toolkit::utilities::shader {
+
+    void CompileShader(const std::filesystem::path& shaderFile,
                        const char* entryPoint,
                        ID3DBlob** blob,
                        const D3D_SHADER_MACRO* defines /*= nullptr*/,
                        ID3DInclude* includes /* = nullptr*/,
                        const char* target /* = "cs_5_0"*/) {
-        DWORD flags =
-            D3DCOMPILE_PACK_MATRIX_COLUMN_MAJOR | D3DCOMPILE_ENABLE_STRICTNESS | D3DCOMPILE_WARNINGS_ARE_ERRORS;
-#ifdef _DEBUG
-        flags |= D3DCOMPILE_SKIP_OPTIMIZATION | D3DCOMPILE_DEBUG;
-#else
-        flags |= D3DCOMPILE_OPTIMIZATION_LEVEL3;
-#endif
-        if (!includes) {
-            // TODO: pSourceName must be a file name to derive relative paths from.
-            includes = D3D_COMPILE_STANDARD_FILE_INCLUDE;
+        std::ifstream file(shaderFile, std::ios_base::binary);
+        if (!file.is_open()) {
+            throw std::runtime_error("Failed to open shader file");
         }
+        const std::string source((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
 
-        ComPtr<ID3DBlob> cdErrorBlob;
-        const HRESULT hr =
-            D3DCompile(data, size, nullptr, defines, includes, entryPoint, target, flags, 0, blob, &cdErrorBlob);
-
-        if (FAILED(hr)) {
-            if (cdErrorBlob) {
-                Log("%s", (char*)cdErrorBlob->GetBufferPointer());
-            }
-            CHECK_HRESULT(hr, "Failed to compile shader");
+        // Only shaders modified after the build need to be compiled.
+        if (LoadFromShaderBundle(shaderFile, source, entryPoint, blob, defines, includes, target)) {
+            return;
         }
+
+        CompileShaderCached(
+            source.data(), source.size(), shaderFile.string().c_str(), entryPoint, blob, defines, includes, target);
+    }
+
+    void CompileShader(const void* data,
+                       size_t size,
+                       const char* entryPoint,
+                       ID3DBlob** blob,
+                       const D3D_SHADER_MACRO* defines /*= nullptr*/,
+                       ID3DInclude* includes /* = nullptr*/,
+                       const char* target /* = "cs_5_0"*/) {
+        // There is no file to derive relative paths from: the #include directives are only resolved through the
+        // include handler, and they fail without one (rather than being looked up in the application's directory).
+        CompileShaderCached(data, size, nullptr, entryPoint, blob, defines, includes, target);
     }
 
     HRESULT IncludeHeader::Open(
@@ -28,6 +28,7 @@
 #include "interfaces.h"
 #include "layer.h"
 #include "log.h"
+#include "profiler.h"
 
 #define CHECK_NVCMD(cmd) xr::detail::_CheckNVResult(cmd, #cmd, FILE_AND_LINE)
 
@@ -222,6 +223,8 @@ namespace {
         }
 
         void beginFrame(XrTime frameTime) override {
+            ProfileZone("VariableRateShader::beginFrame");
+
             if (m_HAM[0] && m_HAM[1] && !m_isHAMReady) {
                 // Create projection for stamping HAM.
                 XrViewLocateInfo info{XR_TYPE_VIEW_LOCATE_INFO};
@@ -260,6 +263,7 @@ namespace {
 
             m_device->blockCallbacks();
             m_device->saveContext();
+            m_device->startGpuStage(GpuStage::VRSMask);
 
             {
                 std::unique_lock lock(m_shadingRateMaskLock);
@@ -307,6 +311,7 @@ namespace {
                 }
             }
 
+            m_device->stopGpuStage(GpuStage::VRSMask);
             m_device->restoreContext();
             m_device->flushContext(false, false);
             m_device->unblockCallbacks();
@@ -345,9 +350,14 @@ namespace {
             if (mode != VariableShadingRateType::None) {
                 const bool usingEyeTracking = m_eyeTracker && m_configManager->getValue(SettingEyeTrackingEnabled);
 
-                const auto hasPatternChanged =
-                    m_usingEyeTracking != usingEyeTracking || hasModeChanged || checkUpdateRings(mode);
-                const auto hasQualityChanged = hasModeChanged || checkUpdateRates(mode);
+                // Only look at the individual settings when one of them changed.
+                const auto configGeneration = m_configManager->getGeneration(SettingGroup::VRS);
+                const auto hasConfigChanged = configGeneration != m_configGeneration;
+                m_configGeneration = configGeneration;
+
+                const auto hasPatternChanged = m_usingEyeTracking != usingEyeTracking || hasModeChanged ||
+                                               (hasConfigChanged && checkUpdateRings(mode));
+                const auto hasQualityChanged = hasModeChanged || (hasConfigChanged && checkUpdateRates(mode));
 
                 m_usingEyeTracking = usingEyeTracking;
 
@@ -366,6 +376,10 @@ namespace {
                     m_currentGen++;
                 }
 
+                // The masks are updated from the application's rendering thread, using the config snapshot. We
+                // acknowledge the config change here.
+                (void)m_configManager->getValue(SettingVRSCullHAM);
+
                 // We can't use config's hasChanged since we don't own this setting.
                 m_isHAMEnabled = isHAMEnabled;
 
@@ -478,6 +492,17 @@ namespace {
             m_gazeOffset[1] = right;
         }
 
+        bool getFoveation(Foveation& foveation, Eye eye) const override {
+            if (m_mode == VariableShadingRateType::None) {
+                return false;
+            }
+
+            // The inner ring is rendered at full rate.
+            foveation.gaze = m_gazeLocation[(size_t)eye];
+            foveation.ring = m_Rings[0];
+            return true;
+        }
+
         uint8_t getMaxRate() const override {
             return static_cast<uint8_t>(m_tileRateMax);
         }
@@ -851,6 +876,9 @@ namespace {
             }
             mask.gen = m_currentGen;
 
+            // We are on the application's rendering thread.
+            const auto snapshot = m_configManager->getSnapshot();
+
             TraceLocalActivity(local);
             TraceLoggingWriteStart(local,
                                    "VariableRateShading_UpdateMask",
@@ -863,8 +891,8 @@ namespace {
                     0.f, 0.f, (float)mask.heightInTiles, (float)mask.widthInTiles, {255.f, 255.f, 255.f, 255.f});
 
                 // Initialize mask with HAM culling if needed.
-                if (i < ViewCount && m_isHAMReady && !m_configManager->peekValue(SettingDisableHAM) &&
-                    m_configManager->getValue(SettingVRSCullHAM)) {
+                if (i < ViewCount && m_isHAMReady && !snapshot.getValue(SettingDisableHAM) &&
+                    snapshot.getValue(SettingVRSCullHAM)) {
                     m_device->setViewProjection(m_viewProjection[i]);
                     m_device->draw(m_HAM[i], Pose::Identity(), {1.f, 1.f, 1.f}, true);
                 }
@@ -1093,6 +1121,7 @@ namespace {
         uint64_t m_currentGen{0};
 
         VariableShadingRateType m_mode{VariableShadingRateType::None};
+        uint64_t m_configGeneration{0};
 
         // ShadingConstants
         XrVector2f m_gazeOffset[ViewCount + 1];
@@ -0,0 +1,245 @@
+# MIT License
+#
+# Copyright(c) 2022 Matthieu Bucchianeri
+#
+# Permission is hereby granted, free of charge, to any person obtaining a copy
+# of this softwareand associated documentation files(the "Software"), to deal
+# in the Software without restriction, including without limitation the rights
+# to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+# copies of the Software, and to permit persons to whom the Software is
+# furnished to do so, subject to the following conditions :
+#
+# The above copyright noticeand this permission notice shall be included in all
+# copies or substantial portions of the Software.
+#
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+# IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+# AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+# LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+# OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+# SOFTWARE.
+
+# Converts a telemetry file recorded with "record_stats" (stats_*.bin) into a per-frame CSV file, a windowed CSV file
+# and a percentile report.
+#
+# Usage: convert_telemetry.py <stats_*.bin> [--window-ms <ms>]
+#
+# The per-frame CSV is written to <stats_*>_frames.csv. The windowed CSV is written to <stats_*>_windows.csv and uses
+# the same columns and the same percentile estimator (utilities::LogHistogram) as the stats_*.csv file written by the
+# layer, so that both can be compared directly. The default window (1000ms) matches the layer, use 100 to match the
+# "high rate" statistics.
+#
+# The file layout must match menu::FrameRecord and the TelemetryRecorder header (see interfaces.h and telemetry.cpp).
+
+import argparse
+import datetime
+import os
+import struct
+import sys
+
+MAGIC = 0x4d545258
+VERSION = 3
+
+# uint32 magic, uint32 version, uint32 recordSize, uint32 capacity, uint64 writeIndex, int64 startTime, 32 reserved.
+HEADER = struct.Struct('<IIIIQq32x')
+
+TIMING_NAMES = ['app CPU', 'rdr CPU', 'app GPU', 'wait', 'lay CPU', 'scl GPU', 'pst GPU', 'ovl CPU', 'ovl GPU',
+                'hnd CPU', 'vrs GPU']
+APP_CPU, RENDER_CPU, APP_GPU = 0, 1, 2
+
+COUNTER_NAMES = ['hookCalls', 'GPU waits', 'desc alloc', 'desc reserved', 'desc free', 'desc ring', 'desc peak',
+                 'desc stalls', 'cb uploads', 'cb skipped', 'cb ring', 'cb peak', 'cb stalls']
+
+RECORD = struct.Struct('<Qqq' + 'Q' * len(TIMING_NAMES) + 'QqQQ' + 'f' + 'f' * 8 + 'IIII' + 'BBBB' + 'Q' +
+                       'I' * len(COUNTER_NAMES) + '4x')
+assert RECORD.size == 264
+
+
+class LogHistogram:
+    """Port of utilities::LogHistogram, see interfaces.h."""
+    SUB_BUCKET_BITS = 3
+    SUB_BUCKET_COUNT = 1 << SUB_BUCKET_BITS
+    MAX_EXPONENT = 32
+    BUCKET_COUNT = (MAX_EXPONENT - SUB_BUCKET_BITS + 1) * SUB_BUCKET_COUNT
+
+    def __init__(self):
+        self.buckets = [0] * self.BUCKET_COUNT
+        self.count = 0
+        self.max = 0
+
+    def record(self, value):
+        self.buckets[self.bucket_index(value)] += 1
+        self.count += 1
+        self.max = max(self.max, value)
+
+    def percentile(self, percentile):
+        if not self.count:
+            return 0
+
+        rank = max((self.count * percentile + 99) // 100, 1)
+        seen = 0
+        for i in range(self.BUCKET_COUNT):
+            seen += self.buckets[i]
+            if seen >= rank:
+                return min(self.bucket_upper_bound(i), self.max)
+        return self.max
+
+    @classmethod
+    def bucket_index(cls, value):
+        if value < cls.SUB_BUCKET_COUNT:
+            return value
+
+        exponent = value.bit_length() - 1
+        if exponent >= cls.MAX_EXPONENT:
+            return cls.BUCKET_COUNT - 1
+
+        sub_bucket = (value >> (exponent - cls.SUB_BUCKET_BITS)) & (cls.SUB_BUCKET_COUNT - 1)
+        return (exponent - cls.SUB_BUCKET_BITS + 1) * cls.SUB_BUCKET_COUNT + sub_bucket
+
+    @classmethod
+    def bucket_upper_bound(cls, index):
+        if index < cls.SUB_BUCKET_COUNT:
+            return index
+
+        exponent = index // cls.SUB_BUCKET_COUNT + cls.SUB_BUCKET_BITS - 1
+        sub_bucket = index % cls.SUB_BUCKET_COUNT
+        width = 1 << (exponent - cls.SUB_BUCKET_BITS)
+        return (1 << exponent) + (sub_bucket + 1) * width - 1
+
+
+def exact_percentile(sorted_values, percentile):
+    if not sorted_values:
+        return 0
+    rank = max((len(sorted_values) * percentile + 99) // 100, 1)
+    return sorted_values[rank - 1]
+
+
+def read_records(path):
+    with open(path, 'rb') as file:
+        magic, version, record_size, capacity, write_index, start_time = HEADER.unpack(file.read(HEADER.size))
+        if magic != MAGIC:
+            sys.exit(f'{path} is not a telemetry file')
+        if version != VERSION or record_size != RECORD.size:
+            sys.exit(f'Unsupported telemetry version {version} (record size {record_size})')
+
+        # The ring holds the last capacity records.
+        first = max(write_index - capacity, 0)
+        print(f'Recorded {write_index} frames starting {datetime.datetime.fromtimestamp(start_time)}, '
+              f'converting the last {write_index - first}')
+
+        records = []
+        for index in range(first, write_index):
+            file.seek(HEADER.size + (index % capacity) * record_size)
+            records.append(RECORD.unpack(file.read(record_size)))
+        return start_time, records
+
+
+def unpack_record(values):
+    n = len(TIMING_NAMES)
+    record = {
+        'frame': values[0],
+        'time': values[1],
+        'predictedDisplayTime': values[2],
+        'timings': values[3:3 + n],
+    }
+    (record['prediction'], record['throttleError'], record['throttleSpin'], record['vramUsedSize'],
+     record['icd']) = values[3 + n:8 + n]
+    record['fov'] = [values[8 + n:12 + n], values[12 + n:16 + n]]
+    (record['biased'], record['vrsRtv'], record['renderWidth'], record['turboStalls'], record['vramUsedPercent'],
+     record['heuristic'], record['flags'], _) = values[16 + n:24 + n]
+    record['hookCpu'] = values[24 + n]
+    record['counters'] = values[25 + n:25 + n + len(COUNTER_NAMES)]
+    return record
+
+
+def write_frames(path, records):
+    with open(path, 'w') as file:
+        header = ['frame', 'time (us)', 'predictedDisplayTime'] + [f'{name} (us)' for name in TIMING_NAMES]
+        header += ['prediction (us)', 'thr error (us)', 'thr spin (us)', 'VRAM (MB)', 'ICD', 'FOV L', 'FOV R',
+                   'biased', 'VRS RTV', 'VRSw', 'turbo stalls', 'VRAM (%)', 'heur', 'pipelining', 'buffers',
+                   'hook CPU (us)'] + COUNTER_NAMES
+        file.write(','.join(header) + '\n')
+
+        for r in records:
+            flags = r['flags']
+            buffers = ''.join(letter if flags & bit else '_' for bit, letter in ((2, 'C'), (4, 'D'), (8, 'C'),
+                                                                                (16, 'D')))
+            row = [r['frame'], r['time'], r['predictedDisplayTime']] + list(r['timings'])
+            row += [r['prediction'], r['throttleError'], r['throttleSpin'], r['vramUsedSize'] // (1024 * 1024),
+                    f"{r['icd']:g}"] + [' '.join(f'{v:g}' for v in fov) for fov in r['fov']]
+            row += [r['biased'], r['vrsRtv'], r['renderWidth'], r['turboStalls'], r['vramUsedPercent'],
+                    r['heuristic'], flags & 1, buffers, r['hookCpu']] + list(r['counters'])
+            file.write(','.join(str(v) for v in row) + '\n')
+
+
+def write_windows(path, start_time, records, window_us):
+    with open(path, 'w') as file:
+        # Same columns as the stats_*.csv file written by the layer.
+        header = ['time', 'FPS', 'appCPU (us)', 'renderCPU (us)', 'appGPU (us)', 'VRAM (MB)', 'VRAM (%)']
+        for name in TIMING_NAMES:
+            header += [f'{name} p50 (us)', f'{name} p95 (us)', f'{name} p99 (us)', f'{name} max (us)']
+        file.write(','.join(header) + '\n')
+
+        def flush(window, window_start, window_end):
+            histograms = [LogHistogram() for _ in TIMING_NAMES]
+            sums = [0] * len(TIMING_NAMES)
+            for r in window:
+                for i, timing in enumerate(r['timings']):
+                    histograms[i].record(timing)
+                    sums[i] += timing
+
+            timestamp = datetime.datetime.fromtimestamp(start_time + window_end / 1e6).astimezone()
+            fps = len(window) * 1e6 / max(window_end - window_start, 1)
+            last = window[-1]
+            row = [timestamp.strftime('%Y-%m-%d %H:%M:%S %z'), f'{fps:.1f}']
+            row += [sums[i] // len(window) for i in (APP_CPU, RENDER_CPU, APP_GPU)]
+            row += [last['vramUsedSize'] // (1024 * 1024), last['vramUsedPercent']]
+            for histogram in histograms:
+                row += [histogram.percentile(50), histogram.percentile(95), histogram.percentile(99), histogram.max]
+            file.write(','.join(str(v) for v in row) + '\n')
+
+        # Like the layer, a window closes on the first frame past its duration.
+        window = []
+        window_start = records[0]['time'] if records else 0
+        for r in records:
+            window.append(r)
+            if r['time'] - window_start >= window_us:
+                flush(window, window_start, r['time'])
+                window = []
+                window_start = r['time']
+        if window:
+            flush(window, window_start, window[-1]['time'])
+
+
+def print_report(records):
+    series = [('frame time', [b['time'] - a['time'] for a, b in zip(records, records[1:])])]
+    series += [(name, [r['timings'][i] for r in records]) for i, name in enumerate(TIMING_NAMES)]
+    series += [('hook CPU', [r['hookCpu'] for r in records])]
+
+    print(f"{'Counter':<12}{'p50 (us)':>10}{'p95 (us)':>10}{'p99 (us)':>10}{'max (us)':>10}")
+    for name, values in series:
+        values = sorted(values)
+        print(f'{name:<12}' + ''.join(f'{exact_percentile(values, p):>10}' for p in (50, 95, 99, 100)))
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Convert an OpenXR Toolkit telemetry file.')
+    parser.add_argument('path', help='stats_*.bin file')
+    parser.add_argument('--window-ms', type=int, default=1000, help='duration of the windows for the windowed CSV')
+    args = parser.parse_args()
+
+    start_time, raw_records = read_records(args.path)
+    records = [unpack_record(values) for values in raw_records]
+
+    base = os.path.splitext(args.path)[0]
+    write_frames(base + '_frames.csv', records)
+    print(f'Wrote {base}_frames.csv')
+    write_windows(base + '_windows.csv', start_time, records, args.window_ms * 1000)
+    print(f'Wrote {base}_windows.csv')
+
+    print_report(records)
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,159 @@
+// MIT License
+//
+// Copyright(c) 2021-2022 Matthieu Bucchianeri
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this softwareand associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright noticeand this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include "pch.h"
+
+#include "factories.h"
+#include "interfaces.h"
+
+#include "memory_config_store.h"
+#include "testing.h"
+
+namespace {
+
+    using namespace toolkit;
+    using namespace toolkit::config;
+    using namespace testing;
+
+    // The settings queried on every frame by the layer, the upscaler, the post-processor and the VRS manager.
+    const Setting FrameSettings[] = {
+        SettingOverlayType,       SettingMenuEyeVisibility,   SettingScalingType,      SettingScaling,
+        SettingAnamorphic,        SettingSharpness,           SettingMipMapBias,       SettingUpscalingFoveated,
+        SettingICD,               SettingFOVType,             SettingFOV,              SettingFOVUp,
+        SettingFOVDown,           SettingFOVLeftLeft,         SettingFOVLeftRight,     SettingFOVRightLeft,
+        SettingFOVRightRight,     SettingZoom,                SettingBlindEye,         SettingPredictionDampen,
+        SettingMotionReprojection, SettingFrameThrottling,    SettingTurboMode,        SettingVRS,
+        SettingVRSQuality,        SettingVRSPattern,          SettingVRSOuter,         SettingVRSOuterRadius,
+        SettingVRSMiddle,         SettingVRSInnerRadius,      SettingVRSInner,         SettingVRSXOffset,
+        SettingVRSXScale,         SettingVRSYOffset,          SettingVRSLeftRightBias, SettingPostProcess,
+        SettingPostSunGlasses,    SettingPostContrast,        SettingPostBrightness,   SettingPostExposure,
+        SettingPostSaturation,    SettingPostVibrance,        SettingPostHighlights,   SettingPostShadows,
+        SettingHandTrackingEnabled, SettingEyeTrackingEnabled, SettingRecordStats,     SettingProfiler,
+    };
+
+    // An emulation of the original config manager: every setting lives in a std::map keyed by name, the lookups
+    // compare strings, and tick() visits all the values.
+    class LegacyConfigManager {
+        struct ConfigValue {
+            int value{0};
+            bool changedSinceLastQuery{false};
+            unsigned int writeCountdown{0};
+        };
+
+      public:
+        LegacyConfigManager() {
+            for (uint32_t i = 0; i < to_integral(SettingId::MaxValue); i++) {
+                m_values.insert_or_assign(FindSettingName(i), ConfigValue{});
+            }
+        }
+
+        int getValue(const std::string& name) {
+            auto it = m_values.find(name);
+            it->second.changedSinceLastQuery = false;
+            return it->second.value;
+        }
+
+        bool hasChanged(const std::string& name) const {
+            auto it = m_values.find(name);
+            return it != m_values.end() ? it->second.changedSinceLastQuery : false;
+        }
+
+        void tick() {
+            for (auto& value : m_values) {
+                if (value.second.writeCountdown > 0) {
+                    value.second.writeCountdown--;
+                }
+            }
+        }
+
+      private:
+        static std::string FindSettingName(uint32_t index) {
+            for (const auto& setting : FrameSettings) {
+                if (to_integral(setting.id) == index) {
+                    return std::string(setting.name);
+                }
+            }
+            // Any other registered setting (only the count matters for the cost of tick()).
+            return "setting_" + std::to_string(index);
+        }
+
+        std::map<std::string, ConfigValue> m_values;
+    };
+
+    BENCHMARK(ConfigManager_PerFrameCost) {
+        // Like the original code, the names are pre-built std::string constants.
+        std::vector<std::string> names;
+        for (const auto& setting : FrameSettings) {
+            names.push_back(std::string(setting.name));
+        }
+
+        int sink = 0;
+
+        LegacyConfigManager legacy;
+        const double legacyCost = MeasureNanoseconds([&] {
+            for (const auto& name : names) {
+                sink += legacy.hasChanged(name);
+                sink += legacy.getValue(name);
+            }
+            legacy.tick();
+        });
+
+        auto store = std::make_shared<MemoryConfigStore>();
+        auto configManager = CreateConfigManager("benchmark", store);
+        for (const auto& setting : FrameSettings) {
+            configManager->setDefault(setting, 1);
+        }
+
+        const double byNameCost = MeasureNanoseconds([&] {
+            for (const auto& name : names) {
+                sink += configManager->hasChanged(name);
+                sink += configManager->getValue(name);
+            }
+            configManager->tick();
+        });
+
+        const double byHandleCost = MeasureNanoseconds([&] {
+            for (const auto& setting : FrameSettings) {
+                sink += configManager->hasChanged(setting);
+                sink += configManager->getValue(setting);
+            }
+            configManager->tick();
+        });
+
+        const auto snapshot = configManager->getSnapshot();
+        const double snapshotCost = MeasureNanoseconds([&] {
+            for (const auto& setting : FrameSettings) {
+                sink += snapshot.getValue(setting);
+            }
+        });
+
+        Report(fmt::format("{} settings, std::map (original)", std::size(FrameSettings)), legacyCost, "ns/frame");
+        Report("by name (slow path)", byNameCost, "ns/frame");
+        Report("by handle", byHandleCost, "ns/frame");
+        Report("from snapshot", snapshotCost, "ns/frame");
+        Report("speedup by handle vs. original", legacyCost / byHandleCost, "x");
+
+        CHECK(sink != 0);
+    }
+
+} // namespace
@@ -0,0 +1,394 @@
+// MIT License
+//
+// Copyright(c) 2021-2022 Matthieu Bucchianeri
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this softwareand associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright noticeand this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include "pch.h"
+
+#include "factories.h"
+#include "interfaces.h"
+#include "layer.h"
+
+#include "memory_config_store.h"
+#include "testing.h"
+
+namespace {
+
+    using namespace toolkit;
+    using namespace toolkit::config;
+    using namespace testing;
+
+    // Must match the deferred write delay in config.cpp.
+    constexpr unsigned int WriteDelay = 22;
+
+    std::filesystem::path GetTestConfigPath(const std::string& name) {
+        const auto path = localAppData / (name + ".settings");
+        std::filesystem::remove(path);
+        return path;
+    }
+
+    TEST_CASE(FileConfigStore_RoundTrip) {
+        const auto path = GetTestConfigPath("round_trip");
+        {
+            auto store = CreateFileConfigStore(path);
+            CHECK(!store->read("a"));
+            store->write("a", 1);
+            store->write("b", -2);
+            store->write("c", 3);
+            store->remove("c");
+            CHECK_EQ(store->read("a").value_or(0), 1);
+            store->flush();
+        }
+        {
+            auto store = CreateFileConfigStore(path);
+            CHECK_EQ(store->read("a").value_or(0), 1);
+            CHECK_EQ(store->read("b").value_or(0), -2);
+            CHECK(!store->read("c"));
+
+            store->removeAll();
+            store->flush();
+            store->reload();
+            CHECK(!store->read("a"));
+            CHECK(!store->read("b"));
+        }
+    }
+
+    TEST_CASE(FileConfigStore_Corrupted) {
+        const auto path = GetTestConfigPath("corrupted");
+        {
+            auto store = CreateFileConfigStore(path);
+            store->write("a_long_setting_name", 42);
+            store->flush();
+        }
+
+        // Truncate the last entry.
+        std::filesystem::resize_file(path, std::filesystem::file_size(path) - 4);
+        {
+            auto store = CreateFileConfigStore(path);
+            CHECK(!store->read("a_long_setting_name"));
+
+            // The store remains usable.
+            store->write("a_long_setting_name", 43);
+            store->flush();
+            store->reload();
+            CHECK_EQ(store->read("a_long_setting_name").value_or(0), 43);
+        }
+
+        // Not a settings file at all.
+        {
+            std::ofstream file(path, std::ios::binary | std::ios::trunc);
+            file << "garbage";
+        }
+        {
+            auto store = CreateFileConfigStore(path);
+            CHECK(!store->read("a_long_setting_name"));
+        }
+    }
+
+    TEST_CASE(FileConfigStore_GlobalFallback) {
+        const auto path = GetTestConfigPath("fallback");
+        auto registry = std::make_shared<MemoryConfigStore>();
+        registry->setGlobal("safe_mode", 1);
+        registry->setGlobal("overridden", 2);
+
+        auto store = CreateFileConfigStore(path, registry);
+        CHECK_EQ(store->readGlobal("safe_mode").value_or(0), 1);
+        CHECK_EQ(store->read("overridden").value_or(0), 2);
+
+        // Values for the application take precedence over the global ones.
+        store->write("overridden", 3);
+        CHECK_EQ(store->read("overridden").value_or(0), 3);
+        CHECK_EQ(store->readGlobal("overridden").value_or(0), 2);
+
+        store->setActiveSession("app");
+        CHECK(registry->activeSession() == "app");
+
+        // Without a fallback, there are no global values.
+        auto standalone = CreateFileConfigStore(path);
+        CHECK(!standalone->readGlobal("safe_mode"));
+        standalone->setActiveSession("app");
+    }
+
+    TEST_CASE(FileConfigStore_Migration) {
+        const auto path = GetTestConfigPath("migration");
+        auto registry = std::make_shared<MemoryConfigStore>();
+        registry->write("a", 1);
+        registry->write("b", 2);
+        registry->setGlobal("c", 3);
+
+        // Without a file, the values of the application are migrated, but not the global ones.
+        {
+            auto store = CreateFileConfigStore(path, registry);
+            CHECK_EQ(store->read("a").value_or(0), 1);
+            CHECK_EQ(store->read("b").value_or(0), 2);
+            CHECK(std::filesystem::exists(path));
+        }
+        {
+            auto store = CreateFileConfigStore(path);
+            CHECK_EQ(store->read("a").value_or(0), 1);
+            CHECK_EQ(store->read("b").value_or(0), 2);
+            CHECK(!store->read("c"));
+        }
+
+        // Once migrated, the file is authoritative.
+        registry->write("a", 4);
+        {
+            auto store = CreateFileConfigStore(path, registry);
+            CHECK_EQ(store->read("a").value_or(0), 1);
+        }
+    }
+
+    TEST_CASE(ConfigManager_Defaults) {
+        auto store = std::make_shared<MemoryConfigStore>();
+        store->write(SettingMenuFontSize.name, 2);
+        auto configManager = CreateConfigManager("test", store);
+
+        configManager->setDefault(SettingMenuTimeout, 1);
+        CHECK_EQ(configManager->getValue(SettingMenuTimeout), 1);
+
+        // A stored value takes precedence over the default.
+        configManager->setDefault(SettingMenuFontSize, 1);
+        CHECK_EQ(configManager->getValue(SettingMenuFontSize), 2);
+
+        // Accessors by name reach the same values.
+        CHECK_EQ(configManager->getValue(std::string(SettingMenuFontSize.name)), 2);
+        configManager->setDefault("custom_value", 5);
+        CHECK_EQ(configManager->getValue("custom_value"), 5);
+
+        CHECK(!configManager->isSafeMode());
+        CHECK(!configManager->isDeveloper());
+    }
+
+    TEST_CASE(ConfigManager_DeferredCommit) {
+        auto store = std::make_shared<MemoryConfigStore>();
+        auto configManager = CreateConfigManager("test", store);
+
+        configManager->setDefault(SettingMenuTimeout, 1);
+        const auto generation = configManager->getGeneration();
+        configManager->setValue(SettingMenuTimeout, 2);
+        CHECK_EQ(configManager->getValue(SettingMenuTimeout), 2);
+        CHECK(configManager->getGeneration() > generation);
+
+        for (unsigned int i = 0; i < WriteDelay - 1; i++) {
+            configManager->tick();
+        }
+        CHECK_EQ(store->flushCount(), 0u);
+        CHECK(!store->stored(std::string(SettingMenuTimeout.name)));
+
+        configManager->tick();
+        CHECK(store->waitForFlush(1));
+        CHECK_EQ(store->stored(std::string(SettingMenuTimeout.name)).value_or(0), 2);
+    }
+
+    TEST_CASE(ConfigManager_NoCommitDelay) {
+        auto store = std::make_shared<MemoryConfigStore>();
+        auto configManager = CreateConfigManager("test", store);
+
+        configManager->setDefault("custom_value", 0);
+        configManager->setValue("custom_value", 3, true);
+        configManager->tick();
+        CHECK(store->waitForFlush(1));
+        CHECK_EQ(store->stored("custom_value").value_or(0), 3);
+    }
+
+    TEST_CASE(ConfigManager_Refresh) {
+        auto store = std::make_shared<MemoryConfigStore>();
+        auto configManager = CreateConfigManager("test", store);
+
+        configManager->setDefault(SettingMenuTimeout, 1);
+        configManager->setDefault(SettingMenuFontSize, 1);
+        CHECK_EQ(configManager->getValue(SettingMenuTimeout), 1);
+        CHECK_EQ(configManager->getValue(SettingMenuFontSize), 1);
+
+        // A modification from another process cancels the write of a value still within its commit delay.
+        configManager->setValue(SettingMenuFontSize, 2);
+
+        store->externalWrite(std::string(SettingMenuTimeout.name), 7);
+        store->externalWrite(std::string(SettingMenuFontSize.name), 8);
+        configManager->tick();
+        CHECK(store->reloadCount() > 0);
+        CHECK(configManager->hasChanged(SettingMenuTimeout));
+        CHECK_EQ(configManager->getValue(SettingMenuTimeout), 7);
+        CHECK(!configManager->hasChanged(SettingMenuTimeout));
+        CHECK_EQ(configManager->getValue(SettingMenuFontSize), 8);
+        for (unsigned int i = 0; i < WriteDelay; i++) {
+            configManager->tick();
+        }
+        CHECK_EQ(store->flushCount(), 0u);
+        CHECK_EQ(store->stored(std::string(SettingMenuFontSize.name)).value_or(0), 8);
+    }
+
+    TEST_CASE(ConfigManager_RefreshDuringCommit) {
+        auto store = std::make_shared<MemoryConfigStore>();
+        store->write(SettingMenuTimeout.name, 1);
+        store->setDeferWrites(true);
+        auto configManager = CreateConfigManager("test", store);
+
+        configManager->setDefault(SettingMenuTimeout, 0);
+        configManager->setDefault(SettingMenuFontSize, 1);
+        CHECK_EQ(configManager->getValue(SettingMenuTimeout), 1);
+
+        // Hold the writer thread in the middle of the batch: the new value is not in the backing storage yet.
+        store->holdFlush();
+        configManager->setValue(SettingMenuTimeout, 2, true);
+        configManager->tick();
+        CHECK(store->waitForFlushStarted());
+
+        // A modification from another process must not revert the value being committed.
+        store->externalWrite(std::string(SettingMenuFontSize.name), 3);
+        configManager->tick();
+        CHECK_EQ(configManager->getValue(SettingMenuFontSize), 3);
+        CHECK_EQ(configManager->getValue(SettingMenuTimeout), 2);
+
+        store->releaseFlush();
+        CHECK(store->waitForFlush(1));
+        CHECK_EQ(store->stored(std::string(SettingMenuTimeout.name)).value_or(0), 2);
+        CHECK_EQ(configManager->getValue(SettingMenuTimeout), 2);
+    }
+
+    TEST_CASE(ConfigManager_DeleteValue) {
+        auto store = std::make_shared<MemoryConfigStore>();
+        store->write("custom_value", 4);
+        auto configManager = CreateConfigManager("test", store);
+
+        configManager->setDefault("custom_value", 0);
+        CHECK_EQ(configManager->getValue("custom_value"), 4);
+
+        configManager->deleteValue("custom_value");
+        CHECK(store->waitForFlush(1));
+        CHECK(!store->stored("custom_value"));
+    }
+
+    TEST_CASE(ConfigManager_HardReset) {
+        auto store = std::make_shared<MemoryConfigStore>();
+        auto configManager = CreateConfigManager("test", store);
+
+        configManager->setDefault(SettingMenuTimeout, 1);
+        configManager->setValue(SettingMenuTimeout, 2, true);
+        configManager->tick();
+        CHECK(store->waitForFlush(1));
+
+        // A pending write must be dropped by the reset.
+        configManager->setValue(SettingMenuTimeout, 3);
+        configManager->hardReset();
+        CHECK_EQ(configManager->getValue(SettingMenuTimeout), 1);
+        CHECK(store->waitForFlush(2));
+        for (unsigned int i = 0; i < WriteDelay; i++) {
+            configManager->tick();
+        }
+        CHECK(!store->stored(std::string(SettingMenuTimeout.name)));
+    }
+
+    TEST_CASE(ConfigManager_GlobalOptions) {
+        auto store = std::make_shared<MemoryConfigStore>();
+        store->setGlobal("safe_mode", 1);
+        store->setGlobal("developer", 1);
+        store->write(SettingMenuTimeout.name, 2);
+        auto configManager = CreateConfigManager("test", store);
+
+        CHECK(configManager->isSafeMode());
+        CHECK(configManager->isDeveloper());
+
+        // Stored values are ignored in safe mode.
+        configManager->setDefault(SettingMenuTimeout, 1);
+        CHECK_EQ(configManager->getValue(SettingMenuTimeout), 1);
+
+        configManager->setActiveSession("test");
+        CHECK(store->activeSession() == "test");
+    }
+
+    TEST_CASE(ConfigManager_InitialSnapshot) {
+        auto store = std::make_shared<MemoryConfigStore>();
+        store->write(SettingMenuTimeout.name, 4);
+        auto configManager = CreateConfigManager("test", store);
+
+        // A snapshot is available before the first frame.
+        const auto snapshot = configManager->getSnapshot();
+        CHECK(snapshot.generation != 0);
+        CHECK_EQ(snapshot.getValue(SettingMenuTimeout), 4);
+
+        configManager->setDefault(SettingMenuFontSize, 2);
+        configManager->publishSnapshot();
+        CHECK_EQ(configManager->getSnapshot().getValue(SettingMenuFontSize), 2);
+        CHECK(configManager->getSnapshot().generation > snapshot.generation);
+    }
+
+    TEST_CASE(ConfigManager_SnapshotStress) {
+        auto store = std::make_shared<MemoryConfigStore>();
+        auto configManager = CreateConfigManager("test", store);
+
+        const Setting settings[] = {SettingVRSOuter,
+                                    SettingVRSMiddle,
+                                    SettingVRSInner,
+                                    SettingVRSOuterRadius,
+                                    SettingVRSInnerRadius,
+                                    SettingPostContrast,
+                                    SettingPostBrightness,
+                                    SettingPostExposure};
+        for (const auto& setting : settings) {
+            configManager->setDefault(setting, 0);
+        }
+        configManager->publishSnapshot();
+
+        // The frame thread updates all the settings to the same value before each publish. A reader must never see a
+        // mix of two publishes.
+        std::atomic<bool> stop{false};
+        std::atomic<uint32_t> tornReads{0};
+        std::atomic<uint32_t> reads{0};
+        std::vector<std::thread> readers;
+        for (int i = 0; i < 3; i++) {
+            readers.emplace_back([&] {
+                int lastValue = 0;
+                while (!stop) {
+                    const auto snapshot = configManager->getSnapshot();
+                    const int value = snapshot.getValue(settings[0]);
+                    for (const auto& setting : settings) {
+                        if (snapshot.getValue(setting) != value) {
+                            tornReads++;
+                        }
+                    }
+                    if (value < lastValue) {
+                        tornReads++;
+                    }
+                    lastValue = value;
+                    reads++;
+                }
+            });
+        }
+
+        const int publishes = 200000;
+        for (int value = 1; value <= publishes; value++) {
+            for (const auto& setting : settings) {
+                configManager->setValue(setting, value);
+            }
+            configManager->publishSnapshot();
+        }
+        stop = true;
+        for (auto& reader : readers) {
+            reader.join();
+        }
+
+        CHECK(reads > 0);
+        CHECK_EQ(tornReads.load(), 0u);
+        CHECK_EQ(configManager->getSnapshot().getValue(settings[0]), publishes);
+    }
+
+} // namespace
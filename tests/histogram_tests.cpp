@@ -0,0 +1,133 @@
+// MIT License
+//
+// Copyright(c) 2021-2022 Matthieu Bucchianeri
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this softwareand associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright noticeand this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include "pch.h"
+
+#include "interfaces.h"
+
+#include "testing.h"
+
+namespace {
+
+    using namespace toolkit::utilities;
+
+    TEST_CASE(LogHistogram_BucketBounds) {
+        // Small values have their own bucket.
+        for (uint64_t value = 0; value < 8; value++) {
+            CHECK_EQ(LogHistogram::getBucketUpperBound(LogHistogram::getBucketIndex(value)), value);
+        }
+
+        // Larger values land in a bucket no wider than 1/8th of the value.
+        uint32_t lastIndex = 0;
+        for (uint64_t value = 1; value < (uint64_t(1) << 32); value += 1 + value / 61) {
+            const uint32_t index = LogHistogram::getBucketIndex(value);
+            const uint64_t upperBound = LogHistogram::getBucketUpperBound(index);
+            CHECK(index < LogHistogram::BucketCount);
+            CHECK(index >= lastIndex);
+            CHECK(upperBound >= value);
+            CHECK(upperBound - value <= value / 8);
+            if (index > 0) {
+                CHECK(LogHistogram::getBucketUpperBound(index - 1) < value);
+            }
+            lastIndex = index;
+        }
+
+        // Out of range values are clamped to the last bucket.
+        CHECK_EQ(LogHistogram::getBucketIndex(uint64_t(1) << 40), LogHistogram::BucketCount - 1);
+        CHECK_EQ(LogHistogram::getBucketIndex(UINT64_MAX), LogHistogram::BucketCount - 1);
+    }
+
+    TEST_CASE(LogHistogram_Empty) {
+        LogHistogram histogram;
+        CHECK_EQ(histogram.getCount(), 0u);
+        CHECK_EQ(histogram.getMax(), 0u);
+        CHECK_EQ(histogram.getPercentile(50), 0u);
+        CHECK_EQ(histogram.getPercentile(100), 0u);
+    }
+
+    TEST_CASE(LogHistogram_SingleValue) {
+        LogHistogram histogram;
+        histogram.record(11111);
+
+        // The bucket upper bound is capped to the largest recorded value.
+        CHECK_EQ(histogram.getPercentile(0), 11111u);
+        CHECK_EQ(histogram.getPercentile(50), 11111u);
+        CHECK_EQ(histogram.getPercentile(100), 11111u);
+        CHECK_EQ(histogram.getMax(), 11111u);
+    }
+
+    TEST_CASE(LogHistogram_Uniform) {
+        LogHistogram histogram;
+        for (uint64_t value = 1; value <= 1000; value++) {
+            histogram.record(value);
+        }
+        CHECK_EQ(histogram.getCount(), 1000u);
+        CHECK_EQ(histogram.getMax(), 1000u);
+
+        for (const uint32_t percentile : {1u, 10u, 50u, 95u, 99u}) {
+            const uint64_t expected = percentile * 10;
+            const uint64_t actual = histogram.getPercentile(percentile);
+            CHECK(actual >= expected);
+            CHECK(actual - expected <= expected / 8);
+        }
+        CHECK_EQ(histogram.getPercentile(100), 1000u);
+    }
+
+    TEST_CASE(LogHistogram_Spikes) {
+        // A steady frame time with 1% of stutters: the mean hides them, the percentiles must not.
+        LogHistogram histogram;
+        for (int i = 0; i < 990; i++) {
+            histogram.record(11000);
+        }
+        for (int i = 0; i < 10; i++) {
+            histogram.record(45000);
+        }
+
+        CHECK(histogram.getPercentile(50) >= 11000);
+        CHECK(histogram.getPercentile(50) <= 11000 + 11000 / 8);
+        CHECK_EQ(histogram.getPercentile(99), histogram.getPercentile(50));
+        CHECK(histogram.getPercentile(100) == 45000);
+        CHECK_EQ(histogram.getMax(), 45000u);
+
+        // 11 stutters push them above the 99th percentile.
+        histogram.record(45000);
+        CHECK(histogram.getPercentile(99) >= 45000 - 45000 / 8);
+    }
+
+    TEST_CASE(LogHistogram_Reset) {
+        LogHistogram histogram;
+        histogram.record(100);
+        histogram.record(UINT64_MAX);
+        CHECK_EQ(histogram.getCount(), 2u);
+        CHECK(histogram.getMax() == UINT64_MAX);
+
+        histogram.reset();
+        CHECK_EQ(histogram.getCount(), 0u);
+        CHECK_EQ(histogram.getMax(), 0u);
+        CHECK_EQ(histogram.getPercentile(99), 0u);
+
+        histogram.record(7);
+        CHECK_EQ(histogram.getPercentile(50), 7u);
+    }
+
+} // namespace
@@ -0,0 +1,85 @@
+// MIT License
+//
+// Copyright(c) 2022 Matthieu Bucchianeri
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this softwareand associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright noticeand this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "pch.h"
+
+#include "image_reference.h"
+#include "testing.h"
+
+namespace {
+
+    using namespace testing;
+    using namespace testing::reference;
+
+    // A 75% upscaling, to 1024x1024.
+    constexpr uint32_t InputSize = 768;
+    constexpr uint32_t OutputSize = 1024;
+
+    BENCHMARK(ImageReference_Throughput) {
+        const auto input = MakeTestImage(InputSize, InputSize);
+        const auto fsr = MakeFSRConstants(InputSize, InputSize, OutputSize, OutputSize, 0.5f);
+        const auto cas = MakeCASConstants(InputSize, InputSize, OutputSize, OutputSize, 0.5f);
+        const auto casSharpen = MakeCASConstants(InputSize, InputSize, InputSize, InputSize, 0.5f);
+        PostProcessConstants postProcess{};
+        postProcess.Params1 = {0.2f, 0.1f, 0.1f, 0.15f};
+        postProcess.Params3 = {0.2f, 0.3f, 0.4f, 0.f};
+
+        Image output(OutputSize, OutputSize);
+        Image sharpened(InputSize, InputSize);
+        auto image = input;
+
+        // The throughput of each kernel, in output megapixels per second.
+        const auto report = [](const std::string& name, Isa isa, uint32_t pixels, double nanoseconds) {
+            Report(fmt::format("{} ({})", name, ToString(isa)), pixels * 1e3 / nanoseconds, "Mpix/s");
+        };
+
+        for (int i = 0; i < static_cast<int>(Isa::MaxValue); i++) {
+            const auto isa = static_cast<Isa>(i);
+            if (!IsSupported(isa)) {
+                continue;
+            }
+
+            report("FSR EASU", isa, OutputSize * OutputSize, MeasureNanoseconds([&] {
+                       FsrEasu(input, output, fsr, isa);
+                   }));
+            report("FSR RCAS", isa, InputSize * InputSize, MeasureNanoseconds([&] {
+                       FsrRcas(input, sharpened, fsr, isa);
+                   }));
+            report("FSR EASU + RCAS", isa, OutputSize * OutputSize, MeasureNanoseconds([&] {
+                       FsrUpscale(input, output, fsr, isa);
+                   }));
+            report("FSR fused + post-processing", isa, OutputSize * OutputSize, MeasureNanoseconds([&] {
+                       FsrFused(input, output, fsr, postProcess, 2, isa);
+                   }));
+            report("CAS upscaling", isa, OutputSize * OutputSize, MeasureNanoseconds([&] {
+                       Cas(input, output, cas, false /* sharpenOnly */, isa);
+                   }));
+            report("CAS sharpening", isa, InputSize * InputSize, MeasureNanoseconds([&] {
+                       Cas(input, sharpened, casSharpen, true /* sharpenOnly */, isa);
+                   }));
+            report("Post-processing", isa, InputSize * InputSize, MeasureNanoseconds([&] {
+                       PostProcess(image, postProcess, isa);
+                   }));
+        }
+    }
+
+} // namespace
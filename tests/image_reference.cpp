@@ -0,0 +1,1343 @@
+// MIT License
+//
+// Copyright(c) 2022 Matthieu Bucchianeri
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this softwareand associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright noticeand this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "pch.h"
+
+#include <intrin.h>
+#include <immintrin.h>
+
+#include "image_reference.h"
+
+#define A_CPU
+#include <ffx_a.h>
+#include <ffx_fsr1.h>
+#include <ffx_cas.h>
+
+namespace {
+
+    using namespace testing::reference;
+
+    // The kernels are written once against the lane types below: float (the scalar code, also used for the remainder
+    // of the rows), Float4 (SSE4.1) and Float8 (AVX2). They perform the same sequence of IEEE operations for every
+    // lane type, so that the vectorized code produces the same results as the scalar code. Like on the GPU, Min() and
+    // Max() return the other operand when one is NaN.
+
+    template <typename F>
+    struct Lanes;
+
+    inline float AsFloat(uint32_t i) {
+        float f;
+        std::memcpy(&f, &i, sizeof(f));
+        return f;
+    }
+    inline uint32_t AsInt(float f) {
+        uint32_t i;
+        std::memcpy(&i, &f, sizeof(i));
+        return i;
+    }
+    inline float ToFloat(uint32_t i) {
+        return static_cast<float>(static_cast<int32_t>(i));
+    }
+    inline uint32_t ToInt(float f) {
+        return static_cast<uint32_t>(static_cast<int32_t>(f));
+    }
+    template <int Count>
+    uint32_t ShiftLeft(uint32_t i) {
+        return i << Count;
+    }
+    template <int Count>
+    uint32_t ShiftRight(uint32_t i) {
+        return i >> Count;
+    }
+    inline float Min(float a, float b) {
+        return std::fmin(a, b);
+    }
+    inline float Max(float a, float b) {
+        return std::fmax(a, b);
+    }
+    inline float Abs(float a) {
+        return std::fabs(a);
+    }
+    inline float Sqrt(float a) {
+        return std::sqrt(a);
+    }
+    inline float Floor(float a) {
+        return std::floor(a);
+    }
+    inline bool Less(float a, float b) {
+        return a < b;
+    }
+    inline bool LessEqual(float a, float b) {
+        return a <= b;
+    }
+    inline float Select(bool mask, float a, float b) {
+        return mask ? a : b;
+    }
+
+    template <>
+    struct Lanes<float> {
+        using Int = uint32_t;
+        static constexpr uint32_t Count = 1;
+
+        static float Load(const float* p) {
+            return *p;
+        }
+        static void Store(float* p, float v) {
+            *p = v;
+        }
+        static float Iota() {
+            return 0.f;
+        }
+        static float Gather(const float* base, uint32_t index) {
+            return base[static_cast<int32_t>(index)];
+        }
+    };
+
+    struct Float4 {
+        Float4() = default;
+        Float4(__m128 v) : v(v) {
+        }
+        Float4(float f) : v(_mm_set1_ps(f)) {
+        }
+        __m128 v;
+    };
+
+    struct Int4 {
+        Int4() = default;
+        Int4(__m128i v) : v(v) {
+        }
+        Int4(uint32_t i) : v(_mm_set1_epi32(static_cast<int32_t>(i))) {
+        }
+        __m128i v;
+    };
+
+    inline Float4 operator+(Float4 a, Float4 b) {
+        return _mm_add_ps(a.v, b.v);
+    }
+    inline Float4 operator-(Float4 a, Float4 b) {
+        return _mm_sub_ps(a.v, b.v);
+    }
+    inline Float4 operator*(Float4 a, Float4 b) {
+        return _mm_mul_ps(a.v, b.v);
+    }
+    inline Float4 operator/(Float4 a, Float4 b) {
+        return _mm_div_ps(a.v, b.v);
+    }
+    inline Float4 operator-(Float4 a) {
+        return _mm_xor_ps(a.v, _mm_set1_ps(-0.f));
+    }
+    inline Int4 operator+(Int4 a, Int4 b) {
+        return _mm_add_epi32(a.v, b.v);
+    }
+    inline Int4 operator-(Int4 a, Int4 b) {
+        return _mm_sub_epi32(a.v, b.v);
+    }
+    inline Int4 operator&(Int4 a, Int4 b) {
+        return _mm_and_si128(a.v, b.v);
+    }
+    inline Int4 operator|(Int4 a, Int4 b) {
+        return _mm_or_si128(a.v, b.v);
+    }
+    inline Float4 AsFloat(Int4 i) {
+        return _mm_castsi128_ps(i.v);
+    }
+    inline Int4 AsInt(Float4 f) {
+        return _mm_castps_si128(f.v);
+    }
+    inline Float4 ToFloat(Int4 i) {
+        return _mm_cvtepi32_ps(i.v);
+    }
+    inline Int4 ToInt(Float4 f) {
+        return _mm_cvttps_epi32(f.v);
+    }
+    template <int Count>
+    Int4 ShiftLeft(Int4 i) {
+        return _mm_slli_epi32(i.v, Count);
+    }
+    template <int Count>
+    Int4 ShiftRight(Int4 i) {
+        return _mm_srli_epi32(i.v, Count);
+    }
+    inline Float4 Min(Float4 a, Float4 b) {
+        return _mm_blendv_ps(_mm_min_ps(a.v, b.v), a.v, _mm_cmpunord_ps(b.v, b.v));
+    }
+    inline Float4 Max(Float4 a, Float4 b) {
+        return _mm_blendv_ps(_mm_max_ps(a.v, b.v), a.v, _mm_cmpunord_ps(b.v, b.v));
+    }
+    inline Float4 Abs(Float4 a) {
+        return _mm_andnot_ps(_mm_set1_ps(-0.f), a.v);
+    }
+    inline Float4 Sqrt(Float4 a) {
+        return _mm_sqrt_ps(a.v);
+    }
+    inline Float4 Floor(Float4 a) {
+        return _mm_floor_ps(a.v);
+    }
+    inline Float4 Less(Float4 a, Float4 b) {
+        return _mm_cmplt_ps(a.v, b.v);
+    }
+    inline Float4 LessEqual(Float4 a, Float4 b) {
+        return _mm_cmple_ps(a.v, b.v);
+    }
+    inline Float4 Select(Float4 mask, Float4 a, Float4 b) {
+        return _mm_blendv_ps(b.v, a.v, mask.v);
+    }
+
+    template <>
+    struct Lanes<Float4> {
+        using Int = Int4;
+        static constexpr uint32_t Count = 4;
+
+        static Float4 Load(const float* p) {
+            return _mm_loadu_ps(p);
+        }
+        static void Store(float* p, Float4 v) {
+            _mm_storeu_ps(p, v.v);
+        }
+        static Float4 Iota() {
+            return _mm_setr_ps(0.f, 1.f, 2.f, 3.f);
+        }
+        static Float4 Gather(const float* base, Int4 index) {
+            alignas(16) int32_t indices[4];
+            _mm_store_si128(reinterpret_cast<__m128i*>(indices), index.v);
+            return _mm_setr_ps(base[indices[0]], base[indices[1]], base[indices[2]], base[indices[3]]);
+        }
+    };
+
+    struct Float8 {
+        Float8() = default;
+        Float8(__m256 v) : v(v) {
+        }
+        Float8(float f) : v(_mm256_set1_ps(f)) {
+        }
+        __m256 v;
+    };
+
+    struct Int8 {
+        Int8() = default;
+        Int8(__m256i v) : v(v) {
+        }
+        Int8(uint32_t i) : v(_mm256_set1_epi32(static_cast<int32_t>(i))) {
+        }
+        __m256i v;
+    };
+
+    inline Float8 operator+(Float8 a, Float8 b) {
+        return _mm256_add_ps(a.v, b.v);
+    }
+    inline Float8 operator-(Float8 a, Float8 b) {
+        return _mm256_sub_ps(a.v, b.v);
+    }
+    inline Float8 operator*(Float8 a, Float8 b) {
+        return _mm256_mul_ps(a.v, b.v);
+    }
+    inline Float8 operator/(Float8 a, Float8 b) {
+        return _mm256_div_ps(a.v, b.v);
+    }
+    inline Float8 operator-(Float8 a) {
+        return _mm256_xor_ps(a.v, _mm256_set1_ps(-0.f));
+    }
+    inline Int8 operator+(Int8 a, Int8 b) {
+        return _mm256_add_epi32(a.v, b.v);
+    }
+    inline Int8 operator-(Int8 a, Int8 b) {
+        return _mm256_sub_epi32(a.v, b.v);
+    }
+    inline Int8 operator&(Int8 a, Int8 b) {
+        return _mm256_and_si256(a.v, b.v);
+    }
+    inline Int8 operator|(Int8 a, Int8 b) {
+        return _mm256_or_si256(a.v, b.v);
+    }
+    inline Float8 AsFloat(Int8 i) {
+        return _mm256_castsi256_ps(i.v);
+    }
+    inline Int8 AsInt(Float8 f) {
+        return _mm256_castps_si256(f.v);
+    }
+    inline Float8 ToFloat(Int8 i) {
+        return _mm256_cvtepi32_ps(i.v);
+    }
+    inline Int8 ToInt(Float8 f) {
+        return _mm256_cvttps_epi32(f.v);
+    }
+    template <int Count>
+    Int8 ShiftLeft(Int8 i) {
+        return _mm256_slli_epi32(i.v, Count);
+    }
+    template <int Count>
+    Int8 ShiftRight(Int8 i) {
+        return _mm256_srli_epi32(i.v, Count);
+    }
+    inline Float8 Min(Float8 a, Float8 b) {
+        return _mm256_blendv_ps(_mm256_min_ps(a.v, b.v), a.v, _mm256_cmp_ps(b.v, b.v, _CMP_UNORD_Q));
+    }
+    inline Float8 Max(Float8 a, Float8 b) {
+        return _mm256_blendv_ps(_mm256_max_ps(a.v, b.v), a.v, _mm256_cmp_ps(b.v, b.v, _CMP_UNORD_Q));
+    }
+    inline Float8 Abs(Float8 a) {
+        return _mm256_andnot_ps(_mm256_set1_ps(-0.f), a.v);
+    }
+    inline Float8 Sqrt(Float8 a) {
+        return _mm256_sqrt_ps(a.v);
+    }
+    inline Float8 Floor(Float8 a) {
+        return _mm256_floor_ps(a.v);
+    }
+    inline Float8 Less(Float8 a, Float8 b) {
+        return _mm256_cmp_ps(a.v, b.v, _CMP_LT_OQ);
+    }
+    inline Float8 LessEqual(Float8 a, Float8 b) {
+        return _mm256_cmp_ps(a.v, b.v, _CMP_LE_OQ);
+    }
+    inline Float8 Select(Float8 mask, Float8 a, Float8 b) {
+        return _mm256_blendv_ps(b.v, a.v, mask.v);
+    }
+
+    template <>
+    struct Lanes<Float8> {
+        using Int = Int8;
+        static constexpr uint32_t Count = 8;
+
+        static Float8 Load(const float* p) {
+            return _mm256_loadu_ps(p);
+        }
+        static void Store(float* p, Float8 v) {
+            _mm256_storeu_ps(p, v.v);
+        }
+        static Float8 Iota() {
+            return _mm256_setr_ps(0.f, 1.f, 2.f, 3.f, 4.f, 5.f, 6.f, 7.f);
+        }
+        static Float8 Gather(const float* base, Int8 index) {
+            return _mm256_i32gather_ps(base, index.v, sizeof(float));
+        }
+    };
+
+    // Invoke a function with a lane type of the requested instruction set.
+    template <typename Function>
+    void Dispatch(Isa isa, Function&& function) {
+        switch (isa) {
+        case Isa::AVX2:
+            function(Float8{});
+            break;
+        case Isa::SSE41:
+            function(Float4{});
+            break;
+        default:
+            function(float{});
+            break;
+        }
+    }
+
+    // Invoke a kernel for each group of lanes of a row, then one pixel at a time for the remainder.
+    template <typename F, typename Kernel>
+    void ForEachSpan(uint32_t width, Kernel&& kernel) {
+        uint32_t x = 0;
+        for (; x + Lanes<F>::Count <= width; x += Lanes<F>::Count) {
+            kernel(F{}, x);
+        }
+        for (; x < width; x++) {
+            kernel(float{}, x);
+        }
+    }
+
+    template <typename F>
+    F Saturate(F a) {
+        return Min(Max(a, F(0.f)), F(1.f));
+    }
+
+    template <typename F>
+    F Min3(F a, F b, F c) {
+        return Min(a, Min(b, c));
+    }
+
+    template <typename F>
+    F Max3(F a, F b, F c) {
+        return Max(a, Max(b, c));
+    }
+
+    // The approximations of ffx_a.h.
+    template <typename F>
+    F ApproxRcpLo(F a) {
+        using I = typename Lanes<F>::Int;
+        return AsFloat(I(0x7ef07ebbu) - AsInt(a));
+    }
+
+    template <typename F>
+    F ApproxRcpMed(F a) {
+        using I = typename Lanes<F>::Int;
+        const F b = AsFloat(I(0x7ef19fffu) - AsInt(a));
+        return b * (-b * a + F(2.f));
+    }
+
+    template <typename F>
+    F ApproxRsqLo(F a) {
+        using I = typename Lanes<F>::Int;
+        return AsFloat(I(0x5f347d74u) - ShiftRight<1>(AsInt(a)));
+    }
+
+    template <typename F>
+    F ApproxSqrtLo(F a) {
+        using I = typename Lanes<F>::Int;
+        return AsFloat(ShiftRight<1>(AsInt(a)) + I(0x1fbc4639u));
+    }
+
+    // log2() for positive normal values, from the series of atanh() on [sqrt(2)/2, sqrt(2)].
+    template <typename F>
+    F Log2(F a) {
+        using I = typename Lanes<F>::Int;
+        const I bits = AsInt(a);
+        F mantissa = AsFloat((bits & I(0x7fffffu)) | I(0x3f800000u));
+        F exponent = ToFloat(ShiftRight<23>(bits) - I(127u));
+        const auto isLarge = Less(F(1.41421356f), mantissa);
+        mantissa = Select(isLarge, mantissa * F(0.5f), mantissa);
+        exponent = exponent + Select(isLarge, F(1.f), F(0.f));
+
+        const F s = (mantissa - F(1.f)) / (mantissa + F(1.f));
+        const F s2 = s * s;
+        const F series =
+            F(2.88539008f) +
+            s2 * (F(0.961796694f) + s2 * (F(0.577078016f) + s2 * (F(0.412198583f) + s2 * F(0.320598898f))));
+        return exponent + s * series;
+    }
+
+    // exp2(), from the Taylor series of 2^x on [0, 1].
+    template <typename F>
+    F Exp2(F a) {
+        using I = typename Lanes<F>::Int;
+        a = Min(Max(a, F(-126.f)), F(126.f));
+        const F integer = Floor(a);
+        const F f = a - integer;
+        const F series =
+            F(1.f) +
+            f * (F(0.693147181f) +
+                 f * (F(0.240226507f) +
+                      f * (F(0.0555041087f) +
+                           f * (F(0.00961812911f) +
+                                f * (F(0.00133335581f) +
+                                     f * (F(0.000154035304f) + f * (F(1.52527338e-5f) + f * F(1.32154868e-6f))))))));
+        return series * AsFloat(ShiftLeft<23>(ToInt(integer) + I(127u)));
+    }
+
+    // SafePow() from postprocess.hlsl.
+    template <typename F>
+    F SafePow(F a, F power) {
+        return Exp2(Log2(Max(Abs(a), F(1.192092896e-07f))) * power);
+    }
+
+    // A copy of an image surrounded with zeros, for the shaders that Load() outside of the image. With squareRoot,
+    // the copy holds the square root of the values (FsrRcasLoadF() with SAMPLE_HDR_OUTPUT).
+    struct PaddedImage {
+        static constexpr uint32_t Border = 2;
+
+        PaddedImage(const Image& image, bool squareRoot) : stride(image.width + 2 * Border) {
+            for (uint32_t c = 0; c < 3; c++) {
+                planes[c].assign((size_t)stride * (image.height + 2 * Border), 0.f);
+                for (uint32_t y = 0; y < image.height; y++) {
+                    float* const row = planes[c].data() + (size_t)(y + Border) * stride + Border;
+                    for (uint32_t x = 0; x < image.width; x++) {
+                        const float value = image.at(c, x, y);
+                        row[x] = squareRoot ? std::sqrt(value) : value;
+                    }
+                }
+            }
+        }
+
+        // The pixel at (0, y), for y in [-Border, height + Border).
+        const float* row(uint32_t channel, int32_t y) const {
+            return planes[channel].data() + (ptrdiff_t)(y + Border) * stride + Border;
+        }
+
+        const uint32_t stride;
+        std::vector<float> planes[3];
+    };
+
+    // FsrEasuSetF().
+    template <typename F>
+    void EasuSet(F& dirX, F& dirY, F& len, F w, F lA, F lB, F lC, F lD, F lE) {
+        const F dc = lD - lC;
+        const F cb = lC - lB;
+        F lenX = Max(Abs(dc), Abs(cb));
+        lenX = ApproxRcpLo(lenX);
+        const F deltaX = lD - lB;
+        dirX = dirX + deltaX * w;
+        lenX = Saturate(Abs(deltaX) * lenX);
+        lenX = lenX * lenX;
+        len = len + lenX * w;
+
+        const F ec = lE - lC;
+        const F ca = lC - lA;
+        F lenY = Max(Abs(ec), Abs(ca));
+        lenY = ApproxRcpLo(lenY);
+        const F deltaY = lE - lA;
+        dirY = dirY + deltaY * w;
+        lenY = Saturate(Abs(deltaY) * lenY);
+        lenY = lenY * lenY;
+        len = len + lenY * w;
+    }
+
+    // FsrEasuTapF().
+    template <typename F>
+    void EasuTap(F (&aC)[3],
+                 F& aW,
+                 F offX,
+                 F offY,
+                 F dirX,
+                 F dirY,
+                 F len2X,
+                 F len2Y,
+                 F lob,
+                 F clp,
+                 const F (&color)[3]) {
+        F vX = offX * dirX + offY * dirY;
+        F vY = offX * -dirY + offY * dirX;
+        vX = vX * len2X;
+        vY = vY * len2Y;
+        F d2 = vX * vX + vY * vY;
+        d2 = Min(d2, clp);
+
+        F wB = F(0.4f) * d2 + F(-1.f);
+        F wA = lob * d2 + F(-1.f);
+        wB = wB * wB;
+        wA = wA * wA;
+        wB = F(1.5625f) * wB + F(-0.5625f);
+        const F w = wB * wA;
+
+        for (uint32_t c = 0; c < 3; c++) {
+            aC[c] = aC[c] + color[c] * w;
+        }
+        aW = aW + w;
+    }
+
+    // FsrEasuF() for the output pixels at (x, y), with the clamp sampler.
+    template <typename F>
+    void EasuPixels(const Image& input, const FSRConstants& constants, F x, float y, F (&pix)[3]) {
+        using L = Lanes<F>;
+        using I = typename L::Int;
+
+        const float ppY = y * AsFloat(constants.Const0[1]) + AsFloat(constants.Const0[3]);
+        const float fpY = std::floor(ppY);
+        const F fracY(ppY - fpY);
+
+        F ppX = x * F(AsFloat(constants.Const0[0])) + F(AsFloat(constants.Const0[2]));
+        const F fpX = Floor(ppX);
+        const F fracX = ppX - fpX;
+
+        // The 12 taps, from the 4x4 neighborhood at (-1, -1) of 'f'.
+        //    b c
+        //  e f g h
+        //  i j k l
+        //    n o
+        const float* rows[4][3];
+        for (int32_t dy = -1; dy <= 2; dy++) {
+            const int32_t row = std::clamp(static_cast<int32_t>(fpY) + dy, 0, static_cast<int32_t>(input.height) - 1);
+            for (uint32_t c = 0; c < 3; c++) {
+                rows[dy + 1][c] = input.planes[c].data() + (size_t)row * input.width;
+            }
+        }
+        I columns[4];
+        for (int32_t dx = -1; dx <= 2; dx++) {
+            columns[dx + 1] = ToInt(Min(Max(fpX + F(static_cast<float>(dx)), F(0.f)), F(input.width - 1.f)));
+        }
+        const auto tap = [&](int32_t dx, int32_t dy, F(&color)[3], F& luma) {
+            for (uint32_t c = 0; c < 3; c++) {
+                color[c] = L::Gather(rows[dy + 1][c], columns[dx + 1]);
+            }
+            luma = color[2] * F(0.5f) + (color[0] * F(0.5f) + color[1]);
+        };
+        F b[3], c[3], e[3], f[3], g[3], h[3], i[3], j[3], k[3], l[3], n[3], o[3];
+        F bL, cL, eL, fL, gL, hL, iL, jL, kL, lL, nL, oL;
+        tap(0, -1, b, bL);
+        tap(1, -1, c, cL);
+        tap(-1, 0, e, eL);
+        tap(0, 0, f, fL);
+        tap(1, 0, g, gL);
+        tap(2, 0, h, hL);
+        tap(-1, 1, i, iL);
+        tap(0, 1, j, jL);
+        tap(1, 1, k, kL);
+        tap(2, 1, l, lL);
+        tap(0, 2, n, nL);
+        tap(1, 2, o, oL);
+
+        // Accumulate for bilinear interpolation.
+        F dirX(0.f), dirY(0.f), len(0.f);
+        EasuSet(dirX, dirY, len, (F(1.f) - fracX) * (F(1.f) - fracY), bL, eL, fL, gL, jL);
+        EasuSet(dirX, dirY, len, fracX * (F(1.f) - fracY), cL, fL, gL, hL, kL);
+        EasuSet(dirX, dirY, len, (F(1.f) - fracX) * fracY, fL, iL, jL, kL, nL);
+        EasuSet(dirX, dirY, len, fracX * fracY, gL, jL, kL, lL, oL);
+
+        // Normalize with approximation, and cleanup close to zero.
+        F dirR = dirX * dirX + dirY * dirY;
+        const auto isZero = Less(dirR, F(1.f / 32768.f));
+        dirR = ApproxRsqLo(dirR);
+        dirR = Select(isZero, F(1.f), dirR);
+        dirX = Select(isZero, F(1.f), dirX);
+        dirX = dirX * dirR;
+        dirY = dirY * dirR;
+
+        // Transform from {0 to 2} to {0 to 1} range, and shape with square.
+        len = len * F(0.5f);
+        len = len * len;
+
+        // Stretch kernel {1.0 vert|horz, to sqrt(2.0) on diagonal}.
+        const F stretch = (dirX * dirX + dirY * dirY) * ApproxRcpLo(Max(Abs(dirX), Abs(dirY)));
+        const F len2X = F(1.f) + (stretch - F(1.f)) * len;
+        const F len2Y = F(1.f) + F(-0.5f) * len;
+        const F lob = F(0.5f) + F(-0.29f) * len;
+        const F clp = ApproxRcpLo(lob);
+
+        F aC[3] = {F(0.f), F(0.f), F(0.f)};
+        F aW(0.f);
+        EasuTap(aC, aW, F(0.f) - fracX, F(-1.f) - fracY, dirX, dirY, len2X, len2Y, lob, clp, b);
+        EasuTap(aC, aW, F(1.f) - fracX, F(-1.f) - fracY, dirX, dirY, len2X, len2Y, lob, clp, c);
+        EasuTap(aC, aW, F(-1.f) - fracX, F(1.f) - fracY, dirX, dirY, len2X, len2Y, lob, clp, i);
+        EasuTap(aC, aW, F(0.f) - fracX, F(1.f) - fracY, dirX, dirY, len2X, len2Y, lob, clp, j);
+        EasuTap(aC, aW, F(0.f) - fracX, F(0.f) - fracY, dirX, dirY, len2X, len2Y, lob, clp, f);
+        EasuTap(aC, aW, F(-1.f) - fracX, F(0.f) - fracY, dirX, dirY, len2X, len2Y, lob, clp, e);
+        EasuTap(aC, aW, F(1.f) - fracX, F(1.f) - fracY, dirX, dirY, len2X, len2Y, lob, clp, k);
+        EasuTap(aC, aW, F(2.f) - fracX, F(1.f) - fracY, dirX, dirY, len2X, len2Y, lob, clp, l);
+        EasuTap(aC, aW, F(2.f) - fracX, F(0.f) - fracY, dirX, dirY, len2X, len2Y, lob, clp, h);
+        EasuTap(aC, aW, F(1.f) - fracX, F(0.f) - fracY, dirX, dirY, len2X, len2Y, lob, clp, g);
+        EasuTap(aC, aW, F(1.f) - fracX, F(2.f) - fracY, dirX, dirY, len2X, len2Y, lob, clp, o);
+        EasuTap(aC, aW, F(0.f) - fracX, F(2.f) - fracY, dirX, dirY, len2X, len2Y, lob, clp, n);
+
+        // Normalize and dering with the min/max of the 4 nearest.
+        const F rcpW = F(1.f) / aW;
+        for (uint32_t ch = 0; ch < 3; ch++) {
+            const F min4 = Min(Min3(f[ch], g[ch], j[ch]), k[ch]);
+            const F max4 = Max(Max3(f[ch], g[ch], j[ch]), k[ch]);
+            pix[ch] = Min(max4, Max(min4, aC[ch] * rcpW));
+        }
+    }
+
+    // The bilinear sampling at the position of the output pixels at (x, y), with the clamp sampler (FSR.hlsl
+    // outside of the foveated region).
+    template <typename F>
+    void BilinearPixels(const Image& input, const FSRConstants& constants, F x, float y, F (&pix)[3]) {
+        using L = Lanes<F>;
+
+        const float v = (y * AsFloat(constants.Const0[1]) + AsFloat(constants.Const0[3])) *
+                            AsFloat(constants.Const1[1]) +
+                        -0.5f * AsFloat(constants.Const1[3]);
+        const float texelY = v * input.height - 0.5f;
+        const float floorY = std::floor(texelY);
+        const F fracY(texelY - floorY);
+        const float* rows[2][3];
+        for (int32_t dy = 0; dy <= 1; dy++) {
+            const int32_t row =
+                std::clamp(static_cast<int32_t>(floorY) + dy, 0, static_cast<int32_t>(input.height) - 1);
+            for (uint32_t c = 0; c < 3; c++) {
+                rows[dy][c] = input.planes[c].data() + (size_t)row * input.width;
+            }
+        }
+
+        const F u = (x * F(AsFloat(constants.Const0[0])) + F(AsFloat(constants.Const0[2]))) *
+                        F(AsFloat(constants.Const1[0])) +
+                    F(0.5f * AsFloat(constants.Const1[2]));
+        const F texelX = u * F(static_cast<float>(input.width)) - F(0.5f);
+        const F floorX = Floor(texelX);
+        const F fracX = texelX - floorX;
+        const F maxX(input.width - 1.f);
+        const auto column0 = ToInt(Min(Max(floorX, F(0.f)), maxX));
+        const auto column1 = ToInt(Min(Max(floorX + F(1.f), F(0.f)), maxX));
+
+        for (uint32_t c = 0; c < 3; c++) {
+            const F top = L::Gather(rows[0][c], column0) +
+                          (L::Gather(rows[0][c], column1) - L::Gather(rows[0][c], column0)) * fracX;
+            const F bottom = L::Gather(rows[1][c], column0) +
+                             (L::Gather(rows[1][c], column1) - L::Gather(rows[1][c], column0)) * fracX;
+            pix[c] = top + (bottom - top) * fracY;
+        }
+    }
+
+    // FsrRcasF() (without FSR_RCAS_DENOISE) for the pixels at p, with their neighbors at +/-1 and +/-stride.
+    template <typename F>
+    void RcasPixels(const float* const (&p)[3], ptrdiff_t stride, float sharpness, F (&pix)[3]) {
+        using L = Lanes<F>;
+
+        //    b
+        //  d e f
+        //    h
+        F b[3], d[3], e[3], f[3], h[3];
+        F lobes[3];
+        for (uint32_t c = 0; c < 3; c++) {
+            b[c] = L::Load(p[c] - stride);
+            d[c] = L::Load(p[c] - 1);
+            e[c] = L::Load(p[c]);
+            f[c] = L::Load(p[c] + 1);
+            h[c] = L::Load(p[c] + stride);
+
+            // Min and max of ring.
+            const F mn4 = Min(Min3(b[c], d[c], f[c]), h[c]);
+            const F mx4 = Max(Max3(b[c], d[c], f[c]), h[c]);
+
+            // Limiters, these need to be high precision RCPs.
+            const F hitMin = Min(mn4, e[c]) * (F(1.f) / (F(4.f) * mx4));
+            const F hitMax = (F(1.f) - Max(mx4, e[c])) * (F(1.f) / (F(4.f) * mn4 + F(-4.f)));
+            lobes[c] = Max(-hitMin, hitMax);
+        }
+        const F lobe =
+            Max(F(-(0.25f - 1.f / 16.f)), Min(Max3(lobes[0], lobes[1], lobes[2]), F(0.f))) * F(sharpness);
+
+        // Resolve, which needs the medium precision rcp approximation to avoid visible tonality changes.
+        const F rcpL = ApproxRcpMed(F(4.f) * lobe + F(1.f));
+        for (uint32_t c = 0; c < 3; c++) {
+            pix[c] = (lobe * b[c] + lobe * d[c] + lobe * h[c] + lobe * f[c] + e[c]) * rcpL;
+        }
+    }
+
+    // CasFilter() with noScaling (without CAS_BETTER_DIAGONALS, CAS_GO_SLOWER and CAS_SLOW) for the pixels at p,
+    // with their neighbors at +/-1 and +/-stride.
+    template <typename F>
+    void CasSharpenPixels(const float* const (&p)[3], ptrdiff_t stride, float peak, F (&pix)[3]) {
+        using L = Lanes<F>;
+
+        //  a b c
+        //  d e f
+        //  g h i
+        F b[3], d[3], e[3], f[3], h[3];
+        for (uint32_t c = 0; c < 3; c++) {
+            b[c] = L::Load(p[c] - stride);
+            d[c] = L::Load(p[c] - 1);
+            e[c] = L::Load(p[c]);
+            f[c] = L::Load(p[c] + 1);
+            h[c] = L::Load(p[c] + stride);
+        }
+
+        // Soft min and max, then the amount of sharpening. Only green is used for the weights.
+        const F mnG = Min3(Min3(d[1], e[1], f[1]), b[1], h[1]);
+        const F mxG = Max3(Max3(d[1], e[1], f[1]), b[1], h[1]);
+        F ampG = Saturate(Min(mnG, F(1.f) - mxG) * ApproxRcpLo(mxG));
+        ampG = ApproxSqrtLo(ampG);
+
+        // Filter shape.
+        //  0 w 0
+        //  w 1 w
+        //  0 w 0
+        const F wG = ampG * F(peak);
+        const F rcpWeight = ApproxRcpMed(F(1.f) + F(4.f) * wG);
+        for (uint32_t c = 0; c < 3; c++) {
+            pix[c] = Saturate((b[c] * wG + d[c] * wG + f[c] * wG + h[c] * wG + e[c]) * rcpWeight);
+        }
+    }
+
+    // The amount of sharpening of CasFilter() for one of the 4 nearest results.
+    template <typename F>
+    F CasWeight(F mn, F mx, float peak) {
+        F amp = Saturate(Min(mn, F(1.f) - mx) * ApproxRcpLo(mx));
+        amp = ApproxSqrtLo(amp);
+        return amp * F(peak);
+    }
+
+    // CasFilter() with scaling (without CAS_BETTER_DIAGONALS, CAS_GO_SLOWER and CAS_SLOW) for the output pixels at
+    // (x, y).
+    template <typename F>
+    void CasUpscalePixels(const PaddedImage& input, const CASConstants& constants, F x, float y, F (&pix)[3]) {
+        using L = Lanes<F>;
+        using I = typename L::Int;
+
+        const float ppY = y * AsFloat(constants.Const0[1]) + AsFloat(constants.Const0[3]);
+        const float fpY = std::floor(ppY);
+        const F fracY(ppY - fpY);
+
+        F ppX = x * F(AsFloat(constants.Const0[0])) + F(AsFloat(constants.Const0[2]));
+        const F fpX = Floor(ppX);
+        const F fracX = ppX - fpX;
+
+        //  a b c d
+        //  e f g h
+        //  i j k l
+        //  m n o p
+        // The loads outside of the image return 0.
+        F t[4][4][3];
+        I columns[4];
+        for (int32_t dx = -1; dx <= 2; dx++) {
+            columns[dx + 1] = ToInt(fpX + F(static_cast<float>(dx)));
+        }
+        for (int32_t dy = -1; dy <= 2; dy++) {
+            for (uint32_t c = 0; c < 3; c++) {
+                const float* const row = input.row(c, static_cast<int32_t>(fpY) + dy);
+                for (int32_t dx = -1; dx <= 2; dx++) {
+                    t[dy + 1][dx + 1][c] = L::Gather(row, columns[dx + 1]);
+                }
+            }
+        }
+        const auto& b = t[0][1];
+        const auto& c = t[0][2];
+        const auto& e = t[1][0];
+        const auto& f = t[1][1];
+        const auto& g = t[1][2];
+        const auto& h = t[1][3];
+        const auto& i = t[2][0];
+        const auto& j = t[2][1];
+        const auto& k = t[2][2];
+        const auto& l = t[2][3];
+        const auto& n = t[3][1];
+        const auto& o = t[3][2];
+
+        // Soft min and max of the 4 nearest results (using green only).
+        const F mnf = Min3(Min3(b[1], e[1], f[1]), g[1], j[1]);
+        const F mxf = Max3(Max3(b[1], e[1], f[1]), g[1], j[1]);
+        const F mng = Min3(Min3(c[1], f[1], g[1]), h[1], k[1]);
+        const F mxg = Max3(Max3(c[1], f[1], g[1]), h[1], k[1]);
+        const F mnj = Min3(Min3(f[1], i[1], j[1]), k[1], n[1]);
+        const F mxj = Max3(Max3(f[1], i[1], j[1]), k[1], n[1]);
+        const F mnk = Min3(Min3(g[1], j[1], k[1]), l[1], o[1]);
+        const F mxk = Max3(Max3(g[1], j[1], k[1]), l[1], o[1]);
+
+        const float peak = AsFloat(constants.Const1[0]);
+        const F wf = CasWeight(mnf, mxf, peak);
+        const F wg = CasWeight(mng, mxg, peak);
+        const F wj = CasWeight(mnj, mxj, peak);
+        const F wk = CasWeight(mnk, mxk, peak);
+
+        // Blend between 4 results, thinning edges to hide bilinear interpolation.
+        //  s t
+        //  u v
+        const F thinB(1.f / 32.f);
+        const F s = (F(1.f) - fracX) * (F(1.f) - fracY) * ApproxRcpLo(thinB + (mxf - mnf));
+        const F tt = fracX * (F(1.f) - fracY) * ApproxRcpLo(thinB + (mxg - mng));
+        const F u = (F(1.f) - fracX) * fracY * ApproxRcpLo(thinB + (mxj - mnj));
+        const F v = fracX * fracY * ApproxRcpLo(thinB + (mxk - mnk));
+
+        // Final weighting.
+        const F qbe = wf * s;
+        const F qch = wg * tt;
+        const F qf = wg * tt + wj * u + s;
+        const F qg = wf * s + wk * v + tt;
+        const F qj = wf * s + wk * v + u;
+        const F qk = wg * tt + wj * u + v;
+        const F qin = wj * u;
+        const F qlo = wk * v;
+        const F rcpW = ApproxRcpMed(F(2.f) * qbe + F(2.f) * qch + F(2.f) * qin + F(2.f) * qlo + qf + qg + qj + qk);
+        for (uint32_t ch = 0; ch < 3; ch++) {
+            pix[ch] = Saturate((b[ch] * qbe + e[ch] * qbe + c[ch] * qch + h[ch] * qch + i[ch] * qin + n[ch] * qin +
+                                l[ch] * qlo + o[ch] * qlo + f[ch] * qf + g[ch] * qg + j[ch] * qj + k[ch] * qk) *
+                               rcpW);
+        }
+    }
+
+    template <typename F>
+    F Luminance(const F (&color)[3], float r, float g, float b) {
+        return Saturate(color[0]) * F(r) + Saturate(color[1]) * F(g) + Saturate(color[2]) * F(b);
+    }
+
+    // AdjustGains() from postprocess.hlsl.
+    template <typename F>
+    void AdjustGains(F (&color)[3], const XrVector4f& gains) {
+        color[0] = Saturate(color[0] * F(gains.x + 1.f));
+        color[1] = Saturate(color[1] * F(gains.y + 1.f));
+        color[2] = Saturate(color[2] * F(gains.z + 1.f));
+    }
+
+    // PostProcess() from postprocess.hlsl.
+    template <typename F>
+    void PostProcessPixels(F (&color)[3], const PostProcessConstants& constants) {
+        const auto& params1 = constants.Params1;
+        const auto& params2 = constants.Params2;
+        const auto& params3 = constants.Params3;
+
+        // adjust color input gains.
+        if (params2.x || params2.y || params2.z) {
+            AdjustGains(color, params2);
+        }
+        // adjust lighting and saturation.
+        if (params1.x || params1.y || params1.z || params1.w) {
+            // AdjustContrast()
+            {
+                const F luminance = Luminance(color, 0.2125f, 0.7154f, 0.0721f);
+                F contrast = luminance * luminance * (F(3.f) - F(2.f) * luminance);
+                contrast = luminance + (contrast - luminance) * F(params1.x);
+                for (uint32_t c = 0; c < 3; c++) {
+                    color[c] = Max(color[c] + contrast - luminance, F(0.f));
+                }
+            }
+            // AdjustBrightness()
+            for (uint32_t c = 0; c < 3; c++) {
+                color[c] = SafePow(color[c], F(1.f - params1.y));
+            }
+            // AdjustExposure()
+            {
+                const F exposure(std::exp2(params1.z));
+                for (uint32_t c = 0; c < 3; c++) {
+                    color[c] = color[c] * exposure;
+                }
+            }
+            // AdjustSaturation()
+            {
+                const F luminance = Luminance(color, 0.2125f, 0.7154f, 0.0721f);
+                for (uint32_t c = 0; c < 3; c++) {
+                    color[c] = luminance + (color[c] - luminance) * F(params1.w + 1.f);
+                }
+            }
+        }
+        // boost colors
+        if (params3.z) {
+            // AdjustVibrance()
+            const F average = (color[0] + color[1] + color[2]) / F(3.f);
+            const F highest = Max(color[0], Max(color[1], color[2]));
+            const F amount = (average - highest) * F(params3.z);
+            for (uint32_t c = 0; c < 3; c++) {
+                color[c] = color[c] + (highest - color[c]) * amount;
+            }
+        }
+        // expand/crush luma for output.
+        if (params3.x || params3.y) {
+            // AdjustHighlightsShadows()
+            const F luma = Luminance(color, 0.3f, 0.3f, 0.3f);
+            const F h = F(1.f) - SafePow(F(1.f) - luma, F(1.f / (params3.x + 1.f)));
+            const F s = SafePow(luma, F(1.f / (params3.y + 1.f)));
+            for (uint32_t c = 0; c < 3; c++) {
+                color[c] = (color[c] / luma) * (h + s - luma);
+            }
+        }
+
+        for (uint32_t c = 0; c < 3; c++) {
+            color[c] = Saturate(color[c]);
+        }
+    }
+
+    // PassThrough() from postprocess.hlsl, with PASS_THROUGH_USE_GAINS.
+    template <typename F>
+    void PassThroughPixels(F (&color)[3], const PostProcessConstants& constants) {
+        const auto& params2 = constants.Params2;
+        if (params2.x || params2.y || params2.z) {
+            AdjustGains(color, params2);
+        }
+
+        for (uint32_t c = 0; c < 3; c++) {
+            color[c] = Saturate(color[c]);
+        }
+    }
+
+    // What the hardware does when writing to a sRGB render target.
+    template <typename F>
+    F EncodeSRGB(F value) {
+        value = Saturate(value);
+        return Select(LessEqual(value, F(0.0031308f)),
+                      value * F(12.92f),
+                      F(1.055f) * Exp2(Log2(Max(value, F(0.0031308f))) * F(1.f / 2.4f)) - F(0.055f));
+    }
+
+    // IsTileFoveated() from FSR.hlsl.
+    bool IsTileFoveated(uint32_t x, uint32_t y, uint32_t size, const Image& output, const float (&foveation)[4]) {
+        const float ndcX[2] = {2.f * (static_cast<float>(x) / output.width) - 1.f,
+                               2.f * (static_cast<float>(x + size) / output.width) - 1.f};
+        const float ndcY[2] = {-2.f * (static_cast<float>(y) / output.height) + 1.f,
+                               -2.f * (static_cast<float>(y + size) / output.height) + 1.f};
+        float posX = std::clamp(foveation[0], std::min(ndcX[0], ndcX[1]), std::max(ndcX[0], ndcX[1])) - foveation[0];
+        float posY = std::clamp(foveation[1], std::min(ndcY[0], ndcY[1]), std::max(ndcY[0], ndcY[1])) - foveation[1];
+        posX *= posX;
+        posY *= posY;
+        return posX * foveation[2] + posY * foveation[3] <= 1.f;
+    }
+
+    // The conversion to the R16G16B16A16_UNORM intermediate texture.
+    void QuantizeUnorm16(Image& image) {
+        for (auto& plane : image.planes) {
+            for (auto& value : plane) {
+                value = std::floor(std::clamp(value, 0.f, 1.f) * 65535.f + 0.5f) / 65535.f;
+            }
+        }
+    }
+
+} // namespace
+
+namespace testing::reference {
+
+    Image::Image(uint32_t width, uint32_t height) : width(width), height(height) {
+        for (auto& plane : planes) {
+            plane.resize((size_t)width * height);
+        }
+    }
+
+    bool IsSupported(Isa isa) {
+        int info[4];
+        switch (isa) {
+        case Isa::Scalar:
+            return true;
+
+        case Isa::SSE41:
+            __cpuid(info, 1);
+            return info[2] & (1 << 19);
+
+        case Isa::AVX2:
+            __cpuid(info, 1);
+            // AVX with OSXSAVE, and the OS saving the YMM registers.
+            if (!(info[2] & (1 << 27)) || !(info[2] & (1 << 28)) || (_xgetbv(0) & 6) != 6) {
+                return false;
+            }
+            __cpuidex(info, 7, 0);
+            return info[1] & (1 << 5);
+
+        default:
+            return false;
+        }
+    }
+
+    const char* ToString(Isa isa) {
+        switch (isa) {
+        case Isa::Scalar:
+            return "Scalar";
+        case Isa::SSE41:
+            return "SSE4.1";
+        case Isa::AVX2:
+            return "AVX2";
+        default:
+            return "";
+        }
+    }
+
+    void FsrEasu(const Image& input, Image& output, const FSRConstants& constants, Isa isa) {
+        Dispatch(isa, [&](auto lanes) {
+            using F = decltype(lanes);
+            for (uint32_t y = 0; y < output.height; y++) {
+                ForEachSpan<F>(output.width, [&](auto lane, uint32_t x) {
+                    using L = decltype(lane);
+                    // The spans never straddle two tiles.
+                    const L xs = Lanes<L>::Iota() + L(static_cast<float>(x));
+                    L pix[3];
+                    if (IsTileFoveated(x & ~15u, y & ~15u, 16, output, constants.Foveation[0])) {
+                        EasuPixels(input, constants, xs, (float)y, pix);
+                    } else {
+                        BilinearPixels(input, constants, xs, (float)y, pix);
+                    }
+                    for (uint32_t c = 0; c < 3; c++) {
+                        Lanes<L>::Store(&output.at(c, x, y), pix[c]);
+                    }
+                });
+            }
+        });
+    }
+
+    void FsrRcas(const Image& input, Image& output, const FSRConstants& constants, Isa isa) {
+        const PaddedImage padded(input, true /* squareRoot */);
+        Dispatch(isa, [&](auto lanes) {
+            using F = decltype(lanes);
+            for (uint32_t y = 0; y < output.height; y++) {
+                ForEachSpan<F>(output.width, [&](auto lane, uint32_t x) {
+                    using L = decltype(lane);
+                    // The spans never straddle two tiles.
+                    const float sharpness =
+                        AsFloat(IsTileFoveated(x & ~15u, y & ~15u, 16, output, constants.Foveation[0])
+                                    ? constants.Const4[0]
+                                    : constants.Const5[0]);
+                    const float* const p[3] = {padded.row(0, y) + x, padded.row(1, y) + x, padded.row(2, y) + x};
+                    L pix[3];
+                    RcasPixels(p, padded.stride, sharpness, pix);
+                    for (uint32_t c = 0; c < 3; c++) {
+                        Lanes<L>::Store(&output.at(c, x, y), pix[c] * pix[c]);
+                    }
+                });
+            }
+        });
+    }
+
+    void FsrUpscale(const Image& input, Image& output, const FSRConstants& constants, Isa isa) {
+        Image intermediate(output.width, output.height);
+        FsrEasu(input, intermediate, constants, isa);
+        QuantizeUnorm16(intermediate);
+        FsrRcas(intermediate, output, constants, isa);
+    }
+
+    void FsrFused(const Image& input,
+                  Image& output,
+                  const FSRConstants& constants,
+                  const PostProcessConstants& postProcess,
+                  int postProcessMode,
+                  Isa isa) {
+        constexpr uint32_t TileSize = 16;
+        constexpr uint32_t TileStride = TileSize + 2;
+
+        Dispatch(isa, [&](auto lanes) {
+            using F = decltype(lanes);
+            std::vector<float> tile[3];
+            for (auto& plane : tile) {
+                plane.resize(TileStride * TileStride);
+            }
+
+            for (uint32_t tileY = 0; tileY < output.height; tileY += TileSize) {
+                for (uint32_t tileX = 0; tileX < output.width; tileX += TileSize) {
+                    const bool isFoveated = IsTileFoveated(tileX, tileY, TileSize, output, constants.Foveation[0]);
+
+                    // EASU (or bilinear filtering outside of the foveated region), including the border needed by
+                    // RCAS. The pixels outside of the image replicate the edges.
+                    for (uint32_t i = 0; i < TileStride; i++) {
+                        const float y = static_cast<float>(
+                            std::clamp(static_cast<int32_t>(tileY + i) - 1, 0, static_cast<int32_t>(output.height) - 1));
+                        ForEachSpan<F>(TileStride, [&](auto lane, uint32_t j) {
+                            using L = decltype(lane);
+                            const L x = Min(Max(Lanes<L>::Iota() + L(static_cast<float>(tileX + j) - 1.f), L(0.f)),
+                                            L(output.width - 1.f));
+                            L pix[3];
+                            if (isFoveated) {
+                                EasuPixels(input, constants, x, y, pix);
+                            } else {
+                                BilinearPixels(input, constants, x, y, pix);
+                            }
+                            for (uint32_t c = 0; c < 3; c++) {
+                                Lanes<L>::Store(&tile[c][i * TileStride + j], Sqrt(Saturate(pix[c])));
+                            }
+                        });
+                    }
+
+                    const float sharpness = AsFloat(isFoveated ? constants.Const4[0] : constants.Const5[0]);
+                    const uint32_t width = std::min(TileSize, output.width - tileX);
+                    const uint32_t height = std::min(TileSize, output.height - tileY);
+                    for (uint32_t i = 0; i < height; i++) {
+                        ForEachSpan<F>(width, [&](auto lane, uint32_t j) {
+                            using L = decltype(lane);
+                            const size_t offset = (i + 1) * TileStride + j + 1;
+                            const float* const p[3] = {
+                                tile[0].data() + offset, tile[1].data() + offset, tile[2].data() + offset};
+                            L pix[3];
+                            RcasPixels(p, TileStride, sharpness, pix);
+                            for (uint32_t c = 0; c < 3; c++) {
+                                pix[c] = pix[c] * pix[c];
+                            }
+                            if (postProcessMode == 1) {
+                                PassThroughPixels(pix, postProcess);
+                            } else if (postProcessMode == 2) {
+                                PostProcessPixels(pix, postProcess);
+                            }
+                            for (uint32_t c = 0; c < 3; c++) {
+                                if (constants.OutputFlags[0]) {
+                                    pix[c] = EncodeSRGB(pix[c]);
+                                }
+                                Lanes<L>::Store(&output.at(c, tileX + j, tileY + i), pix[c]);
+                            }
+                        });
+                    }
+                }
+            }
+        });
+    }
+
+    void Cas(const Image& input, Image& output, const CASConstants& constants, bool sharpenOnly, Isa isa) {
+        const PaddedImage padded(input, false /* squareRoot */);
+        Dispatch(isa, [&](auto lanes) {
+            using F = decltype(lanes);
+            for (uint32_t y = 0; y < output.height; y++) {
+                ForEachSpan<F>(output.width, [&](auto lane, uint32_t x) {
+                    using L = decltype(lane);
+                    L pix[3];
+                    if (sharpenOnly) {
+                        const float* const p[3] = {padded.row(0, y) + x, padded.row(1, y) + x, padded.row(2, y) + x};
+                        CasSharpenPixels(p, padded.stride, AsFloat(constants.Const1[0]), pix);
+                    } else {
+                        CasUpscalePixels(padded, constants, Lanes<L>::Iota() + L(static_cast<float>(x)), (float)y, pix);
+                    }
+                    for (uint32_t c = 0; c < 3; c++) {
+                        Lanes<L>::Store(&output.at(c, x, y), pix[c]);
+                    }
+                });
+            }
+        });
+    }
+
+    void PostProcess(Image& image, const PostProcessConstants& constants, Isa isa) {
+        Dispatch(isa, [&](auto lanes) {
+            using F = decltype(lanes);
+            for (uint32_t y = 0; y < image.height; y++) {
+                ForEachSpan<F>(image.width, [&](auto lane, uint32_t x) {
+                    using L = decltype(lane);
+                    L color[3];
+                    for (uint32_t c = 0; c < 3; c++) {
+                        color[c] = Lanes<L>::Load(&image.at(c, x, y));
+                    }
+                    PostProcessPixels(color, constants);
+                    for (uint32_t c = 0; c < 3; c++) {
+                        Lanes<L>::Store(&image.at(c, x, y), color[c]);
+                    }
+                });
+            }
+        });
+    }
+
+    void PassThrough(Image& image, const PostProcessConstants& constants, Isa isa) {
+        Dispatch(isa, [&](auto lanes) {
+            using F = decltype(lanes);
+            for (uint32_t y = 0; y < image.height; y++) {
+                ForEachSpan<F>(image.width, [&](auto lane, uint32_t x) {
+                    using L = decltype(lane);
+                    L color[3];
+                    for (uint32_t c = 0; c < 3; c++) {
+                        color[c] = Lanes<L>::Load(&image.at(c, x, y));
+                    }
+                    PassThroughPixels(color, constants);
+                    for (uint32_t c = 0; c < 3; c++) {
+                        Lanes<L>::Store(&image.at(c, x, y), color[c]);
+                    }
+                });
+            }
+        });
+    }
+
+    FSRConstants MakeFSRConstants(
+        uint32_t inputWidth, uint32_t inputHeight, uint32_t outputWidth, uint32_t outputHeight, float sharpness) {
+        FSRConstants constants{};
+        FsrEasuCon(constants.Const0,
+                   constants.Const1,
+                   constants.Const2,
+                   constants.Const3,
+                   static_cast<AF1>(inputWidth),
+                   static_cast<AF1>(inputHeight),
+                   static_cast<AF1>(inputWidth),
+                   static_cast<AF1>(inputHeight),
+                   static_cast<AF1>(outputWidth),
+                   static_cast<AF1>(outputHeight));
+
+        const auto attenuation = 1.f - AClampF1(sharpness, 0, 1);
+        FsrRcasCon(constants.Const4, static_cast<AF1>(attenuation));
+        FsrRcasCon(constants.Const5, static_cast<AF1>(attenuation + 1.f));
+        return constants;
+    }
+
+    CASConstants MakeCASConstants(
+        uint32_t inputWidth, uint32_t inputHeight, uint32_t outputWidth, uint32_t outputHeight, float sharpness) {
+        CASConstants constants{};
+        CasSetup(constants.Const0,
+                 constants.Const1,
+                 AClampF1(sharpness, 0, 1),
+                 static_cast<AF1>(inputWidth),
+                 static_cast<AF1>(inputHeight),
+                 static_cast<AF1>(outputWidth),
+                 static_cast<AF1>(outputHeight));
+        return constants;
+    }
+
+    Image MakeTestImage(uint32_t width, uint32_t height) {
+        const auto pattern = [](float u, float v, float (&color)[3]) {
+            // Smooth gradients.
+            color[0] = u;
+            color[1] = v;
+            color[2] = 0.5f + 0.4f * std::sin(6.2831853f * (u + v));
+
+            // A disc with hard edges.
+            if ((u - 0.35f) * (u - 0.35f) + (v - 0.4f) * (v - 0.4f) < 0.04f) {
+                color[0] = 0.9f;
+                color[1] = 0.2f;
+                color[2] = 0.1f;
+            }
+
+            // Thin diagonal lines.
+            const float line = (u - v) * 8.f;
+            if (line - std::floor(line) < 0.05f) {
+                color[0] = color[1] = color[2] = 0.05f;
+            }
+
+            // A fine checkerboard.
+            if (u > 0.65f && v > 0.6f) {
+                const bool isOdd = (static_cast<int>(u * 24.f) + static_cast<int>(v * 24.f)) % 2;
+                color[0] = color[1] = color[2] = isOdd ? 0.85f : 0.15f;
+            }
+        };
+
+        // Average 4x4 samples per pixel.
+        constexpr uint32_t Samples = 4;
+        Image image(width, height);
+        for (uint32_t y = 0; y < height; y++) {
+            for (uint32_t x = 0; x < width; x++) {
+                float sum[3] = {};
+                for (uint32_t i = 0; i < Samples * Samples; i++) {
+                    float color[3];
+                    pattern((x + (i % Samples + 0.5f) / Samples) / width,
+                            (y + (i / Samples + 0.5f) / Samples) / height,
+                            color);
+                    for (uint32_t c = 0; c < 3; c++) {
+                        sum[c] += color[c];
+                    }
+                }
+                for (uint32_t c = 0; c < 3; c++) {
+                    image.at(c, x, y) = sum[c] / (Samples * Samples);
+                }
+            }
+        }
+        return image;
+    }
+
+    double ComputePSNR(const Image& a, const Image& b) {
+        double sum = 0;
+        for (uint32_t c = 0; c < 3; c++) {
+            for (size_t i = 0; i < a.planes[c].size(); i++) {
+                const double error = (double)a.planes[c][i] - b.planes[c][i];
+                sum += error * error;
+            }
+        }
+        const double mse = sum / (3.0 * a.width * a.height);
+        return mse > 0 ? 10 * std::log10(1 / mse) : std::numeric_limits<double>::infinity();
+    }
+
+    float ComputeMaxDifference(const Image& a, const Image& b) {
+        float maxDifference = 0;
+        for (uint32_t c = 0; c < 3; c++) {
+            for (size_t i = 0; i < a.planes[c].size(); i++) {
+                maxDifference = std::max(maxDifference, std::abs(a.planes[c][i] - b.planes[c][i]));
+            }
+        }
+        return maxDifference;
+    }
+
+    bool WriteImage(const std::filesystem::path& path, const Image& image) {
+        std::ofstream file(path, std::ios::binary);
+        file << "P6\n" << image.width << " " << image.height << "\n65535\n";
+        for (uint32_t y = 0; y < image.height; y++) {
+            for (uint32_t x = 0; x < image.width; x++) {
+                for (uint32_t c = 0; c < 3; c++) {
+                    const auto value =
+                        static_cast<uint16_t>(std::clamp(image.at(c, x, y), 0.f, 1.f) * 65535.f + 0.5f);
+                    file.put(static_cast<char>(value >> 8));
+                    file.put(static_cast<char>(value & 0xff));
+                }
+            }
+        }
+        return file.good();
+    }
+
+    std::optional<Image> ReadImage(const std::filesystem::path& path) {
+        std::ifstream file(path, std::ios::binary);
+        std::string magic;
+        uint32_t width = 0, height = 0, maxValue = 0;
+        file >> magic >> width >> height >> maxValue;
+        if (!file || magic != "P6" || maxValue != 65535) {
+            return {};
+        }
+        file.get();
+
+        Image image(width, height);
+        for (uint32_t y = 0; y < height; y++) {
+            for (uint32_t x = 0; x < width; x++) {
+                for (uint32_t c = 0; c < 3; c++) {
+                    const auto high = static_cast<uint8_t>(file.get());
+                    const auto low = static_cast<uint8_t>(file.get());
+                    image.at(c, x, y) = ((high << 8) | low) / 65535.f;
+                }
+            }
+        }
+        if (!file) {
+            return {};
+        }
+        return image;
+    }
+
+} // namespace testing::reference
@@ -0,0 +1,107 @@
+// MIT License
+//
+// Copyright(c) 2022 Matthieu Bucchianeri
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this softwareand associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright noticeand this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include "interfaces.h"
+
+// CPU reference implementations of the upscalers and post-processing shaders, for testing them without a GPU.
+// Each kernel follows the FP32 permutation of the shader that the layer uses, and reads the same constant buffer
+// (filled with the same FidelityFX setup functions as the layer).
+namespace testing::reference {
+
+    using toolkit::graphics::CASConstants;
+    using toolkit::graphics::FSRConstants;
+    using toolkit::graphics::PostProcessConstants;
+
+    // A linear RGB image, with one plane per channel.
+    struct Image {
+        Image() = default;
+        Image(uint32_t width, uint32_t height);
+
+        float& at(uint32_t channel, uint32_t x, uint32_t y) {
+            return planes[channel][(size_t)y * width + x];
+        }
+        float at(uint32_t channel, uint32_t x, uint32_t y) const {
+            return planes[channel][(size_t)y * width + x];
+        }
+
+        uint32_t width{0};
+        uint32_t height{0};
+        std::vector<float> planes[3];
+    };
+
+    // The instruction sets that the kernels are compiled for.
+    enum class Isa { Scalar = 0, SSE41, AVX2, MaxValue };
+
+    bool IsSupported(Isa isa);
+    const char* ToString(Isa isa);
+
+    // FSR.hlsl mainCS with SAMPLE_EASU (bilinear filtering outside of the foveated region).
+    void FsrEasu(const Image& input, Image& output, const FSRConstants& constants, Isa isa);
+
+    // FSR.hlsl mainCS with SAMPLE_RCAS and SAMPLE_HDR_OUTPUT (lighter outside of the foveated region). The output has
+    // the size of the input.
+    void FsrRcas(const Image& input, Image& output, const FSRConstants& constants, Isa isa);
+
+    // The separate (non-fused) path of the FSR upscaler: EASU into the R16G16B16A16_UNORM intermediate, then RCAS.
+    void FsrUpscale(const Image& input, Image& output, const FSRConstants& constants, Isa isa);
+
+    // FSR.hlsl mainFusedCS with SAMPLE_POST_PROCESS (0 = none, 1 = color gains only, 2 = all the adjustments).
+    void FsrFused(const Image& input,
+                  Image& output,
+                  const FSRConstants& constants,
+                  const PostProcessConstants& postProcess,
+                  int postProcessMode,
+                  Isa isa);
+
+    // CAS.hlsl mainCS.
+    void Cas(const Image& input, Image& output, const CASConstants& constants, bool sharpenOnly, Isa isa);
+
+    // postprocess.hlsl mainPostProcess and mainPassThrough (with PASS_THROUGH_USE_GAINS), in place. The chromatic
+    // aberration correction of mainPassThrough is not implemented.
+    void PostProcess(Image& image, const PostProcessConstants& constants, Isa isa);
+    void PassThrough(Image& image, const PostProcessConstants& constants, Isa isa);
+
+    // The constants of the FSR upscaler for an image, like FSRUpscaler::updateConfig() (no foveation, no sRGB output).
+    FSRConstants MakeFSRConstants(
+        uint32_t inputWidth, uint32_t inputHeight, uint32_t outputWidth, uint32_t outputHeight, float sharpness);
+
+    // The constants of the CAS upscaler for an image, like CASUpscaler::processInternal().
+    CASConstants MakeCASConstants(
+        uint32_t inputWidth, uint32_t inputHeight, uint32_t outputWidth, uint32_t outputHeight, float sharpness);
+
+    // A synthetic image with smooth gradients, hard edges, thin lines and a fine checkerboard. Images of different
+    // sizes show the same content, so a larger one serves as the ground truth for upscaling a smaller one.
+    Image MakeTestImage(uint32_t width, uint32_t height);
+
+    // The peak signal-to-noise ratio between two images of the same size, for a peak value of 1.
+    double ComputePSNR(const Image& a, const Image& b);
+
+    // The largest absolute difference between two images of the same size.
+    float ComputeMaxDifference(const Image& a, const Image& b);
+
+    // Read and write a 16-bit binary PPM file (values are saturated).
+    bool WriteImage(const std::filesystem::path& path, const Image& image);
+    std::optional<Image> ReadImage(const std::filesystem::path& path);
+
+} // namespace testing::reference
@@ -0,0 +1,319 @@
+// MIT License
+//
+// Copyright(c) 2022 Matthieu Bucchianeri
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this softwareand associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright noticeand this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "pch.h"
+
+#include "image_reference.h"
+#include "testing.h"
+
+namespace {
+
+    using namespace testing;
+    using namespace testing::reference;
+
+    // Odd sizes, to exercise the remainder of the rows.
+    constexpr uint32_t InputWidth = 45;
+    constexpr uint32_t InputHeight = 37;
+    constexpr uint32_t OutputWidth = 67;
+    constexpr uint32_t OutputHeight = 55;
+
+    PostProcessConstants MakePostProcessConstants() {
+        PostProcessConstants constants{};
+        constants.Params1 = {0.2f, 0.1f, 0.1f, 0.15f};
+        constants.Params2 = {0.05f, 0.f, -0.05f, 0.f};
+        constants.Params3 = {0.2f, 0.3f, 0.4f, 0.f};
+        return constants;
+    }
+
+    // Enable the foveated region, with an ellipse around the gaze like the VRS inner ring.
+    void SetFoveation(FSRConstants& constants, float gazeX, float gazeY, float semiMajor, float semiMinor) {
+        constants.Foveation[0][0] = gazeX;
+        constants.Foveation[0][1] = gazeY;
+        constants.Foveation[0][2] = 1.f / (semiMajor * semiMajor);
+        constants.Foveation[0][3] = 1.f / (semiMinor * semiMinor);
+    }
+
+    // The largest absolute difference, excluding a border (where the shaders differ in their handling of the edges).
+    float ComputeMaxInteriorDifference(const Image& a, const Image& b, uint32_t border) {
+        float maxDifference = 0;
+        for (uint32_t c = 0; c < 3; c++) {
+            for (uint32_t y = border; y < a.height - border; y++) {
+                for (uint32_t x = border; x < a.width - border; x++) {
+                    maxDifference = std::max(maxDifference, std::abs(a.at(c, x, y) - b.at(c, x, y)));
+                }
+            }
+        }
+        return maxDifference;
+    }
+
+    // Bilinear filtering with the clamp sampler.
+    Image ResizeBilinear(const Image& input, uint32_t width, uint32_t height) {
+        Image output(width, height);
+        for (uint32_t y = 0; y < height; y++) {
+            const float v = (y + 0.5f) * input.height / height - 0.5f;
+            const float fracY = v - std::floor(v);
+            const auto y0 = static_cast<uint32_t>(std::clamp(std::floor(v), 0.f, input.height - 1.f));
+            const auto y1 = static_cast<uint32_t>(std::clamp(std::floor(v) + 1, 0.f, input.height - 1.f));
+            for (uint32_t x = 0; x < width; x++) {
+                const float u = (x + 0.5f) * input.width / width - 0.5f;
+                const float fracX = u - std::floor(u);
+                const auto x0 = static_cast<uint32_t>(std::clamp(std::floor(u), 0.f, input.width - 1.f));
+                const auto x1 = static_cast<uint32_t>(std::clamp(std::floor(u) + 1, 0.f, input.width - 1.f));
+                for (uint32_t c = 0; c < 3; c++) {
+                    const float top = input.at(c, x0, y0) + (input.at(c, x1, y0) - input.at(c, x0, y0)) * fracX;
+                    const float bottom = input.at(c, x0, y1) + (input.at(c, x1, y1) - input.at(c, x0, y1)) * fracX;
+                    output.at(c, x, y) = top + (bottom - top) * fracY;
+                }
+            }
+        }
+        return output;
+    }
+
+    // Run each kernel on the test image with the given instruction set.
+    std::map<std::string, Image> RunKernels(Isa isa) {
+        const auto input = MakeTestImage(InputWidth, InputHeight);
+        const auto postProcess = MakePostProcessConstants();
+        std::map<std::string, Image> outputs;
+
+        auto fsr = MakeFSRConstants(InputWidth, InputHeight, OutputWidth, OutputHeight, 0.5f);
+        outputs["easu"] = Image(OutputWidth, OutputHeight);
+        FsrEasu(input, outputs["easu"], fsr, isa);
+        outputs["rcas"] = Image(InputWidth, InputHeight);
+        FsrRcas(input, outputs["rcas"], fsr, isa);
+        outputs["fsr"] = Image(OutputWidth, OutputHeight);
+        FsrUpscale(input, outputs["fsr"], fsr, isa);
+        SetFoveation(fsr, 0.1f, -0.1f, 0.5f, 0.4f);
+        fsr.OutputFlags[0] = 1;
+        for (int mode = 0; mode <= 2; mode++) {
+            const auto name = "fsr_fused_" + std::to_string(mode);
+            outputs[name] = Image(OutputWidth, OutputHeight);
+            FsrFused(input, outputs[name], fsr, postProcess, mode, isa);
+        }
+
+        const auto cas = MakeCASConstants(InputWidth, InputHeight, OutputWidth, OutputHeight, 0.5f);
+        outputs["cas"] = Image(OutputWidth, OutputHeight);
+        Cas(input, outputs["cas"], cas, false /* sharpenOnly */, isa);
+        const auto casSharpen = MakeCASConstants(InputWidth, InputHeight, InputWidth, InputHeight, 0.5f);
+        outputs["cas_sharpen"] = Image(InputWidth, InputHeight);
+        Cas(input, outputs["cas_sharpen"], casSharpen, true /* sharpenOnly */, isa);
+
+        outputs["postprocess"] = input;
+        PostProcess(outputs["postprocess"], postProcess, isa);
+        outputs["passthrough"] = input;
+        PassThrough(outputs["passthrough"], postProcess, isa);
+
+        return outputs;
+    }
+
+    TEST_CASE(ImageReference_SimdMatchesScalar) {
+        const auto expected = RunKernels(Isa::Scalar);
+        for (int i = 1; i < static_cast<int>(Isa::MaxValue); i++) {
+            const auto isa = static_cast<Isa>(i);
+            if (!IsSupported(isa)) {
+                std::cout << "  " << ToString(isa) << " is not supported, skipping" << std::endl;
+                continue;
+            }
+
+            // The kernels perform the same operations for each lane type, but the compiler may contract them (and the
+            // 16-bit intermediate of the separate FSR path may then round the other way).
+            for (const auto& [name, output] : RunKernels(isa)) {
+                const float difference = ComputeMaxDifference(output, expected.at(name));
+                if (difference > 1e-4f) {
+                    Fail(__FILE__,
+                         __LINE__,
+                         fmt::format("{} with {} differs from scalar by {}", name, ToString(isa), difference));
+                }
+            }
+        }
+    }
+
+    TEST_CASE(ImageReference_FlatField) {
+        Image input(InputWidth, InputHeight);
+        for (auto& plane : input.planes) {
+            std::fill(plane.begin(), plane.end(), 0.5f);
+        }
+
+        // EASU uses the clamp sampler, the whole image is preserved.
+        const auto fsr = MakeFSRConstants(InputWidth, InputHeight, OutputWidth, OutputHeight, 1.f);
+        Image easu(OutputWidth, OutputHeight);
+        FsrEasu(input, easu, fsr, Isa::Scalar);
+        for (const auto& plane : easu.planes) {
+            for (const auto value : plane) {
+                CHECK(std::abs(value - 0.5f) < 1e-6f);
+            }
+        }
+
+        // RCAS and CAS load 0 outside of the image, only the interior is preserved (within 1%, because of the
+        // approximation of the reciprocal when resolving).
+        Image rcas(InputWidth, InputHeight);
+        FsrRcas(input, rcas, fsr, Isa::Scalar);
+        CHECK(ComputeMaxInteriorDifference(rcas, input, 1) < 0.5f * 1e-2f);
+
+        const auto casSharpen = MakeCASConstants(InputWidth, InputHeight, InputWidth, InputHeight, 1.f);
+        Image cas(InputWidth, InputHeight);
+        Cas(input, cas, casSharpen, true /* sharpenOnly */, Isa::Scalar);
+        CHECK(ComputeMaxInteriorDifference(cas, input, 1) < 0.5f * 1e-2f);
+    }
+
+    TEST_CASE(ImageReference_PostProcessIdentity) {
+        const auto input = MakeTestImage(InputWidth, InputHeight);
+
+        // Without any adjustment, both permutations only saturate the input (which is already in range).
+        const PostProcessConstants constants{};
+        auto postProcess = input;
+        PostProcess(postProcess, constants, Isa::Scalar);
+        CHECK_EQ(ComputeMaxDifference(postProcess, input), 0.f);
+        auto passThrough = input;
+        PassThrough(passThrough, constants, Isa::Scalar);
+        CHECK_EQ(ComputeMaxDifference(passThrough, input), 0.f);
+
+        // The fused permutations match the separate post-processing of the upscaled image.
+        const auto postProcessConstants = MakePostProcessConstants();
+        const auto fsr = MakeFSRConstants(InputWidth, InputHeight, OutputWidth, OutputHeight, 0.5f);
+        Image upscaled(OutputWidth, OutputHeight);
+        FsrFused(input, upscaled, fsr, postProcessConstants, 0, Isa::Scalar);
+        Image fused(OutputWidth, OutputHeight);
+        FsrFused(input, fused, fsr, postProcessConstants, 2, Isa::Scalar);
+        PostProcess(upscaled, postProcessConstants, Isa::Scalar);
+        CHECK(ComputeMaxDifference(fused, upscaled) < 1e-6f);
+    }
+
+    TEST_CASE(ImageReference_FusedMatchesSeparate) {
+        const auto input = MakeTestImage(InputWidth, InputHeight);
+        const auto fsr = MakeFSRConstants(InputWidth, InputHeight, OutputWidth, OutputHeight, 0.5f);
+
+        // The separate path goes through a 16-bit intermediate and loads 0 outside of the image, while the fused path
+        // replicates the edges.
+        Image separate(OutputWidth, OutputHeight);
+        FsrUpscale(input, separate, fsr, Isa::Scalar);
+        Image fused(OutputWidth, OutputHeight);
+        FsrFused(input, fused, fsr, {}, 0, Isa::Scalar);
+        CHECK(ComputeMaxInteriorDifference(fused, separate, 1) < 1e-3f);
+        CHECK(ComputePSNR(fused, separate) > 30);
+
+        // With the sRGB output flag, the values are encoded like the hardware would do.
+        auto srgbConstants = fsr;
+        srgbConstants.OutputFlags[0] = 1;
+        Image srgb(OutputWidth, OutputHeight);
+        FsrFused(input, srgb, srgbConstants, {}, 0, Isa::Scalar);
+        float maxError = 0;
+        for (uint32_t c = 0; c < 3; c++) {
+            for (size_t i = 0; i < fused.planes[c].size(); i++) {
+                const float value = std::clamp(fused.planes[c][i], 0.f, 1.f);
+                const float expected =
+                    value <= 0.0031308f ? value * 12.92f : 1.055f * std::pow(value, 1.f / 2.4f) - 0.055f;
+                maxError = std::max(maxError, std::abs(srgb.planes[c][i] - expected));
+            }
+        }
+        CHECK(maxError < 1e-5f);
+    }
+
+    TEST_CASE(ImageReference_Foveation) {
+        const auto input = MakeTestImage(InputWidth, InputHeight);
+
+        // Both the fused and the separate paths.
+        const std::function<void(const FSRConstants&, Image&)> upscalers[] = {
+            [&](const FSRConstants& fsr, Image& output) { FsrFused(input, output, fsr, {}, 0, Isa::Scalar); },
+            [&](const FSRConstants& fsr, Image& output) { FsrUpscale(input, output, fsr, Isa::Scalar); },
+        };
+        for (const auto& upscale : upscalers) {
+            auto fsr = MakeFSRConstants(InputWidth, InputHeight, OutputWidth, OutputHeight, 0.5f);
+            Image full(OutputWidth, OutputHeight);
+            upscale(fsr, full);
+
+            // The tiles containing the gaze are processed at full quality, the corners are not. In the separate path,
+            // RCAS reads the pixels of the neighboring tiles, so the border of the tile is excluded.
+            SetFoveation(fsr, 0.f, 0.f, 0.2f, 0.2f);
+            Image foveated(OutputWidth, OutputHeight);
+            upscale(fsr, foveated);
+            float centerDifference = 0;
+            float cornerDifference = 0;
+            for (uint32_t c = 0; c < 3; c++) {
+                for (uint32_t y = 0; y < 16; y++) {
+                    for (uint32_t x = 0; x < 16; x++) {
+                        if (x > 0 && x < 15 && y > 0 && y < 15) {
+                            centerDifference =
+                                std::max(centerDifference,
+                                         std::abs(full.at(c, 32 + x, 16 + y) - foveated.at(c, 32 + x, 16 + y)));
+                        }
+                        cornerDifference =
+                            std::max(cornerDifference, std::abs(full.at(c, x, y) - foveated.at(c, x, y)));
+                    }
+                }
+            }
+            CHECK_EQ(centerDifference, 0.f);
+            CHECK(cornerDifference > 0.f);
+        }
+    }
+
+    TEST_CASE(ImageReference_UpscalingQuality) {
+        const auto input = MakeTestImage(InputWidth, InputHeight);
+        const auto groundTruth = MakeTestImage(OutputWidth, OutputHeight);
+
+        const auto bilinear = ResizeBilinear(input, OutputWidth, OutputHeight);
+
+        Image easu(OutputWidth, OutputHeight);
+        FsrEasu(input, easu, MakeFSRConstants(InputWidth, InputHeight, OutputWidth, OutputHeight, 0.5f), Isa::Scalar);
+        Image cas(OutputWidth, OutputHeight);
+        Cas(input,
+            cas,
+            MakeCASConstants(InputWidth, InputHeight, OutputWidth, OutputHeight, 0.5f),
+            false /* sharpenOnly */,
+            Isa::Scalar);
+
+        const double bilinearPSNR = ComputePSNR(bilinear, groundTruth);
+        const double easuPSNR = ComputePSNR(easu, groundTruth);
+        const double casPSNR = ComputePSNR(cas, groundTruth);
+        Report("bilinear PSNR", bilinearPSNR, "dB");
+        Report("EASU PSNR", easuPSNR, "dB");
+        Report("CAS PSNR", casPSNR, "dB");
+        CHECK(easuPSNR > bilinearPSNR);
+        CHECK(casPSNR > 20);
+    }
+
+    TEST_CASE(ImageReference_Golden) {
+        const auto& directory = GetGoldenDirectory();
+        for (const auto& [name, output] : RunKernels(Isa::Scalar)) {
+            const auto path = directory / (name + ".ppm");
+            const auto golden = ReadImage(path);
+            if (!golden) {
+                // Record the missing reference images, to be reviewed and checked in.
+                std::filesystem::create_directories(directory);
+                CHECK(WriteImage(path, output));
+                std::cout << "  wrote " << path.string() << std::endl;
+                continue;
+            }
+
+            if (golden->width != output.width || golden->height != output.height) {
+                Fail(__FILE__, __LINE__, fmt::format("{} does not have the size of the output", path.string()));
+                continue;
+            }
+
+            // The reference images are quantized to 16 bits.
+            const double psnr = ComputePSNR(output, *golden);
+            if (psnr < 80) {
+                Fail(__FILE__, __LINE__, fmt::format("{} differs from the reference image (PSNR {:.1f} dB)", name, psnr));
+            }
+        }
+    }
+
+} // namespace
@@ -0,0 +1,113 @@
+// MIT License
+//
+// Copyright(c) 2021-2022 Matthieu Bucchianeri
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this softwareand associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright noticeand this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include "pch.h"
+
+#include "layer.h"
+#include "log.h"
+
+#include "testing.h"
+
+namespace toolkit {
+    // The globals normally initialized by the layer's entry point.
+    std::filesystem::path dllHome;
+    std::filesystem::path localAppData;
+
+    namespace log {
+        std::ofstream logStream;
+    } // namespace log
+} // namespace toolkit
+
+namespace testing {
+
+    namespace {
+        int g_failures = 0;
+        const char* g_currentTest = nullptr;
+        std::filesystem::path g_goldenDirectory = std::filesystem::path(__FILE__).parent_path() / "golden";
+    } // namespace
+
+    std::vector<TestCase>& GetRegistry() {
+        static std::vector<TestCase> registry;
+        return registry;
+    }
+
+    void Fail(const char* file, int line, const std::string& message) {
+        std::cout << "  " << file << "(" << line << "): check failed in " << g_currentTest << ": " << message
+                  << std::endl;
+        g_failures++;
+    }
+
+    void Report(const std::string& name, double value, const char* unit) {
+        std::cout << "  " << std::left << std::setw(48) << name << std::right << std::setw(12) << std::fixed
+                  << std::setprecision(2) << value << " " << unit << std::endl;
+    }
+
+    const std::filesystem::path& GetGoldenDirectory() {
+        return g_goldenDirectory;
+    }
+
+} // namespace testing
+
+// Usage: tests [--benchmark] [--golden <directory>] [filter]
+int main(int argc, char** argv) {
+    bool runBenchmarks = false;
+    std::string filter;
+    for (int i = 1; i < argc; i++) {
+        const std::string arg = argv[i];
+        if (arg == "--benchmark") {
+            runBenchmarks = true;
+        } else if (arg == "--golden" && i + 1 < argc) {
+            testing::g_goldenDirectory = argv[++i];
+        } else {
+            filter = arg;
+        }
+    }
+
+    toolkit::localAppData = std::filesystem::temp_directory_path() / "OpenXR-Toolkit-tests";
+    std::filesystem::create_directories(toolkit::localAppData);
+
+    int count = 0;
+    for (const auto& test : testing::GetRegistry()) {
+        if (test.isBenchmark != runBenchmarks ||
+            (!filter.empty() && std::string(test.name).find(filter) == std::string::npos)) {
+            continue;
+        }
+
+        std::cout << "[ RUN  ] " << test.name << std::endl;
+        testing::g_currentTest = test.name;
+        const int failuresBefore = testing::g_failures;
+        try {
+            test.function();
+        } catch (std::exception& exc) {
+            testing::Fail(__FILE__, __LINE__, std::string("unexpected exception: ") + exc.what());
+        }
+        std::cout << (testing::g_failures == failuresBefore ? "[  OK  ] " : "[ FAIL ] ") << test.name << std::endl;
+        count++;
+    }
+
+    std::error_code ec;
+    std::filesystem::remove_all(toolkit::localAppData, ec);
+
+    std::cout << count << " test(s) run, " << testing::g_failures << " failure(s)" << std::endl;
+    return testing::g_failures ? 1 : 0;
+}
@@ -0,0 +1,215 @@
+// MIT License
+//
+// Copyright(c) 2021-2022 Matthieu Bucchianeri
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this softwareand associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright noticeand this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+#include "interfaces.h"
+
+namespace testing {
+
+    // An in-memory config store. The "backing storage" can be modified directly to emulate another process (eg: the
+    // companion app) editing the values.
+    // With deferred writes, the backing storage is only updated upon flush(), and flush() can be held to observe the
+    // config writer thread in the middle of a batch.
+    class MemoryConfigStore : public toolkit::config::IConfigStore {
+      public:
+        void reload() override {
+            std::unique_lock lock(m_mutex);
+            m_values = m_backing;
+            m_reloadCount++;
+        }
+
+        std::optional<int> read(std::string_view name) const override {
+            std::unique_lock lock(m_mutex);
+            const auto it = m_values.find(name);
+            if (it != m_values.end()) {
+                return it->second;
+            }
+            return {};
+        }
+
+        std::optional<int> readGlobal(std::string_view name) const override {
+            std::unique_lock lock(m_mutex);
+            const auto it = m_globals.find(name);
+            if (it != m_globals.end()) {
+                return it->second;
+            }
+            return {};
+        }
+
+        std::map<std::string, int, std::less<>> readAll() const override {
+            std::unique_lock lock(m_mutex);
+            return m_values;
+        }
+
+        void write(std::string_view name, int value) override {
+            std::unique_lock lock(m_mutex);
+            m_values.insert_or_assign(std::string(name), value);
+            if (m_deferWrites) {
+                m_unflushed.push_back({std::string(name), value});
+            } else {
+                m_backing.insert_or_assign(std::string(name), value);
+            }
+        }
+
+        void remove(std::string_view name) override {
+            std::unique_lock lock(m_mutex);
+            m_values.erase(std::string(name));
+            if (m_deferWrites) {
+                m_unflushed.push_back({std::string(name), std::nullopt});
+            } else {
+                m_backing.erase(std::string(name));
+            }
+        }
+
+        void removeAll() override {
+            std::unique_lock lock(m_mutex);
+            m_values.clear();
+            if (m_deferWrites) {
+                m_unflushed.push_back({"", std::nullopt});
+            } else {
+                m_backing.clear();
+            }
+        }
+
+        void flush() override {
+            {
+                std::unique_lock lock(m_mutex);
+                m_isFlushing = true;
+                m_flushed.notify_all();
+                m_flushed.wait(lock, [&] { return !m_holdFlush; });
+
+                for (const auto& [name, value] : m_unflushed) {
+                    if (name.empty()) {
+                        m_backing.clear();
+                    } else if (value) {
+                        m_backing.insert_or_assign(name, value.value());
+                    } else {
+                        m_backing.erase(name);
+                    }
+                }
+                m_unflushed.clear();
+                m_isFlushing = false;
+                m_flushCount++;
+            }
+            m_flushed.notify_all();
+        }
+
+        void watch(std::function<void()> onChanged) override {
+            m_onChanged = std::move(onChanged);
+        }
+
+        void setActiveSession(const std::string& appName) override {
+            std::unique_lock lock(m_mutex);
+            m_activeSession = appName;
+        }
+
+        // Emulate a modification from another process.
+        void externalWrite(const std::string& name, int value) {
+            {
+                std::unique_lock lock(m_mutex);
+                m_backing.insert_or_assign(name, value);
+            }
+            if (m_onChanged) {
+                m_onChanged();
+            }
+        }
+
+        void setGlobal(const std::string& name, int value) {
+            std::unique_lock lock(m_mutex);
+            m_globals.insert_or_assign(name, value);
+        }
+
+        // Read the backing storage, rather than the snapshot.
+        std::optional<int> stored(const std::string& name) const {
+            std::unique_lock lock(m_mutex);
+            const auto it = m_backing.find(name);
+            if (it != m_backing.end()) {
+                return it->second;
+            }
+            return {};
+        }
+
+        std::string activeSession() const {
+            std::unique_lock lock(m_mutex);
+            return m_activeSession;
+        }
+
+        uint32_t flushCount() const {
+            std::unique_lock lock(m_mutex);
+            return m_flushCount;
+        }
+
+        uint32_t reloadCount() const {
+            std::unique_lock lock(m_mutex);
+            return m_reloadCount;
+        }
+
+        void setDeferWrites(bool defer) {
+            std::unique_lock lock(m_mutex);
+            m_deferWrites = defer;
+        }
+
+        // Block flush() until releaseFlush() is called.
+        void holdFlush() {
+            std::unique_lock lock(m_mutex);
+            m_holdFlush = true;
+        }
+
+        void releaseFlush() {
+            {
+                std::unique_lock lock(m_mutex);
+                m_holdFlush = false;
+            }
+            m_flushed.notify_all();
+        }
+
+        // Wait for the config writer thread to be blocked in flush().
+        bool waitForFlushStarted() {
+            std::unique_lock lock(m_mutex);
+            return m_flushed.wait_for(lock, std::chrono::seconds(5), [&] { return m_isFlushing; });
+        }
+
+        // Wait for the config writer thread to commit a batch.
+        bool waitForFlush(uint32_t count) {
+            std::unique_lock lock(m_mutex);
+            return m_flushed.wait_for(lock, std::chrono::seconds(5), [&] { return m_flushCount >= count; });
+        }
+
+      private:
+        mutable std::mutex m_mutex;
+        std::condition_variable m_flushed;
+        std::map<std::string, int, std::less<>> m_backing;
+        std::map<std::string, int, std::less<>> m_values;
+        std::map<std::string, int, std::less<>> m_globals;
+        std::vector<std::pair<std::string, std::optional<int>>> m_unflushed; // An empty name means removeAll().
+        std::function<void()> m_onChanged;
+        std::string m_activeSession;
+        bool m_deferWrites{false};
+        bool m_holdFlush{false};
+        bool m_isFlushing{false};
+        uint32_t m_flushCount{0};
+        uint32_t m_reloadCount{0};
+    };
+
+} // namespace testing
@@ -0,0 +1,153 @@
+// MIT License
+//
+// Copyright(c) 2021-2022 Matthieu Bucchianeri
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this softwareand associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright noticeand this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include "pch.h"
+
+#include "profiler.h"
+
+#include "testing.h"
+
+namespace {
+
+    using namespace toolkit;
+    using namespace testing;
+
+    // Must match the ring size in profiler.cpp.
+    constexpr size_t ZonesPerThread = 16384;
+
+    struct ExportedZone {
+        std::string name;
+        uint32_t tid;
+        double ts;
+        double dur;
+    };
+
+    std::vector<ExportedZone> ExportZones() {
+        const auto path = std::filesystem::temp_directory_path() / "profiler_tests.json";
+        CHECK(profiler::ExportChromeTrace(path));
+
+        std::vector<ExportedZone> zones;
+        std::ifstream file(path);
+        std::string line;
+        while (std::getline(file, line)) {
+            const auto nameEnd = line.find("\",\"ph\"");
+            if (line.rfind("{\"name\":\"", 0) != 0 || nameEnd == std::string::npos) {
+                continue;
+            }
+
+            ExportedZone zone;
+            zone.name = line.substr(9, nameEnd - 9);
+            CHECK(sscanf(line.c_str() + nameEnd,
+                         "\",\"ph\":\"X\",\"pid\":0,\"tid\":%u,\"ts\":%lf,\"dur\":%lf}",
+                         &zone.tid,
+                         &zone.ts,
+                         &zone.dur) == 3);
+            zones.push_back(zone);
+        }
+        file.close();
+        std::filesystem::remove(path);
+
+        return zones;
+    }
+
+    size_t CountZones(const std::vector<ExportedZone>& zones, const std::string& name) {
+        return std::count_if(zones.cbegin(), zones.cend(), [&](const ExportedZone& zone) { return zone.name == name; });
+    }
+
+    TEST_CASE(Profiler_MergesThreads) {
+        // Interleave the zones of 4 threads in time.
+        std::vector<std::thread> threads;
+        for (int t = 0; t < 4; t++) {
+            threads.emplace_back([t] {
+                for (int64_t i = 0; i < 100; i++) {
+                    const int64_t start = profiler::Now() + (i * 4 + t) * 1000;
+                    profiler::RecordZone("merge", start, start + 500);
+                }
+            });
+        }
+        for (auto& thread : threads) {
+            thread.join();
+        }
+
+        const auto zones = ExportZones();
+        CHECK_EQ(CountZones(zones, "merge"), size_t(400));
+
+        std::set<uint32_t> threadIds;
+        for (size_t i = 0; i < zones.size(); i++) {
+            if (i > 0) {
+                CHECK(zones[i].ts >= zones[i - 1].ts);
+            }
+            if (zones[i].name == "merge") {
+                threadIds.insert(zones[i].tid);
+                CHECK(zones[i].dur == 0.5);
+            }
+        }
+        CHECK_EQ(threadIds.size(), size_t(4));
+    }
+
+    TEST_CASE(Profiler_RingWrapsAround) {
+        std::thread([] {
+            const int64_t base = profiler::Now();
+            for (int64_t i = 0; i < int64_t(ZonesPerThread) + 100; i++) {
+                profiler::RecordZone(i < 100 ? "wrap_old" : "wrap_new", base + i * 1000, base + i * 1000 + 1);
+            }
+        }).join();
+
+        const auto zones = ExportZones();
+        CHECK_EQ(CountZones(zones, "wrap_old"), size_t(0));
+        CHECK_EQ(CountZones(zones, "wrap_new"), ZonesPerThread);
+    }
+
+    TEST_CASE(Profiler_ExportWhileRecording) {
+        // Every zone lasts exactly 1us, a torn read of a slot being overwritten would show a different duration.
+        std::atomic<bool> stop{false};
+        std::thread writer([&] {
+            while (!stop.load()) {
+                const int64_t start = profiler::Now();
+                profiler::RecordZone("concurrent", start, start + 1000);
+            }
+        });
+
+        for (int i = 0; i < 5; i++) {
+            const auto zones = ExportZones();
+            for (const auto& zone : zones) {
+                if (zone.name == "concurrent") {
+                    CHECK(zone.dur == 1.0);
+                }
+            }
+            CHECK(CountZones(zones, "concurrent") <= ZonesPerThread);
+        }
+
+        stop = true;
+        writer.join();
+    }
+
+    BENCHMARK(Profiler_Zone) {
+        Report("zone (disabled)", MeasureNanoseconds([] { ProfileZone("benchmark"); }), "ns");
+
+        profiler::Enable(true);
+        Report("zone (enabled)", MeasureNanoseconds([] { ProfileZone("benchmark"); }), "ns");
+        profiler::Enable(false);
+    }
+
+} // namespace
@@ -0,0 +1,103 @@
+// MIT License
+//
+// Copyright(c) 2021-2022 Matthieu Bucchianeri
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this softwareand associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright noticeand this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+// A minimal test harness for the layer's platform-independent components.
+// Tests are registered with TEST_CASE() and benchmarks with BENCHMARK(). Benchmarks only run with --benchmark.
+
+namespace testing {
+
+    struct TestCase {
+        const char* name;
+        void (*function)();
+        bool isBenchmark;
+    };
+
+    std::vector<TestCase>& GetRegistry();
+
+    struct Registration {
+        Registration(const char* name, void (*function)(), bool isBenchmark) {
+            GetRegistry().push_back({name, function, isBenchmark});
+        }
+    };
+
+    // Report a failed check for the running test case.
+    void Fail(const char* file, int line, const std::string& message);
+
+    // Print a benchmark result, eg: Report("lookup", 12.3, "ns/frame").
+    void Report(const std::string& name, double value, const char* unit);
+
+    // The directory holding the reference images of the image tests (see --golden).
+    const std::filesystem::path& GetGoldenDirectory();
+
+    // Measure the average duration of a function in nanoseconds, over enough iterations to last about 200ms.
+    template <typename Function>
+    double MeasureNanoseconds(Function&& function) {
+        using Clock = std::chrono::steady_clock;
+
+        // Warm up and calibrate.
+        uint64_t iterations = 1;
+        while (true) {
+            const auto start = Clock::now();
+            for (uint64_t i = 0; i < iterations; i++) {
+                function();
+            }
+            const auto duration = Clock::now() - start;
+            if (duration >= std::chrono::milliseconds(200)) {
+                return std::chrono::duration<double, std::nano>(duration).count() / iterations;
+            }
+            iterations *= 2;
+        }
+    }
+
+} // namespace testing
+
+#define TEST_CASE(name)                                                                                                \
+    static void name();                                                                                                \
+    static const testing::Registration name##_registration(#name, name, false);                                        \
+    static void name()
+
+#define BENCHMARK(name)                                                                                                \
+    static void name();                                                                                                \
+    static const testing::Registration name##_registration(#name, name, true);                                         \
+    static void name()
+
+#define CHECK(expr)                                                                                                    \
+    do {                                                                                                               \
+        if (!(expr)) {                                                                                                 \
+            testing::Fail(__FILE__, __LINE__, #expr);                                                                  \
+        }                                                                                                              \
+    } while (0)
+
+#define CHECK_EQ(actual, expected)                                                                                     \
+    do {                                                                                                               \
+        const auto actualValue = (actual);                                                                             \
+        const auto expectedValue = (expected);                                                                         \
+        if (!(actualValue == expectedValue)) {                                                                         \
+            testing::Fail(__FILE__,                                                                                    \
+                          __LINE__,                                                                                    \
+                          std::string(#actual " == " #expected " (actual: ") + std::to_string(actualValue) +           \
+                              ", expected: " + std::to_string(expectedValue) + ")");                                   \
+        }                                                                                                              \
+    } while (0)